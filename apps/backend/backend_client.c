@@ -50,11 +50,13 @@
 #include <fcntl.h>
 #include <time.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <assert.h>
@@ -72,6 +74,35 @@
 #include "backend_client.h"
 #include "backend_handle.h"
 
+/*
+ * Constants
+ */
+/* Stop reading requests from a client when this many bytes are queued to it */
+#define CE_OUTQ_HIGH   (1024*1024)
+
+/* Drop notifications to a client when this many bytes are queued to it */
+#define CE_OUTQ_MAX    (64*1024*1024)
+
+/* Read at most this many bytes from a client socket at a time */
+#define CE_READ_SIZE   16384
+
+/* Send reply data in messages of this size, see client_reply_xml */
+#define CE_REPLY_CHUNK (64*1024)
+
+/* A read worker gives up a reply when the backend has not read half of it 
+ * within this many ms, see ce_drain */
+#define CE_DRAIN_TIMEOUT 10000
+
+/* Nr of running read workers, see CLICON_BACKEND_READ_WORKERS */
+static uint32_t ce_nworkers = 0;
+
+/* Set in a read worker process, see ce_worker_start */
+static int ce_isworker = 0;
+
+static int ce_output(int s, void *arg);
+static int ce_worker_input(int s, void *arg);
+static int from_client_dispatch(clicon_handle h, struct client_entry *ce);
+
 /*! Find client by session-id 
  * @param[in] ce_list   List of clients
  * @param[in] id        Session id
@@ -88,10 +119,537 @@ ce_find_byid(struct client_entry *ce_list,
     return NULL;
 }
 
+/*! Send as much as possible of the output queue of a client without blocking
+ *
+ * If data remains, an output callback is registered to continue when the
+ * socket is writable. If the client has closed its socket, the queue is 
+ * dropped, the close is then detected on input.
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_flush(struct client_entry *ce)
+{
+    ssize_t n;
+
+    while (ce->ce_ooff < ce->ce_olen){
+	if ((n = send(ce->ce_s, ce->ce_obuf + ce->ce_ooff,
+		      ce->ce_olen - ce->ce_ooff, MSG_NOSIGNAL)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    if (errno == EPIPE || errno == ECONNRESET){
+		/* man (2) write: 
+		 * EPIPE  fd is connected to a pipe or socket whose reading end is 
+		 * closed.
+		 * In Clixon this means a client, eg restconf, netconf or cli closes
+		 * the (UNIX domain) socket.
+		 */
+		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+		ce->ce_ooff = ce->ce_olen;
+		break;
+	    }
+	    clicon_err(OE_UNIX, errno, "send");
+	    return -1;
+	}
+	ce->ce_ooff += n;
+    }
+    if (ce->ce_ooff == ce->ce_olen){
+	ce->ce_olen = ce->ce_ooff = 0;
+	if (ce->ce_wreg){
+	    if (clixon_event_unreg_fd(ce->ce_s, ce_output) < 0)
+		return -1;
+	    ce->ce_wreg = 0;
+	}
+    }
+    else if (!ce->ce_wreg){
+	if (clixon_event_reg_fd_write(ce->ce_s, ce_output, (void*)ce, "client output") < 0)
+	    return -1;
+	ce->ce_wreg = 1;
+    }
+    return 0;
+}
+
+/*! Append data to the output queue of a client
+ * @param[in]  ce   Client entry
+ * @param[in]  data Data, copied to the output queue of the client
+ * @param[in]  len  Length of data
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_queue(struct client_entry *ce,
+	 void                *data,
+	 size_t               len)
+{
+    size_t size;
+    char  *buf;
+
+    if (ce->ce_ooff){ /* Move unsent data to start of queue */
+	memmove(ce->ce_obuf, ce->ce_obuf + ce->ce_ooff, ce->ce_olen - ce->ce_ooff);
+	ce->ce_olen -= ce->ce_ooff;
+	ce->ce_ooff = 0;
+    }
+    if (ce->ce_olen + len > ce->ce_osize){
+	size = ce->ce_osize?ce->ce_osize:CE_READ_SIZE;
+	while (size < ce->ce_olen + len)
+	    size *= 2;
+	if ((buf = realloc(ce->ce_obuf, size)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	ce->ce_obuf = buf;
+	ce->ce_osize = size;
+    }
+    memcpy(ce->ce_obuf + ce->ce_olen, data, len);
+    ce->ce_olen += len;
+    return 0;
+}
+
+/*! A message has been queued to a client, send what can be sent without blocking
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_queued(struct client_entry *ce)
+{
+    ce->ce_stat_out++;
+    /* If output callback is registered, socket would block: wait for it */
+    if (!ce->ce_wreg && ce_flush(ce) < 0)
+	return -1;
+    if (ce->ce_olen - ce->ce_ooff > ce->ce_stat_qmax)
+	ce->ce_stat_qmax = ce->ce_olen - ce->ce_ooff;
+    return 0;
+}
+
+/*! Queue a message to a client with body from a string
+ * The message is built directly in the output queue, no message is allocated.
+ * Used for replies and, with request-id 0, for notifications.
+ * @param[in]  ce    Client entry
+ * @param[in]  reqid Request-id of request
+ * @param[in]  flags Message flags, eg CLICON_MSG_F_MORE if not last part of reply
+ * @param[in]  data  Body string
+ * @param[in]  len   Length of data (not including null-termination)
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+ce_send_reply(struct client_entry *ce,
+	      uint32_t             reqid,
+	      uint32_t             flags,
+	      char                *data,
+	      size_t               len)
+{
+    struct clicon_msg hdr = {0,};
+
+    if (ce->ce_s == 0) /* closed */
+	return 0;
+    hdr.op_len = htonl(sizeof(hdr) + len + 1);
+    hdr.op_reqid = htonl(reqid);
+    hdr.op_flags = htonl(flags);
+    if (ce_queue(ce, &hdr, sizeof(hdr)) < 0 ||
+	ce_queue(ce, data, len) < 0 ||
+	ce_queue(ce, "", 1) < 0)
+	return -1;
+    return ce_queued(ce);
+}
+
+/*! Read worker: wait until at most max bytes are queued to the backend
+ * Only used in a read worker, where it blocks nobody else. The backend stops reading
+ * from the worker while the output queue to the client is full, so this waits for 
+ * the client. The wait is bounded by CE_DRAIN_TIMEOUT, on timeout the queue is
+ * dropped and an error is returned: the worker exits and the backend removes the
+ * client, see ce_worker_done.
+ * @param[in]  ce   Client entry
+ * @param[in]  max  Max nr of bytes in output queue
+ * @retval     0    OK
+ * @retval    -1    Error, or timeout
+ */
+static int
+ce_drain(struct client_entry *ce,
+	 size_t               max)
+{
+    struct pollfd  pfd;
+    struct timeval deadline;
+    struct timeval now;
+    struct timeval t;
+    int            ret;
+
+    gettimeofday(&deadline, NULL);
+    t.tv_sec = CE_DRAIN_TIMEOUT/1000;
+    t.tv_usec = (CE_DRAIN_TIMEOUT%1000)*1000;
+    timeradd(&deadline, &t, &deadline);
+    while (ce->ce_s && ce->ce_olen - ce->ce_ooff > max){
+	gettimeofday(&now, NULL);
+	if (timercmp(&now, &deadline, <))
+	    timersub(&deadline, &now, &t);
+	else
+	    timerclear(&t);
+	pfd.fd = ce->ce_s;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	if ((ret = poll(&pfd, 1, t.tv_sec*1000 + t.tv_usec/1000)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "poll");
+	    return -1;
+	}
+	if (ret == 0){
+	    clicon_log(LOG_WARNING, "client %d: reply not read within %d ms", 
+		       ce->ce_nr, CE_DRAIN_TIMEOUT);
+	    ce->ce_olen = ce->ce_ooff = 0;
+	    clicon_err(OE_PROTO, ETIMEDOUT, "Client %d does not read reply", ce->ce_nr);
+	    return -1;
+	}
+	if (ce_flush(ce) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Send a part of a reply to the client, see clicon_xml2cbuf_stream
+ * In a read worker, if too much is queued, wait until half of it is sent, so that
+ * the memory used by a large reply is bounded.
+ * The backend itself never waits, that would stall all other clients: the part is
+ * queued and sent when the client socket is writable (ce_output). A large reply 
+ * served by the backend is therefore queued in full, use read workers to bound it.
+ * @param[in]  cb   Part of reply, reset when sent
+ * @param[in]  arg  Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_reply_part(cbuf *cb,
+	      void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t             flags = CLICON_MSG_F_MORE;
+
+    if (ce->ce_binsent)
+	flags |= CLICON_MSG_F_BIN;
+    if (ce_send_reply(ce, ce->ce_reqid, flags, cbuf_get(cb), cbuf_len(cb)) < 0)
+	return -1;
+    ce->ce_partsent = 1;
+    cbuf_reset(cb);
+    if (ce_isworker && ce->ce_olen - ce->ce_ooff > CE_OUTQ_HIGH &&
+	ce_drain(ce, CE_OUTQ_HIGH/2) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Write reply data as XML, large data is sent to the client in parts
+ * Parts are sent as messages with CLICON_MSG_F_MORE set while the tree is serialized,
+ * the last part remains in cbret and is sent as the final message of the reply by
+ * from_client_msg.
+ * @param[in]  ce     Client entry, if NULL all data is written to cbret
+ * @param[in]  x      XML tree
+ * @param[in]  depth  Limit levels of child resources: -1 is all
+ * @param[out] cbret  Reply
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+client_reply_xml(struct client_entry *ce,
+		 cxobj               *x,
+		 int32_t              depth,
+		 cbuf                *cbret)
+{
+    if (ce == NULL)
+	return clicon_xml2cbuf(cbret, x, 0, 0, depth);
+    return clicon_xml2cbuf_stream(cbret, x, 0, 0, depth, CE_REPLY_CHUNK, ce_reply_part, ce);
+}
+
+/*! Write rpc-reply with data of get or get-config, binary encoded if client accepts it
+ * A binary reply is written as the tree <rpc-reply><data>..</data></rpc-reply> 
+ * and sent in parts as client_reply_xml, with CLICON_MSG_F_BIN set. Other replies
+ * (eg errors) are always XML text.
+ * @param[in]  ce     Client entry, or NULL
+ * @param[in]  xdata  Reply data tree, named "data", or NULL
+ * @param[in]  depth  Limit levels of child resources: -1 is all
+ * @param[out] cbret  Reply, must be empty if binary
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_SOCK_BINARY
+ */
+static int
+client_reply_data(struct client_entry *ce,
+		  cxobj               *xdata,
+		  int32_t              depth,
+		  cbuf                *cbret)
+{
+    int          retval = -1;
+    xml_bin_enc *be = NULL;
+
+    if (ce == NULL || !ce->ce_binreply || cbuf_len(cbret) != 0){
+	cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+	if (xdata == NULL)
+	    cprintf(cbret, "<data/>");
+	else if (client_reply_xml(ce, xdata, depth, cbret) < 0)
+	    goto done;
+	cprintf(cbret, "</rpc-reply>");
+	goto ok;
+    }
+    ce->ce_binsent = 1;
+    if ((be = clixon_xml_bin_new(cbret, CE_REPLY_CHUNK, ce_reply_part, ce)) == NULL)
+	goto done;
+    if (clixon_xml_bin_start(be, NULL, "rpc-reply") < 0 ||
+	clixon_xml_bin_attr(be, NULL, "xmlns", NETCONF_BASE_NAMESPACE) < 0)
+	goto done;
+    if (xdata == NULL){
+	if (clixon_xml_bin_start(be, NULL, "data") < 0 ||
+	    clixon_xml_bin_end(be) < 0)
+	    goto done;
+    }
+    else if (clixon_xml_bin_tree(be, xdata, depth) < 0)
+	goto done;
+    if (clixon_xml_bin_end(be) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (be)
+	clixon_xml_bin_free(be);
+    return retval;
+}
+
+/*! Resume input from a client, and from its read worker, when its output queue is half empty
+ * Input from the client is not resumed while a read worker sends its reply.
+ * @param[in]  ce   Client entry
+ * @retval     0    OK (the client may have been removed)
+ * @retval    -1    Error
+ */
+static int
+ce_resume(struct client_entry *ce)
+{
+    if (ce->ce_s == 0 || ce->ce_olen - ce->ce_ooff >= CE_OUTQ_HIGH/2)
+	return 0;
+    if (ce->ce_wstop){
+	if (clixon_event_reg_fd(ce->ce_wfd, ce_worker_input, (void*)ce, "read worker") < 0)
+	    return -1;
+	ce->ce_wstop = 0;
+    }
+    if (ce->ce_rstop && ce->ce_wpid == 0){
+	if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0)
+	    return -1;
+	ce->ce_rstop = 0;
+	/* Complete requests may already have been received */
+	if (from_client_dispatch(ce->ce_handle, ce) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Start a read worker process serving the request being dispatched
+ *
+ * The worker is a forked copy of the backend, it serves the request from its copy
+ * of the datastores which is not changed by requests served by the backend 
+ * meanwhile. It sends the reply on a socket to the backend, which queues it to
+ * the client. No more requests are read from the client until the reply is complete,
+ * so that replies are sent in order.
+ * @param[in]  h      Clicon handle
+ * @param[in]  ce     Client entry
+ * @param[out] worker Set to 1 in worker: serve the request, then call ce_worker_exit
+ * @retval     1      Request is served by worker
+ * @retval     0      Serve the request here: in worker, or worker could not be started
+ * @retval    -1      Error
+ * @see CLICON_BACKEND_READ_WORKERS
+ */
+static int
+ce_worker_start(clicon_handle        h,
+		struct client_entry *ce,
+		int                 *worker)
+{
+    int   retval = -1;
+    int   fds[2];
+    pid_t pid;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0){
+	clicon_log(LOG_WARNING, "%s socketpair: %s", __FUNCTION__, strerror(errno));
+	goto fail;
+    }
+    if ((pid = fork()) < 0){
+	clicon_log(LOG_WARNING, "%s fork: %s", __FUNCTION__, strerror(errno));
+	close(fds[0]);
+	close(fds[1]);
+	goto fail;
+    }
+    if (pid == 0){ /* Worker: send reply to backend, output queue is the backend's */
+	close(fds[0]);
+	close(ce->ce_s);
+	ce->ce_s = fds[1];
+	/* Non-blocking so that ce_drain can give up on a client that does not read */
+	if (fcntl(fds[1], F_SETFL, O_NONBLOCK) < 0)
+	    clicon_log(LOG_WARNING, "%s fcntl: %s", __FUNCTION__, strerror(errno));
+	ce->ce_olen = ce->ce_ooff = 0;
+	ce->ce_wreg = 0;
+	ce_isworker = 1;
+	*worker = 1;
+	goto fail;
+    }
+    close(fds[1]);
+    ce->ce_wpid = pid;
+    ce->ce_wfd = fds[0];
+    ce->ce_wreqid = ce->ce_reqid;
+    ce->ce_wlen = 0;
+    ce_nworkers++;
+    if (fcntl(fds[0], F_SETFL, O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
+    if (clixon_event_reg_fd(fds[0], ce_worker_input, (void*)ce, "read worker") < 0)
+	goto done;
+    /* Stop reading requests until reply is complete */
+    if (!ce->ce_rstop){
+	if (clixon_event_unreg_fd(ce->ce_s, from_client) < 0)
+	    goto done;
+	ce->ce_rstop = 1;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read worker: send what remains of the reply and exit
+ * @param[in]  ce      Client entry
+ * @param[in]  status  Result of serving the request: 0 OK, -1 error
+ * @note Never returns
+ */
+static void
+ce_worker_exit(struct client_entry *ce,
+	       int                  status)
+{
+    if (status == 0 && ce_drain(ce, 0) < 0)
+	status = -1;
+    _exit(status<0?1:0);
+}
+
+/*! Read worker has exited, complete its reply and resume input from the client
+ * If the worker failed before sending anything, an error is sent instead. If it 
+ * failed in the middle of a reply, the client is removed since the reply cannot be
+ * completed.
+ * @param[in]  ce   Client entry
+ * @retval     0    OK (the client may have been removed)
+ * @retval    -1    Error
+ */
+static int
+ce_worker_done(struct client_entry *ce)
+{
+    int   retval = -1;
+    int   status = 0;
+    cbuf *cb = NULL;
+
+    if (!ce->ce_wstop)
+	clixon_event_unreg_fd(ce->ce_wfd, ce_worker_input);
+    ce->ce_wstop = 0;
+    close(ce->ce_wfd);
+    while (waitpid(ce->ce_wpid, &status, 0) < 0 && errno == EINTR)
+	;
+    ce->ce_wpid = 0;
+    ce_nworkers--;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0){
+	clicon_log(LOG_WARNING, "client %d: read worker failed", ce->ce_nr);
+	if (ce->ce_wlen != 0){ /* Reply is incomplete */
+	    backend_client_rm(ce->ce_handle, ce);
+	    goto ok;
+	}
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (netconf_operation_failed(cb, "application", "read worker failed") < 0)
+	    goto done;
+	if (ce_send_reply(ce, ce->ce_wreqid, 0, cbuf_get(cb), cbuf_len(cb)) < 0)
+	    goto done;
+    }
+    else
+	ce->ce_stat_out++;
+    /* Notifications held back while the reply was sent */
+    if (ce->ce_nbuf && cbuf_len(ce->ce_nbuf)){
+	if (ce_queue(ce, cbuf_get(ce->ce_nbuf), cbuf_len(ce->ce_nbuf)) < 0)
+	    goto done;
+	cbuf_reset(ce->ce_nbuf);
+	if (ce_queued(ce) < 0)
+	    goto done;
+    }
+    if (ce_resume(ce) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Input callback: reply data from read worker, queue it to the client
+ * Reading from the worker stops while the output queue to the client is full.
+ * @param[in]   s    Socket to read worker
+ * @param[in]   arg  Client entry
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+ce_worker_input(int   s,
+		void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+    char                 buf[CE_READ_SIZE];
+    ssize_t              n;
+
+    if ((n = read(s, buf, sizeof(buf))) < 0){
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	    return 0;
+	clicon_log(LOG_WARNING, "client %d: read worker: %s", ce->ce_nr, strerror(errno));
+	n = 0;
+    }
+    if (n == 0) /* eof: worker is done */
+	return ce_worker_done(ce);
+    ce->ce_wlen += n;
+    if (ce_queue(ce, buf, n) < 0)
+	return -1;
+    if (!ce->ce_wreg && ce_flush(ce) < 0)
+	return -1;
+    if (ce->ce_olen - ce->ce_ooff > ce->ce_stat_qmax)
+	ce->ce_stat_qmax = ce->ce_olen - ce->ce_ooff;
+    if (ce->ce_olen - ce->ce_ooff >= CE_OUTQ_HIGH){
+	if (clixon_event_unreg_fd(s, ce_worker_input) < 0)
+	    return -1;
+	ce->ce_wstop = 1;
+    }
+    return 0;
+}
+
+/*! Output callback: client socket is writable, send queued data
+ * Input from client is resumed when the queue is half empty.
+ * @param[in]   s    Socket to client
+ * @param[in]   arg  Client entry
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+ce_output(int   s,
+	  void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    if (ce_flush(ce) < 0)
+	return -1;
+    return ce_resume(ce);
+}
+
 /*! Stream callback for netconf stream notification (RFC 5277)
+ * The event is queued to the client from its serialized form shared by all
+ * subscriptions, it is not serialized per client.
  * @param[in]  h     Clicon handle
  * @param[in]  op    0:event, 1:rm
  * @param[in]  event Event as XML
+ * @param[in]  cbev  Event serialized as XML
  * @param[in]  arg   Extra argument provided in stream_ss_add
  * @see stream_ss_add
  */
@@ -99,9 +657,12 @@ int
 ce_event_cb(clicon_handle h,
 	    int           op,
 	    cxobj        *event,
+	    cbuf         *cbev,
 	    void         *arg)
 {
+    int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
+    struct clicon_msg    hdr = {0,};
     
     clicon_debug(1, "%s op:%d", __FUNCTION__, op);
     switch (op){
@@ -111,14 +672,32 @@ ce_event_cb(clicon_handle h,
 	    backend_client_rm(h, ce);
 	break;
     default:
-	if (send_msg_notify_xml(h, ce->ce_s, event) < 0){
-	    if (errno == ECONNRESET || errno == EPIPE){
-		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	if (ce->ce_olen - ce->ce_ooff +
+	    (ce->ce_nbuf?cbuf_len(ce->ce_nbuf):0) >= CE_OUTQ_MAX){
+	    if (ce->ce_stat_drops++ == 0)
+		clicon_log(LOG_WARNING, "client %d too slow, dropping notifications", ce->ce_nr);
+	    break;
+	}
+	if (ce->ce_wpid){ /* Hold back until reply of read worker is sent */
+	    if (ce->ce_nbuf == NULL && (ce->ce_nbuf = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    hdr.op_len = htonl(sizeof(hdr) + cbuf_len(cbev) + 1);
+	    if (cbuf_append_buf(ce->ce_nbuf, &hdr, sizeof(hdr)) < 0 ||
+		cbuf_append_buf(ce->ce_nbuf, cbuf_get(cbev), cbuf_len(cbev)+1) < 0){
+		clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+		goto done;
 	    }
 	    break;
 	}
+	if (ce_send_reply(ce, 0, 0, cbuf_get(cbev), cbuf_len(cbev)) < 0)
+	    goto done;
+	break;
     }
-    return 0;
+    retval = 0;
+ done:
+    return retval;
 }
 
 /*! Remove client entry state
@@ -126,6 +705,8 @@ ce_event_cb(clicon_handle h,
  * Finally actually remove client struct in handle
  * @param[in]  h   Clicon handle
  * @param[in]  ce  Client handle
+ * @note If called while dispatching a request of the client itself (eg from a
+ *       callback), the client struct is removed when the dispatch is done.
  * @see backend_client_delete for actual deallocation of client entry struct
  */
 int
@@ -139,12 +720,26 @@ backend_client_rm(clicon_handle        h,
     clicon_debug(1, "%s", __FUNCTION__);
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
+    if (ce->ce_wpid){ /* Stop read worker */
+	if (!ce->ce_wstop)
+	    clixon_event_unreg_fd(ce->ce_wfd, ce_worker_input);
+	close(ce->ce_wfd);
+	kill(ce->ce_wpid, SIGKILL);
+	while (waitpid(ce->ce_wpid, NULL, 0) < 0 && errno == EINTR)
+	    ;
+	ce->ce_wpid = 0;
+	ce->ce_wstop = 0;
+	ce_nworkers--;
+    }
     c0 = backend_client_list(h);
     ce_prev = &c0; /* this points to stack and is not real backpointer */
     for (c = *ce_prev; c; c = c->ce_next){
 	if (c == ce){
 	    if (ce->ce_s){
-		clixon_event_unreg_fd(ce->ce_s, from_client);
+		if (!ce->ce_rstop)
+		    clixon_event_unreg_fd(ce->ce_s, from_client);
+		if (ce->ce_wreg)
+		    clixon_event_unreg_fd(ce->ce_s, ce_output);
 		close(ce->ce_s);
 		ce->ce_s = 0;
 	    }
@@ -152,6 +747,8 @@ backend_client_rm(clicon_handle        h,
 	}
 	ce_prev = &c->ce_next;
     }
+    if (ce->ce_busy) /* purged in from_client_dispatch */
+	return 0;
     return backend_client_delete(h, ce); /* actually purge it */
 }
 
@@ -391,20 +988,22 @@ client_statedata(clicon_handle h,
  * @param[in]  username
  * @param[in]  content
  * @param[in]  depth
+ * @param[in]  ce      Client entry, large reply is sent in parts (or NULL)
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
  * @retval     0       OK
  * @retval    -1       Error
  * @see from_client_get
  */
 static int
-client_get_config_only(clicon_handle h,
-		       cvec         *nsc,
-		       yang_stmt    *yspec,
-		       char         *db,
-		       char         *xpath,
-		       char         *username,
-		       int32_t       depth,
-		       cbuf         *cbret)
+client_get_config_only(clicon_handle        h,
+		       cvec                *nsc,
+		       yang_stmt           *yspec,
+		       char                *db,
+		       char                *xpath,
+		       char                *username,
+		       int32_t              depth,
+		       struct client_entry *ce,
+		       cbuf                *cbret)
 {
     int     retval = -1;
     cxobj  *xret = NULL;
@@ -430,16 +1029,10 @@ client_get_config_only(clicon_handle h,
 	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
-    if (xret==NULL)
-	cprintf(cbret, "<data/>");
-    else{
-	if (xml_name_set(xret, "data") < 0)
-	    goto done;
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
-	    goto done;
-    }
-    cprintf(cbret, "</rpc-reply>");
+    if (xret && xml_name_set(xret, "data") < 0)
+	goto done;
+    if (client_reply_data(ce, xret, depth>0?depth+1:depth, cbret) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -531,7 +1124,8 @@ from_client_get_config(clicon_handle h,
 	    goto ok;
 	}
     }
-    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, cbret)) < 0)
+    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1,
+				      (struct client_entry *)arg, cbret)) < 0)
 	goto done;
  ok:
     retval = 0;
@@ -1074,7 +1668,8 @@ from_client_get(clicon_handle h,
 	}
     }
     if (content == CONTENT_CONFIG){ /* config only, no state */
-	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, cbret) < 0)
+	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth,
+				   (struct client_entry *)arg, cbret) < 0)
 	    goto done;
 	goto ok;
     }
@@ -1178,17 +1773,11 @@ from_client_get(clicon_handle h,
 	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
-    if (xret==NULL)
-	cprintf(cbret, "<data/>");
-    else{
-	if (xml_name_set(xret, "data") < 0)
-	    goto done;
-	/* Top level is data, so add 1 to depth if significant */
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
-	    goto done;
-    }
-    cprintf(cbret, "</rpc-reply>");
+    if (xret && xml_name_set(xret, "data") < 0)
+	goto done;
+    /* Top level is data, so add 1 to depth if significant */
+    if (client_reply_data((struct client_entry *)arg, xret, depth>0?depth+1:depth, cbret) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -1365,7 +1954,7 @@ from_client_create_subscription(clicon_handle h,
     /* Add subscriber to stream - to make notifications for this client */
     if (stream_ss_add(h, stream, selector,
 		      starttime?&start:NULL, stoptime?&stop:NULL,
-		      ce_event_cb, (void*)ce) < 0)
+		      ce_event_cb, (void*)ce) == NULL)
 	goto done;
     /* Replay of this stream to specific subscription according to start and 
      * stop (if present). 
@@ -1459,8 +2048,9 @@ from_client_stats(clicon_handle h,
 		  void         *arg,
 		  void         *regarg)
 {
-    int      retval = -1;
-    uint64_t nr;
+    int                  retval = -1;
+    uint64_t             nr;
+    struct client_entry *ce;
     
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
     nr=0;
@@ -1472,6 +2062,15 @@ from_client_stats(clicon_handle h,
 	goto done;
     if (clixon_stats_get_db(h, "startup", cbret) < 0)
 	goto done;
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+	cprintf(cbret, "<client><nr>%d</nr><session-id>%u</session-id>", 
+		ce->ce_nr, ce->ce_id);
+	cprintf(cbret, "<in>%d</in><out>%d</out>", ce->ce_stat_in, ce->ce_stat_out);
+	cprintf(cbret, "<queued>%zu</queued>", ce->ce_olen - ce->ce_ooff);
+	cprintf(cbret, "<queued-max>%" PRIu64 "</queued-max>", ce->ce_stat_qmax);
+	cprintf(cbret, "<stalls>%" PRIu64 "</stalls>", ce->ce_stat_stalls);
+	cprintf(cbret, "<drops>%" PRIu64 "</drops></client>", ce->ce_stat_drops);
+    }
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
@@ -1538,6 +2137,8 @@ from_client_hello(clicon_handle       h,
 {
     int      retval = -1;
     uint32_t id;
+    cxobj   *xcaps;
+    cxobj   *xc;
 
     if (clicon_session_id_get(h, &id) < 0){
 	clicon_err(OE_NETCONF, ENOENT, "session_id not set");
@@ -1545,8 +2146,19 @@ from_client_hello(clicon_handle       h,
     }
     id++;
     clicon_session_id_set(h, id);
-    cprintf(cbret, "<hello xmlns=\"%s\"><session-id>%u</session-id></hello>",
-	    NETCONF_BASE_NAMESPACE, id);
+    cprintf(cbret, "<hello xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    /* Accept binary replies if offered, see CLICON_SOCK_BINARY */
+    if ((xcaps = xml_find_type(x, NULL, "capabilities", CX_ELMNT)) != NULL){
+	xc = NULL;
+	while ((xc = xml_child_each(xcaps, xc, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xc), "capability") == 0 &&
+		clicon_strcmp(xml_body(xc), CLIXON_PROTO_BINARY_CAPABILITY) == 0){
+		cprintf(cbret, "<capabilities><capability>%s</capability></capabilities>",
+			CLIXON_PROTO_BINARY_CAPABILITY);
+		break;
+	    }
+    }
+    cprintf(cbret, "<session-id>%u</session-id></hello>", id);
     retval = 0;
  done:
     return retval;
@@ -1581,9 +2193,14 @@ from_client_msg(clicon_handle        h,
     cxobj               *xret = NULL;
     uint32_t             id;
     enum nacm_credentials_t creds;
+    int                  worker = 0; /* Serving request in read worker */
     
     clicon_debug(1, "%s", __FUNCTION__);
     yspec = clicon_dbspec_yang(h); 
+    ce->ce_reqid = ntohl(msg->op_reqid);
+    ce->ce_binreply = (ntohl(msg->op_flags) & CLICON_MSG_F_BIN_REPLY) != 0;
+    ce->ce_binsent = 0;
+    ce->ce_partsent = 0;
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
      */
@@ -1665,8 +2282,30 @@ from_client_msg(clicon_handle        h,
 	    if (ret == 0) /* Not permitted and cbret set */
 		goto reply;
 	}
+	/* Serve single read-only request in a read worker */
+	if (!worker &&
+	    ce_nworkers < clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS") &&
+	    strcmp(module, "ietf-netconf") == 0 &&
+	    (strcmp(rpc, "get") == 0 || strcmp(rpc, "get-config") == 0) &&
+	    xml_child_nr_type(x, CX_ELMNT) == 1){
+	    if ((ret = ce_worker_start(h, ce, &worker)) < 0)
+		goto done;
+	    if (ret == 1)
+		goto ok;
+	}
 	clicon_err_reset();
 	if ((ret = rpc_callback_call(h, xe, cbret, ce)) < 0){
+	    if (ce->ce_partsent){
+		/* Reply is incomplete and cannot be terminated with an error: remove
+		 * the client. A read worker exits with error instead, and the client
+		 * is removed by ce_worker_done */
+		clicon_log(LOG_WARNING, "client %d: error in the middle of reply: %s",
+			   ce->ce_nr, clicon_err_reason);
+		if (worker)
+		    goto done;
+		backend_client_rm(h, ce);
+		goto ok;
+	    }
 	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 		goto done;
 	    clicon_log(LOG_NOTICE, "%s Error in rpc_callback_call:%s", __FUNCTION__, xml_name(xe));
@@ -1688,27 +2327,16 @@ from_client_msg(clicon_handle        h,
     if (cbuf_len(cbret) == 0)
 	if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
 	    goto done;
-    clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
+    if (ce->ce_binsent)
+	clicon_debug(1, "%s cbret: binary %d bytes", __FUNCTION__, cbuf_len(cbret));
+    else
+	clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
-	switch (errno){
-	case EPIPE:
-	    /* man (2) write: 
-	     * EPIPE  fd is connected to a pipe or socket whose reading end is 
-	     * closed.  When this happens the writing process will also receive 
-	     * a SIGPIPE signal. 
-	     * In Clixon this means a client, eg restconf, netconf or cli closes
-	     * the (UNIX domain) socket.
-	     */
-	case ECONNRESET:
-	    clicon_log(LOG_WARNING, "client rpc reset");
-	    break;
-	default:
-	    goto done;
-	}
-    }
-    // ok:
+    if (ce_send_reply(ce, ce->ce_reqid, ce->ce_binsent?CLICON_MSG_F_BIN:0,
+		      cbuf_get(cbret), cbuf_len(cbret)) < 0)
+	goto done;
+ ok:
     retval = 0;
   done:  
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
@@ -1727,11 +2355,78 @@ from_client_msg(clicon_handle        h,
     if (retval < 0 && clicon_errno < 0) 
 	clicon_log(LOG_NOTICE, "%s: Internal error: No clicon_err call on RPC error (message: %s)",
 		   __FUNCTION__, rpc?rpc:"");
+    if (worker)
+	ce_worker_exit(ce, retval);
     //    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
     return retval;// -1 here terminates backend
 }
 
+/*! Dispatch all complete messages received from a client
+ *
+ * Messages may arrive in pieces or several at once. Stop when the output 
+ * queue to the client is full, until the client has read its replies.
+ * @param[in]   h    Clicon handle
+ * @param[in]   ce   Client entry
+ * @retval      0    OK (the client may have been removed)
+ * @retval      -1   Error
+ */
+static int
+from_client_dispatch(clicon_handle        h,
+		     struct client_entry *ce)
+{
+    int                  retval = -1;
+    struct clicon_msg    hdr;
+    struct clicon_msg   *msg = NULL;
+    size_t               off = 0;
+    uint32_t             mlen;
+
+    ce->ce_busy++;
+    while (ce->ce_s != 0 && !ce->ce_rstop && ce->ce_ilen - off >= sizeof(hdr)){
+	memcpy(&hdr, ce->ce_ibuf + off, sizeof(hdr));
+	mlen = ntohl(hdr.op_len);
+	if (mlen < sizeof(hdr)){
+	    clicon_log(LOG_WARNING, "client %d: invalid message length %u", ce->ce_nr, mlen);
+	    backend_client_rm(h, ce);
+	    break;
+	}
+	if (ce->ce_ilen - off < mlen) /* Wait for rest of message */
+	    break;
+	if ((msg = malloc(mlen)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memcpy(msg, ce->ce_ibuf + off, mlen);
+	off += mlen;
+	ce->ce_stat_in++;
+	if (from_client_msg(h, ce, msg) < 0)
+	    goto done;
+	free(msg);
+	msg = NULL;
+	/* Backpressure: stop reading until client has read its replies */
+	if (ce->ce_s != 0 && !ce->ce_rstop && ce->ce_olen - ce->ce_ooff >= CE_OUTQ_HIGH){
+	    if (clixon_event_unreg_fd(ce->ce_s, from_client) < 0)
+		goto done;
+	    ce->ce_rstop = 1;
+	    ce->ce_stat_stalls++;
+	}
+    }
+    retval = 0;
+ done:
+    if (off){
+	memmove(ce->ce_ibuf, ce->ce_ibuf + off, ce->ce_ilen - off);
+	ce->ce_ilen -= off;
+    }
+    if (msg)
+	free(msg);
+    /* Client removed by a request, eg kill-session */
+    if (--ce->ce_busy == 0 && ce->ce_s == 0)
+	backend_client_delete(h, ce);
+    return retval;
+}
+
 /*! An internal clicon message has arrived from a client. Receive and dispatch.
+ * The socket is non-blocking: read what is available and dispatch complete
+ * messages, keep the rest until more arrives.
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
@@ -1743,25 +2438,44 @@ from_client(int   s,
 	    void* arg)
 {
     int                  retval = -1;
-    struct clicon_msg   *msg = NULL;
     struct client_entry *ce = (struct client_entry *)arg;
     clicon_handle        h = ce->ce_handle;
-    int                  eof;
+    ssize_t              n;
+    size_t               size;
+    char                *buf;
 
     clicon_debug(1, "%s", __FUNCTION__);
-    // assert(s == ce->ce_s);
-    if (clicon_msg_rcv(ce->ce_s, &msg, &eof) < 0)
-	goto done;
-    if (eof)
-	backend_client_rm(h, ce); 
-    else
-	if (from_client_msg(h, ce, msg) < 0)
+    if (ce->ce_isize - ce->ce_ilen < CE_READ_SIZE){
+	size = ce->ce_isize?ce->ce_isize:CE_READ_SIZE;
+	while (size - ce->ce_ilen < CE_READ_SIZE)
+	    size *= 2;
+	if ((buf = realloc(ce->ce_ibuf, size)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    goto done;
+	}
+	ce->ce_ibuf = buf;
+	ce->ce_isize = size;
+    }
+    if ((n = read(ce->ce_s, ce->ce_ibuf + ce->ce_ilen, CE_READ_SIZE)) < 0){
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	    goto ok;
+	if (errno != ECONNRESET){
+	    clicon_err(OE_UNIX, errno, "read");
 	    goto done;
+	}
+	n = 0;
+    }
+    if (n == 0){ /* eof */
+	backend_client_rm(h, ce); 
+	goto ok;
+    }
+    ce->ce_ilen += n;
+    if (from_client_dispatch(h, ce) < 0)
+	goto done;
+ ok:
     retval = 0;
   done:
     clicon_debug(1, "%s retval=%d", __FUNCTION__, retval);
-    if (msg)
-	free(msg);
     return retval; /* -1 here terminates backend */
 }
 
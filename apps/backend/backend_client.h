@@ -52,6 +52,29 @@ struct client_entry{
     int                   ce_id;      /* Session id */
     char                 *ce_username;/* Translated from peer user cred */
     clicon_handle         ce_handle;  /* clicon config handle (all clients have same?) */
+    char                 *ce_ibuf;    /* Input: received data not yet dispatched */
+    size_t                ce_ilen;    /* Length of data in ce_ibuf */
+    size_t                ce_isize;   /* Allocated size of ce_ibuf */
+    char                 *ce_obuf;    /* Output queue: data not yet sent to client */
+    size_t                ce_olen;    /* Length of data in ce_obuf */
+    size_t                ce_ooff;    /* Offset of first unsent byte in ce_obuf */
+    size_t                ce_osize;   /* Allocated size of ce_obuf */
+    int                   ce_wreg;    /* Output callback registered: socket would block */
+    int                   ce_rstop;   /* Input stopped since output queue is full */
+    int                   ce_busy;    /* Dispatching requests: do not free on remove */
+    uint32_t              ce_reqid;   /* Request-id of request being dispatched */
+    int                   ce_binreply;/* Request accepts binary reply, CLICON_MSG_F_BIN_REPLY */
+    int                   ce_binsent; /* Reply being sent is binary, CLICON_MSG_F_BIN */
+    int                   ce_partsent;/* Parts of reply being sent are queued, CLICON_MSG_F_MORE */
+    pid_t                 ce_wpid;    /* Read worker process serving a request, or 0 */
+    int                   ce_wfd;     /* Socket from read worker, if ce_wpid */
+    int                   ce_wstop;   /* Reading from worker stopped since output queue is full */
+    uint32_t              ce_wreqid;  /* Request-id of request served by worker */
+    size_t                ce_wlen;    /* Nr of reply bytes received from worker */
+    cbuf                 *ce_nbuf;    /* Notifications held back while worker sends reply */
+    uint64_t              ce_stat_qmax;   /* Max nr of bytes in output queue */
+    uint64_t              ce_stat_stalls; /* Nr of times input stopped by full output queue */
+    uint64_t              ce_stat_drops;  /* Nr of notifications dropped by full output queue */
 };
 
 
@@ -100,8 +100,18 @@ generic_validate(clicon_handle       h,
     int             i;
     int             ret;
 
+    if (td->td_src != NULL &&
+	clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL")){
+	/* Only changed entries and entries depending on them */
+	if ((ret = xml_yang_validate_diff(h, td->td_target,
+					  td->td_dvec, td->td_dlen,
+					  td->td_avec, td->td_alen,
+					  td->td_scvec, td->td_tcvec, td->td_clen,
+					  xret)) < 0)
+	    goto done;
+    }
     /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
+    else if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
 	goto done;
     if (ret == 0)
 	goto fail;
@@ -469,9 +479,14 @@ from_validate_common(clicon_handle       h,
     /* Validate the target state. It is not completely clear this should be done 
      * here. It is being made in generic_validate below. 
      * But xml_diff requires some basic validation, at least check that yang-specs
-     * have been assigned
+     * have been assigned. With incremental validation only that is checked here,
+     * the rest is made on the differences in generic_validate.
      */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0)
+    if (clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL"))
+	ret = xml_yang_validate_bind(h, td->td_target, xret);
+    else
+	ret = xml_yang_validate_all_top(h, td->td_target, xret);
+    if (ret < 0)
 	goto done;
     if (ret == 0)
 	goto fail;
@@ -883,6 +898,9 @@ from_client_restart_one(clicon_handle h,
 	    goto done;
 	}
     }
+    /* Cached state may not be valid after restart */
+    if (clixon_plugin_statedata_cache_free(h) < 0)
+	goto done;
     /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
 	goto done;
@@ -109,6 +109,10 @@ backend_terminate(clicon_handle h)
     /* Free changelog */
     if ((x = clicon_xml_changelog_get(h)) != NULL)
 	xml_free(x);
+    /* Free validation dependency index */
+    xml_yang_validate_deps_free(h);
+    /* Free state data cache */
+    clixon_plugin_statedata_cache_free(h);
     if ((yspec = clicon_dbspec_yang(h)) != NULL)
 	yspec_free(yspec);
     if ((yspec = clicon_config_yang(h)) != NULL)
@@ -128,6 +132,7 @@ backend_terminate(clicon_handle h)
     /* Delete all backend plugin upgrade callbacks */
     upgrade_callback_delete_all(h); 
     xpath_optimize_exit();
+    xpath_cache_exit();
 
     if (pidfile)
 	unlink(pidfile);   
@@ -386,6 +391,38 @@ ret2status(int                  ret,
     return retval;
 }
 
+/*! Load backend-specific yang modules, see yang_cache_spec_load
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Yang spec
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+backend_yang_load(clicon_handle h,
+		  yang_stmt    *yspec)
+{
+    int retval = -1;
+
+    /* Load yang restconf module */
+    if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
+	goto done;
+    /* Load yang Restconf stream discovery */
+    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
+	yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
+	goto done;
+    /* Load yang Netconf stream discovery */
+    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
+	yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
+	goto done;
+    /* Load yang YANG module state */
+    if (clicon_option_bool(h, "CLICON_XMLDB_MODSTATE") &&
+	yang_spec_parse_module(h, "ietf-yang-library", NULL, yspec)< 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! usage
  */
 static void
@@ -452,7 +489,6 @@ main(int    argc,
     char         *nacm_mode;
     int           logdst = CLICON_LOG_SYSLOG|CLICON_LOG_STDERR;
     yang_stmt    *yspec = NULL;
-    char         *str;
     int           ss = -1; /* server socket */
     cbuf         *cbret = NULL; /* startup cbuf if invalid */
     enum startup_status status = STARTUP_ERR; /* Startup status */
@@ -702,6 +738,9 @@ main(int    argc,
     if (clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1)
 	xml_bind_yang_unknown_anydata(1);
 
+    /* Allocate XML parsed from file, eg datastores, in arenas */
+    xml_arena_enable(clicon_option_bool(h, "CLICON_XML_ARENA"));
+
     /* Publish stream on pubsub channels.
      * CLICON_STREAM_PUB should be set to URL to where streams are published
      * and configure should be run with --enable-publish
@@ -733,44 +772,8 @@ main(int    argc,
 			    clicon_option_str(h, "CLICON_BACKEND_REGEXP")) < 0)
 	goto done;
 
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL)
-	if (yang_spec_parse_file(h, str, yspec) < 0)
-	    goto done;
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL)
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
-	    goto done;
-    /* 3. Load all modules in a directory (will not overwrite file loaded ^) */
-    if ((str = clicon_yang_main_dir(h)) != NULL)
-	if (yang_spec_load_dir(h, str, yspec) < 0)
-	    goto done;
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-    /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
-    /* Add netconf yang spec, used by netconf client and as internal protocol 
-     */
-    if (netconf_module_load(h) < 0)
-	goto done;
-    /* Load yang restconf module */
-    if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
-	goto done;
-    /* Load yang Restconf stream discovery */
-    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
-	yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
-	goto done;
-    /* Load yang Netconf stream discovery */
-    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
-	yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
-	goto done;
-    /* Load yang YANG module state */
-    if (clicon_option_bool(h, "CLICON_XMLDB_MODSTATE") &&
-	yang_spec_parse_module(h, "ietf-yang-library", NULL, yspec)< 0)
+    /* Load Yang modules, from binary cache if valid, see CLICON_YANG_CACHE_DIR */
+    if (yang_cache_spec_load(h, "backend", yspec, backend_yang_load) < 0)
 	goto done;
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
@@ -50,8 +50,11 @@
 #include <errno.h>
 #include <signal.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
 #include <sys/param.h>
 #include <netinet/in.h>
 
@@ -65,6 +68,36 @@
 #include "backend_plugin.h"
 #include "backend_commit.h"
 
+/*
+ * Constants
+ */
+/* Max number of cached state trees, see ca_statedata_ttl */
+#define STATEDATA_CACHE_MAX 1024
+
+/*
+ * Types
+ */
+/* State data from one plugin while collecting state from all plugins
+ * @see clixon_plugin_statedata_all
+ */
+struct statedata_result{
+    clixon_plugin *sr_cp;      /* Plugin */
+    cxobj         *sr_x;       /* State tree from callback: <config>... */
+    int            sr_cached;  /* sr_x is a copy of cached bound state tree */
+    int            sr_fail;    /* Callback failed, reason in sr_reason */
+    int            sr_timeout; /* Callback process killed by CLICON_STATEDATA_TIMEOUT */
+    char          *sr_reason;  /* Reason for callback failure */
+    pid_t          sr_pid;     /* Process calling the callback (if parallel) */
+    int            sr_fd;      /* Pipe from process, or -1 */
+    cbuf          *sr_cb;      /* Data read from process */
+};
+
+/* Cached state tree of a plugin and an xpath, see ca_statedata_ttl */
+struct statedata_cache{
+    struct timeval sc_expire;  /* Entry is not used after this time */
+    cxobj         *sc_x;       /* Bound and sorted state tree (or NULL if empty) */
+};
+
 /*! Request plugins to reset system state
  * The system 'state' should be the same as the contents of running_db
  * @param[in]  cp      Plugin handle
@@ -217,9 +250,574 @@ clixon_plugin_statedata_one(clixon_plugin  *cp,
     goto done;
 }
 
+/*! Make key of state data cache entry: plugin name, xpath and namespace context
+ * @param[in]  cp     Plugin handle
+ * @param[in]  nsc    Namespace context
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[out] cb     Key is written here
+ */
+static int
+statedata_cache_key(clixon_plugin *cp,
+		    cvec          *nsc,
+		    char          *xpath,
+		    cbuf          *cb)
+{
+    cg_var *cv = NULL;
+
+    cprintf(cb, "%s\n%s", cp->cp_name, xpath?xpath:"");
+    while ((cv = cvec_each(nsc, cv)) != NULL)
+	cprintf(cb, "\n%s=%s", cv_name_get(cv)?cv_name_get(cv):"", cv_string_get(cv));
+    return 0;
+}
+
+/*! Get a copy of a cached state tree of a plugin if it has not expired
+ * @param[in]  h      Clicon handle
+ * @param[in]  key    Cache key, see statedata_cache_key
+ * @param[out] xp     Copy of state tree, or NULL if state was empty
+ * @retval    -1      Error
+ * @retval     0      Not in cache or expired
+ * @retval     1      Found, xp is set
+ */
+static int
+statedata_cache_get(clicon_handle h,
+		    char         *key,
+		    cxobj       **xp)
+{
+    clicon_hash_t          *cache;
+    struct statedata_cache *sc;
+    size_t                  len;
+    void                   *p;
+    struct timeval          now;
+
+    if ((p = clicon_hash_value(clicon_data(h), "statedata_cache", &len)) == NULL)
+	return 0;
+    cache = *(clicon_hash_t **)p;
+    if ((sc = clicon_hash_value(cache, key, &len)) == NULL)
+	return 0;
+    gettimeofday(&now, NULL);
+    if (timercmp(&now, &sc->sc_expire, >))
+	return 0;
+    *xp = NULL;
+    if (sc->sc_x && (*xp = xml_dup(sc->sc_x)) == NULL)
+	return -1;
+    return 1;
+}
+
+/*! Free state trees of cache entries, all or only those that have expired
+ * @param[in]  cache  State data cache
+ * @param[in]  all    If set free all entries, otherwise only expired
+ */
+static int
+statedata_cache_purge(clicon_hash_t *cache,
+		      int            all)
+{
+    int                     retval = -1;
+    char                  **keys = NULL;
+    size_t                  klen;
+    size_t                  len;
+    int                     i;
+    struct statedata_cache *sc;
+    struct timeval          now;
+
+    gettimeofday(&now, NULL);
+    if (clicon_hash_keys(cache, &keys, &klen) < 0)
+	goto done;
+    for (i=0; i<klen; i++){
+	if ((sc = clicon_hash_value(cache, keys[i], &len)) == NULL)
+	    continue;
+	if (!all && timercmp(&now, &sc->sc_expire, <=))
+	    continue;
+	if (sc->sc_x)
+	    xml_free(sc->sc_x);
+	clicon_hash_del(cache, keys[i]);
+    }
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Save a copy of a bound state tree of a plugin in the cache
+ * @param[in]  h      Clicon handle
+ * @param[in]  cp     Plugin handle, cp_api.ca_statedata_ttl is time to live in ms
+ * @param[in]  key    Cache key, see statedata_cache_key
+ * @param[in]  x      State tree, or NULL if state is empty
+ */
+static int
+statedata_cache_set(clicon_handle  h,
+		    clixon_plugin *cp,
+		    char          *key,
+		    cxobj         *x)
+{
+    int                     retval = -1;
+    clicon_hash_t          *cache;
+    struct statedata_cache  sc0 = {{0,},};
+    struct statedata_cache *sc;
+    size_t                  len;
+    void                   *p;
+    struct timeval          t;
+    char                  **keys = NULL;
+    size_t                  klen;
+
+    if ((p = clicon_hash_value(clicon_data(h), "statedata_cache", &len)) != NULL)
+	cache = *(clicon_hash_t **)p;
+    else {
+	if ((cache = clicon_hash_init()) == NULL)
+	    goto done;
+	if (clicon_hash_add(clicon_data(h), "statedata_cache", &cache, sizeof(cache)) == NULL){
+	    clicon_hash_free(cache);
+	    goto done;
+	}
+    }
+    if ((sc = clicon_hash_value(cache, key, &len)) != NULL){
+	if (sc->sc_x)
+	    xml_free(sc->sc_x);
+	clicon_hash_del(cache, key);
+    }
+    else { /* Bound size of cache: remove expired, or do not cache if still full */
+	if (clicon_hash_keys(cache, &keys, &klen) < 0)
+	    goto done;
+	if (klen >= STATEDATA_CACHE_MAX){
+	    if (statedata_cache_purge(cache, 0) < 0)
+		goto done;
+	    free(keys);
+	    keys = NULL;
+	    if (clicon_hash_keys(cache, &keys, &klen) < 0)
+		goto done;
+	    if (klen >= STATEDATA_CACHE_MAX)
+		goto ok;
+	}
+    }
+    gettimeofday(&sc0.sc_expire, NULL);
+    t.tv_sec = cp->cp_api.ca_statedata_ttl/1000;
+    t.tv_usec = (cp->cp_api.ca_statedata_ttl%1000)*1000;
+    timeradd(&sc0.sc_expire, &t, &sc0.sc_expire);
+    if (x && (sc0.sc_x = xml_dup(x)) == NULL)
+	goto done;
+    if (clicon_hash_add(cache, key, &sc0, sizeof(sc0)) == NULL){
+	if (sc0.sc_x)
+	    xml_free(sc0.sc_x);
+	goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Free the state data cache
+ * @param[in]  h      Clicon handle
+ * @see ca_statedata_ttl
+ */
+int
+clixon_plugin_statedata_cache_free(clicon_handle h)
+{
+    clicon_hash_t *cache;
+    size_t         len;
+    void          *p;
+
+    if ((p = clicon_hash_value(clicon_data(h), "statedata_cache", &len)) == NULL)
+	return 0;
+    cache = *(clicon_hash_t **)p;
+    statedata_cache_purge(cache, 1);
+    clicon_hash_free(cache);
+    clicon_hash_del(clicon_data(h), "statedata_cache");
+    return 0;
+}
+
+/*! Child process: call statedata callback of one plugin and write result on pipe
+ * The result is "0" followed by the state XML, or "1" followed by error reason
+ * @param[in]  cp     Plugin handle
+ * @param[in]  h      Clicon handle
+ * @param[in]  nsc    Namespace context
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  s      Write end of pipe to parent
+ * @note Never returns
+ */
+static void
+statedata_child(clixon_plugin *cp,
+		clicon_handle  h,
+		cvec          *nsc,
+		char          *xpath,
+		int            s)
+{
+    cbuf    *cb;
+    cxobj   *x = NULL;
+    char    *buf;
+    size_t   len;
+    ssize_t  n;
+
+    if ((cb = cbuf_new()) == NULL)
+	_exit(1);
+    if (clixon_plugin_statedata_one(cp, h, nsc, xpath, &x) != 1)
+	cprintf(cb, "1%s", clicon_err_reason);
+    else{
+	cprintf(cb, "0");
+	if (x && clicon_xml2cbuf(cb, x, 0, 0, -1) < 0){
+	    cbuf_reset(cb);
+	    cprintf(cb, "1%s", clicon_err_reason);
+	}
+    }
+    buf = cbuf_get(cb);
+    len = cbuf_len(cb);
+    while (len > 0){
+	if ((n = write(s, buf, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    _exit(1);
+	}
+	buf += n;
+	len -= n;
+    }
+    _exit(0);
+}
+
+/*! Call statedata callbacks of plugins concurrently, each in a forked process
+ *
+ * Each process serializes its state tree to a pipe. Processes that have not 
+ * returned within CLICON_STATEDATA_TIMEOUT ms are killed, and fail.
+ * @param[in]     h      Clicon handle
+ * @param[in,out] sr     Plugins to call (not cached). Result in sr_x or sr_fail
+ * @param[in]     nr     Length of sr
+ * @param[in]     nsc    Namespace context
+ * @param[in]     xpath  String with XPATH syntax. or NULL for all
+ * @retval        0      OK (plugin errors in sr)
+ * @retval       -1      Error
+ * @note Callbacks run in a child process: changes they make to memory are lost.
+ */
+static int
+statedata_fork_all(clicon_handle            h,
+		   struct statedata_result *sr,
+		   int                      nr,
+		   cvec                    *nsc,
+		   char                    *xpath)
+{
+    int            retval = -1;
+    int            i;
+    int            j;
+    int            fds[2];
+    pid_t          pid;
+    struct pollfd *pfd = NULL;
+    int            npfd;
+    uint32_t       timeout;
+    struct timeval deadline;
+    struct timeval now;
+    struct timeval t;
+    int            ms;
+    char           buf[4096];
+    ssize_t        n;
+    int            status;
+    char          *str;
+    cxobj         *xt = NULL;
+
+    timeout = clicon_option_int(h, "CLICON_STATEDATA_TIMEOUT");
+    gettimeofday(&deadline, NULL);
+    t.tv_sec = timeout/1000;
+    t.tv_usec = (timeout%1000)*1000;
+    timeradd(&deadline, &t, &deadline);
+    for (i=0; i<nr; i++)
+	sr[i].sr_fd = -1;
+    if ((pfd = calloc(nr, sizeof(*pfd))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nr; i++){
+	if (sr[i].sr_cached)
+	    continue;
+	if ((sr[i].sr_cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (pipe(fds) < 0){
+	    clicon_err(OE_UNIX, errno, "pipe");
+	    goto done;
+	}
+	if ((pid = fork()) < 0){
+	    clicon_err(OE_UNIX, errno, "fork");
+	    close(fds[0]);
+	    close(fds[1]);
+	    goto done;
+	}
+	if (pid == 0){ /* child */
+	    close(fds[0]);
+	    statedata_child(sr[i].sr_cp, h, nsc, xpath, fds[1]);
+	}
+	close(fds[1]);
+	sr[i].sr_pid = pid;
+	sr[i].sr_fd = fds[0];
+    }
+    /* Read results from all processes until eof or timeout */
+    while (1){
+	npfd = 0;
+	for (i=0; i<nr; i++)
+	    if (sr[i].sr_fd != -1){
+		pfd[npfd].fd = sr[i].sr_fd;
+		pfd[npfd].events = POLLIN;
+		pfd[npfd].revents = 0;
+		npfd++;
+	    }
+	if (npfd == 0)
+	    break;
+	ms = -1;
+	if (timeout){
+	    gettimeofday(&now, NULL);
+	    if (timercmp(&now, &deadline, >=))
+		break;
+	    timersub(&deadline, &now, &t);
+	    ms = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+	}
+	if (poll(pfd, npfd, ms) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "poll");
+	    goto done;
+	}
+	for (j=0; j<npfd; j++){
+	    if (pfd[j].revents == 0)
+		continue;
+	    for (i=0; i<nr; i++)
+		if (sr[i].sr_fd == pfd[j].fd)
+		    break;
+	    if ((n = read(sr[i].sr_fd, buf, sizeof(buf))) < 0 && errno == EINTR)
+		continue;
+	    if (n > 0)
+		cprintf(sr[i].sr_cb, "%.*s", (int)n, buf);
+	    else {
+		close(sr[i].sr_fd);
+		sr[i].sr_fd = -1;
+	    }
+	}
+    }
+    retval = 0;
+ done:
+    /* Kill processes that have not finished, and collect all processes */
+    for (i=0; i<nr; i++){
+	if (sr[i].sr_fd != -1){
+	    close(sr[i].sr_fd);
+	    sr[i].sr_fd = -1;
+	    kill(sr[i].sr_pid, SIGKILL);
+	    sr[i].sr_fail = 1;
+	    sr[i].sr_timeout = 1;
+	}
+	if (sr[i].sr_pid > 0)
+	    while (waitpid(sr[i].sr_pid, &status, 0) < 0 && errno == EINTR)
+		;
+	sr[i].sr_pid = 0;
+    }
+    /* Parse results */
+    for (i=0; retval == 0 && i<nr; i++){
+	if (sr[i].sr_cached || sr[i].sr_fail)
+	    continue;
+	str = cbuf_get(sr[i].sr_cb);
+	switch (*str){
+	case '0':
+	    if (*(str+1) == '\0')
+		break;
+	    if (clixon_xml_parse_string(str+1, YB_NONE, NULL, &xt, NULL) < 0 ||
+		xml_rootchild(xt, 0, &xt) < 0){
+		sr[i].sr_fail = 1;
+		str = clicon_err_reason;
+	    }
+	    else{
+		sr[i].sr_x = xt;
+		xt = NULL;
+	    }
+	    break;
+	case '1':
+	    sr[i].sr_fail = 1;
+	    str++;
+	    break;
+	default:
+	    sr[i].sr_fail = 1;
+	    str = "process terminated";
+	    break;
+	}
+	if (xt){
+	    xml_free(xt);
+	    xt = NULL;
+	}
+	if (sr[i].sr_fail && (sr[i].sr_reason = strdup(str)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    retval = -1;
+	}
+    }
+    if (pfd)
+	free(pfd);
+    return retval;
+}
+
+/*! Collect the leading steps of a location path as namespace/name pairs
+ * Steps are collected until one that is not a named child step, eg a wildcard, a 
+ * parent step or "//". 
+ * @param[in]  xs     XPath parse tree of a relative location path or step
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  steps  Steps, name is namespace (NULL if not known), value is node name
+ * @retval    -1      Error
+ * @retval     0      Stop, not a named child step
+ * @retval     1      OK, continue with next step
+ */
+static int
+statedata_xpath_steps(xpath_tree *xs,
+		      cvec       *nsc,
+		      cvec       *steps)
+{
+    int         ret;
+    xpath_tree *xn;
+    char       *ns = NULL;
+
+    if (xs == NULL)
+	return 0;
+    switch (xs->xs_type){
+    case XP_RELLOCPATH:
+	if ((ret = statedata_xpath_steps(xs->xs_c0, nsc, steps)) < 1)
+	    return ret;
+	if (xs->xs_c1 == NULL)
+	    return 1;
+	if (xs->xs_int == A_DESCENDANT_OR_SELF) /* "//" */
+	    return 0;
+	return statedata_xpath_steps(xs->xs_c1, nsc, steps);
+    case XP_STEP:
+	if (xs->xs_int != A_CHILD ||
+	    (xn = xs->xs_c0) == NULL ||
+	    xn->xs_type != XP_NODE ||
+	    xn->xs_s1 == NULL)
+	    return 0;
+	if (nsc)
+	    ns = xml_nsctx_get(nsc, xn->xs_s0);
+	if (cvec_add_string(steps, ns, xn->xs_s1) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    return -1;
+	}
+	return 1;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Get the leading steps of an absolute xpath, all selected nodes are below them
+ * Descend through single-operand expressions to an absolute location path. 
+ * If the xpath is anything else, eg a union, a relative path or a function, no 
+ * steps are returned, which means any node may be selected.
+ * @param[in]  xs     XPath parse tree
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  steps  Steps, see statedata_xpath_steps
+ * @retval    -1      Error
+ * @retval     0      OK
+ */
+static int
+statedata_xpath_prefix(xpath_tree *xs,
+		       cvec       *nsc,
+		       cvec       *steps)
+{
+    if (xs == NULL)
+	return 0;
+    switch (xs->xs_type){
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+    case XP_UNION:
+    case XP_PATHEXPR:
+    case XP_LOCPATH:
+	if (xs->xs_c1 != NULL) /* Operator or union */
+	    break;
+	return statedata_xpath_prefix(xs->xs_c0, nsc, steps);
+    case XP_ABSPATH:
+	if (xs->xs_int != A_ROOT)
+	    break;
+	if (statedata_xpath_steps(xs->xs_c0, nsc, steps) < 0)
+	    return -1;
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Check if the state paths declared by a plugin may intersect the nodes of an xpath
+ * A declared path is eg "/example:top/x", where a name without module prefix has 
+ * the module of the step before. The paths intersect if one is a prefix of the 
+ * other. 
+ * @param[in]  cp     Plugin handle, see ca_statedata_paths
+ * @param[in]  yspec  Yang spec
+ * @param[in]  steps  Leading steps of xpath, see statedata_xpath_prefix
+ * @retval    -1      Error
+ * @retval     0      No, plugin state cannot be selected by xpath
+ * @retval     1      Yes, or plugin does not declare paths
+ */
+static int
+statedata_paths_match(clixon_plugin *cp,
+		      yang_stmt     *yspec,
+		      cvec          *steps)
+{
+    int          retval = -1;
+    const char **paths;
+    char       **vec = NULL;
+    int          nvec;
+    int          i;
+    int          j;
+    char        *name;
+    char        *ns;
+    char        *ns1;
+    yang_stmt   *ymod;
+    cg_var      *cv;
+    int          match;
+
+    if ((paths = cp->cp_api.ca_statedata_paths) == NULL ||
+	cvec_len(steps) == 0)
+	goto ok;
+    for (; *paths; paths++){
+	if ((vec = clicon_strsep((char*)*paths, "/", &nvec)) == NULL)
+	    goto done;
+	ns = NULL;
+	match = 1;
+	j = 0;
+	for (i=0; i<nvec && j<cvec_len(steps); i++){
+	    if (strlen(vec[i]) == 0)
+		continue;
+	    if ((name = index(vec[i], ':')) != NULL){
+		*name++ = '\0';
+		if ((ymod = yang_find_module_by_name(yspec, vec[i])) != NULL)
+		    ns = yang_find_mynamespace(ymod);
+		else
+		    ns = NULL;
+	    }
+	    else
+		name = vec[i];
+	    cv = cvec_i(steps, j++);
+	    ns1 = cv_name_get(cv);
+	    if (strcmp(name, cv_string_get(cv)) != 0 ||
+		(ns && ns1 && strcmp(ns, ns1) != 0)){
+		match = 0;
+		break;
+	    }
+	}
+	free(vec);
+	vec = NULL;
+	if (match)
+	    goto ok;
+    }
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+ ok:
+    retval = 1;
+    goto done;
+}
+
 /*! Go through all backend statedata callbacks and collect state data
  * This is internal system call, plugin is invoked (does not call) this function
  * Backend plugins can register 
+ * If CLICON_STATEDATA_PARALLEL is set, callbacks are called concurrently.
+ * State of plugins with ca_statedata_ttl set is cached per xpath.
+ * Plugins with ca_statedata_paths set are only called if xpath may select nodes in
+ * those paths.
  * @param[in]     h       clicon handle
  * @param[in]     yspec   Yang spec
  * @param[in]     nsc     Namespace context
@@ -237,25 +835,98 @@ clixon_plugin_statedata_all(clicon_handle    h,
 			    char            *xpath,
 			    cxobj          **xret)
 {
-    int             retval = -1;
-    int             ret;
-    cxobj          *x = NULL;
-    clixon_plugin  *cp = NULL;
-    cbuf           *cberr = NULL; 
-    cxobj          *xerr = NULL;
+    int                      retval = -1;
+    int                      ret;
+    cxobj                   *x = NULL;
+    clixon_plugin           *cp = NULL;
+    cbuf                    *cberr = NULL; 
+    cxobj                   *xerr = NULL;
+    struct statedata_result *sr = NULL;
+    int                      nr = 0;
+    int                      i;
+    cbuf                    *key = NULL;
+    xpath_tree              *xpt = NULL;
+    cvec                    *steps = NULL;
     
     clicon_debug(1, "%s", __FUNCTION__);
-    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-	if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_statedata)
+	    nr++;
+    if (nr == 0)
+	goto ok;
+    if ((sr = calloc(nr, sizeof(*sr))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if ((key = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((steps = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if (xpath){
+	if (xpath_parse(xpath, &xpt) < 0)
+	    goto done;
+	if (statedata_xpath_prefix(xpt, nsc, steps) < 0)
+	    goto done;
+    }
+    i = 0;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL){
+	if (cp->cp_api.ca_statedata == NULL)
+	    continue;
+	if ((ret = statedata_paths_match(cp, yspec, steps)) < 0)
 	    goto done;
 	if (ret == 0){
+	    clicon_debug(1, "%s skip plugin %s", __FUNCTION__, cp->cp_name);
+	    continue;
+	}
+	sr[i].sr_cp = cp;
+	if (cp->cp_api.ca_statedata_ttl){
+	    cbuf_reset(key);
+	    statedata_cache_key(cp, nsc, xpath, key);
+	    if ((ret = statedata_cache_get(h, cbuf_get(key), &sr[i].sr_x)) < 0)
+		goto done;
+	    sr[i].sr_cached = ret;
+	}
+	i++;
+    }
+    nr = i;
+    /* Call callbacks of plugins whose state is not cached */
+    if (clicon_option_bool(h, "CLICON_STATEDATA_PARALLEL")){
+	if (statedata_fork_all(h, sr, nr, nsc, xpath) < 0)
+	    goto done;
+    }
+    else
+	for (i=0; i<nr; i++){
+	    if (sr[i].sr_cached)
+		continue;
+	    if ((ret = clixon_plugin_statedata_one(sr[i].sr_cp, h, nsc, xpath, &sr[i].sr_x)) < 0)
+		goto done;
+	    if (ret == 0){
+		sr[i].sr_fail = 1;
+		/* error reason should be in clicon_err_reason */
+		if ((sr[i].sr_reason = strdup(clicon_err_reason)) == NULL){
+		    clicon_err(OE_UNIX, errno, "strdup");
+		    goto done;
+		}
+	    }
+	}
+    /* Bind, sort and merge state trees in plugin order */
+    for (i=0; i<nr; i++){
+	cp = sr[i].sr_cp;
+	if (sr[i].sr_fail){
 	    if ((cberr = cbuf_new()) == NULL){
 		clicon_err(OE_UNIX, errno, "cbuf_new");
 		goto done;
 	    }
-	    /* error reason should be in clicon_err_reason */
-	    cprintf(cberr, "Internal error, state callback in plugin %s returned invalid XML: %s",
-		    cp->cp_name, clicon_err_reason);
+	    if (sr[i].sr_timeout)
+		cprintf(cberr, "State callback in plugin %s did not return within %d ms",
+			cp->cp_name, clicon_option_int(h, "CLICON_STATEDATA_TIMEOUT"));
+	    else
+		cprintf(cberr, "Internal error, state callback in plugin %s returned invalid XML: %s",
+			cp->cp_name, sr[i].sr_reason);
 	    if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
 		goto done;
 	    xml_free(*xret);
@@ -263,45 +934,72 @@ clixon_plugin_statedata_all(clicon_handle    h,
 	    xerr = NULL;
 	    goto fail;
 	}
-	if (x == NULL)
-	    continue;
-	if (xml_child_nr(x) == 0){
-	    xml_free(x);
-	    x = NULL;
-	    continue;
-	}
+	x = sr[i].sr_x;
+	sr[i].sr_x = NULL;
+	if (!sr[i].sr_cached){
+	    if (x && xml_child_nr(x) == 0){
+		xml_free(x);
+		x = NULL;
+	    }
+	    if (x){
 #if 1
-	if (clicon_debug_get())
-	    clicon_log_xml(LOG_DEBUG, x, "%s STATE:", __FUNCTION__);
+		if (clicon_debug_get())
+		    clicon_log_xml(LOG_DEBUG, x, "%s STATE:", __FUNCTION__);
 #endif
-	/* XXX: ret == 0 invalid yang binding should be handled as internal error */
-	if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
-	    goto done;
-	if (ret == 0){
-	    if (clixon_netconf_internal_error(xerr,
-					      ". Internal error, state callback returned invalid XML: ",
-					      cp->cp_name) < 0)
-		goto done;
-	    xml_free(*xret);
-	    *xret = xerr;
-	    xerr = NULL;
-	    goto fail;
+		/* XXX: ret == 0 invalid yang binding should be handled as internal error */
+		if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
+		    goto done;
+		if (ret == 0){
+		    if (clixon_netconf_internal_error(xerr,
+						      ". Internal error, state callback returned invalid XML: ",
+						      cp->cp_name) < 0)
+			goto done;
+		    xml_free(*xret);
+		    *xret = xerr;
+		    xerr = NULL;
+		    goto fail;
+		}
+		if (xml_sort_recurse(x) < 0)
+		    goto done;
+		if (xml_default_recurse(x) < 0)
+		    goto done;
+	    }
+	    if (cp->cp_api.ca_statedata_ttl){
+		cbuf_reset(key);
+		statedata_cache_key(cp, nsc, xpath, key);
+		if (statedata_cache_set(h, cp, cbuf_get(key), x) < 0)
+		    goto done;
+	    }
 	}
-	if (xml_sort_recurse(x) < 0)
-	    goto done;
-	if (xml_default_recurse(x) < 0)
-	    goto done;
+	if (x == NULL)
+	    continue;
 	if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
-	if (x){
-	    xml_free(x);
-	    x = NULL;
-	}
-    } /* while plugin */
+	xml_free(x);
+	x = NULL;
+    } /* for plugin */
+ ok:
     retval = 1;
  done:
+    if (sr){
+	for (i=0; i<nr; i++){
+	    if (sr[i].sr_x)
+		xml_free(sr[i].sr_x);
+	    if (sr[i].sr_reason)
+		free(sr[i].sr_reason);
+	    if (sr[i].sr_cb)
+		cbuf_free(sr[i].sr_cb);
+	}
+	free(sr);
+    }
+    if (key)
+	cbuf_free(key);
+    if (steps)
+	cvec_free(steps);
+    if (xpt)
+	xpath_tree_free(xpt);
     if (xerr)
 	xml_free(xerr);
     if (cberr)
@@ -76,6 +76,7 @@ int clixon_plugin_daemon_one(clixon_plugin *cp, clicon_handle h);
 int clixon_plugin_daemon_all(clicon_handle h);
 
 int clixon_plugin_statedata_all(clicon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath, cxobj **xtop);
+int clixon_plugin_statedata_cache_free(clicon_handle h);
 
 transaction_data_t * transaction_new(void);
 int transaction_free(transaction_data_t *);
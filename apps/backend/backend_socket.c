@@ -285,6 +285,11 @@ backend_accept_client(int   fd,
 	break;
     }
     ce->ce_s = s;
+    /* Requests and replies are buffered in the client entry, never block on a client */
+    if (fcntl(s, F_SETFL, O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
 
     /*
      * Here we register callbacks for actual data socket 
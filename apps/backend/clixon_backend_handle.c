@@ -179,6 +179,12 @@ backend_client_delete(clicon_handle        h,
 	    *ce_prev = c->ce_next;
 	    if (ce->ce_username)
 		free(ce->ce_username);
+	    if (ce->ce_ibuf)
+		free(ce->ce_ibuf);
+	    if (ce->ce_obuf)
+		free(ce->ce_obuf);
+	    if (ce->ce_nbuf)
+		cbuf_free(ce->ce_nbuf);
 	    free(ce);
 	    break;
 	}
@@ -177,6 +177,7 @@ cli_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     cli_plugin_finish(h);    
     cli_history_save(h);
     cli_handle_exit(h);
@@ -401,7 +402,6 @@ main(int    argc,
     char          *restarg = NULL; /* what remains after options */
     yang_stmt     *yspec;
     struct passwd *pw;
-    char          *str;
     int            tabmode;
     char          *dir;
     cvec          *nsctx_global = NULL; /* Global namespace context */
@@ -629,33 +629,8 @@ main(int    argc,
 	goto done;
     clicon_dbspec_yang_set(h, yspec);	
 
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL){
-	if (yang_spec_parse_file(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL){
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
-	    goto done;
-    }
-    /* 3. Load all modules in a directory */
-    if ((str = clicon_yang_main_dir(h)) != NULL){
-	if (yang_spec_load_dir(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-
-     /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
-
-    /* Add netconf yang spec, used as internal protocol */
-    if (netconf_module_load(h) < 0)
+    /* Load Yang modules, from binary cache if valid, see CLICON_YANG_CACHE_DIR */
+    if (yang_cache_spec_load(h, "cli", yspec, NULL) < 0)
 	goto done;
     
     /* Here all modules are loaded 
@@ -172,9 +172,11 @@ netconf_input_packet(clicon_handle h,
 	    goto done;
     }
     else  /* rpc */
-	if (netconf_rpc_dispatch(h, xrpc, &xret) < 0){
+	if ((ret = netconf_rpc_dispatch(h, xrpc, &xret)) < 0){
 	    goto done;
 	}
+	else if (ret == 1) /* reply already written */
+	    ;
 	else{ /* there is a return message in xret */
 
 	    if (xret == NULL){
@@ -342,6 +344,7 @@ netconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clicon_handle_exit(h);
     clicon_log_exit();
@@ -400,7 +403,6 @@ main(int    argc,
     struct passwd   *pw;
     struct timeval   tv = {0,}; /* timeout */
     yang_stmt       *yspec = NULL;
-    char            *str;
     uint32_t         id;
     cvec            *nsctx_global = NULL; /* Global namespace context */
     size_t           cligen_buflen;
@@ -544,31 +546,8 @@ main(int    argc,
 	clixon_plugins_load(h, CLIXON_PLUGIN_INIT, dir, NULL) < 0)
 	goto done;
     
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL){
-	if (yang_spec_parse_file(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL){
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
-	    goto done;
-    }
-    /* 3. Load all modules in a directory */
-    if ((str = clicon_yang_main_dir(h)) != NULL){
-	if (yang_spec_load_dir(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-     /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
-	goto done;
-    /* Add netconf yang spec, used by netconf client and as internal protocol */
-    if (netconf_module_load(h) < 0)
+    /* Load Yang modules, from binary cache if valid, see CLICON_YANG_CACHE_DIR */
+    if (yang_cache_spec_load(h, "netconf", yspec, NULL) < 0)
 	goto done;
     /* Here all modules are loaded 
      * Compute and set canonical namespace context
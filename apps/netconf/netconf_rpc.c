@@ -108,10 +108,153 @@ ok:
     return retval;
 }
 
+/* State of a reply from backend written to stdout as it arrives
+ * @see netconf_rpc_stream
+ */
+struct netconf_stream{
+    cxobj *ns_xrpc;  /* Request, its attributes are copied to the reply */
+    int    ns_first; /* Set until first part of reply is written */
+    int    ns_last;  /* Set when last part of reply is written */
+    cbuf  *ns_cb;    /* Output buffer */
+};
+
+/*! Write part of a reply from backend to stdout, see clicon_rpc_netconf_xml_stream
+ * Attributes of the request, eg message-id, are added to the rpc-reply start tag 
+ * in the first part, as done in netconf_input_packet.
+ * @param[in]  data  Part of reply
+ * @param[in]  len   Length of data
+ * @param[in]  last  Set if last part of reply
+ * @param[in]  arg   Stream state
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+netconf_stream_cb(char  *data,
+		  size_t len,
+		  int    last,
+		  void  *arg)
+{
+    int                    retval = -1;
+    struct netconf_stream *ns = (struct netconf_stream *)arg;
+    cbuf                  *cb = ns->ns_cb;
+    char                  *p;
+    size_t                 n;
+    cxobj                 *xa = NULL;
+    char                  *prefix;
+    char                  *name;
+    char                  *tag = NULL;
+    cbuf                  *cba = NULL;
+    char                  *buf;
+    ssize_t                nw;
+    
+    cbuf_reset(cb);
+    if (ns->ns_first){
+	ns->ns_first = 0;
+	add_preamble(cb);
+	/* Start tag of rpc-reply */
+	if ((p = memchr(data, '>', len)) == NULL || p == data){
+	    clicon_err(OE_PROTO, EPROTO, "Reply start tag expected");
+	    goto done;
+	}
+	n = p - data;
+	if (data[n-1] == '/')
+	    n--;
+	if ((tag = strndup(data, n)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	if ((cba = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}
+	cbuf_append_buf(cb, data, n);
+	while ((xa = xml_child_each(ns->ns_xrpc, xa, CX_ATTR)) != NULL){
+	    prefix = xml_prefix(xa);
+	    name = xml_name(xa);
+	    /* Username is only for backend, see netconf_rpc_dispatch */
+	    if (prefix == NULL && strcmp(name, "username") == 0)
+		continue;
+	    cbuf_reset(cba);
+	    cprintf(cba, " %s%s%s=", prefix?prefix:"", prefix?":":"", name);
+	    /* If attribute already exists, dont copy it */
+	    if (strstr(tag, cbuf_get(cba)) != NULL)
+		continue;
+	    cprintf(cb, "%s\"%s\"", cbuf_get(cba), xml_value(xa));
+	}
+	data += n;
+	len -= n;
+    }
+    cbuf_append_buf(cb, data, len);
+    if (last){
+	add_postamble(cb);
+	ns->ns_last = 1;
+    }
+    buf = cbuf_get(cb);
+    n = cbuf_len(cb);
+    while (n > 0){
+	if ((nw = write(1, buf, n)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno != EPIPE)
+		clicon_log(LOG_ERR, "%s: write: %s", __FUNCTION__, strerror(errno));
+	    goto done;
+	}
+	buf += nw;
+	n -= nw;
+    }
+    retval = 0;
+ done:
+    if (tag)
+	free(tag);
+    if (cba)
+	cbuf_free(cba);
+    return retval;
+}
+
+/*! Send rpc to backend and write reply to stdout as it arrives
+ * Used for get and get-config that may have large replies, which are not parsed.
+ * @param[in]  h       clicon handle
+ * @param[in]  xrpc    Request at <rpc>...</rpc> level.
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+netconf_rpc_stream(clicon_handle h,
+		   cxobj        *xrpc)
+{
+    int                   retval = -1;
+    struct netconf_stream ns = {0,};
+
+    ns.ns_xrpc = xrpc;
+    ns.ns_first = 1;
+    if ((ns.ns_cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_rpc_netconf_xml_stream(h, xrpc, netconf_stream_cb, &ns) < 0){
+	/* Terminate a partially written reply, so that the client can find the
+	 * start of next message */
+	if (!ns.ns_first && !ns.ns_last){
+	    cbuf_reset(ns.ns_cb);
+	    add_postamble(ns.ns_cb);
+	    netconf_output(1, ns.ns_cb, "rpc-reply");
+	}
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (ns.ns_cb)
+	cbuf_free(ns.ns_cb);
+    return retval;
+}
+
 /*! Get configuration
  * @param[in]  h       Clicon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @retval     0       OK, xret set
+ * @retval     1       OK, reply already written, see netconf_rpc_stream
+ * @retval    -1       Error
  * @note filter type subtree and xpath is supported, but xpath is preferred, and
  *              better performance and tested. Please use xpath.
  *
@@ -155,6 +298,9 @@ ok:
      <rpc><get-config><source><candidate/></source><filter type="subtree"><configuration><interfaces><interface><ipv4><enabled/></ipv4></interface></interfaces></configuration></filter></get-config></rpc>]]>]]>
  * filter xpath + select:
      <rpc><get-config><source><candidate/></source><filter type="xpath" select="/interfaces/interface/ipv4"/></get-config></rpc>]]>]]>
+ * @retval     0       OK, xret set
+ * @retval     1       OK, reply already written, see netconf_rpc_stream
+ * @retval    -1       Error
  */
 static int
 netconf_get_config(clicon_handle h, 
@@ -169,8 +315,10 @@ netconf_get_config(clicon_handle h,
      if ((xfilter = xpath_first(xn, NULL, "filter")) != NULL) 
 	 ftype = xml_find_value(xfilter, "type");
      if (xfilter == NULL || ftype == NULL || strcmp(ftype, "xpath")==0){
-	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
-	     goto done;	
+	 /* Reply is not modified: write it as it arrives */
+	 if (netconf_rpc_stream(h, xml_parent(xn)) < 0)
+	     goto done;
+	 goto sent;
      }
      else if (strcmp(ftype, "subtree")==0){
 	 /* Get whole config first, then filter. This is suboptimal
@@ -194,6 +342,9 @@ netconf_get_config(clicon_handle h,
     retval = 0;
  done:
     return retval;
+ sent:
+    retval = 1;
+    goto done;
 }
 
 /*! Get options from netconf edit-config
@@ -349,6 +500,9 @@ netconf_edit_config(clicon_handle h,
  * @param[in]  h       Clicon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @retval     0       OK, xret set
+ * @retval     1       OK, reply already written, see netconf_rpc_stream
+ * @retval    -1       Error
  * @note filter type subtree and xpath is supported, but xpath is preferred, and
  *              better performance and tested. Please use xpath.
  *
@@ -369,8 +523,10 @@ netconf_get(clicon_handle h,
      if ((xfilter = xpath_first(xn, NULL, "filter")) != NULL) 
 	 ftype = xml_find_value(xfilter, "type");
      if (xfilter == NULL || ftype == NULL || strcmp(ftype, "xpath")==0){
-	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
-	     goto done;	
+	 /* Reply is not modified: write it as it arrives */
+	 if (netconf_rpc_stream(h, xml_parent(xn)) < 0)
+	     goto done;
+	 goto sent;
      }
      else if (strcmp(ftype, "subtree")==0){
 	 /* Get whole config + state first, then filter. This is suboptimal
@@ -394,6 +550,9 @@ netconf_get(clicon_handle h,
     retval = 0;
  done:
     return retval;
+ sent:
+    retval = 1;
+    goto done;
 }
 
 /*! Called when a notification has happened on backend
@@ -441,9 +600,9 @@ netconf_notification_cb(int   s,
     /* handle close from remote end: this will exit the client */
     if (eof){
 	clicon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+	clixon_event_unreg_fd(s, netconf_notification_cb);
 	close(s);
 	errno = ESHUTDOWN;
-	clixon_event_unreg_fd(s, netconf_notification_cb);
 	goto done;
     }
     yspec = clicon_dbspec_yang(h);
@@ -655,6 +814,7 @@ netconf_application_rpc(clicon_handle h,
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
  * @retval     0       OK, can also be netconf error 
+ * @retval     1       OK, reply already written (not in xret)
  * @retval    -1       Error, fatal
  */
 int
@@ -666,6 +826,8 @@ netconf_rpc_dispatch(clicon_handle h,
     cxobj      *xe;
     char       *username;
     cxobj      *xa;
+    int         ret;
+    int         sent = 0;
     
     /* Tag username on all incoming requests in case they are forwarded as internal messages
      * This may be unecesary since not all are forwarded. 
@@ -697,16 +859,20 @@ netconf_rpc_dispatch(clicon_handle h,
 		goto done;	
 	}
 	else if (strcmp(xml_name(xe), "get-config") == 0){
-	    if (netconf_get_config(h, xe, xret) < 0)
+	    if ((ret = netconf_get_config(h, xe, xret)) < 0)
 		goto done;
+	    if (ret == 1)
+		sent++;
 	}
 	else if (strcmp(xml_name(xe), "edit-config") == 0){
 	    if (netconf_edit_config(h, xe, xret) < 0)
 		goto done;
 	}
 	else if (strcmp(xml_name(xe), "get") == 0){
-	    if (netconf_get(h, xe, xret) < 0)
+	    if ((ret = netconf_get(h, xe, xret)) < 0)
 		goto done;
+	    if (ret == 1)
+		sent++;
 	}
 	else if (strcmp(xml_name(xe), "close-session") == 0){
 	    cc_closed++;
@@ -737,7 +903,7 @@ netconf_rpc_dispatch(clicon_handle h,
 	    }
 	}
     }
-    retval = 0;
+    retval = sent?1:0;
  done:
     /* Username attribute added at top - otherwise it is returned to sender */
     if ((xa = xml_find(xn, "username")) != NULL)
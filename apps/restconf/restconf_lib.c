@@ -253,6 +253,7 @@ restconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     restconf_handle_exit(h);
     clicon_log_exit();
     return 0;
@@ -376,6 +377,33 @@ restconf_insert_attributes(cxobj *xdata,
     return retval;
 }
 
+/*! Load restconf-specific yang modules, see yang_cache_spec_load
+ * @param[in]  h     Clixon handle
+ * @param[in]  yspec Yang spec
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+restconf_yang_load(clicon_handle h,
+		   yang_stmt    *yspec)
+{
+    int retval = -1;
+
+    /* Load yang restconf module */
+    if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
+	goto done;
+    /* Add system modules */
+    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
+	yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
+	goto done;
+    if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
+	yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Callback for yang extensions ietf-restconf:yang-data
  * @see ietf-restconf.yang
  * @param[in] h    Clixon handle
@@ -207,7 +207,6 @@ main(int    argc,
     char          *stream_path;
     int            finish = 0;
     int            start = 1;
-    char          *str;
     clixon_plugin *cp = NULL;
     uint32_t       id = 0;
     cvec          *nsctx_global = NULL; /* Global namespace context */
@@ -359,46 +358,10 @@ main(int    argc,
 	goto done;
     cp->cp_api.ca_extension = restconf_main_extension_cb;
 
-    /* Load Yang modules
-     * 1. Load a yang module as a specific absolute filename */
-    if ((str = clicon_yang_main_file(h)) != NULL){
-	if (yang_spec_parse_file(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* 2. Load a (single) main module */
-    if ((str = clicon_yang_module_main(h)) != NULL){
-	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
-				   yspec) < 0)
-	    goto done;
-    }
-    /* 3. Load all modules in a directory */
-    if ((str = clicon_yang_main_dir(h)) != NULL){
-	if (yang_spec_load_dir(h, str, yspec) < 0)
-	    goto done;
-    }
-    /* Load clixon lib yang module */
-    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
-	goto done;
-     /* Load yang module library, RFC7895 */
-    if (yang_modules_init(h) < 0)
+    /* Load Yang modules, from binary cache if valid, see CLICON_YANG_CACHE_DIR */
+    if (yang_cache_spec_load(h, "restconf", yspec, restconf_yang_load) < 0)
 	goto done;
 
-    /* Load yang restconf module */
-    if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
-	goto done;
-    
-    /* Add netconf yang spec, used as internal protocol */
-    if (netconf_module_load(h) < 0)
-	goto done;
-    
-    /* Add system modules */
-     if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
-	 yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
-	 goto done;
-     if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
-	 yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
-	 goto done;
-
      /* Here all modules are loaded 
       * Compute and set canonical namespace context
       */
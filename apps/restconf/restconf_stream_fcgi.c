@@ -483,10 +483,10 @@ api_stream(clicon_handle h,
 	    stream_timeout(0, req);
 	    /* Start loop */
 	    clixon_event_loop();
-	    close(s);
 	    clixon_event_unreg_fd(s, restconf_stream_cb);
 	    clixon_event_unreg_fd(rfcgi->listen_sock,
 				  restconf_stream_cb);
+	    close(s);
 	    clixon_event_unreg_timeout(stream_timeout, (void*)req);
 	    clicon_exit_reset();
 #ifdef STREAM_FORK
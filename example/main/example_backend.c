@@ -66,7 +66,7 @@
 #include <clixon/clixon_backend.h> 
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_EXAMPLE_OPTS "rsS:iuUt:v:"
+#define BACKEND_EXAMPLE_OPTS "rsS:ic:p:uUt:v:"
 
 /*! Variable to control if reset code is run.
  * The reset code inserts "extra XML" which assumes ietf-interfaces is
@@ -94,6 +94,11 @@ static char *_state_file = NULL;
 static int _state_file_init = 0;
 static cxobj *_state_xstate = NULL;
 
+/*! State path declared in ca_statedata_paths, state callback only called for it
+ * Start backend with -- -sp <path>, eg -sp /example:state
+ */
+static const char *_state_paths[] = {NULL, NULL};
+
 /*! Variable to control module-specific upgrade callbacks.
  * If set, call test-case for upgrading ietf-interfaces, otherwise call 
  * auto-upgrade
@@ -1025,7 +1030,7 @@ static clixon_plugin_api api = {
  * @param[in]  h    Clixon handle
  * @retval     NULL Error with clicon_err set
  * @retval     api  Pointer to API struct
- * In this example, you can pass -r, -s, -u to control the behaviour, mainly 
+ * In this example, you can pass -r, -s, -c, -u to control the behaviour, mainly 
  * for use in the test suites.
  */
 clixon_plugin_api *
@@ -1057,6 +1062,13 @@ clixon_plugin_init(clicon_handle h)
 	case 'i': /* read state file on init not by request (requires -sS <file> */
 	    _state_file_init = 1;
 	    break;
+	case 'c': /* cache state this many ms (requires -s) */
+	    api.ca_statedata_ttl = atoi(optarg);
+	    break;
+	case 'p': /* declare state path (requires -s) */
+	    _state_paths[0] = optarg;
+	    api.ca_statedata_paths = _state_paths;
+	    break;
        case 'u': /* module-specific upgrade */
            _module_upgrade = 1;
            break;
@@ -64,6 +64,14 @@
  */
 #define XPATH_LIST_OPTIMIZE
 
+/*! Number of parsed xpaths kept in the xpath cache
+ * Parsed xpath trees are cached on the xpath string and reused by xpath_first, xpath_vec,
+ * etc, and prepared xpaths. Least recently used trees are removed when the cache is full.
+ * Set to 0 to disable the cache.
+ * @see xpath_cache_size_set
+ */
+#define XPATH_CACHE_SIZE 128
+
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  * This also applies if there are multiple keys and you want to search on only the second for 
  * example.
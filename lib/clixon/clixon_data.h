@@ -118,6 +118,10 @@ int clicon_argv_set(clicon_handle h, char *argv0, int argc, char **argv);
 int clicon_session_id_set(clicon_handle h, uint32_t id);
 int clicon_session_id_get(clicon_handle h, uint32_t *id);
 
+/*! Set and get if backend accepted binary encoded replies in hello */
+int clicon_proto_binary_get(clicon_handle h);
+int clicon_proto_binary_set(clicon_handle h, int val);
+
 /* If set, quit startup directly after upgrade */
 int clicon_quit_upgrade_get(clicon_handle h);
 int clicon_quit_upgrade_set(clicon_handle h, int val);
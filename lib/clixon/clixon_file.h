@@ -43,4 +43,8 @@ int clicon_file_dirent(const char *dir, struct dirent **ent,
 
 int clicon_file_copy(char *src, char *target);
 
+int clicon_file_read(int fd, char **bufp, size_t *lenp);
+
+int clicon_file_write(int fd, char *buf, size_t len);
+
 #endif /* _CLIXON_FILE_H_ */
@@ -36,14 +36,15 @@
 #ifndef _CLIXON_HASH_H_
 #define _CLIXON_HASH_H_
 
+/* Hash table entry */
 struct clicon_hash {
-    qelem_t	h_qelem;
     char       *h_key;
     size_t	h_vlen;
     void       *h_val;
 };
 typedef struct clicon_hash *clicon_hash_t;
 
+uint64_t       clicon_hash_string(const char *str);
 clicon_hash_t *clicon_hash_init (void);
 int            clicon_hash_free (clicon_hash_t *);
 clicon_hash_t  clicon_hash_lookup (clicon_hash_t *head, const char *key);
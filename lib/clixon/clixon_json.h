@@ -45,8 +45,11 @@
  */
 int json2xml_decode(cxobj *x, cxobj **xerr);
 int xml2json_cbuf(cbuf *cb, cxobj *x, int pretty);
+int xml2json_cbuf_stream(cbuf *cb, cxobj *x, int pretty,
+			 size_t chunk, clicon_xml2cbuf_fn *fn, void *arg);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty);
 int xml2json(FILE *f, cxobj *x, int pretty);
+int xml2json_fd(int fd, cxobj *x, int pretty);
 int xml2json_cb(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn);
 int json_print(FILE *f, cxobj *x);
 int xml2json_vec(FILE *f, cxobj **vec, size_t veclen, int pretty);
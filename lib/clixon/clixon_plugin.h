@@ -152,6 +152,8 @@ typedef int (plgreset_t)(clicon_handle h, const char *db); /* Reset system statu
  * @param[in]  xtop   XML tree where statedata is added
  * @retval    -1      Fatal error
  * @retval     0      OK
+ * @note If ca_statedata_paths is set, the callback is only called if xpath may select
+ *       nodes in those paths, eg "/ex:top/ex:x" for "/example:top"
  */
 typedef int (plgstatedata_t)(clicon_handle h, cvec *nsc, char *xpath, cxobj *xtop);
 
@@ -231,6 +233,9 @@ struct clixon_plugin_api{
 	    trans_cb_t       *cb_trans_end;	 /* Transaction completed  */
     	    trans_cb_t       *cb_trans_abort;	 /* Transaction aborted */
 	    datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+	    uint32_t          cb_statedata_ttl;  /* Cache state data this many ms (0: no cache) */
+	    const char      **cb_statedata_paths; /* NULL-terminated vector of state paths, eg
+						     "/module:top", (NULL: all) */
 	} cau_backend;
     } u;
 };
@@ -251,6 +256,8 @@ struct clixon_plugin_api{
 #define ca_trans_end      u.cau_backend.cb_trans_end
 #define ca_trans_abort    u.cau_backend.cb_trans_abort
 #define ca_datastore_upgrade  u.cau_backend.cb_datastore_upgrade
+#define ca_statedata_ttl  u.cau_backend.cb_statedata_ttl
+#define ca_statedata_paths u.cau_backend.cb_statedata_paths
 
 /*
  * Macros
@@ -55,9 +55,19 @@ enum format_enum{
 struct clicon_msg {
     uint32_t    op_len;     /* length of message. network byte order. */
     uint32_t    op_id;      /* session-id. network byte order. */
+    uint32_t    op_reqid;   /* request-id, copied to reply. network byte order. */
+    uint32_t    op_flags;   /* CLICON_MSG_F_*. network byte order. */
     char        op_body[0]; /* rest of message, actual data */
 };
 
+/* Protocol message header flags (op_flags) */
+#define CLICON_MSG_F_MORE      0x01 /* Reply continues in next message, see clicon_msg_rcv */
+#define CLICON_MSG_F_BIN       0x02 /* Body is binary encoded XML, see clixon_xml_parse_bin */
+#define CLICON_MSG_F_BIN_REPLY 0x04 /* Request: client accepts a binary encoded reply */
+
+/* Capability in internal hello for binary encoded replies, see CLICON_SOCK_BINARY */
+#define CLIXON_PROTO_BINARY_CAPABILITY "http://clicon.org/proto/binary/1.0"
+
 /*
  * Prototypes
  */ 
@@ -73,6 +83,8 @@ int clicon_msg_decode(struct clicon_msg *msg, yang_stmt *yspec, uint32_t *id, cx
 
 int clicon_connect_unix(clicon_handle h, char *sockpath);
 
+int clicon_connect_inet(clicon_handle h, char *dst, uint16_t port);
+
 
 int clicon_rpc_connect_unix(clicon_handle         h,
 			    struct clicon_msg    *msg, 
@@ -91,11 +103,15 @@ int clicon_rpc(int s, struct clicon_msg *msg, char **xret);
 
 int clicon_msg_send(int s, struct clicon_msg *msg);
 
+int clicon_msg_rcv_frame(int s, struct clicon_msg **msg, int *eof);
+
+int clicon_msg_rcv_rest(int s, struct clicon_msg **msg, int *eof);
+
 int clicon_msg_rcv(int s, struct clicon_msg **msg, int *eof);
 
 int send_msg_notify_xml(clicon_handle h, int s, cxobj *xev);
 
-int send_msg_reply(int s, char *data, uint32_t datalen);
+int send_msg_reply(int s, uint32_t reqid, char *data, uint32_t datalen);
 
 int detect_endtag(char *tag, char  ch, int  *state);
 
@@ -42,10 +42,33 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+/*
+ * Types
+ */
+/* Called with each part of a reply body, see clicon_rpc_msg_stream
+ * @param[in]  data  Part of reply body (not null-terminated)
+ * @param[in]  len   Length of data
+ * @param[in]  last  Set if this is the last part of the reply
+ * @param[in]  arg   Argument given to clicon_rpc_msg_stream
+ * @retval     0     OK
+ * @retval    -1     Error, rest of reply is dropped
+ */
+typedef int (clicon_rpc_stream_cb)(char *data, size_t len, int last, void *arg);
+
+/*
+ * Prototypes
+ */
+int clicon_rpc_msg_close(clicon_handle h);
+int clicon_rpc_msg_send(clicon_handle h, struct clicon_msg *msg, uint32_t *reqid);
+int clicon_rpc_msg_rcv(clicon_handle h, uint32_t reqid, cxobj **xret0);
+int clicon_rpc_msg_stream(clicon_handle h, struct clicon_msg *msg,
+			  clicon_rpc_stream_cb *fn, void *arg);
 int clicon_rpc_msg(clicon_handle h, struct clicon_msg *msg, cxobj **xret0,
 		   int *sock0);
 int clicon_rpc_netconf(clicon_handle h, char *xmlst, cxobj **xret, int *sp);
 int clicon_rpc_netconf_xml(clicon_handle h, cxobj *xml, cxobj **xret, int *sp);
+int clicon_rpc_netconf_xml_stream(clicon_handle h, cxobj *xml,
+				  clicon_rpc_stream_cb *fn, void *arg);
 int clicon_rpc_get_config(clicon_handle h, char *username, char *db, char *xpath, cvec *nsc, cxobj **xret);
 int clicon_rpc_edit_config(clicon_handle h, char *db, enum operation_type op, 
 			   char *xml);
@@ -0,0 +1,65 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Delimiter search for the hand-written XML and JSON scanners, see configure
+  * --enable-xml-scanner. Uses SSE2 or AVX2 when available on the running cpu
+ */
+#ifndef _CLIXON_SCAN_H
+#define _CLIXON_SCAN_H
+
+/*
+ * Constants
+ */
+#define CLIXON_SCAN_MAXDELIM 8  /* Max nr of delimiters in a set */
+
+/*
+ * Types
+ */
+/*! A set of delimiter characters, prepared by clixon_scan_set_init */
+struct clixon_scan_set {
+    int           ss_n;                        /* Nr of delimiters */
+    unsigned char ss_c[CLIXON_SCAN_MAXDELIM];  /* Delimiters */
+    unsigned char ss_tab[256];                 /* 1 if char is a delimiter */
+};
+typedef struct clixon_scan_set clixon_scan_set;
+
+/*
+ * Prototypes
+ */
+int   clixon_scan_set_init(clixon_scan_set *ss, const char *delims);
+char *clixon_scan_delim(clixon_scan_set *ss, char *p, char *end);
+const char *clixon_scan_impl(void);
+int   clixon_scan_impl_set(const char *impl);
+
+#endif /* _CLIXON_SCAN_H */
@@ -63,26 +63,60 @@
  * @param[in]  h     Clicon handle
  * @param[in]  op    Operation: 0 OK, 1 Close
  * @param[in]  event Event as XML
+ * @param[in]  cbev  Event serialized as XML, shared by all subscriptions
  * @param[in]  arg   Extra argument provided in stream_ss_add
  * @see stream_ss_add
  */
-typedef	int (*stream_fn_t)(clicon_handle h, int op, cxobj *event, void *arg);
+typedef	int (*stream_fn_t)(clicon_handle h, int op, cxobj *event, cbuf *cbev, void *arg);
+
+/* Subscription filter, shared by subscriptions of a stream with same xpath
+ * The filter is evaluated once per event.
+ */
+struct stream_filter{
+    qelem_t                     sf_q;      /* queue header */
+    char                       *sf_xpath;  /* Filter selector as xpath */
+    struct xpath_tree          *sf_xpt;    /* Parsed xpath */
+    int                         sf_refcnt; /* Nr of subscriptions using filter */
+    uint64_t                    sf_event;  /* Event nr of sf_match */
+    int                         sf_match;  /* Filter matches event sf_event */
+};
 
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
     char                       *ss_xpath;  /* Filter selector as xpath */
+    struct stream_filter       *ss_filter; /* Filter or NULL if no xpath */
     struct timeval              ss_starttime; /* Replay starttime */
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
 };
 
-/* Replay time-series */
+/* Replay time index entry, location of one serialized event in replay buffer */
+struct stream_replay_ent{
+    struct timeval re_tv;   /* event time */
+    size_t         re_off;  /* offset of event in r_data */
+    size_t         re_len;  /* length of event (no NUL) */
+};
+
+/* Replay store of serialized events in time order
+ * Events are stored in a ring buffer r_data, oldest are dropped when a size or
+ * count limit is reached. The index r_ent is a ring of entries sorted by time.
+ * If r_fd is set, r_data is a memory-mapped segment file.
+ * @see stream_replay_add
+ */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
-    struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    struct stream_replay_ent *r_ent; /* ring of index entries */
+    size_t          r_entmax;  /* allocated entries in r_ent */
+    size_t          r_first;   /* oldest entry in r_ent */
+    size_t          r_nr;      /* number of entries */
+    char           *r_data;    /* ring buffer of serialized events */
+    size_t          r_datalen; /* allocated length of r_data */
+    size_t          r_head;    /* offset in r_data after newest event */
+    size_t          r_maxsize; /* max length of r_data, 0 is no limit */
+    size_t          r_maxnr;   /* max number of events, 0 is no limit */
+    char           *r_file;    /* segment file or NULL */
+    int             r_fd;      /* segment file descriptor or -1 */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -92,9 +126,11 @@ struct event_stream{
     char                *es_name; /* name of notification event stream */
     char                *es_description;
     struct stream_subscription *es_subscription;
+    struct stream_filter *es_filters; /* filters of subscriptions */
+    uint64_t             es_event;  /* event counter */
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
+    struct stream_replay *es_replay; /* replay store if replay enabled */
 
 };
 typedef struct event_stream event_stream_t;
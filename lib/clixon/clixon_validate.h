@@ -46,5 +46,10 @@ int xml_yang_validate_add(clicon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_list_key_only(clicon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_all(clicon_handle h, cxobj *xt, cxobj **xret);
 int xml_yang_validate_all_top(clicon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_bind(clicon_handle h, cxobj *xt, cxobj **xret);
+int xml_yang_validate_diff(clicon_handle h, cxobj *xt, cxobj **dvec, int dlen,
+			   cxobj **avec, int alen, cxobj **scvec, cxobj **tcvec, int clen,
+			   cxobj **xret);
+int xml_yang_validate_deps_free(clicon_handle h);
 
 #endif  /* _CLIXON_VALIDATE_H_ */
@@ -147,6 +147,7 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 #define XML_FLAG_CHANGE  0x08  /* Node is changed (commits) or child changed rec */
 #define XML_FLAG_NONE    0x10  /* Node is added as NONE */
 #define XML_FLAG_DEFAULT 0x20  /* Added when a value is set as default @see xml_default */
+/* Flags 0x2000-0x8000 are reserved for internal use */
 
 /*
  * Prototypes
@@ -154,6 +155,10 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 char     *xml_type2str(enum cxobj_type type);
 int       xml_stats_global(uint64_t *nr);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
+int       xml_stats_arena(uint64_t *nrp, size_t *szp);
+int       xml_arena_enable(int enable);
+int       xml_arena_begin(void);
+int       xml_arena_end(void);
 char     *xml_name(cxobj *xn);
 int       xml_name_set(cxobj *xn, char *name);
 char     *xml_prefix(cxobj *xn);
@@ -247,6 +252,7 @@ int       xml_search_index_p(cxobj *x);
 
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
+int       xml_search_child_insert_vec(cxobj *xpp, cxobj **xvec, int xlen);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
@@ -0,0 +1,58 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Compact binary encoding of XML trees, see clixon_xml_bin.c
+ */
+#ifndef _CLIXON_XML_BIN_H_
+#define _CLIXON_XML_BIN_H_
+
+/*
+ * Types
+ */
+typedef struct xml_bin_enc xml_bin_enc; /* struct defined in clixon_xml_bin.c */
+
+/*
+ * Prototypes
+ */
+xml_bin_enc *clixon_xml_bin_new(cbuf *cb, size_t chunk, clicon_xml2cbuf_fn *fn, void *arg);
+int clixon_xml_bin_free(xml_bin_enc *be);
+int clixon_xml_bin_start(xml_bin_enc *be, char *prefix, char *name);
+int clixon_xml_bin_attr(xml_bin_enc *be, char *prefix, char *name, char *value);
+int clixon_xml_bin_body(xml_bin_enc *be, char *value);
+int clixon_xml_bin_end(xml_bin_enc *be);
+int clixon_xml_bin_tree(xml_bin_enc *be, cxobj *x, int32_t depth);
+int clixon_xml2bin(cbuf *cb, cxobj *x, int32_t depth);
+int clixon_xml_parse_bin(const char *buf, size_t len, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
+
+#endif /* _CLIXON_XML_BIN_H_ */
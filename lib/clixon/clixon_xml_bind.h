@@ -48,5 +48,7 @@ int xml_bind_yang_rpc(cxobj *xrpc, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang_rpc_reply(cxobj *xrpc, char *name, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang0(cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang(cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_node(cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj *xsibling, cxobj **xerr);
+int xml_bind_yang_end(cxobj *xt);
 
 #endif  /* _CLIXON_XML_BIND_H_ */
@@ -40,13 +40,22 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/* Consume (and reset) a buffer of serialized XML, see clicon_xml2cbuf_stream */
+typedef int (clicon_xml2cbuf_fn)(cbuf *cb, void *arg);
+
 /*
  * Prototypes
  */
 int clicon_xml2file_cb(FILE *f, cxobj *x, int level, int prettyprint, clicon_output_cb *fn);
 int clicon_xml2file(FILE *f, cxobj *x, int level, int prettyprint);
+int clicon_xml2fd(int fd, cxobj *x, int level, int prettyprint);
 int xml_print(FILE *f, cxobj *xn);
 int clicon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth);
+int clicon_xml2cbuf_stream(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth,
+			   size_t chunk, clicon_xml2cbuf_fn *fn, void *arg);
 char *clicon_xml2str(cxobj *x);
 int xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 
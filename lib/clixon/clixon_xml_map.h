@@ -61,6 +61,7 @@ int xml_diff(yang_stmt *yspec, cxobj *x0, cxobj *x1,
 	     cxobj ***first, int *firstlen, 
 	     cxobj ***second, int *secondlen, 
 	     cxobj ***changed_x0, cxobj ***changed_x1, int *changedlen);
+int xml_tree_sync(cxobj *x0, cxobj *x1);
 int xml_tree_prune_flagged_sub(cxobj *xt, int flag, int test, int *upmark);
 int xml_tree_prune_flagged(cxobj *xt, int flag, int test);
 int xml_namespace_change(cxobj *x, char *ns, char *prefix);
@@ -99,6 +99,7 @@ enum xp_type{
     XP_PRIME_NR,
     XP_PRIME_STR,
     XP_PRIME_FN,
+    XP_PRIME_VAR, /* s0 is variable name, bound at eval time */
 };
 
 /*! XPATH Parsing generates a tree of nodes that is later traversed
@@ -111,7 +112,7 @@ struct xpath_tree{
     int                xs_int;    /* step-> axis_type */
     double             xs_double; /* set if XP_PRIME_NR */
     char              *xs_strnr;  /* original string xs_double: numeric value */
-    char              *xs_s0;     /* set if XP_PRIME_STR, XP_PRIME_FN, XP_NODE[_FN] prefix*/
+    char              *xs_s0;     /* set if XP_PRIME_STR, XP_PRIME_FN, XP_PRIME_VAR, XP_NODE[_FN] prefix*/
     char              *xs_s1;     /* set if XP_NODE NAME */
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
@@ -119,6 +120,9 @@ struct xpath_tree{
 };
 typedef struct xpath_tree xpath_tree;
 
+/* Prepared xpath, parsed once and evaluated many times, see xpath_prepare */
+typedef struct xpath_prepared xpath_prepared;
+
 /*
  * Prototypes
  */
@@ -132,6 +136,18 @@ xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
+int   xpath_tree_ctx(cxobj *xcur, cvec *nsc, xpath_tree *xptree, int localonly, xp_ctx  **xrp);
+int   xpath_prepare(const char *xpath, xpath_prepared **xpp);
+int   xpath_prepared_free(xpath_prepared *xp);
+xpath_tree *xpath_prepared_tree(xpath_prepared *xp);
+int   xpath_prepared_ctx(cxobj *xcur, cvec *nsc, xpath_prepared *xp, cvec *vars, int localonly, xp_ctx **xrp);
+int   xpath_prepared_vec(cxobj *xcur, cvec *nsc, xpath_prepared *xp, cvec *vars, cxobj ***vec, size_t *veclen);
+cxobj *xpath_prepared_first(cxobj *xcur, cvec *nsc, xpath_prepared *xp, cvec *vars);
+int   xpath_prepared_bool(cxobj *xcur, cvec *nsc, xpath_prepared *xp, cvec *vars);
+int   xpath_cache_size_set(int size);
+int   xpath_cache_stats(uint64_t *hits, uint64_t *misses, int *nr);
+int   xpath_cache_print(FILE *f);
+void  xpath_cache_exit(void);
 
 #if defined(__GNUC__) && __GNUC__ >= 3
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
@@ -712,6 +712,38 @@ clicon_session_id_set(clicon_handle h,
     return 0;
 }
 
+/*! Get binary reply flag of client
+ * @param[in]  h    Clicon handle
+ * @retval     1    Backend accepted binary encoded replies in hello, see CLICON_SOCK_BINARY
+ * @retval     0    Replies are XML text
+ */
+int
+clicon_proto_binary_get(clicon_handle h)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    void           *p;
+
+    if ((p = clicon_hash_value(cdat, "proto-binary", NULL)) == NULL)
+	return 0;
+    return *(int*)p;
+}
+
+/*! Set binary reply flag of client
+ * @param[in]  h    Clicon handle
+ * @param[in]  val  Set or reset flag
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clicon_proto_binary_set(clicon_handle h, 
+			int           val)
+{
+    clicon_hash_t  *cdat = clicon_data(h);
+
+    clicon_hash_add(cdat, "proto-binary", &val, sizeof(int));
+    return 0;
+}
+
 /*! Get quit-after-upgrade flag
  * @param[in]  h    Clicon handle
  * @retval     1    Flag set: quit startup directly after upgrade
@@ -73,9 +73,11 @@
 #include "clixon_plugin.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
+#include "clixon_xml_map.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
 
 
 /*! Translate from symbolic database name to actual filename in file-system
@@ -169,6 +171,7 @@ xmldb_disconnect(clicon_handle h)
 		de->de_xml = NULL;
 	    }
 	}
+    xmldb_journal_exit();
     retval = 0;
  done:
     if (keys)
@@ -176,7 +179,88 @@ xmldb_disconnect(clicon_handle h)
     return retval;
 }
 
+/*! Replace a datastore file with a copy of another file
+ *
+ * The copy is written to a temporary file which is then renamed to the target,
+ * so that the target is never seen partially written, neither by readers nor
+ * after a crash.
+ * @param[in]  fromfile  Source file
+ * @param[in]  tofile    Target file, replaced
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note The file is copied, not linked: datastore files are also modified in place,
+ *       eg truncated by xmldb_delete, which would then modify both datastores.
+ * @see clicon_file_copy  which copies in-place
+ */
+static int
+xmldb_file_swap(char *fromfile,
+		char *tofile)
+{
+    int         retval = -1;
+    char       *tmpfile = NULL;
+    int         inF = -1;
+    int         ouF = -1;
+    char        buf[BUFSIZ*8];
+    ssize_t     bytes;
+    struct stat st;
+
+    if ((tmpfile = malloc(strlen(tofile) + 5)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    sprintf(tmpfile, "%s.tmp", tofile);
+    if ((inF = open(fromfile, O_RDONLY)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s) for read", fromfile);
+	goto done;
+    }
+    if (fstat(inF, &st) < 0){
+	clicon_err(OE_UNIX, errno, "stat(%s)", fromfile);
+	goto done;
+    }
+    if ((ouF = open(tmpfile, O_WRONLY|O_CREAT|O_TRUNC, st.st_mode)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s) for write", tmpfile);
+	goto done;
+    }
+    while ((bytes = read(inF, buf, sizeof(buf))) != 0){
+	if (bytes < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "read(%s)", fromfile);
+	    goto done;
+	}
+	if (write(ouF, buf, bytes) != bytes){
+	    clicon_err(OE_UNIX, errno, "write(%s)", tmpfile);
+	    goto done;
+	}
+    }
+    if (fsync(ouF) < 0){
+	clicon_err(OE_UNIX, errno, "fsync(%s)", tmpfile);
+	goto done;
+    }
+    if (rename(tmpfile, tofile) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s)", tmpfile);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (inF != -1)
+	close(inF);
+    if (ouF != -1)
+	close(ouF);
+    if (retval < 0 && tmpfile)
+	unlink(tmpfile);
+    if (tmpfile)
+	free(tmpfile);
+    return retval;
+}
+
 /*! Copy database from db1 to db2
+ *
+ * If both databases are cached, the cache of the target is synced with the
+ * source so that only the nodes that differ are freed or copied. A commit of a
+ * few changes in a large candidate is thereby proportional to the changes, not
+ * to the size of the configuration.
+ * The file is copied to a temporary file and renamed, ie atomically replaced.
  * @param[in]  h     Clicon handle
  * @param[in]  from  Source database
  * @param[in]  to    Destination database
@@ -218,11 +302,8 @@ xmldb_copy(clicon_handle h,
 	    if (xml_copy(x1, x2) < 0) 
 		goto done;
 	}
-	else{ /* copy x1 to x2 */
-	    xml_free(x2);
-	    if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-		goto done;
-	    if (xml_copy(x1, x2) < 0) 
+	else{ /* sync x2 with x1: only change what differs */
+	    if (xml_tree_sync(x1, x2) < 0) 
 		goto done;
 	}
 	/* always set cache although not strictly necessary in case 1
@@ -238,7 +319,10 @@ xmldb_copy(clicon_handle h,
 	goto done;
     if (xmldb_db2file(h, to, &tofile) < 0)
 	goto done;
-    if (clicon_file_copy(fromfile, tofile) < 0)
+    if (xmldb_file_swap(fromfile, tofile) < 0)
+	goto done;
+    /* Copy journal after file, the journal refers to the file it is written on */
+    if (xmldb_journal_copy(h, from, to) < 0)
 	goto done;
     retval = 0;
  done:
@@ -416,6 +500,8 @@ xmldb_delete(clicon_handle h,
 	    clicon_err(OE_DB, errno, "truncate %s", filename);
 	    goto done;
 	}
+    if (xmldb_journal_remove(h, db) < 0)
+	goto done;
     retval = 0;
  done:
     if (filename)
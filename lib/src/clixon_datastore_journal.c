@@ -0,0 +1,673 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Datastore journal, see CLICON_XMLDB_JOURNAL
+ * Instead of rewriting the whole datastore file <db>_db on every xmldb_put, the edit
+ * is appended to a journal file <db>_db.journal. The journal is replayed on top of
+ * the datastore file when read. When the journal grows larger than the datastore
+ * file, a new datastore file is written (and atomically renamed) and the journal
+ * is removed.
+ * Journal file format:
+ *   clixon-journal <version> <inode> <size>\n    Header: datastore file journal is written on
+ *   <op> <len>\n<xml>\n                         One record per edit, xml is <len> bytes
+ *   ...
+ * A journal whose header does not match the current datastore file is stale, eg a crash
+ * between renaming a new datastore file and removing the journal, and is ignored.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_string.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_yang_module.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_xml_io.h"
+#include "clixon_file.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_write.h"
+#include "clixon_datastore_journal.h"
+
+/*
+ * Constants
+ */
+#define JOURNAL_MAGIC   "clixon-journal"
+#define JOURNAL_VERSION 1
+
+/*
+ * Types
+ */
+/* Bad record found when replaying a journal, eg a record truncated by a crash.
+ * Replay only stops at a bad record. The journal is repaired (truncated) by the next
+ * append in the same process, since only the process writing the journal (the backend)
+ * appends to it. Readers, eg forked read workers, never modify the journal: what looks
+ * like a truncated record to them may be a record that is being appended.
+ */
+struct journal_bad{
+    ino_t  jb_ino;   /* Journal inode when replayed */
+    off_t  jb_size;  /* Journal size when replayed */
+    off_t  jb_off;   /* Offset of first bad record */
+};
+
+/*
+ * Variables
+ */
+/* Bad records indexed by journal filename, see struct journal_bad */
+static clicon_hash_t *_journal_bad = NULL;
+
+/* Set if a journal file has been read, which may remain when CLICON_XMLDB_JOURNAL
+ * is disabled, see xmldb_journal_remove */
+static int _journal_found = 0;
+
+/*! Translate from symbolic database name to datastore and journal filenames
+ * @param[in]   h       Clicon handle
+ * @param[in]   db      Symbolic database name, eg "candidate", "running"
+ * @param[out]  dbfile  Datastore filename. Unallocate after use with free()
+ * @param[out]  jfile   Journal filename. Unallocate after use with free()
+ * @retval      0       OK
+ * @retval     -1       Error
+ */
+static int
+journal_files(clicon_handle h,
+	      const char   *db,
+	      char        **dbfile,
+	      char        **jfile)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if (xmldb_db2file(h, db, dbfile) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s.journal", *dbfile);
+    if ((*jfile = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Check that a journal header matches the datastore file
+ * @param[in]  buf   Journal contents, null-terminated
+ * @param[in]  st    Stat of datastore file
+ * @param[out] hlen  Length of header line including newline
+ * @retval     1     Header matches datastore file
+ * @retval     0     No or bad header, or header of another datastore file (stale)
+ */
+static int
+journal_header_check(char        *buf,
+		     struct stat *st,
+		     size_t      *hlen)
+{
+    char     *nl;
+    char      magic[32];
+    int       version;
+    uintmax_t ino;
+    intmax_t  size;
+
+    if ((nl = strchr(buf, '\n')) == NULL)
+	return 0;
+    if (sscanf(buf, "%31s %d %ju %jd", magic, &version, &ino, &size) != 4)
+	return 0;
+    if (strcmp(magic, JOURNAL_MAGIC) != 0 || version != JOURNAL_VERSION)
+	return 0;
+    if (ino != (uintmax_t)st->st_ino || size != (intmax_t)st->st_size)
+	return 0;
+    *hlen = nl - buf + 1;
+    return 1;
+}
+
+/*! Read a journal file into a malloced null-terminated buffer
+ * @param[in]  jfile  Journal filename
+ * @param[out] bufp   Journal contents. Free with free()
+ * @param[out] lenp   Length of journal
+ * @param[out] inop   Inode of journal (or NULL)
+ * @retval     1      OK
+ * @retval     0      No journal file
+ * @retval    -1      Error
+ */
+static int
+journal_read(char   *jfile,
+	     char  **bufp,
+	     size_t *lenp,
+	     ino_t  *inop)
+{
+    int         retval = -1;
+    int         fd = -1;
+    struct stat st;
+    char       *buf = NULL;
+    size_t      len = 0;
+    ssize_t     n;
+
+    if ((fd = open(jfile, O_RDONLY)) < 0){
+	if (errno == ENOENT){
+	    retval = 0;
+	    goto done;
+	}
+	clicon_err(OE_UNIX, errno, "open(%s)", jfile);
+	goto done;
+    }
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", jfile);
+	goto done;
+    }
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    while (len < st.st_size){
+	if ((n = read(fd, buf+len, st.st_size-len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "read(%s)", jfile);
+	    goto done;
+	}
+	if (n == 0)
+	    break;
+	len += n;
+    }
+    buf[len] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    *lenp = len;
+    if (inop)
+	*inop = st.st_ino;
+    _journal_found = 1;
+    retval = 1;
+ done:
+    if (buf)
+	free(buf);
+    if (fd != -1)
+	close(fd);
+    return retval;
+}
+
+/*! Register, or clear, a bad record found when replaying a journal
+ * @param[in]  jfile  Journal filename
+ * @param[in]  jb     Bad record, or NULL to clear
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see struct journal_bad
+ */
+static int
+journal_bad_set(char               *jfile,
+		struct journal_bad *jb)
+{
+    if (jb == NULL){
+	if (_journal_bad && clicon_hash_lookup(_journal_bad, jfile) != NULL)
+	    clicon_hash_del(_journal_bad, jfile);
+	return 0;
+    }
+    if (_journal_bad == NULL &&
+	(_journal_bad = clicon_hash_init()) == NULL)
+	return -1;
+    if (clicon_hash_add(_journal_bad, jfile, jb, sizeof(*jb)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Free bad record registry of journals
+ */
+int
+xmldb_journal_exit(void)
+{
+    if (_journal_bad){
+	clicon_hash_free(_journal_bad);
+	_journal_bad = NULL;
+    }
+    return 0;
+}
+
+/*! Serialize a modification tree into a journal record
+ * Namespace declarations in scope of x1 (eg from an enclosing edit-config) are added
+ * to the top-level of the record, so that the record can be parsed stand-alone.
+ * @param[in]  cb   Cligen buffer to append record to
+ * @param[in]  op   Top-level operation
+ * @param[in]  x1   Modification tree, top-level symbol is "config"
+ */
+static int
+journal_record(cbuf               *cb,
+	       enum operation_type op,
+	       cxobj              *x1)
+{
+    int     retval = -1;
+    cxobj  *xd = NULL;
+    cvec   *nsc = NULL;
+    cg_var *cv = NULL;
+    char   *prefix;
+    cbuf   *cbx = NULL;
+
+    if ((xd = xml_dup(x1)) == NULL)
+	goto done;
+    if (xml_nsctx_node(x1, &nsc) < 0)
+	goto done;
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+	prefix = cv_name_get(cv);
+	if (prefix == NULL){
+	    if (xml_find_type(xd, NULL, "xmlns", CX_ATTR) != NULL)
+		continue;
+	}
+	else if (xml_find_type(xd, "xmlns", prefix, CX_ATTR) != NULL)
+	    continue;
+	if (xmlns_set(xd, prefix, cv_string_get(cv)) < 0)
+	    goto done;
+    }
+    if ((cbx = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cbx, xd, 0, 0, -1) < 0)
+	goto done;
+    cprintf(cb, "%s %d\n%s\n", xml_operation2str(op), cbuf_len(cbx), cbuf_get(cbx));
+    retval = 0;
+ done:
+    if (cbx)
+	cbuf_free(cbx);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (xd)
+	xml_free(xd);
+    return retval;
+}
+
+/*! Append an edit to the journal of a datastore
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Symbolic database name, eg "candidate", "running"
+ * @param[in]  op   Top-level operation, can be superceded by other op in tree
+ * @param[in]  x1   Modification tree, top-level symbol is "config"
+ * @retval     1    OK, edit appended to journal
+ * @retval     0    Not appended, caller should write a new datastore file (compact)
+ * @retval    -1    Error
+ * The edit is not appended if there is no datastore file, or if the journal would
+ * become larger than the datastore file. This bounds replay time and makes the
+ * amortized write cost proportional to the size of the edit.
+ */
+int
+xmldb_journal_append(clicon_handle       h,
+		     const char         *db,
+		     enum operation_type op,
+		     cxobj              *x1)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    char       *jfile = NULL;
+    struct stat st;         /* datastore file */
+    struct stat jst;        /* journal file */
+    int         fd = -1;
+    char        hdr[128];
+    ssize_t     n;
+    size_t      hlen;
+    cbuf       *cb = NULL;
+    struct journal_bad *jb;
+
+    if (journal_files(h, db, &dbfile, &jfile) < 0)
+	goto done;
+    if (stat(dbfile, &st) < 0){
+	if (errno == ENOENT)
+	    goto compact;
+	clicon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((fd = open(jfile, O_RDWR|O_CREAT, S_IRWXU)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", jfile);
+	goto done;
+    }
+    if (fstat(fd, &jst) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", jfile);
+	goto done;
+    }
+    /* Repair journal if this process found a bad record in it, unless it changed since */
+    if (_journal_bad &&
+	(jb = clicon_hash_value(_journal_bad, jfile, NULL)) != NULL){
+	if (jb->jb_ino == jst.st_ino && jb->jb_size == jst.st_size){
+	    clicon_log(LOG_WARNING, "%s: %s: truncated at bad record, offset %jd",
+		       __FUNCTION__, jfile, (intmax_t)jb->jb_off);
+	    if (ftruncate(fd, jb->jb_off) < 0){
+		clicon_err(OE_UNIX, errno, "ftruncate(%s)", jfile);
+		goto done;
+	    }
+	    jst.st_size = jb->jb_off;
+	}
+	if (journal_bad_set(jfile, NULL) < 0)
+	    goto done;
+    }
+    if (jst.st_size > 0){
+	if ((n = pread(fd, hdr, sizeof(hdr)-1, 0)) < 0){
+	    clicon_err(OE_UNIX, errno, "pread(%s)", jfile);
+	    goto done;
+	}
+	hdr[n] = '\0';
+	if (journal_header_check(hdr, &st, &hlen) == 0)
+	    jst.st_size = 0; /* Stale journal, restart it */
+    }
+    if (jst.st_size == 0){
+	if (ftruncate(fd, 0) < 0){
+	    clicon_err(OE_UNIX, errno, "ftruncate(%s)", jfile);
+	    goto done;
+	}
+	cprintf(cb, "%s %d %ju %jd\n", JOURNAL_MAGIC, JOURNAL_VERSION,
+		(uintmax_t)st.st_ino, (intmax_t)st.st_size);
+    }
+    if (journal_record(cb, op, x1) < 0)
+	goto done;
+    if (jst.st_size + cbuf_len(cb) > st.st_size)
+	goto compact;
+    if (lseek(fd, 0, SEEK_END) < 0){
+	clicon_err(OE_UNIX, errno, "lseek(%s)", jfile);
+	goto done;
+    }
+    if (clicon_file_write(fd, cbuf_get(cb), cbuf_len(cb)) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (cb)
+	cbuf_free(cb);
+    if (dbfile)
+	free(dbfile);
+    if (jfile)
+	free(jfile);
+    return retval;
+ compact:
+    retval = 0;
+    goto done;
+}
+
+/*! Replay the journal of a datastore on top of the tree read from its datastore file
+ *
+ * Records are applied in order without NACM checks, they were checked when written.
+ * A stale journal is ignored. Replay stops at the first truncated or bad record (eg
+ * after a crash while appending, or a record being appended by another process).
+ * The journal is not modified here, since this is the read path and may run in a
+ * read worker. Instead the bad record is registered, and the next append in this
+ * process truncates the journal there, so that appends are not hidden behind it.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  xt     XML tree read from datastore file, top-level symbol is "config"
+ * @param[in]  st     Stat of datastore file xt was read from, taken before reading it
+ * @retval     n      Number of records replayed (0 if no journal)
+ * @retval    -1      Error
+ * @note The datastore file may be replaced (compacted) after it was read, in which
+ *       case the journal does not match st. The caller needs to check that and read
+ *       the datastore file again.
+ */
+int
+xmldb_journal_replay(clicon_handle h,
+		     const char   *db,
+		     yang_stmt    *yspec,
+		     cxobj        *xt,
+		     struct stat  *st)
+{
+    int                 retval = -1;
+    char               *dbfile = NULL;
+    char               *jfile = NULL;
+    char               *buf = NULL;
+    size_t              len;
+    size_t              off;
+    size_t              reclen;
+    char               *p;
+    char                opstr[16];
+    enum operation_type op;
+    cxobj              *x1 = NULL;
+    cbuf               *cbret = NULL;
+    int                 nr = 0;
+    int                 ret;
+    ino_t               ino;
+    struct journal_bad  jb;
+
+    if (journal_files(h, db, &dbfile, &jfile) < 0)
+	goto done;
+    if ((ret = journal_read(jfile, &buf, &len, &ino)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    if (journal_header_check(buf, st, &off) == 0){
+	clicon_debug(1, "%s: stale journal %s ignored", __FUNCTION__, jfile);
+	goto ok;
+    }
+    if ((cbret = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    while (off < len){
+	/* Record header: "<op> <len>\n" */
+	if ((p = strchr(buf+off, '\n')) == NULL)
+	    break;
+	*p++ = '\0';
+	if (sscanf(buf+off, "%15s %zu", opstr, &reclen) != 2 ||
+	    xml_operation(opstr, &op) < 0)
+	    break;
+	if (reclen >= len - (p-buf) || p[reclen] != '\n')
+	    break; /* truncated */
+	p[reclen] = '\0';
+	if ((ret = clixon_xml_parse_string(p, YB_MODULE, yspec, &x1, NULL)) < 0)
+	    break;
+	if (ret == 0 || xml_child_nr_type(x1, CX_ELMNT) != 1 ||
+	    xml_rootchild(x1, 0, &x1) < 0)
+	    break;
+	cbuf_reset(cbret);
+	if ((ret = xmldb_modify(h, xt, op, x1, yspec, NULL, NULL, 1, cbret)) < 0)
+	    goto done;
+	if (ret == 0){
+	    clicon_log(LOG_WARNING, "%s: %s: record %d not applied: %s",
+		       __FUNCTION__, jfile, nr, cbuf_get(cbret));
+	    break;
+	}
+	xml_free(x1);
+	x1 = NULL;
+	nr++;
+	off = (p - buf) + reclen + 1;
+    }
+    if (off < len){
+	clicon_log(LOG_WARNING, "%s: %s: bad record after %d records",
+		   __FUNCTION__, jfile, nr);
+	jb.jb_ino = ino;
+	jb.jb_size = len;
+	jb.jb_off = off;
+	if (journal_bad_set(jfile, &jb) < 0)
+	    goto done;
+    }
+    else if (journal_bad_set(jfile, NULL) < 0)
+	goto done;
+ ok:
+    retval = nr;
+ done:
+    if (x1)
+	xml_free(x1);
+    if (cbret)
+	cbuf_free(cbret);
+    if (buf)
+	free(buf);
+    if (dbfile)
+	free(dbfile);
+    if (jfile)
+	free(jfile);
+    return retval;
+}
+
+/*! Copy the journal of one datastore to another
+ * The datastore file itself must already have been copied, since the new journal
+ * header refers to the target datastore file.
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_journal_copy(clicon_handle h,
+		   const char   *from,
+		   const char   *to)
+{
+    int         retval = -1;
+    char       *fromdb = NULL;
+    char       *fromj = NULL;
+    char       *todb = NULL;
+    char       *toj = NULL;
+    struct stat st;
+    char       *buf = NULL;
+    size_t      len;
+    size_t      hlen;
+    int         fd = -1;
+    cbuf       *cb = NULL;
+    int         ret;
+
+    if (xmldb_journal_remove(h, to) < 0)
+	goto done;
+    if (journal_files(h, from, &fromdb, &fromj) < 0)
+	goto done;
+    if ((ret = journal_read(fromj, &buf, &len, NULL)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    if (stat(fromdb, &st) < 0){
+	clicon_err(OE_UNIX, errno, "stat(%s)", fromdb);
+	goto done;
+    }
+    if (journal_header_check(buf, &st, &hlen) == 0)
+	goto ok;
+    if (journal_files(h, to, &todb, &toj) < 0)
+	goto done;
+    if (stat(todb, &st) < 0){
+	clicon_err(OE_UNIX, errno, "stat(%s)", todb);
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s %d %ju %jd\n", JOURNAL_MAGIC, JOURNAL_VERSION,
+	    (uintmax_t)st.st_ino, (intmax_t)st.st_size);
+    if ((fd = open(toj, O_WRONLY|O_CREAT|O_TRUNC, S_IRWXU)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", toj);
+	goto done;
+    }
+    if (clicon_file_write(fd, cbuf_get(cb), cbuf_len(cb)) < 0)
+	goto done;
+    if (clicon_file_write(fd, buf+hlen, len-hlen) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (cb)
+	cbuf_free(cb);
+    if (buf)
+	free(buf);
+    if (fromdb)
+	free(fromdb);
+    if (fromj)
+	free(fromj);
+    if (todb)
+	free(todb);
+    if (toj)
+	free(toj);
+    return retval;
+}
+
+/*! Remove the journal of a datastore, if any
+ * If journals are disabled, this is a no-op unless a journal has been read by this
+ * process, eg written before CLICON_XMLDB_JOURNAL was disabled.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Symbolic database name, eg "candidate", "running"
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_journal_remove(clicon_handle h,
+		     const char   *db)
+{
+    int   retval = -1;
+    char *dbfile = NULL;
+    char *jfile = NULL;
+
+    if (!_journal_found && !clicon_option_bool(h, "CLICON_XMLDB_JOURNAL"))
+	goto ok;
+    if (journal_files(h, db, &dbfile, &jfile) < 0)
+	goto done;
+    if (unlink(jfile) < 0 && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+	goto done;
+    }
+    if (journal_bad_set(jfile, NULL) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (dbfile)
+	free(dbfile);
+    if (jfile)
+	free(jfile);
+    return retval;
+}
@@ -70,17 +70,18 @@
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xml_io.h"
 #include "clixon_json.h"
 #include "clixon_nacm.h"
 #include "clixon_path.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_yang_module.h"
 #include "clixon_xml_map.h"
-#include "clixon_xml_io.h"
 #include "clixon_xml_nsctx.h"
 
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -429,6 +430,8 @@ xmldb_readfile(clicon_handle    h,
     int        fd = -1;
     char      *format;
     int        ret;
+    struct stat st;
+    struct stat st1;
     
     if (xmldb_db2file(h, db, &dbfile) < 0)
 	goto done;
@@ -441,10 +444,15 @@ xmldb_readfile(clicon_handle    h,
 	goto done;
     }
     /* Parse file into internal XML tree from different formats */
+ again:
     if ((fd = open(dbfile, O_RDONLY)) < 0) {
 	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
 	goto done;
     }    
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", dbfile);
+	goto done;
+    }
     if (strcmp(format, "json")==0){
 	if ((ret = clixon_json_parse_file(fd, yb, yspec, &x0, NULL)) < 0) /* XXX: ret == 0*/
 	    goto done;
@@ -477,6 +485,36 @@ xmldb_readfile(clicon_handle    h,
      */
     if (text_read_modstate(h, yspec, x0, msdiff) < 0)
 	goto done;
+    /* Apply edits appended to the journal since the file was written */
+    if ((ret = xmldb_journal_replay(h, db, yspec, x0, &st)) < 0)
+	goto done;
+    /* If the datastore file was replaced (compacted) while reading it and its journal,
+     * the journal may not belong to what was read: read again */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL")){
+	if (stat(dbfile, &st1) < 0){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+	    goto done;
+	}
+	if (st1.st_ino != st.st_ino || st1.st_size != st.st_size){
+	    clicon_debug(1, "%s: %s replaced while read, read again", __FUNCTION__, dbfile);
+	    xml_free(x0);
+	    x0 = NULL;
+	    close(fd);
+	    fd = -1;
+	    if (de)
+		de->de_empty = 0;
+	    if (msdiff){ /* Set by text_read_modstate */
+		if (msdiff->md_set_id)
+		    free(msdiff->md_set_id);
+		if (msdiff->md_diff)
+		    xml_free(msdiff->md_diff);
+		memset(msdiff, 0, sizeof(*msdiff));
+	    }
+	    goto again;
+	}
+    }
+    if (ret > 0 && de)
+	de->de_empty = (xml_child_nr(x0) == 0);
     if (xp){
 	*xp = x0;
 	x0 = NULL;
@@ -65,22 +65,24 @@
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xml_io.h"
 #include "clixon_json.h"
 #include "clixon_nacm.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_yang_type.h"
 #include "clixon_yang_module.h"
 #include "clixon_xml_nsctx.h"
-#include "clixon_xml_io.h"
 #include "clixon_xml_map.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_journal.h"
 
 /*! Given an attribute name and its expected namespace, find its value
  * 
@@ -214,6 +216,8 @@ check_body_namespace(cxobj     *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  xadd     If set, a new x0 not ordered-by user is added to xadd instead of
+ *                      inserted in x0p. The caller inserts them with xml_insert_vec
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval    -1        Error
  * @retval     0        Failed (cbret set)
@@ -237,6 +241,7 @@ text_modify(clicon_handle       h,
 	    char               *username,
 	    cxobj              *xnacm,
 	    int                 permit,
+	    clixon_xvec        *xadd,
 	    cbuf               *cbret)
 {
     int        retval = -1;
@@ -259,6 +264,10 @@ text_modify(clicon_handle       h,
     int        changed = 0; /* Only if x0p's children have changed-> sort necessary */
     cvec      *nscx1 = NULL;
     char      *createstr = NULL;	
+    clixon_xvec *x0add = NULL; /* New children of x0 to insert at once */
+    int        nadd;
+    cxobj    **xvec;
+    int        xlen;
     
     if (x1 == NULL){
 	clicon_err(OE_XML, EINVAL, "x1 is missing");
@@ -447,7 +456,12 @@ text_modify(clicon_handle       h,
 		}
 	    }
 	    if (changed){ 
-		if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
+		if (xadd && yang_find(y0, Y_ORDERED_BY, "user") == NULL){
+		    if (clixon_xvec_append(xadd, x0) < 0)
+			goto done;
+		    changed = 0; /* Inserted by caller */
+		}
+		else if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
 		    goto done;
 	    }
 	    break;
@@ -641,6 +655,14 @@ text_modify(clicon_handle       h,
 		}
 		x0vec[i++] = x0c; /* != NULL if x0c is matching x1c */
 	    }
+	    /* Several new children, eg list entries: insert them at once when done,
+	     * instead of one by one in the sorted child vector */
+	    nadd = 0;
+	    while (i > 0)
+		if (x0vec[--i] == NULL)
+		    nadd++;
+	    if (nadd > 1 && (x0add = clixon_xvec_new()) == NULL)
+		goto done;
 	    /* Second pass: Loop through children of the x1 modification tree again
 	     * Now potentially modify x0:s children 
 	     * Here x0vec contains one-to-one matching nodes of x1:s children.
@@ -653,14 +675,27 @@ text_modify(clicon_handle       h,
 		yc = yang_find_datanode(y0, x1cname);
 		if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
 				       yc, op,
-				       username, xnacm, permit, cbret)) < 0)
+				       username, xnacm, permit, x0add, cbret)) < 0)
 		    goto done;
 		/* If xml return - ie netconf error xml tree, then stop and return OK */
 		if (ret == 0)
 		    goto fail;
 	    }
+	    if (x0add && clixon_xvec_len(x0add)){
+		if (clixon_xvec_extract(x0add, &xvec, &xlen) < 0)
+		    goto done;
+		ret = xml_insert_vec(x0, xvec, xlen);
+		free(xvec);
+		if (ret < 0)
+		    goto done;
+	    }
 	    if (changed){
-		if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
+		if (xadd && yang_find(y0, Y_ORDERED_BY, "user") == NULL){
+		    if (clixon_xvec_append(xadd, x0) < 0)
+			goto done;
+		    changed = 0; /* Inserted by caller */
+		}
+		else if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
 		    goto done;
 	    }
 	    break;
@@ -695,6 +730,11 @@ text_modify(clicon_handle       h,
 	xml_purge(x0);
     if (x0vec)
 	free(x0vec);
+    if (x0add){ /* Remove new children not inserted */
+	for (i=0; i<clixon_xvec_len(x0add); i++)
+	    xml_free(clixon_xvec_i(x0add, i));
+	clixon_xvec_free(x0add);
+    }
     return retval;
  fail: /* cbret set */
     retval = 0;
@@ -851,7 +891,7 @@ text_modify_top(clicon_handle       h,
 	}
 	if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
 			       yc, op,
-			       username, xnacm, permit, cbret)) < 0)
+			       username, xnacm, permit, NULL, cbret)) < 0)
 	    goto done;
 	/* If xml return - ie netconf error xml tree, then stop and return OK */
 	if (ret == 0)
@@ -866,6 +906,61 @@ text_modify_top(clicon_handle       h,
     goto done;
 } /* text_modify_top */
 
+/*! Modify a base tree with a modification tree and clean up the result
+ * @param[in]  h        Clicon handle
+ * @param[in]  x0       Base xml tree, top-level symbol is "config"
+ * @param[in]  op       Top-level operation, can be superceded by other op in tree
+ * @param[in]  x1       Modification tree, top-level symbol is "config"
+ * @param[in]  yspec    Top-level yang spec
+ * @param[in]  username User name of requestor for nacm
+ * @param[in]  xnacm    NACM XML tree (only if !permit)
+ * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
+ * @retval    -1        Error
+ * @retval     0        Failed (cbret set)
+ * @retval     1        OK
+ * @see xmldb_put
+ * @see xmldb_journal_replay
+ */
+int
+xmldb_modify(clicon_handle       h,
+	     cxobj              *x0,
+	     enum operation_type op,
+	     cxobj              *x1,
+	     yang_stmt          *yspec,
+	     char               *username,
+	     cxobj              *xnacm,
+	     int                 permit,
+	     cbuf               *cbret)
+{
+    int retval = -1;
+    int ret;
+
+    if ((ret = text_modify_top(h, x0, x0, x1, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+	goto done;
+    /* If xml return - ie netconf error xml tree, then stop and return OK */
+    if (ret == 0)
+	goto fail;
+    /* Remove NONE nodes if all subs recursively are also NONE */
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+	goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
+		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
+	goto done;
+    /* Mark non-presence containers as XML_FLAG_DEFAULT */
+    if (xml_apply(x0, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
+	goto done;
+    /* Clear XML tree of defaults */
+    if (xml_tree_prune_flagged(x0, XML_FLAG_DEFAULT, 1) < 0)
+	goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -900,7 +995,6 @@ xmldb_put(clicon_handle       h,
 {
     int                 retval = -1;
     char               *dbfile = NULL;
-    FILE               *f = NULL;
     cbuf               *cb = NULL;
     yang_stmt          *yspec;
     cxobj              *x0 = NULL;
@@ -914,6 +1008,9 @@ xmldb_put(clicon_handle       h,
     cvec               *nsc = NULL; /* nacm namespace context */
     int                 firsttime = 0;
     int                 pretty;
+    int                 journal = 0;
+    char               *tmpfile = NULL;
+    int                 fd = -1;
 
     if (cbret == NULL){
 	clicon_err(OE_XML, EINVAL, "cbret is NULL");
@@ -961,7 +1058,7 @@ xmldb_put(clicon_handle       h,
      * Modify base tree x with modification x1. This is where the
      * new tree is made.
      */
-    if ((ret = text_modify_top(h, x0, x0, x1, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+    if ((ret = xmldb_modify(h, x0, op, x1, yspec, username, xnacm, permit, cbret)) < 0)
 	goto done;
     /* If xml return - ie netconf error xml tree, then stop and return OK */
     if (ret == 0){
@@ -972,19 +1069,6 @@ xmldb_put(clicon_handle       h,
 	}
 	goto fail;
     }
-
-    /* Remove NONE nodes if all subs recursively are also NONE */
-    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
-	goto done;
-    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
-		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
-	goto done;
-    /* Mark non-presence containers as XML_FLAG_DEFAULT */
-    if (xml_apply(x0, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
-	goto done;
-    /* Clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x0, XML_FLAG_DEFAULT, 1) < 0)
-	goto done;
 #if 0 /* debug */
     if (xml_apply0(x0, -1, xml_sort_verify, NULL) < 0)
 	clicon_log(LOG_NOTICE, "%s: verify failed #3", __FUNCTION__);
@@ -1000,6 +1084,16 @@ xmldb_put(clicon_handle       h,
 	de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
 	clicon_db_elmnt_set(h, db, &de0);
     }
+    /* Append the edit to the journal instead of writing the whole datastore file.
+     * If that is not possible, compact: write the file and remove the journal below
+     */
+    if (x1 && clicon_option_bool(h, "CLICON_XMLDB_JOURNAL")){
+	if ((ret = xmldb_journal_append(h, db, op, x1)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+	journal++;
+    }
     if (xmldb_db2file(h, db, &dbfile) < 0)
 	goto done;
     if (dbfile==NULL){
@@ -1019,25 +1113,58 @@ xmldb_put(clicon_handle       h,
 	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
 	goto done;
     }
-    if ((f = fopen(dbfile, "w")) == NULL){
+    if (journal){
+	/* Write to a temporary file which is then renamed, so that a crash never 
+	 * leaves a partially written datastore file with a journal on top of it */
+	if ((tmpfile = malloc(strlen(dbfile) + 5)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	sprintf(tmpfile, "%s.tmp", dbfile);
+	if ((fd = open(tmpfile, O_WRONLY|O_CREAT|O_TRUNC, S_IRWXU)) < 0){
+	    clicon_err(OE_CFG, errno, "Creating file %s", tmpfile);
+	    goto done;
+	}
+    }
+    else if ((fd = open(dbfile, O_WRONLY|O_CREAT|O_TRUNC,
+			S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH)) < 0){
 	clicon_err(OE_CFG, errno, "Creating file %s", dbfile);
 	goto done;
     } 
+    /* Serialize into a buffer written to the file in large blocks */
     pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
     if (strcmp(format,"json")==0){
-	if (xml2json(f, x0, pretty) < 0)
+	if (xml2json_fd(fd, x0, pretty) < 0)
 	    goto done;
     }
-    else if (clicon_xml2file(f, x0, 0, pretty) < 0)
+    else if (clicon_xml2fd(fd, x0, 0, pretty) < 0)
 	goto done;
     /* Remove modules state after writing to file
      */
     if (xmodst && xml_purge(xmodst) < 0)
 	goto done;
+    if (journal){
+	if (fsync(fd) < 0){
+	    clicon_err(OE_UNIX, errno, "fsync(%s)", tmpfile);
+	    goto done;
+	}
+	close(fd);
+	fd = -1;
+	if (rename(tmpfile, dbfile) < 0){
+	    clicon_err(OE_UNIX, errno, "rename(%s)", tmpfile);
+	    goto done;
+	}
+    }
+    /* The datastore file now contains all edits, any journal is obsolete */
+    if (xmldb_journal_remove(h, db) < 0)
+	goto done;
+ ok:
     retval = 1;
  done:
-    if (f != NULL)
-	fclose(f);
+    if (fd != -1)
+	close(fd);
+    if (tmpfile)
+	free(tmpfile);
     if (nsc)
 	xml_nsctx_free(nsc);
     if (dbfile)
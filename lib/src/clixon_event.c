@@ -35,6 +35,8 @@
 
  *
  * Event handling and loop
+ * File descriptors are polled with epoll(7) if available, otherwise select(2).
+ * Timers are kept in a binary heap ordered by timeout.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -49,8 +51,12 @@
 #include <errno.h>
 #include <string.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#endif
 
 #include "clixon_queue.h"
 #include "clixon_log.h"
@@ -62,29 +68,70 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of file descriptor events returned by one epoll_wait */
+#define EVENT_MAXEVENTS 64
+
+/* Name of system call waiting for events, for error messages */
+#ifdef HAVE_EPOLL_CREATE1
+#define EVENT_WAIT_FN "epoll_wait"
+#else
+#define EVENT_WAIT_FN "select"
+#endif
+
 /*
  * Types
  */
 struct event_data{
     struct event_data *e_next;     /* next in list */
     int (*e_fn)(int, void*);            /* function */
-    enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
+    enum {EVENT_FD, EVENT_FD_WRITE, EVENT_TIME} e_type; /* type of event */
     int e_fd;                      /* File descriptor */
     struct timeval e_time;         /* Timeout */
+    uint64_t e_nr;                 /* Timer registration order, tie-breaker */
+    int e_unreg;                   /* Unregistered, free after dispatch */
+    struct event_data *e_unreg_next; /* next in list of unregistered events */
     void *e_arg;                   /* function argument */
     char e_string[EVENT_STRLEN];             /* string for debugging */
 };
 
+/* All callbacks registered on one file descriptor, see ee_fds
+ */
+struct event_fd{
+    struct event_data *ef_ee;      /* list of callbacks registered on fd */
+    uint32_t           ef_gen;     /* Incremented each time fd is added */
+    int                ef_nopoll;  /* fd cannot be polled, eg regular file */
+    int                ef_write;   /* Nr of write callbacks (EVENT_FD_WRITE) on fd */
+};
+
 /*
  * Internal variables
  * XXX consider use handle variables instead of global
  */
-static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+/* File descriptor callbacks indexed by fd */
+static struct event_fd *ee_fds = NULL;
+static int              ee_fds_len = 0;
+
+/* Timers as a binary heap: ee_timers[0] has the smallest timeout */
+static struct event_data **ee_timers = NULL;
+static int                 ee_timers_len = 0;
+static int                 ee_timers_max = 0;
+static uint64_t            ee_timers_nr = 0;
+
+/* Unregistered fd callbacks are not freed immediately since they may be 
+ * referenced in an ongoing dispatch */
+static struct event_data *ee_unreg = NULL;
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
 
+/* Number of fds that cannot be polled, they are always considered readable */
+static int ee_nopoll = 0;
+
+#ifdef HAVE_EPOLL_CREATE1
+static int   ee_epfd = -1; /* epoll instance */
+static pid_t ee_pid = 0;   /* process that created ee_epfd, re-create after fork */
+#endif
+
 static int _clicon_exit = 0;
 
 /*! For signal handlers: instead of doing exit, set a global variable to exit
@@ -116,6 +163,221 @@ clicon_exit_get(void)
     return _clicon_exit;
 }
 
+#ifdef HAVE_EPOLL_CREATE1
+/*! Get epoll events to wait for on fd: input if any read callback, output if any write callback
+ * @param[in]  fd  File descriptor
+ */
+static uint32_t
+event_epoll_events(int fd)
+{
+    struct event_fd *ef = &ee_fds[fd];
+    struct event_data *e;
+    uint32_t events = 0;
+
+    for (e = ef->ef_ee; e; e = e->e_next)
+	if (e->e_type == EVENT_FD)
+	    events |= EPOLLIN;
+    if (ef->ef_write)
+	events |= EPOLLOUT;
+    return events;
+}
+
+/*! Add fd to the epoll instance
+ * @param[in]  fd  File descriptor
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_epoll_add(int fd)
+{
+    struct epoll_event ev = {0,};
+
+    ev.events = event_epoll_events(fd);
+    ev.data.u64 = ((uint64_t)ee_fds[fd].ef_gen << 32) | (uint32_t)fd;
+    if (epoll_ctl(ee_epfd, EPOLL_CTL_ADD, fd, &ev) < 0){
+	if (errno != EPERM){
+	    clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	    return -1;
+	}
+	/* Eg regular files cannot be polled but are always readable (as in select) */
+	ee_fds[fd].ef_nopoll = 1;
+	ee_nopoll++;
+    }
+    return 0;
+}
+
+/*! Create epoll instance if not created, or created by another process (fork)
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_epoll_init(void)
+{
+    int fd;
+
+    if (ee_epfd != -1 && ee_pid == getpid())
+	return 0;
+    /* Child process shares the epoll instance with parent: create a new */
+    if (ee_epfd != -1)
+	close(ee_epfd);
+    if ((ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+	clicon_err(OE_EVENTS, errno, "epoll_create1");
+	return -1;
+    }
+    ee_pid = getpid();
+    for (fd=0; fd<ee_fds_len; fd++){
+	if (ee_fds[fd].ef_nopoll){
+	    ee_fds[fd].ef_nopoll = 0;
+	    ee_nopoll--;
+	}
+	if (ee_fds[fd].ef_ee != NULL)
+	    if (event_epoll_add(fd) < 0)
+		return -1;
+    }
+    return 0;
+}
+#endif /* HAVE_EPOLL_CREATE1 */
+
+/*! Start polling a file descriptor, called on first callback registration of fd
+ * @param[in]  fd  File descriptor
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_fd_add(int fd)
+{
+    ee_fds[fd].ef_gen++;
+#ifdef HAVE_EPOLL_CREATE1
+    if (event_epoll_init() < 0)
+	return -1;
+    if (event_epoll_add(fd) < 0)
+	return -1;
+#else
+    if (fd >= FD_SETSIZE){
+	clicon_err(OE_EVENTS, EINVAL, "fd %d larger than FD_SETSIZE", fd);
+	return -1;
+    }
+#endif
+    return 0;
+}
+
+/*! Update events polled on a file descriptor, after a read or write callback is added or removed
+ * @param[in]  fd  File descriptor with other callbacks registered
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_fd_mod(int fd)
+{
+#ifdef HAVE_EPOLL_CREATE1
+    struct epoll_event ev = {0,};
+
+    if (ee_fds[fd].ef_nopoll)
+	return 0;
+    if (event_epoll_init() < 0)
+	return -1;
+    ev.events = event_epoll_events(fd);
+    ev.data.u64 = ((uint64_t)ee_fds[fd].ef_gen << 32) | (uint32_t)fd;
+    if (epoll_ctl(ee_epfd, EPOLL_CTL_MOD, fd, &ev) < 0){
+	clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	return -1;
+    }
+#endif
+    return 0;
+}
+
+/*! Stop polling a file descriptor, called when last callback of fd is unregistered
+ * @param[in]  fd  File descriptor
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @note Unregister fd before closing it. Close removes fd from epoll only if no other
+ *       descriptor refers to the same file, which is not the case if it is shared with
+ *       a forked child.
+ */
+static int
+event_fd_del(int fd)
+{
+    if (ee_fds[fd].ef_nopoll){
+	ee_fds[fd].ef_nopoll = 0;
+	ee_nopoll--;
+	return 0;
+    }
+#ifdef HAVE_EPOLL_CREATE1
+    /* A forked child must not modify the epoll instance shared with its parent */
+    if (ee_epfd != -1 && ee_pid == getpid() &&
+	epoll_ctl(ee_epfd, EPOLL_CTL_DEL, fd, NULL) < 0 &&
+	errno != ENOENT && errno != EBADF){
+	clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	return -1;
+    }
+#endif
+    return 0;
+}
+
+/*! Register a callback function on a file descriptor
+ * @param[in]  fd   File descriptor
+ * @param[in]  type EVENT_FD for input or EVENT_FD_WRITE for output
+ * @param[in]  fn   Function to call when input available on fd
+ * @param[in]  arg  Argument to function fn
+ * @param[in]  str  Describing string for logging
+ * @see clixon_event_reg_fd
+ * @see clixon_event_reg_fd_write
+ */
+static int
+event_reg_fd(int   fd, 
+	     int   type,
+	     int (*fn)(int, void*), 
+	     void *arg, 
+	     char *str)
+{
+    struct event_data *e;
+    struct event_fd   *ef;
+    int                len;
+    int                first;
+
+    if (fd < 0){
+	clicon_err(OE_EVENTS, EINVAL, "Invalid fd %d", fd);
+	return -1;
+    }
+    if (fd >= ee_fds_len){ /* Grow fd vector */
+	len = ee_fds_len?ee_fds_len:64;
+	while (len <= fd)
+	    len *= 2;
+	if ((ef = realloc(ee_fds, len*sizeof(struct event_fd))) == NULL){
+	    clicon_err(OE_EVENTS, errno, "realloc");
+	    return -1;
+	}
+	memset(&ef[ee_fds_len], 0, (len-ee_fds_len)*sizeof(struct event_fd));
+	ee_fds = ef;
+	ee_fds_len = len;
+    }
+    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
+	clicon_err(OE_EVENTS, errno, "malloc");
+	return -1;
+    }
+    memset(e, 0, sizeof(struct event_data));
+    strncpy(e->e_string, str, EVENT_STRLEN-1);
+    e->e_fd = fd;
+    e->e_fn = fn;
+    e->e_arg = arg;
+    e->e_type = type;
+    ef = &ee_fds[fd];
+    first = (ef->ef_ee == NULL);
+    e->e_next = ef->ef_ee;
+    ef->ef_ee = e;
+    if (type == EVENT_FD_WRITE)
+	ef->ef_write++;
+    if ((first ? event_fd_add(fd) : event_fd_mod(fd)) < 0){
+	ef->ef_ee = e->e_next;
+	if (type == EVENT_FD_WRITE)
+	    ef->ef_write--;
+	free(e);
+	return -1;
+    }
+    clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
+    return 0;
+}
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd  File descriptor
@@ -134,29 +396,35 @@ clixon_event_reg_fd(int   fd,
 		    void *arg, 
 		    char *str)
 {
-    struct event_data *e;
+    return event_reg_fd(fd, EVENT_FD, fn, arg, str);
+}
 
-    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
-	clicon_err(OE_EVENTS, errno, "malloc");
-	return -1;
-    }
-    memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_string, str, EVENT_STRLEN);
-    e->e_fd = fd;
-    e->e_fn = fn;
-    e->e_arg = arg;
-    e->e_type = EVENT_FD;
-    e->e_next = ee;
-    ee = e;
-    clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
-    return 0;
+/*! Register a callback function to be called when output is possible on a file descriptor
+ *
+ * Typically registered when a write on a non-blocking fd would block, and 
+ * unregistered with clixon_event_unreg_fd when all data is written.
+ * @param[in]  fd  File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @see clixon_event_reg_fd  for input
+ */
+int
+clixon_event_reg_fd_write(int   fd, 
+			  int (*fn)(int, void*), 
+			  void *arg, 
+			  char *str)
+{
+    return event_reg_fd(fd, EVENT_FD_WRITE, fn, arg, str);
 }
 
-/*! Deregister a file descriptor callback
+/*! Deregister a file descriptor callback (input or output)
  * @param[in]  s   File descriptor
  * @param[in]  fn  Function to call when input available on fd
  * Note: deregister when exactly function and socket match, not argument
+ * Note: deregister before closing s
  * @see clixon_event_reg_fd
+ * @see clixon_event_reg_fd_write
  * @see clixon_event_unreg_timeout
  */
 int
@@ -166,20 +434,114 @@ clixon_event_unreg_fd(int   s,
     struct event_data *e, **e_prev;
     int found = 0;
 
-    e_prev = &ee;
-    for (e = ee; e; e = e->e_next){
-	if (fn == e->e_fn && s == e->e_fd) {
+    if (s < 0 || s >= ee_fds_len)
+	return -1;
+    e_prev = &ee_fds[s].ef_ee;
+    for (e = ee_fds[s].ef_ee; e; e = e->e_next){
+	if (fn == e->e_fn) {
 	    found++;
 	    *e_prev = e->e_next;
 	    _ee_unreg++;
-	    free(e);
+	    /* e->e_next is kept so that an ongoing dispatch may proceed */
+	    e->e_unreg = 1;
+	    e->e_unreg_next = ee_unreg;
+	    ee_unreg = e;
+	    if (e->e_type == EVENT_FD_WRITE)
+		ee_fds[s].ef_write--;
 	    break;
 	}
 	e_prev = &e->e_next;
     }
+    if (found){
+	if (ee_fds[s].ef_ee == NULL){
+	    if (event_fd_del(s) < 0)
+		return -1;
+	}
+	else if (event_fd_mod(s) < 0)
+	    return -1;
+    }
     return found?0:-1;
 }
 
+/*! Free unregistered fd callbacks
+ */
+static void
+event_unreg_free(void)
+{
+    struct event_data *e;
+
+    while ((e = ee_unreg) != NULL){
+	ee_unreg = e->e_unreg_next;
+	free(e);
+    }
+}
+
+/*! Compare two timers, earliest timeout first, then registration order
+ * @retval  1  e1 is before e2
+ * @retval  0  e1 is not before e2
+ */
+static int
+event_timer_lt(struct event_data *e1,
+	       struct event_data *e2)
+{
+    if (timercmp(&e1->e_time, &e2->e_time, <))
+	return 1;
+    if (timercmp(&e2->e_time, &e1->e_time, <))
+	return 0;
+    return e1->e_nr < e2->e_nr;
+}
+
+/*! Move timer at position i in heap up to its place
+ */
+static void
+event_timer_up(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                p;
+
+    while (i > 0){
+	p = (i-1)/2;
+	if (!event_timer_lt(e, ee_timers[p]))
+	    break;
+	ee_timers[i] = ee_timers[p];
+	i = p;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Move timer at position i in heap down to its place
+ */
+static void
+event_timer_down(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                c;
+
+    while ((c = 2*i+1) < ee_timers_len){
+	if (c+1 < ee_timers_len && event_timer_lt(ee_timers[c+1], ee_timers[c]))
+	    c++;
+	if (!event_timer_lt(ee_timers[c], e))
+	    break;
+	ee_timers[i] = ee_timers[c];
+	i = c;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Remove timer at position i from heap (does not free it)
+ */
+static void
+event_timer_rm(int i)
+{
+    ee_timers_len--;
+    if (i < ee_timers_len){
+	ee_timers[i] = ee_timers[ee_timers_len];
+	event_timer_down(i);
+	event_timer_up(i);
+    }
+    ee_timers[ee_timers_len] = NULL;
+}
+
 /*! Call a callback function at an absolute time
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
  * @param[in]  fn  Function to call at time t
@@ -200,6 +562,7 @@ clixon_event_unreg_fd(int   s,
  * registration for each period, see example above.
  * Note also that the first argument to fn is a dummy, just to get the same
  * signatute as for file-descriptor callbacks.
+ * Timers with the same timestamp are called in registration order.
  * @see clixon_event_reg_fd
  * @see clixon_event_unreg_timeout
  */
@@ -209,27 +572,33 @@ clixon_event_reg_timeout(struct timeval t,
 			 void          *arg, 
 			 char          *str)
 {
-    struct event_data *e, *e1, **e_prev;
-
+    struct event_data  *e;
+    struct event_data **vec;
+    int                 max;
+
+    if (ee_timers_len == ee_timers_max){ /* Grow heap */
+	max = ee_timers_max?2*ee_timers_max:16;
+	if ((vec = realloc(ee_timers, max*sizeof(struct event_data *))) == NULL){
+	    clicon_err(OE_EVENTS, errno, "realloc");
+	    return -1;
+	}
+	ee_timers = vec;
+	ee_timers_max = max;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
 	clicon_err(OE_EVENTS, errno, "malloc");
 	return -1;
     }
     memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_string, str, EVENT_STRLEN);
+    strncpy(e->e_string, str, EVENT_STRLEN-1);
     e->e_fn = fn;
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-	if (timercmp(&e->e_time, &e1->e_time, <))
-	    break;
-	e_prev = &e1->e_next;
-    }
-    e->e_next = e1;
-    *e_prev = e;
+    e->e_nr = ee_timers_nr++;
+    /* Insert into heap */
+    ee_timers[ee_timers_len++] = e;
+    event_timer_up(ee_timers_len-1);
     clicon_debug(2, "%s: %s", __FUNCTION__, str); 
     return 0;
 }
@@ -247,20 +616,18 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*), 
 			   void *arg)
 {
-    struct event_data *e, **e_prev;
-    int found = 0;
+    struct event_data *e;
+    int                i;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
+    for (i=0; i<ee_timers_len; i++){
+	e = ee_timers[i];
 	if (fn == e->e_fn && arg == e->e_arg) {
-	    found++;
-	    *e_prev = e->e_next;
+	    event_timer_rm(i);
 	    free(e);
-	    break;
+	    return 0;
 	}
-	e_prev = &e->e_next;
     }
-    return found?0:-1;
+    return -1;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -273,89 +640,223 @@ int
 clixon_event_poll(int fd)
 {
     int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
+    struct pollfd  pfd = {0,};
 
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-	clicon_err(OE_EVENTS, errno, "select");
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+	clicon_err(OE_EVENTS, errno, "poll");
     return retval;
 }
 
-/*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
- * There is an issue with fairness that timeouts may take over all events
- * One could try to poll the file descriptors after a timeout?
+/*! Get time until first timer expires as argument to poll
+ * @param[out] tp   Time until first timer, or 0 if expired or nopoll fds exist
+ * @retval     0    No timers (and no nopoll fds), wait forever
+ * @retval     1    tp is set
+ */
+static int
+event_timeout_get(struct timeval *tp)
+{
+    struct timeval t0;
+
+    if (ee_nopoll){
+	timerclear(tp);
+	return 1;
+    }
+    if (ee_timers_len == 0)
+	return 0;
+    gettimeofday(&t0, NULL);
+    timersub(&ee_timers[0]->e_time, &t0, tp);
+    if (tp->tv_sec < 0)
+	timerclear(tp);
+    return 1;
+}
+
+/*! Call callbacks of expired timers
+ * Only timers that expired before the call are dispatched, timers registered 
+ * by the callbacks are dispatched next loop so that file descriptors are not
+ * starved by timers.
+ * @retval  0  OK
+ * @retval -1  Error in callback
+ */
+static int
+event_timer_dispatch(void)
+{
+    struct event_data *e;
+    struct timeval     t0;
+    uint64_t           nr;
+
+    gettimeofday(&t0, NULL);
+    nr = ee_timers_nr;
+    while (ee_timers_len && !clicon_exit_get()){
+	e = ee_timers[0];
+	if (timercmp(&e->e_time, &t0, >) || e->e_nr >= nr)
+	    break;
+	event_timer_rm(0);
+	clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
+	if ((*e->e_fn)(0, e->e_arg) < 0){
+	    free(e);
+	    return -1;
+	}
+	free(e);
+    }
+    return 0;
+}
+
+/*! Call callbacks registered on a file descriptor
+ * @param[in]  fd   File descriptor
+ * @param[in]  in   Input available (or error): call input callbacks
+ * @param[in]  out  Output possible (or error): call output callbacks
+ * @retval     0    OK
+ * @retval    -1    Error in callback
+ */
+static int
+event_fd_dispatch(int fd,
+		  int in,
+		  int out)
+{
+    struct event_data *e;
+    struct event_data *e_next;
+
+    for (e = ee_fds[fd].ef_ee; e; e = e_next){
+	if (clicon_exit_get())
+	    break;
+	e_next = e->e_next;
+	if (e->e_unreg) /* unregistered by previous callback */
+	    continue;
+	if (!(e->e_type == EVENT_FD_WRITE ? out : in))
+	    continue;
+	clicon_debug(2, "%s: %s", __FUNCTION__, e->e_string);
+	if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
+	    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Call callbacks of fds that cannot be polled
+ * @retval  0  OK
+ * @retval -1  Error in callback
+ */
+static int
+event_nopoll_dispatch(void)
+{
+    int fd;
+
+    for (fd=0; ee_nopoll && fd<ee_fds_len; fd++){
+	if (clicon_exit_get())
+	    break;
+	if (ee_fds[fd].ef_nopoll && event_fd_dispatch(fd, 1, 1) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Wait for and dispatch file descriptor events (and timeouts) by invoking callbacks.
+ * Each loop first waits for input on file descriptors or for the first timer 
+ * to expire, then calls the callbacks of the expired timers and then of the
+ * file descriptors with input. Neither timers nor file descriptors can
+ * therefore starve the other.
  * @retval  0  OK
  * @retval -1  Error: eg select, callback, timer, 
  */
 int
 clixon_event_loop(void)
 {
-    struct event_data *e;
-    struct event_data *e_next;
     int                n;
     struct timeval     t;
-    struct timeval     t0;
-    struct timeval     tnull = {0,};
-    fd_set             fdset;
     int                retval = -1;
+#ifdef HAVE_EPOLL_CREATE1
+    struct epoll_event events[EVENT_MAXEVENTS];
+    int                i;
+    int                fd;
+    int                timeout;
+
+    if (event_epoll_init() < 0)
+	return -1;
+    uint32_t           ev;
+#else
+    fd_set             fdset;
+    fd_set             wfdset;
+    int                fd;
+    int                nfds;
+#endif
 
     while (!clicon_exit_get()){
+	event_unreg_free();
+#ifdef HAVE_EPOLL_CREATE1
+	if (event_epoll_init() < 0)
+	    goto err;
+	timeout = -1;
+	if (event_timeout_get(&t))
+	    timeout = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+	n = epoll_wait(ee_epfd, events, EVENT_MAXEVENTS, timeout);
+#else
 	FD_ZERO(&fdset);
-	for (e=ee; e; e=e->e_next)
-	    if (e->e_type == EVENT_FD)
-		FD_SET(e->e_fd, &fdset);
-	if (ee_timers != NULL){
-	    gettimeofday(&t0, NULL);
-	    timersub(&ee_timers->e_time, &t0, &t); 
-	    if (t.tv_sec < 0)
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
-	    else
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
-	}
+	FD_ZERO(&wfdset);
+	nfds = 0;
+	for (fd=0; fd<ee_fds_len && fd<FD_SETSIZE; fd++)
+	    if (ee_fds[fd].ef_ee != NULL){
+		FD_SET(fd, &fdset);
+		if (ee_fds[fd].ef_write)
+		    FD_SET(fd, &wfdset);
+		nfds = fd+1;
+	    }
+	if (event_timeout_get(&t))
+	    n = select(nfds, &fdset, &wfdset, NULL, &t);
 	else
-	    n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL); 
+	    n = select(nfds, &fdset, &wfdset, NULL, NULL);
+#endif
 	if (clicon_exit_get())
 	    break;
 	if (n == -1) {
 	    if (errno == EINTR){
-		clicon_debug(1, "%s select: %s", __FUNCTION__, strerror(errno));
-		clicon_err(OE_EVENTS, errno, "select");
+		clicon_debug(1, "%s %s: %s", __FUNCTION__, EVENT_WAIT_FN, strerror(errno));
+		clicon_err(OE_EVENTS, errno, "%s", EVENT_WAIT_FN);
 		retval = 0;
 	    }
 	    else
-		clicon_err(OE_EVENTS, errno, "select");
+		clicon_err(OE_EVENTS, errno, "%s", EVENT_WAIT_FN);
 	    goto err;
 	}
-	if (n==0){ /* Timeout */
-	    e = ee_timers;
-	    ee_timers = ee_timers->e_next;
-	    clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
-	    if ((*e->e_fn)(0, e->e_arg) < 0){
-		free(e);
+	if (event_timer_dispatch() < 0)
+	    goto err;
+#ifdef HAVE_EPOLL_CREATE1
+	for (i=0; i<n; i++){
+	    if (clicon_exit_get())
+		break;
+	    fd = (int)(events[i].data.u64 & 0xffffffff);
+	    /* fd may have been unregistered, or closed and re-registered, by 
+	     * a previous callback */
+	    if (fd >= ee_fds_len || ee_fds[fd].ef_ee == NULL ||
+		ee_fds[fd].ef_gen != (uint32_t)(events[i].data.u64 >> 32))
+		continue;
+	    ev = events[i].events;
+	    if (event_fd_dispatch(fd,
+				  (ev & (EPOLLIN|EPOLLHUP|EPOLLERR)) != 0,
+				  (ev & (EPOLLOUT|EPOLLHUP|EPOLLERR)) != 0) < 0)
 		goto err;
-	    }
-	    free(e);
 	}
+#else
 	_ee_unreg = 0;
-	for (e=ee; e; e=e_next){
+	for (fd=0; n > 0 && fd<nfds; fd++){
 	    if (clicon_exit_get())
 		break;
-	    e_next = e->e_next;
-	    if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
-		clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
-		if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
-		    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
+	    if ((FD_ISSET(fd, &fdset) || FD_ISSET(fd, &wfdset)) &&
+		ee_fds[fd].ef_ee != NULL){
+		if (event_fd_dispatch(fd, FD_ISSET(fd, &fdset), FD_ISSET(fd, &wfdset)) < 0)
 		    goto err;
-
-		}
+		/* fd may have been closed and re-registered */
 		if (_ee_unreg){
 		    _ee_unreg = 0;
 		    break;
 		}
 	    }
 	}
+#endif
+	if (event_nopoll_dispatch() < 0)
+	    goto err;
 	continue;
       err:
 	break;
@@ -368,18 +869,33 @@ int
 clixon_event_exit(void)
 {
     struct event_data *e, *e_next;
-    
-    e_next = ee;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
-    }
-    ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
+    int                fd;
+    int                i;
+
+    for (fd=0; fd<ee_fds_len; fd++){
+	e_next = ee_fds[fd].ef_ee;
+	while ((e = e_next) != NULL){
+	    e_next = e->e_next;
+	    free(e);
+	}
     }
+    if (ee_fds)
+	free(ee_fds);
+    ee_fds = NULL;
+    ee_fds_len = 0;
+    ee_nopoll = 0;
+    event_unreg_free();
+    for (i=0; i<ee_timers_len; i++)
+	free(ee_timers[i]);
+    if (ee_timers)
+	free(ee_timers);
     ee_timers = NULL;
+    ee_timers_len = 0;
+    ee_timers_max = 0;
+#ifdef HAVE_EPOLL_CREATE1
+    if (ee_epfd != -1)
+	close(ee_epfd);
+    ee_epfd = -1;
+#endif
     return 0;
 }
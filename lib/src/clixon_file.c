@@ -210,3 +210,103 @@ clicon_file_copy(char *src,
 	errno = err;
     return retval;
 }
+
+/*! Read the rest of a file or stream into a malloced buffer in large blocks
+ *
+ * If fd is a regular file, the buffer is allocated once from its size.
+ * Otherwise (eg a pipe) the buffer is grown by doubling until end-of-file.
+ * The buffer is terminated with two null bytes (not included in len), which
+ * lets a flex scanner parse it in place with yy_scan_buffer.
+ * @param[in]  fd    File descriptor, read from current offset to end-of-file
+ * @param[out] bufp  Malloced buffer, free after use
+ * @param[out] lenp  Nr of bytes read (excluding the two null bytes)
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+clicon_file_read(int     fd,
+		 char  **bufp,
+		 size_t *lenp)
+{
+    int         retval = -1;
+    char       *buf = NULL;
+    char       *b;
+    size_t      buflen = 65536; /* Initial size if size is not known */
+    size_t      len = 0;
+    size_t      size = 0;       /* Expected size of regular file, or 0 */
+    ssize_t     n;
+    off_t       off;
+    struct stat st;
+
+    if (bufp == NULL || lenp == NULL){
+	clicon_err(OE_UNIX, EINVAL, "bufp or lenp is NULL");
+	goto done;
+    }
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+	(off = lseek(fd, 0, SEEK_CUR)) >= 0 && st.st_size > off){
+	size = st.st_size - off;
+	buflen = size + 2;
+    }
+    if ((buf = malloc(buflen)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    while (1){
+	if (len >= buflen - 2){ /* Room for terminating null bytes */
+	    buflen *= 2;
+	    if ((b = realloc(buf, buflen)) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		goto done;
+	    }
+	    buf = b;
+	}
+	if ((n = read(fd, buf+len, buflen-2-len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "read");
+	    goto done;
+	}
+	if (n == 0) /* end-of-file */
+	    break;
+	len += n;
+	if (size && len == size) /* Regular file: no need to read eof */
+	    break;
+    }
+    buf[len] = '\0';
+    buf[len+1] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    *lenp = len;
+    retval = 0;
+ done:
+    if (buf)
+	free(buf);
+    return retval;
+}
+
+/*! Write a buffer to a file descriptor, continue on partial writes
+ * @param[in]  fd    File descriptor
+ * @param[in]  buf   Buffer to write
+ * @param[in]  len   Nr of bytes to write
+ * @retval     0     OK, all bytes written
+ * @retval    -1     Error
+ */
+int
+clicon_file_write(int     fd,
+		  char   *buf,
+		  size_t  len)
+{
+    ssize_t n;
+
+    while (len > 0){
+	if ((n = write(fd, buf, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "write");
+	    return -1;
+	}
+	buf += n;
+	len -= n;
+    }
+    return 0;
+}
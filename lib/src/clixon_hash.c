@@ -33,12 +33,17 @@
 
  */
 
-
 /*
  * A simple implementation of a associative array style data store. Keys
  * are always strings while values can be some arbitrary data referenced
  * by void*.
  *
+ * The table uses open addressing with linear probing. Keys are hashed with 
+ * SipHash-1-3 and the table is doubled when more than 3/4 of the slots are
+ * used. Entries are allocated separately, so entry pointers returned by
+ * clicon_hash_lookup() and clicon_hash_add() are stable until the entry is 
+ * deleted.
+ *
  * XXX: functions such as hash_keys(), hash_value() etc are currently returning
  * pointers to the actual data storage. Should probably make copies.
  *
@@ -93,19 +98,180 @@
 #include "clixon_err.h"
 #include "clixon_hash.h"
 
-#define HASH_SIZE	1031	/* Number of hash buckets. Should be a prime */ 
+#define HASH_SIZE_START	16	/* Initial number of slots. Must be a power of 2 */ 
 #define align4(s) (((s)/4)*4 + 4)
 
-/*! A very simplistic algorithm to calculate a hash bucket index
+/* Table is grown when number of entries exceeds 3/4 of the slots */
+#define hash_full(ht) ((ht)->ht_nr+1 > ((ht)->ht_size/4)*3)
+
+/*
+ * Types
+ */
+/* One slot in the open addressing table */
+struct hash_slot{
+    uint64_t      hs_hash;  /* Hash of key */
+    clicon_hash_t hs_entry; /* Entry or NULL if slot is empty */
+};
+
+/* Hash table. The API refers to it as clicon_hash_t* for backward compatibility
+ */
+struct hash_table{
+    struct hash_slot *ht_slots; /* Vector of ht_size slots */
+    size_t            ht_size;  /* Number of slots, power of 2 */
+    size_t            ht_nr;    /* Number of entries */
+};
+
+/* SipHash key. Keys are names chosen by clixon and applications (options, 
+ * databases, etc), so a fixed key is used which also gives the same key order
+ * in every run */
+static const uint8_t hash_sipkey[16] = {
+    0x63, 0x6c, 0x69, 0x78, 0x6f, 0x6e, 0x2d, 0x68,
+    0x61, 0x73, 0x68, 0x2d, 0x6b, 0x65, 0x79, 0x21
+};
+
+#define ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND					\
+    do {						\
+	v0 += v1; v1 = ROTL64(v1, 13); v1 ^= v0;	\
+	v0 = ROTL64(v0, 32);				\
+	v2 += v3; v3 = ROTL64(v3, 16); v3 ^= v2;	\
+	v0 += v3; v3 = ROTL64(v3, 21); v3 ^= v0;	\
+	v2 += v1; v1 = ROTL64(v1, 17); v1 ^= v2;	\
+	v2 = ROTL64(v2, 32);				\
+    } while (0)
+
+/*! Read 8 bytes little-endian
+ */
+static uint64_t
+hash_u8to64(const uint8_t *p)
+{
+    return ((uint64_t)p[0])       | ((uint64_t)p[1] << 8)  |
+	   ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+	   ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) |
+	   ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+/*! Compute SipHash-1-3 of a byte string
+ * @param[in]  in    Input bytes
+ * @param[in]  len   Number of bytes
+ * @param[in]  k     128-bit key
+ * @retval     hash  64-bit hash value
+ * One compression and three finalization rounds, which is sufficient for a hash
+ * table and faster than the original 2-4 variant
+ * @see https://www.aumasson.jp/siphash/siphash.pdf
+ */
+static uint64_t
+hash_siphash(const uint8_t *in,
+	     size_t         len,
+	     const uint8_t *k)
+{
+    uint64_t       k0 = hash_u8to64(k);
+    uint64_t       k1 = hash_u8to64(k + 8);
+    uint64_t       v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t       v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t       v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t       v3 = 0x7465646279746573ULL ^ k1;
+    uint64_t       b = ((uint64_t)len) << 56;
+    uint64_t       m;
+    const uint8_t *end = in + len - (len % 8);
+
+    for (; in != end; in += 8){
+	m = hash_u8to64(in);
+	v3 ^= m;
+	SIPROUND;
+	v0 ^= m;
+    }
+    switch (len & 7){
+    case 7: b |= ((uint64_t)in[6]) << 48; /* fall through */
+    case 6: b |= ((uint64_t)in[5]) << 40; /* fall through */
+    case 5: b |= ((uint64_t)in[4]) << 32; /* fall through */
+    case 4: b |= ((uint64_t)in[3]) << 24; /* fall through */
+    case 3: b |= ((uint64_t)in[2]) << 16; /* fall through */
+    case 2: b |= ((uint64_t)in[1]) << 8;  /* fall through */
+    case 1: b |= ((uint64_t)in[0]);
+	break;
+    case 0:
+	break;
+    }
+    v3 ^= b;
+    SIPROUND;
+    v0 ^= b;
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/*! Compute hash value of a string
+ * @param[in]  str   String
+ * @retval     hash  64-bit hash value
+ * Can be used for other string tables than clicon_hash
  */
-static uint32_t
-hash_bucket(const char *str)
+uint64_t
+clicon_hash_string(const char *str)
 {
-    uint32_t n = 0;
+    return hash_siphash((const uint8_t *)str, strlen(str), hash_sipkey);
+}
 
-    while(*str)
-	n += (uint32_t)*str++;
-    return n % HASH_SIZE;
+/*! Find slot of key, or empty slot where key should be inserted
+ * @param[in]  ht    Hash table
+ * @param[in]  key   Key
+ * @param[in]  hv    Hash value of key
+ * @retval     i     Slot index, entry is NULL if not found
+ */
+static size_t
+hash_slot_find(struct hash_table *ht,
+	       const char        *key,
+	       uint64_t           hv)
+{
+    size_t            mask = ht->ht_size - 1;
+    size_t            i;
+    struct hash_slot *hs;
+
+    for (i = hv & mask; ; i = (i+1) & mask){
+	hs = &ht->ht_slots[i];
+	if (hs->hs_entry == NULL)
+	    break;
+	if (hs->hs_hash == hv && strcmp(hs->hs_entry->h_key, key) == 0)
+	    break;
+    }
+    return i;
+}
+
+/*! Double the number of slots and re-insert all entries
+ * @param[in]  ht    Hash table
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+hash_grow(struct hash_table *ht)
+{
+    struct hash_slot *slots0 = ht->ht_slots;
+    size_t            size0 = ht->ht_size;
+    struct hash_slot *slots;
+    size_t            size = 2*size0;
+    size_t            i;
+    size_t            j;
+
+    if ((slots = calloc(size, sizeof(struct hash_slot))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    for (i = 0; i < size0; i++){
+	if (slots0[i].hs_entry == NULL)
+	    continue;
+	for (j = slots0[i].hs_hash & (size-1); 
+	     slots[j].hs_entry != NULL;
+	     j = (j+1) & (size-1))
+	    ;
+	slots[j] = slots0[i];
+    }
+    free(slots0);
+    ht->ht_slots = slots;
+    ht->ht_size = size;
+    return 0;
 }
 
 /*! Initialize hash table.
@@ -117,14 +283,20 @@ hash_bucket(const char *str)
 clicon_hash_t *
 clicon_hash_init(void)
 {
-  clicon_hash_t *hash;
-
-  if ((hash = (clicon_hash_t *)malloc(sizeof(clicon_hash_t) * HASH_SIZE)) == NULL){
-      clicon_err(OE_UNIX, errno, "malloc: %s", strerror(errno));
-      return NULL;
-  }
-  memset(hash, 0, sizeof(clicon_hash_t)*HASH_SIZE);
-  return hash;
+    struct hash_table *ht;
+
+    if ((ht = (struct hash_table *)malloc(sizeof(*ht))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc: %s", strerror(errno));
+	return NULL;
+    }
+    memset(ht, 0, sizeof(*ht));
+    if ((ht->ht_slots = calloc(HASH_SIZE_START, sizeof(struct hash_slot))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc: %s", strerror(errno));
+	free(ht);
+	return NULL;
+    }
+    ht->ht_size = HASH_SIZE_START;
+    return (clicon_hash_t *)ht;
 }
 
 /*! Free hash table.
@@ -136,18 +308,20 @@ clicon_hash_init(void)
 int
 clicon_hash_free(clicon_hash_t *hash)
 {
-    int i;
-    clicon_hash_t tmp;
-    for (i = 0; i < HASH_SIZE; i++) {
-	while (hash[i]) {
-	    tmp = hash[i];
-	    DELQ(tmp, hash[i], clicon_hash_t);
-	    free(tmp->h_key);
-	    free(tmp->h_val);
-	    free(tmp);
+    struct hash_table *ht = (struct hash_table *)hash;
+    size_t             i;
+    clicon_hash_t      h;
+
+    for (i = 0; i < ht->ht_size; i++) {
+	if ((h = ht->ht_slots[i].hs_entry) != NULL){
+	    free(h->h_key);
+	    if (h->h_val)
+		free(h->h_val);
+	    free(h);
 	}
     }
-    free(hash);
+    free(ht->ht_slots);
+    free(ht);
     return 0;
 }
 
@@ -162,19 +336,11 @@ clicon_hash_t
 clicon_hash_lookup(clicon_hash_t *hash, 
 		   const char    *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
+    struct hash_table *ht = (struct hash_table *)hash;
+    size_t             i;
 
-    bkt = hash_bucket(key);
-    h = hash[bkt];
-    if (h) {
-	do {
-	    if (!strcmp(h->h_key, key))
-		return h;
-	    h = NEXTQ(clicon_hash_t, h);
-	} while (h != hash[bkt]);
-    }
-    return NULL;
+    i = hash_slot_find(ht, key, clicon_hash_string(key));
+    return ht->ht_slots[i].hs_entry;
 }
 
 /*! Get value of hash
@@ -220,9 +386,12 @@ clicon_hash_add(clicon_hash_t *hash,
 		void          *val, 
 		size_t         vlen)
 {
-    void         *newval = NULL;
-    clicon_hash_t h;
-    clicon_hash_t new = NULL;
+    struct hash_table *ht = (struct hash_table *)hash;
+    void              *newval = NULL;
+    clicon_hash_t      h;
+    clicon_hash_t      new = NULL;
+    uint64_t           hv;
+    size_t             i;
     
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -235,7 +404,9 @@ clicon_hash_add(clicon_hash_t *hash,
 	goto catch;
     }
     /* If variable exist, don't allocate a new. just replace value */
-    h = clicon_hash_lookup(hash, key);
+    hv = clicon_hash_string(key);
+    i = hash_slot_find(ht, key, hv);
+    h = ht->ht_slots[i].hs_entry;
     if (h == NULL) {
 	if ((new = (clicon_hash_t)malloc(sizeof(*new))) == NULL){
 	    clicon_err(OE_UNIX, errno, "malloc: %s", strerror(errno));
@@ -248,7 +419,12 @@ clicon_hash_add(clicon_hash_t *hash,
 	    clicon_err(OE_UNIX, errno, "strdup: %s", strerror(errno));
 	    goto catch;
 	}
-	
+	/* Grow before insert, slot index is then recomputed */
+	if (hash_full(ht)){
+	    if (hash_grow(ht) < 0)
+		goto catch;
+	    i = hash_slot_find(ht, key, hv);
+	}
 	h = new;
     }
     
@@ -268,10 +444,12 @@ clicon_hash_add(clicon_hash_t *hash,
     h->h_val = newval;
     h->h_vlen =  vlen;
 
-    /* Add to list only if new variable */
-    if (new)
-	INSQ(h, hash[hash_bucket(key)]);
-
+    /* Add to table only if new variable */
+    if (new){
+	ht->ht_slots[i].hs_hash = hv;
+	ht->ht_slots[i].hs_entry = h;
+	ht->ht_nr++;
+    }
     return h;
 
 catch:
@@ -291,25 +469,47 @@ catch:
  *
  * @retval    0       OK
  * @retval   -1       Key not found
+ * Entries after the deleted entry in the same probe sequence are moved back, 
+ * so that no "deleted" markers are needed.
  */
 int
 clicon_hash_del(clicon_hash_t *hash, 
 		const char    *key)
 {
-    clicon_hash_t h;
+    struct hash_table *ht = (struct hash_table *)hash;
+    clicon_hash_t      h;
+    size_t             mask;
+    size_t             i;
+    size_t             j;
+    size_t             k;
 
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
 	return -1;
     }
-    h = clicon_hash_lookup(hash, key);
-    if (h == NULL)
+    i = hash_slot_find(ht, key, clicon_hash_string(key));
+    if ((h = ht->ht_slots[i].hs_entry) == NULL)
 	return -1;
-    
-    DELQ(h, hash[hash_bucket(key)], clicon_hash_t);
+    mask = ht->ht_size - 1;
+    j = i;
+    for (;;){
+	j = (j+1) & mask;
+	if (ht->ht_slots[j].hs_entry == NULL)
+	    break;
+	k = ht->ht_slots[j].hs_hash & mask; /* Home slot of entry in j */
+	/* Entry stays if its home slot is cyclically in (i, j] */
+	if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+	    continue;
+	ht->ht_slots[i] = ht->ht_slots[j];
+	i = j;
+    }
+    ht->ht_slots[i].hs_entry = NULL;
+    ht->ht_slots[i].hs_hash = 0;
+    ht->ht_nr--;
   
     free(h->h_key);
-    free(h->h_val);
+    if (h->h_val)
+	free(h->h_val);
     free(h);
 
     return 0;
@@ -329,32 +529,25 @@ clicon_hash_keys(clicon_hash_t *hash,
 		 char        ***vector,
 		 size_t        *nkeys)
 {
-    int           retval = -1;
-    int           bkt;
-    clicon_hash_t h;
-    char        **tmp;
-    char        **keys = NULL;
+    struct hash_table *ht = (struct hash_table *)hash;
+    int                retval = -1;
+    size_t             i;
+    clicon_hash_t      h;
+    char             **keys = NULL;
 
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
 	return -1;
     }
     *nkeys = 0;
-    for (bkt = 0; bkt < HASH_SIZE; bkt++) {
-	h = hash[bkt];
-	do {
-	    if (h == NULL)
-		break;
-	    tmp = realloc(keys, ((*nkeys)+1) * sizeof(char *));
-	    if (tmp == NULL){
-		clicon_err(OE_UNIX, errno, "realloc: %s", strerror(errno));
-		goto catch;
-	    }
-	    keys = tmp;
-	    keys[*nkeys] = h->h_key;
-	    (*nkeys)++;
-	    h = NEXTQ(clicon_hash_t, h);
-	} while (h != hash[bkt]);
+    if (ht->ht_nr &&
+	(keys = malloc(ht->ht_nr * sizeof(char *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc: %s", strerror(errno));
+	goto catch;
+    }
+    for (i = 0; i < ht->ht_size; i++) {
+	if ((h = ht->ht_slots[i].hs_entry) != NULL)
+	    keys[(*nkeys)++] = h->h_key;
     }
     if (vector){
 	*vector = keys;
@@ -383,7 +576,7 @@ clicon_hash_dump(clicon_hash_t *hash,
     char **keys = NULL;
     void  *val;
     size_t klen;
-    size_t vlen;
+    size_t vlen = 0;
     
     if (hash == NULL)
 	goto ok;
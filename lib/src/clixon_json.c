@@ -49,6 +49,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <dirent.h>
 #include <stdint.h>
 #include <syslog.h>
 
@@ -72,19 +73,21 @@
 #include "clixon_xml_map.h"
 #include "clixon_xml_nsctx.h" /* namespace context */
 #include "clixon_netconf_lib.h"
+#include "clixon_file.h"
+#include "clixon_xml_io.h"
 #include "clixon_json.h"
 #include "clixon_json_parse.h"
 
 #define JSON_INDENT 2 /* maybe we should set this programmatically? */
 
+/* Translated JSON is written to file when output buffer is larger than this */
+#define JSON_OUT_CHUNK 65536
+
 /* Let xml2json_cbuf_vec() return json array: [a,b].
    ALternative is to create a pseudo-object and return that: {top:{a,b}}
 */
 #define VEC_ARRAY 1
 
-/* Size of json read buffer when reading from file*/
-#define BUFLEN 1024
-
 /* Name of xml top object created by xml parse functions */
 #define JSON_TOP_SYMBOL "top"
 
@@ -231,6 +234,7 @@ array_eval(cxobj *xprev,
 }
 
 /*! Escape a json string as well as decode xml cdata
+ * Runs of characters that need no escaping are appended as they are.
  * @param[out] cb   cbuf   (encoded)
  * @param[in]  str  string (unencoded)
  */
@@ -238,46 +242,47 @@ static int
 json_str_escape_cdata(cbuf *cb,
 		      char *str)
 {
-    int   retval = -1;
-    int   i;
-    int   esc = 0; /* cdata escape */
+    char  *p = str;
+    size_t n;
+    int    esc = 0; /* cdata escape */
 
-    for (i=0;i<strlen(str);i++)
-	switch (str[i]){
+    while (*p != '\0'){
+	if ((n = strcspn(p, esc?"\n\"\\]":"\n\"\\<")) > 0){
+	    cbuf_append_buf(cb, p, n);
+	    p += n;
+	}
+	switch (*p){
 	case '\n':
-	    cprintf(cb, "\\n");
+	    cbuf_append_str(cb, "\\n");
 	    break;
 	case '\"':
-	    cprintf(cb, "\\\"");
+	    cbuf_append_str(cb, "\\\"");
 	    break;
 	case '\\':
-	    cprintf(cb, "\\\\");
+	    cbuf_append_str(cb, "\\\\");
 	    break;
-	case '<':
-	    if (!esc &&
-		strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		esc=1;
-		i += strlen("<![CDATA[")-1;
+	case '<': /* Only if !esc */
+	    if (strncmp(p, "<![CDATA[", strlen("<![CDATA[")) == 0){
+		esc = 1;
+		p += strlen("<![CDATA[")-1;
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append(cb, *p);
 	    break;
-	case ']':
-	    if (esc &&
-		strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		esc=0;
-		i += strlen("]]>")-1;
+	case ']': /* Only if esc */
+	    if (strncmp(p, "]]>", strlen("]]>")) == 0){
+		esc = 0;
+		p += strlen("]]>")-1;
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
-	    break;
-	default: /* fall thru */
-	    cprintf(cb, "%c", str[i]);
+		cbuf_append(cb, *p);
 	    break;
+	default: /* end of string */
+	    continue;
 	}
-    retval = 0;
-    // done:
-    return retval;
+	p++;
+    }
+    return 0;
 }
 
 /*! Decode types from JSON to XML identityrefs
@@ -514,6 +519,8 @@ xml2json_encode_identityref(cxobj     *xb,
 }
 
 /*! Encode leaf/leaf_list types from XML to JSON
+ * The body is written directly to cb0, only a translated identityref is made in a
+ * separate buffer.
  * @param[in]     x   XML body
  * @param[in]     ys  Yang spec of parent
  * @param[out]    cb0  Encoded string
@@ -532,15 +539,13 @@ xml2json_encode_leafs(cxobj     *xb,
     char         *body;
     enum cv_type  cvtype;
     int           quote = 1; /* Quote value w string: "val" */
-    cbuf         *cb = NULL; /* the variable itself */
+    char         *str;       /* the variable itself */
+    cbuf         *cb = NULL; /* translated identityref */
 
-    if ((cb = cbuf_new()) ==NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
-	goto done;
-    }
     body = xb?xml_value(xb):NULL;
+    str = body;
     if (yp == NULL){
-	cprintf(cb, "%s", body?body:"null"); 
+	str = body?body:"null";
 	goto ok; /* unknown */
     }
     keyword = yang_keyword_get(yp);
@@ -555,17 +560,16 @@ xml2json_encode_leafs(cxobj     *xb,
 	case CGV_STRING:
 	case CGV_REST:
 	    if (body==NULL)
-		; /* empty: "" */
-	    else if (ytype){
-		if (strcmp(restype, "identityref")==0){
-		    if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
-			goto done;
+		str = ""; /* empty: "" */
+	    else if (ytype && strcmp(restype, "identityref")==0){
+		if ((cb = cbuf_new()) ==NULL){
+		    clicon_err(OE_XML, errno, "cbuf_new");
+		    goto done;
 		}
-		else
-		    cprintf(cb, "%s", body);
+		if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
+		    goto done;
+		str = cbuf_get(cb);
 	    }
-	    else
-		cprintf(cb, "%s", body);
 	    break;
 	case CGV_INT8:
 	case CGV_INT16:
@@ -577,39 +581,38 @@ xml2json_encode_leafs(cxobj     *xb,
 	case CGV_UINT64:
 	case CGV_DEC64:
 	case CGV_BOOL:
-	    cprintf(cb, "%s", body);
 	    quote = 0;
 	    break;
 	case CGV_VOID:
 	    /* special case YANG empty type */
 	    if (body == NULL && strcmp(restype, "empty")==0){
 		quote = 0;
-		cprintf(cb, "[null]");
+		str = "[null]";
 	    }
+	    else
+		str = "";
 	    break;
 	default:
-	    if (body)
-		cprintf(cb, "%s", body);
-	    else
-		cprintf(cb, "{}"); /* dont know */
+	    if (body == NULL)
+		str = "{}"; /* dont know */
 	}
 	break;
     default:
-	cprintf(cb, "%s", body);
 	break;
     }
  ok:
+    if (str == NULL) /* No body where one is expected */
+	str = "null";
     /* write into original cb0
      * includign quoting and encoding 
      */
     if (quote){
-	cprintf(cb0, "\"");
-	json_str_escape_cdata(cb0, cbuf_get(cb));
+	cbuf_append(cb0, '"');
+	json_str_escape_cdata(cb0, str);
+	cbuf_append(cb0, '"');
     }
     else
-	cprintf(cb0, "%s", cbuf_get(cb));
-    if (quote)
-	cprintf(cb0, "\"");
+	cbuf_append_str(cb0, str);
     retval = 0;
  done:
     if (cb)
@@ -635,14 +638,14 @@ nullchild(cbuf      *cb,
 	/* This is very problematic.
 	 * RFC 7951 explicitly forbids "null" to be used unless for empty types in [null]
 	 */
-	cprintf(cb, "{}");
+	cbuf_append_str(cb, "{}");
     }
     else{
 	switch (yang_keyword_get(y)){
 	case Y_ANYXML:
 	case Y_ANYDATA:
 	case Y_CONTAINER:
-	    cprintf(cb, "{}");
+	    cbuf_append_str(cb, "{}");
 	    break;
 	case Y_LEAF:
 	case Y_LEAF_LIST:
@@ -653,7 +656,7 @@ nullchild(cbuf      *cb,
 	    /* This is very problematic.
 	     * RFC 7951 explicitly forbids "null" to be used unless for empty types in [null]
 	     */
-	    cprintf(cb, "{}");
+	    cbuf_append_str(cb, "{}");
 	    break;
 	}
     }
@@ -662,6 +665,30 @@ nullchild(cbuf      *cb,
     return retval;
 }
 
+/*! Append a JSON member name, ie "module:name": or "name":, with indentation
+ * @param[in]  cb      Cligen buffer
+ * @param[in]  modname Module name or NULL
+ * @param[in]  name    Name
+ * @param[in]  indent  Nr of spaces to indent
+ * @param[in]  pretty  Pretty-print: space after colon
+ */
+static void
+json_cbuf_name(cbuf *cb,
+	       char *modname,
+	       char *name,
+	       int   indent,
+	       int   pretty)
+{
+    clixon_cbuf_indent(cb, indent);
+    cbuf_append(cb, '"');
+    if (modname){
+	cbuf_append_str(cb, modname);
+	cbuf_append(cb, ':');
+    }
+    cbuf_append_str(cb, name);
+    cbuf_append_str(cb, pretty?"\": ":"\":");
+}
+
 /*! Do the actual work of translating XML to JSON 
  * @param[out]   cb        Cligen text buffer containing json on exit
  * @param[in]    x         XML tree structure containing XML to translate
@@ -671,6 +698,9 @@ nullchild(cbuf      *cb,
  * @param[in]    pretty    Pretty-print output (2 means debug)
  * @param[in]    flat      Dont print NO_ARRAY object name (for _vec call)
  * @param[in]    bodystr   Set if value is string, 0 otherwise. Only if body
+ * @param[in]    chunk     Call fn when buffer is larger than this
+ * @param[in]    fn        Function consuming buffer, or NULL
+ * @param[in]    arg       Argument to fn
  *
  * @note Does not work with XML attributes
  * The following matrix explains how the mapping is done.
@@ -707,7 +737,10 @@ xml2json1_cbuf(cbuf                   *cb,
 	       int                     level,
 	       int                     pretty,
 	       int                     flat,
-	       char                   *modname0)
+	       char                   *modname0,
+	       size_t                  chunk,
+	       clicon_xml2cbuf_fn     *fn,
+	       void                   *arg)
 {
     int              retval = -1;
     int              i;
@@ -742,10 +775,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	break;
     case NO_ARRAY:
 	if (!flat){
-	    cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	    if (modname) 
-		cprintf(cb, "%s:", modname);
-	    cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	    json_cbuf_name(cb, modname, xml_name(x), pretty?level*JSON_INDENT:0, pretty);
 	}
 	switch (childt){
 	case NULL_CHILD:
@@ -755,7 +785,9 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append(cb, '{');
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    break;
 	default:
 	    break;
@@ -763,14 +795,13 @@ xml2json1_cbuf(cbuf                   *cb,
 	break;
     case FIRST_ARRAY:
     case SINGLE_ARRAY:
-	cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	if (modname)
-	    cprintf(cb, "%s:", modname);
-	cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	json_cbuf_name(cb, modname, xml_name(x), pretty?level*JSON_INDENT:0, pretty);
 	level++;
-	cprintf(cb, "[%s%*s", 
-		pretty?"\n":"",
-		pretty?(level*JSON_INDENT):0, "");
+	cbuf_append(cb, '[');
+	if (pretty){
+	    cbuf_append(cb, '\n');
+	    clixon_cbuf_indent(cb, level*JSON_INDENT);
+	}
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -779,7 +810,9 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append(cb, '{');
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    break;
 	default:
 	    break;
@@ -788,8 +821,8 @@ xml2json1_cbuf(cbuf                   *cb,
     case MIDDLE_ARRAY:
     case LAST_ARRAY:
 	level++;
-	cprintf(cb, "%*s", 
-		pretty?(level*JSON_INDENT):0, "");
+	if (pretty)
+	    clixon_cbuf_indent(cb, level*JSON_INDENT);
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -798,7 +831,9 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append(cb, '{');
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    break;
 	default:
 	    break;
@@ -823,12 +858,17 @@ xml2json1_cbuf(cbuf                   *cb,
 	if (xml2json1_cbuf(cb, 
 			   xc, 
 			   xc_arraytype,
-			   level+1, pretty, 0, modname0) < 0)
+			   level+1, pretty, 0, modname0,
+			   chunk, fn, arg) < 0)
 	    goto done;
 	if (commas > 0) {
-	    cprintf(cb, ",%s", pretty?"\n":"");
+	    cbuf_append(cb, ',');
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    --commas;
 	}
+	if (fn && cbuf_len(cb) >= chunk && fn(cb, arg) < 0)
+	    goto done;
     }
     switch (arraytype){
     case BODY_ARRAY:
@@ -839,9 +879,11 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
+	    if (pretty){
+		cbuf_append(cb, '\n');
+		clixon_cbuf_indent(cb, level*JSON_INDENT);
+	    }
+	    cbuf_append(cb, '}');
 	    break;
 	default:
 	    break;
@@ -855,9 +897,11 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
+	    if (pretty){
+		cbuf_append(cb, '\n');
+		clixon_cbuf_indent(cb, level*JSON_INDENT);
+	    }
+	    cbuf_append(cb, '}');
 	    level--;
 	    break;
 	default:
@@ -869,20 +913,25 @@ xml2json1_cbuf(cbuf                   *cb,
 	switch (childt){
 	case NULL_CHILD:
 	case BODY_CHILD:
-	    cprintf(cb, "%s",pretty?"\n":"");
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
-	    cprintf(cb, "%s",pretty?"\n":"");
+	    if (pretty){
+		cbuf_append(cb, '\n');
+		clixon_cbuf_indent(cb, level*JSON_INDENT);
+	    }
+	    cbuf_append(cb, '}');
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    level--;
 	    break;
 	default:
 	    break;
 	}
-	cprintf(cb, "%*s]",
-		pretty?(level*JSON_INDENT):0,"");
+	if (pretty)
+	    clixon_cbuf_indent(cb, level*JSON_INDENT);
+	cbuf_append(cb, ']');
 	break;
     default:
 	break;
@@ -917,6 +966,32 @@ int
 xml2json_cbuf(cbuf      *cb, 
 	      cxobj     *x, 
 	      int        pretty)
+{
+    return xml2json_cbuf_stream(cb, x, pretty, 0, NULL, NULL);
+}
+
+/*! Translate an XML tree to JSON in a CLIgen buffer in parts
+ *
+ * As xml2json_cbuf, but when the buffer has grown to chunk bytes after an 
+ * element, fn is called. fn should consume the buffer, eg write it, and reset it.
+ * @param[in,out] cb     Cligen buffer to write to
+ * @param[in]     x      XML tree to translate from
+ * @param[in]     pretty Set if output is pretty-printed
+ * @param[in]     chunk  Call fn when buffer is larger than this
+ * @param[in]     fn     Function consuming buffer
+ * @param[in]     arg    Argument to fn
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @note The last part of the JSON remains in cb when returning
+ * @see clicon_xml2cbuf_stream
+ */
+int 
+xml2json_cbuf_stream(cbuf               *cb, 
+		     cxobj              *x, 
+		     int                 pretty,
+		     size_t              chunk,
+		     clicon_xml2cbuf_fn *fn,
+		     void               *arg)
 {
     int    retval = 1;
     int    level = 0;
@@ -930,8 +1005,8 @@ xml2json_cbuf(cbuf      *cb,
 		       level+1,
 		       pretty,
 		       0,
-		       NULL /* ancestor modname / namespace */
-		       ) < 0)
+		       NULL, /* ancestor modname / namespace */
+		       chunk, fn, arg) < 0)
 	goto done;
     cprintf(cb, "%s%*s}%s", 
 	    pretty?"\n":"",
@@ -990,7 +1065,7 @@ xml2json_cbuf_vec(cbuf      *cb,
 		       xp, 
 		       NO_ARRAY,
 		       level+1, pretty,
-		       1, NULL) < 0)
+		       1, NULL, 0, NULL, NULL) < 0)
 	goto done;
 
     if (0){
@@ -1008,6 +1083,40 @@ xml2json_cbuf_vec(cbuf      *cb,
     return retval;
 }
 
+/*! Write a part of translated JSON to an output stream, see xml2json_cbuf_stream
+ * @param[in]  cb   Buffer with JSON, reset when written
+ * @param[in]  arg  Output stream (FILE*)
+ */
+static int
+json2file_part(cbuf *cb,
+	       void *arg)
+{
+    FILE *f = (FILE *)arg;
+
+    if (cbuf_len(cb) && fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb)){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	return -1;
+    }
+    cbuf_reset(cb);
+    return 0;
+}
+
+/*! Write a part of translated JSON to a file descriptor, see xml2json_cbuf_stream
+ * @param[in]  cb   Buffer with JSON, reset when written
+ * @param[in]  arg  Pointer to file descriptor (int*)
+ */
+static int
+json2fd_part(cbuf *cb,
+	     void *arg)
+{
+    int fd = *(int *)arg;
+
+    if (clicon_file_write(fd, cbuf_get(cb), cbuf_len(cb)) < 0)
+	return -1;
+    cbuf_reset(cb);
+    return 0;
+}
+
 /*! Translate from xml tree to JSON and print to file using a callback
  * @param[in]  f      File to print to
  * @param[in]  x      XML tree to translate from
@@ -1064,7 +1173,54 @@ xml2json(FILE      *f,
 	 cxobj     *x, 
 	 int        pretty)
 {
-    return xml2json_cb(f, x, pretty, fprintf);
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) ==NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (xml2json_cbuf_stream(cb, x, pretty, JSON_OUT_CHUNK, json2file_part, f) < 0)
+	goto done;
+    if (json2file_part(cb, f) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Translate from xml tree to JSON and write to a file descriptor
+ * The JSON is written in large blocks as it is translated.
+ * @param[in]  fd     File descriptor
+ * @param[in]  x      XML tree to translate from
+ * @param[in]  pretty Set if output is pretty-printed
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clicon_xml2fd
+ */
+int 
+xml2json_fd(int        fd, 
+	    cxobj     *x, 
+	    int        pretty)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) ==NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (xml2json_cbuf_stream(cb, x, pretty, JSON_OUT_CHUNK, json2fd_part, &fd) < 0)
+	goto done;
+    if (json2fd_part(cb, &fd) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
 }
 
 
@@ -1077,7 +1233,7 @@ int
 json_print(FILE  *f, 
 	   cxobj *x)
 {
-    return xml2json_cb(f, x, 1, fprintf);
+    return xml2json(f, x, 1);
 }
 
 /*! Translate a vector of xml objects to JSON File.
@@ -1182,6 +1338,8 @@ json_xmlns_translate(yang_stmt *yspec,
  * are split and interpreted as in RFC7951
  *
  * @param[in]  str    Input string containing JSON
+ * @param[in]  len    If > 0, parse str in place: length of str including two
+ *                    terminating null bytes. If 0, str is copied by the scanner.
  * @param[in]  yb     How to bind yang to XML top-level when parsing
  * @param[in]  yspec  If set, also do yang validation
  * @param[out] xt     XML top of tree typically w/o children on entry (but created)
@@ -1196,6 +1354,7 @@ json_xmlns_translate(yang_stmt *yspec,
  */
 static int 
 _json_parse(char      *str, 
+	    size_t     len,
 	    yang_bind  yb,
 	    yang_stmt *yspec,
 	    cxobj     *xt,
@@ -1211,6 +1370,7 @@ _json_parse(char      *str,
     
     clicon_debug(1, "%s %d %s", __FUNCTION__, yb, str);
     jy.jy_parse_string = str;
+    jy.jy_parse_len = len;
     jy.jy_linenum = 1;
     jy.jy_current = xt;
     jy.jy_xtop = xt;
@@ -1348,7 +1508,7 @@ clixon_json_parse_string(char      *str,
 	if ((*xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
 	    return -1;
     }
-    return _json_parse(str, yb, yspec, *xt, xerr);
+    return _json_parse(str, 0, yb, yspec, *xt, xerr);
 }
 
 /*! Read a JSON definition from file and parse it into a parse-tree. 
@@ -1377,6 +1537,7 @@ clixon_json_parse_string(char      *str,
  * @note  you need to free the xml parse tree after use, using xml_free()
  * @note, If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
  * @note May block on file I/O
+ * @note If enabled, nodes are allocated in an arena, see xml_arena_begin
  *
  * @retval        1     OK and valid
  * @retval        0     Invalid (only if yang spec) w xerr set
@@ -1395,56 +1556,34 @@ clixon_json_parse_file(int        fd,
     int       retval = -1;
     int       ret;
     char     *jsonbuf = NULL;
-    int       jsonbuflen = BUFLEN; /* start size */
-    int       oldjsonbuflen;
-    char     *ptr;
-    char      ch;
-    int       len = 0;
+    size_t    len = 0;
+    int       arena = 0;
     
     if (xt==NULL){
 	clicon_err(OE_XML, EINVAL, "xt is NULL");
 	return -1;
     }
-    if ((jsonbuf = malloc(jsonbuflen)) == NULL){
-	clicon_err(OE_XML, errno, "malloc");
+    /* Read whole file in large blocks */
+    if (clicon_file_read(fd, &jsonbuf, &len) < 0)
 	goto done;
-    }
-    memset(jsonbuf, 0, jsonbuflen);
-    ptr = jsonbuf;
-    while (1){
-	if ((ret = read(fd, &ch, 1)) < 0){
-	    clicon_err(OE_XML, errno, "read");
-	    break;
-	}
-	if (ret != 0)
-	    jsonbuf[len++] = ch;
-	if (ret == 0){
-	    if (*xt == NULL)
-		if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-		    goto done;
-	    if (len){
-		if ((ret = _json_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-	    }
-	    break;
-	}
-	if (len >= jsonbuflen-1){ /* Space: one for the null character */
-	    oldjsonbuflen = jsonbuflen;
-	    jsonbuflen *= 2;
-	    if ((jsonbuf = realloc(jsonbuf, jsonbuflen)) == NULL){
-		clicon_err(OE_XML, errno, "realloc");
-		goto done;
-	    }
-	    memset(jsonbuf+oldjsonbuflen, 0, jsonbuflen-oldjsonbuflen);
-	    ptr = jsonbuf;
-	}
+    if ((arena = xml_arena_begin()) < 0)
+	goto done;
+    if (*xt == NULL)
+	if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	    goto done;
+    if (len){
+	/* Parse buffer in place, it is terminated by two null bytes */
+	if ((ret = _json_parse(jsonbuf, len+2, yb, yspec, *xt, xerr)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
     }
     retval = 1;
  done:
+    if (arena)
+	xml_arena_end();
     if (retval < 0 && *xt){
-	free(*xt);
+	xml_free(*xt);
 	*xt = NULL;
     }
     if (jsonbuf)
@@ -42,7 +42,8 @@
 
 struct clixon_json_yacc { 
     int        jy_linenum;      /* Number of \n in parsed buffer */
-    char      *jy_parse_string; /* original (copy of) parse string */
+    char      *jy_parse_string; /* original parse string */
+    size_t     jy_parse_len;    /* If set, parse string in place: length incl two null bytes */
     void      *jy_lexbuf;       /* internal parse buffer from lex */
     cxobj     *jy_xtop;         /* cxobj top element (fixed) */
     cxobj     *jy_current;      /* cxobj active element (changes with parse context) */
@@ -0,0 +1,324 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written JSON scanner, alternative to the flex scanner in clixon_json_parse.l
+ * Enabled with configure --enable-xml-scanner.
+ * Returns the same tokens as the flex scanner to the yacc parser in 
+ * clixon_json_parse.y, except that string characters between escapes are returned
+ * as one J_CHAR token instead of one token per character.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#ifdef CLIXON_XML_SCANNER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "clixon_json_parse.tab.h"   /* generated file */
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_err.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_json_parse.h"
+#include "clixon_scan.h"
+
+/* Scanner states, same as start conditions in clixon_json_parse.l */
+enum json_scan_state{
+    JS_START,
+    JS_STRING,
+    JS_ESCAPE
+};
+
+/*! JSON scanner state, kept in jy_lexbuf */
+struct json_scan{
+    char  *js_buf;    /* Scanned buffer, terminated by two null bytes */
+    int    js_copy;   /* js_buf is a copy of the parse string, free it */
+    char  *js_p;      /* Current position in js_buf */
+    char  *js_end;    /* End of js_buf (first null byte) */
+    char  *js_holdp;  /* Null byte terminating last token, or NULL */
+    char   js_hold;   /* Character overwritten by that null byte */
+    enum json_scan_state js_state;
+};
+
+#define DIGIT(c) ((c)>='0' && (c)<='9')
+
+/* Delimiter set of strings, initialized once */
+static int             _js_init = 0;
+static clixon_scan_set _js_string;
+
+/*! Return token: null-terminate its text in the buffer and advance
+ */
+static int
+js_token(struct json_scan *js,
+	 char             *start,
+	 char             *end,
+	 int               token)
+{
+    clixon_json_parsetext = start;
+    js->js_holdp = end;
+    js->js_hold = *end;
+    *end = '\0';
+    js->js_p = end;
+    return token;
+}
+
+/*! Return token with a copy of its text as value
+ */
+static int
+js_token_dup(struct json_scan *js,
+	     char             *start,
+	     char             *end,
+	     int               token)
+{
+    if ((clixon_json_parselval.string = strndup(start, end-start)) == NULL){
+	clicon_err(OE_XML, errno, "strndup");
+	return -1;
+    }
+    return js_token(js, start, end, token);
+}
+
+/*! Return 1 if the string s is at p (and before end)
+ */
+static inline int
+js_match(char       *p,
+	 char       *end,
+	 const char *s,
+	 size_t      len)
+{
+    return (size_t)(end - p) >= len && memcmp(p, s, len) == 0;
+}
+
+/*! Scan a number: -?({integer}|{real}|{exp}), see clixon_json_parse.l
+ * @param[in]  p    Start of number
+ * @param[in]  end  End of buffer
+ * @retval     q    End of number
+ * @retval     NULL Not a number
+ */
+static char *
+js_number(char *p,
+	  char *end)
+{
+    char *q = p;
+    char *n = NULL;
+    char *r;
+
+    if (q < end && *q == '-')
+	q++;
+    for (r = q; r < end && DIGIT(*r); r++);
+    if (r > q)                                   /* integer */
+	n = r;
+    if (r < end && *r == '.'){
+	for (r++; r < end && DIGIT(*r); r++);
+	if (r - q > 1)                           /* real */
+	    n = r;
+    }
+    if (n && end - n >= 3 &&                     /* exp */
+	(*n == 'e' || *n == 'E') &&
+	(n[1] == '+' || n[1] == '-') && DIGIT(n[2])){
+	for (r = n+3; r < end && DIGIT(*r); r++);
+	n = r;
+    }
+    return n;
+}
+
+/*! Scan next token, called by the yacc parser
+ * @param[in]  _jy  JSON parser yacc handler struct
+ * @retval     token
+ * @retval     0     End of input in a string
+ * @retval    -1     Error, or invalid character
+ */
+int
+clixon_json_parselex(void *_jy)
+{
+    clixon_json_yacc *jy = (clixon_json_yacc *)_jy;
+    struct json_scan *js = (struct json_scan *)jy->jy_lexbuf;
+    char             *p;
+    char             *q;
+    char             *end;
+    char              c;
+
+    if (js->js_holdp){
+	*js->js_holdp = js->js_hold;
+	js->js_holdp = NULL;
+    }
+    p = js->js_p;
+    end = js->js_end;
+    while (1){
+	if (p >= end){
+	    if (js->js_state == JS_START)
+		return js_token(js, end, end, J_EOF);
+	    js_token(js, end, end, 0);
+	    return 0;
+	}
+	c = *p;
+	switch (js->js_state){
+	case JS_START:
+	    switch (c){
+	    case ' ': case '\t': case '\r':
+		p++;
+		continue;
+	    case '\n':
+		jy->jy_linenum++;
+		p++;
+		continue;
+	    case '{': case '}': case '[': case ']': case ':': case ',':
+		return js_token(js, p, p+1, c);
+	    case '"':
+		js->js_state = JS_STRING;
+		return js_token(js, p, p+1, J_DQ);
+	    default:
+		break;
+	    }
+	    if (js_match(p, end, "null", 4))
+		return js_token(js, p, p+4, J_NULL);
+	    if (js_match(p, end, "false", 5))
+		return js_token(js, p, p+5, J_FALSE);
+	    if (js_match(p, end, "true", 4))
+		return js_token(js, p, p+4, J_TRUE);
+	    if ((q = js_number(p, end)) != NULL)
+		return js_token_dup(js, p, q, J_NUMBER);
+	    js_token(js, p, p+1, -1);
+	    return -1;
+	case JS_STRING:
+	    switch (c){
+	    case '"':
+		js->js_state = JS_START;
+		return js_token(js, p, p+1, J_DQ);
+	    case '\\':
+		js->js_state = JS_ESCAPE;
+		p++;
+		continue;
+	    case '\n':
+		jy->jy_linenum++;
+		return js_token_dup(js, p, p+1, J_CHAR);
+	    default:
+		q = clixon_scan_delim(&_js_string, p+1, end);
+		return js_token_dup(js, p, q, J_CHAR);
+	    }
+	    break;
+	case JS_ESCAPE:
+	    if (c == '\n'){ /* Not matched by flex scanner either */
+		p++;
+		continue;
+	    }
+	    js->js_state = JS_STRING;
+	    return js_token_dup(js, p, p+1, J_CHAR);
+	}
+    }
+    return 0; /* not reached */
+}
+
+/*! Initialize JSON scanner.
+ */
+int
+json_scan_init(clixon_json_yacc *jy)
+{
+    int               retval = -1;
+    struct json_scan *js = NULL;
+    size_t            len;
+
+    if (_js_init == 0){
+	if (clixon_scan_set_init(&_js_string, "\"\\\n") < 0)
+	    goto done;
+	_js_init++;
+    }
+    if ((js = malloc(sizeof(*js))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memset(js, 0, sizeof(*js));
+    if (jy->jy_parse_len){ /* Scan in place, no copy */
+	len = jy->jy_parse_len;
+	if (len < 2 || jy->jy_parse_string[len-2] != '\0' || jy->jy_parse_string[len-1] != '\0'){
+	    clicon_err(OE_XML, 0, "Parse buffer not terminated by two null bytes");
+	    goto done;
+	}
+	js->js_buf = jy->jy_parse_string;
+	len -= 2;
+    }
+    else{
+	len = strlen(jy->jy_parse_string);
+	if ((js->js_buf = malloc(len+2)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	memcpy(js->js_buf, jy->jy_parse_string, len);
+	js->js_buf[len] = '\0';
+	js->js_buf[len+1] = '\0';
+	js->js_copy = 1;
+    }
+    js->js_p = js->js_buf;
+    js->js_end = js->js_buf + len;
+    js->js_state = JS_START;
+    jy->jy_lexbuf = js;
+    js = NULL;
+    retval = 0;
+ done:
+    if (js)
+	free(js);
+    return retval;
+}
+
+/*! Exit JSON scanner
+ */
+int
+json_scan_exit(clixon_json_yacc *jy)
+{
+    struct json_scan *js = (struct json_scan *)jy->jy_lexbuf;
+
+    if (js == NULL)
+	return 0;
+    if (js->js_holdp)
+	*js->js_holdp = js->js_hold;
+    if (js->js_copy)
+	free(js->js_buf);
+    free(js);
+    jy->jy_lexbuf = NULL;
+    return 0;
+}
+
+#endif /* CLIXON_XML_SCANNER */
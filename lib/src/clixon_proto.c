@@ -340,7 +340,7 @@ clicon_msg_send(int                s,
     return retval;
 }
 
-/*! Receive a CLICON message
+/*! Receive one CLICON message frame
  *
  * XXX: timeout? and signals?
  * There is rudimentary code for turning on signals and handling them 
@@ -354,11 +354,12 @@ clicon_msg_send(int                s,
  * @param[out]  msg    CLICON msg data reply structure. Free with free()
  * @param[out]  eof    Set if eof encountered
  * Note: caller must ensure that s is closed if eof is set after call.
+ * @note A reply may consist of several frames, see clicon_msg_rcv
  */
 int
-clicon_msg_rcv(int                s,
-	       struct clicon_msg **msg,
-	       int                *eof)
+clicon_msg_rcv_frame(int                s,
+		     struct clicon_msg **msg,
+		     int                *eof)
 { 
     int       retval = -1;
     struct clicon_msg hdr;
@@ -409,6 +410,101 @@ clicon_msg_rcv(int                s,
     return retval;
 }
 
+/*! Receive the remaining frames of a reply and append them to its first frame
+ *
+ * A large reply, eg of get, is sent by the backend in several frames with the same 
+ * request-id, where all but the last have CLICON_MSG_F_MORE set. The bodies are 
+ * null-terminated strings which are concatenated.
+ * @param[in]     s    socket (unix or inet) to communicate with backend
+ * @param[in,out] msg  First frame, extended with remaining frames. Free with free()
+ * @param[out]    eof  Set if eof encountered, msg is then freed and set to NULL
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+int
+clicon_msg_rcv_rest(int                s,
+		    struct clicon_msg **msg,
+		    int                *eof)
+{
+    int                retval = -1;
+    struct clicon_msg *m = *msg;
+    struct clicon_msg *frame = NULL;
+    size_t             len;
+    size_t             flen;
+    size_t             size;
+
+    *eof = 0;
+    len = size = ntohl(m->op_len);
+    while (ntohl(m->op_flags) & CLICON_MSG_F_MORE){
+	if (clicon_msg_rcv_frame(s, &frame, eof) < 0)
+	    goto done;
+	if (*eof)
+	    break;
+	if (frame->op_reqid != m->op_reqid){
+	    clicon_err(OE_PROTO, EPROTO, "Reply %u interleaved with reply %u",
+		       ntohl(frame->op_reqid), ntohl(m->op_reqid));
+	    goto done;
+	}
+	/* Overwrite null-termination of body with next body */
+	if (len > sizeof(*m) && ((char*)m)[len-1] == '\0')
+	    len--;
+	flen = ntohl(frame->op_len) - sizeof(*frame);
+	if (len + flen > size){
+	    while (size < len + flen)
+		size *= 2;
+	    if ((m = realloc(m, size)) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		goto done;
+	    }
+	    *msg = m;
+	}
+	memcpy((char*)m + len, frame->op_body, flen);
+	len += flen;
+	m->op_len = htonl(len);
+	m->op_flags = frame->op_flags;
+	free(frame);
+	frame = NULL;
+    }
+    if (*eof){
+	free(m);
+	*msg = NULL;
+    }
+    retval = 0;
+ done:
+    if (frame)
+	free(frame);
+    return retval;
+}
+
+/*! Receive a CLICON message
+ *
+ * If the message is a reply sent in several frames, all frames are received 
+ * and returned as one message.
+ * @param[in]   s      socket (unix or inet) to communicate with backend
+ * @param[out]  msg    CLICON msg data reply structure. Free with free()
+ * @param[out]  eof    Set if eof encountered
+ * Note: caller must ensure that s is closed if eof is set after call.
+ * @see clicon_msg_rcv_frame  to receive one frame
+ */
+int
+clicon_msg_rcv(int                s,
+	       struct clicon_msg **msg,
+	       int                *eof)
+{ 
+    int retval = -1;
+
+    if (clicon_msg_rcv_frame(s, msg, eof) < 0)
+	goto done;
+    if (*eof)
+	goto ok;
+    if (clicon_msg_rcv_rest(s, msg, eof) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Connect to server, send a clicon_msg message and wait for result using unix socket
  *
  * @param[in]  h       Clicon handle
@@ -454,6 +550,44 @@ clicon_rpc_connect_unix(clicon_handle      h,
     return retval;
 }
 
+/*! Open connection to server using an inet socket
+ * @param[in]  h       Clicon handle
+ * @param[in]  dst     IPv4 address
+ * @param[in]  port    TCP port
+ * @retval     s       socket
+ * @retval     -1      error
+ */
+int
+clicon_connect_inet(clicon_handle h,
+		    char         *dst,
+		    uint16_t      port)
+{
+    int                retval = -1;
+    int                s;
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(addr.sin_family, dst, &addr.sin_addr) != 1){
+	clicon_err(OE_CFG, errno, "inet_pton: %s", dst);
+	goto done; /* Could check getaddrinfo */
+    }
+    if ((s = socket(addr.sin_family, SOCK_STREAM, 0)) < 0) {
+	clicon_err(OE_CFG, errno, "socket");
+	goto done;
+    }
+    clicon_debug(2, "%s: connecting to %s:%hu", __FUNCTION__, dst, port);
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+	clicon_err(OE_CFG, errno, "connecting socket inet4");
+	close(s);
+	goto done;
+    }
+    retval = s;
+ done:
+    return retval;
+}
+
 /*! Connect to server, send a clicon_msg message and wait for result using an inet socket
  *
  * @param[in]  h       Clicon handle
@@ -476,26 +610,10 @@ clicon_rpc_connect_inet(clicon_handle      h,
 {
     int                retval = -1;
     int                s = -1;
-    struct sockaddr_in addr;
 
     clicon_debug(1, "Send msg to %s:%hu", dst, port);
-
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    if (inet_pton(addr.sin_family, dst, &addr.sin_addr) != 1)
-	goto done; /* Could check getaddrinfo */
-    
-    /* special error handling to get understandable messages (otherwise ENOENT) */
-    if ((s = socket(addr.sin_family, SOCK_STREAM, 0)) < 0) {
-	clicon_err(OE_CFG, errno, "socket");
-	return -1;
-    }
-    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0){
-	clicon_err(OE_CFG, errno, "connecting socket inet4");
-	close(s);
+    if ((s = clicon_connect_inet(h, dst, port)) < 0)
 	goto done;
-    }
     if (clicon_rpc(s, msg, retdata) < 0)
 	goto done;
     if (sock0 != NULL)
@@ -559,6 +677,7 @@ clicon_rpc(int                   s,
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
  * @param[in]  s       Socket to communicate with client
+ * @param[in]  reqid   Request-id of request, see clicon_rpc_msg_send
  * @param[in]  data    Returned data as byte-string.
  * @param[in]  datalen Length of returned data XXX  may be unecessary if always string?
  * @retval     0       OK
@@ -566,6 +685,7 @@ clicon_rpc(int                   s,
  */
 int 
 send_msg_reply(int      s, 
+	       uint32_t reqid,
 	       char    *data, 
 	       uint32_t datalen)
 {
@@ -578,6 +698,7 @@ send_msg_reply(int      s,
 	goto done;
     memset(reply, 0, len);
     reply->op_len = htonl(len);
+    reply->op_reqid = htonl(reqid);
     if (datalen > 0)
       memcpy(reply->op_body, data, datalen);
     if (clicon_msg_send(s, reply) < 0)
@@ -49,10 +49,13 @@
 #include <errno.h>
 #include <assert.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/syslog.h>
+#include <poll.h>
+#include <arpa/inet.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -79,9 +82,432 @@
 #include "clixon_xml_bind.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_bin.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_proto_client.h"
 
+/* Max number of requests sent on the persistent connection without reading
+ * replies. Bounds the replies the backend may need to buffer before the
+ * client reads, which otherwise may block both sides.
+ */
+#define CLICON_RPC_PIPELINE_MAX 32
+
+/*! Persistent connection from client to backend, one per handle
+ * Requests are tagged with a request-id which the backend copies to the reply,
+ * so several requests may be outstanding.
+ * @see clicon_rpc_msg_send
+ */
+struct clicon_rpc_conn{
+    int                 rc_s;        /* Socket, or -1 if not connected */
+    pid_t               rc_pid;      /* Process that opened socket (not a forked child) */
+    uint32_t            rc_reqid;    /* Last request-id sent */
+    int                 rc_pending;  /* Nr of requests sent whose reply is not read */
+    struct clicon_msg **rc_replies;  /* Replies read but not yet consumed */
+    int                 rc_nreplies; /* Length of rc_replies */
+};
+
+/*! Get persistent backend connection of handle, create if not exists
+ * @param[in]  h    Clicon handle
+ * @retval     rc   Connection (possibly not connected)
+ * @retval     NULL Error
+ */
+static struct clicon_rpc_conn *
+clicon_rpc_conn_get(clicon_handle h)
+{
+    clicon_hash_t          *cdat = clicon_data(h);
+    struct clicon_rpc_conn *rc;
+    size_t                  len;
+    void                   *p;
+
+    if ((p = clicon_hash_value(cdat, "rpc_conn", &len)) != NULL)
+	return *(struct clicon_rpc_conn **)p;
+    if ((rc = malloc(sizeof(*rc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(rc, 0, sizeof(*rc));
+    rc->rc_s = -1;
+    if (clicon_hash_add(cdat, "rpc_conn", &rc, sizeof(rc)) == NULL){
+	free(rc);
+	return NULL;
+    }
+    return rc;
+}
+
+/*! Close persistent backend connection, drop all outstanding requests
+ * @param[in]  rc   Connection
+ */
+static int
+clicon_rpc_conn_reset(struct clicon_rpc_conn *rc)
+{
+    int i;
+
+    if (rc->rc_s != -1){
+	close(rc->rc_s);
+	rc->rc_s = -1;
+    }
+    for (i=0; i<rc->rc_nreplies; i++)
+	free(rc->rc_replies[i]);
+    if (rc->rc_replies)
+	free(rc->rc_replies);
+    rc->rc_replies = NULL;
+    rc->rc_nreplies = 0;
+    rc->rc_pending = 0;
+    return 0;
+}
+
+/*! Save a reply read on persistent connection until it is asked for
+ * @param[in]  rc    Connection
+ * @param[in]  reply Reply message, consumed
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clicon_rpc_conn_save(struct clicon_rpc_conn *rc,
+		     struct clicon_msg      *reply)
+{
+    struct clicon_msg **replies;
+
+    if ((replies = realloc(rc->rc_replies, (rc->rc_nreplies+1)*sizeof(reply))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	free(reply);
+	return -1;
+    }
+    rc->rc_replies = replies;
+    rc->rc_replies[rc->rc_nreplies++] = reply;
+    return 0;
+}
+
+/*! Connect to backend according to CLICON_SOCK and CLICON_SOCK_FAMILY
+ * @param[in]  h    Clicon handle
+ * @retval     s    Socket
+ * @retval    -1    Error
+ */
+static int
+clicon_rpc_connect(clicon_handle h)
+{
+    char       *sock;
+    int         port;
+    struct stat sb;
+
+    if ((sock = clicon_sock(h)) == NULL){
+	clicon_err(OE_FATAL, 0, "CLICON_SOCK option not set");
+	return -1;
+    }
+    switch (clicon_sock_family(h)){
+    case AF_UNIX:
+	/* special error handling to get understandable messages (otherwise ENOENT) */
+	if (stat(sock, &sb) < 0){
+	    clicon_err(OE_PROTO, errno, "%s: config daemon not running?", sock);
+	    return -1;
+	}
+	if (!S_ISSOCK(sb.st_mode)){
+	    clicon_err(OE_PROTO, EIO, "%s: Not unix socket", sock);
+	    return -1;
+	}
+	return clicon_connect_unix(h, sock);
+    case AF_INET:
+	if ((port = clicon_sock_port(h)) < 0){
+	    clicon_err(OE_FATAL, 0, "CLICON_SOCK_PORT not set");
+	    return -1;
+	}
+	return clicon_connect_inet(h, sock, port);
+    default:
+	clicon_err(OE_PROTO, EAFNOSUPPORT, "CLICON_SOCK_FAMILY not supported");
+	return -1;
+    }
+}
+
+/*! Check if an idle connection has been closed by the backend
+ * With no outstanding requests, nothing should be readable on the socket: 
+ * if it is, the backend has closed it (eg restarted or kill-session).
+ * @param[in]  s    Socket
+ * @retval     1    Socket is closed (or in error)
+ * @retval     0    Socket is open
+ */
+static int
+clicon_rpc_conn_closed(int s)
+{
+    struct pollfd pfd;
+
+    pfd.fd = s;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) < 0)
+	return 1;
+    return pfd.revents != 0;
+}
+
+/*! Close the persistent connection to the backend of a handle
+ * Outstanding replies are dropped. A new connection is made on next request.
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK
+ * @see clicon_rpc_msg_send
+ */
+int
+clicon_rpc_msg_close(clicon_handle h)
+{
+    clicon_hash_t          *cdat = clicon_data(h);
+    struct clicon_rpc_conn *rc;
+    size_t                  len;
+    void                   *p;
+
+    if ((p = clicon_hash_value(cdat, "rpc_conn", &len)) == NULL)
+	return 0;
+    rc = *(struct clicon_rpc_conn **)p;
+    clicon_rpc_conn_reset(rc);
+    free(rc);
+    clicon_hash_del(cdat, "rpc_conn");
+    return 0;
+}
+
+/*! Send internal netconf rpc to backend on persistent connection without waiting for reply
+ *
+ * The connection is opened on first request, and re-opened if the backend has
+ * closed it. Several requests may be sent before their replies are read with
+ * clicon_rpc_msg_rcv.
+ * @param[in]  h      CLICON handle
+ * @param[in]  msg    Encoded message. Request-id is set in the message header
+ * @param[out] reqid  Request-id, use in clicon_rpc_msg_rcv to get the reply
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   uint32_t id[2];
+ *   if (clicon_rpc_msg_send(h, msg1, &id[0]) < 0 ||
+ *       clicon_rpc_msg_send(h, msg2, &id[1]) < 0)
+ *      err;
+ *   if (clicon_rpc_msg_rcv(h, id[0], &xret1) < 0 ||
+ *       clicon_rpc_msg_rcv(h, id[1], &xret2) < 0)
+ *      err;
+ * @endcode
+ * @see clicon_rpc_msg  which sends a request and waits for its reply
+ */
+int
+clicon_rpc_msg_send(clicon_handle      h, 
+		    struct clicon_msg *msg, 
+		    uint32_t          *reqid)
+{
+    int                     retval = -1;
+    struct clicon_rpc_conn *rc;
+    struct clicon_msg      *reply = NULL;
+    int                     eof;
+
+    clicon_debug(1, "%s request:%s", __FUNCTION__, msg->op_body);
+    if ((rc = clicon_rpc_conn_get(h)) == NULL)
+	goto done;
+    /* Do not share socket with parent after fork. Closing the inherited copy
+     * does not affect the connection of the parent */
+    if (rc->rc_s != -1 && rc->rc_pid != getpid())
+	clicon_rpc_conn_reset(rc);
+    if (rc->rc_s != -1 && rc->rc_pending == 0 && clicon_rpc_conn_closed(rc->rc_s)){
+	clicon_debug(1, "%s: backend closed connection, reconnect", __FUNCTION__);
+	clicon_rpc_conn_reset(rc);
+    }
+    if (rc->rc_s == -1){
+	if ((rc->rc_s = clicon_rpc_connect(h)) < 0)
+	    goto done;
+	/* Not inherited by programs executed, eg by plugins */
+	if (fcntl(rc->rc_s, F_SETFD, FD_CLOEXEC) < 0){
+	    clicon_err(OE_UNIX, errno, "fcntl");
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	rc->rc_pid = getpid();
+    }
+    /* Read a reply before sending more if too many are outstanding */
+    if (rc->rc_pending >= CLICON_RPC_PIPELINE_MAX){
+	if (clicon_msg_rcv(rc->rc_s, &reply, &eof) < 0)
+	    goto done;
+	if (eof){
+	    clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	rc->rc_pending--;
+	if (clicon_rpc_conn_save(rc, reply) < 0){
+	    reply = NULL;
+	    goto done;
+	}
+	reply = NULL;
+    }
+    if (++rc->rc_reqid == 0) /* 0 is not used as request-id */
+	rc->rc_reqid++;
+    msg->op_reqid = htonl(rc->rc_reqid);
+    if (clicon_msg_send(rc->rc_s, msg) < 0){
+	clicon_rpc_conn_reset(rc);
+	goto done;
+    }
+    rc->rc_pending++;
+    *reqid = rc->rc_reqid;
+    retval = 0;
+ done:
+    if (reply)
+	free(reply);
+    return retval;
+}
+
+/*! Wait for reply of an internal netconf rpc sent on persistent connection
+ *
+ * Replies of other requests arriving before are saved until asked for.
+ * @param[in]  h      CLICON handle
+ * @param[in]  reqid  Request-id given by clicon_rpc_msg_send
+ * @param[out] xret0  Return value from backend as xml tree. Free w xml_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note A binary encoded reply (CLICON_MSG_F_BIN) is decoded to the same tree
+ * @see clicon_rpc_msg_send
+ */
+int
+clicon_rpc_msg_rcv(clicon_handle h, 
+		   uint32_t      reqid,
+		   cxobj       **xret0)
+{
+    int                     retval = -1;
+    struct clicon_rpc_conn *rc;
+    struct clicon_msg      *reply = NULL;
+    int                     eof;
+    int                     i;
+    cxobj                  *xret = NULL;
+    size_t                  len;
+
+    if ((rc = clicon_rpc_conn_get(h)) == NULL)
+	goto done;
+    /* Already read? */
+    for (i=0; i<rc->rc_nreplies; i++)
+	if (ntohl(rc->rc_replies[i]->op_reqid) == reqid){
+	    reply = rc->rc_replies[i];
+	    rc->rc_nreplies--;
+	    memmove(&rc->rc_replies[i], &rc->rc_replies[i+1],
+		    (rc->rc_nreplies-i)*sizeof(reply));
+	    break;
+	}
+    while (reply == NULL){
+	if (rc->rc_s == -1 || rc->rc_pending == 0){
+	    clicon_err(OE_PROTO, ENOENT, "No outstanding request with request-id %u", reqid);
+	    goto done;
+	}
+	if (clicon_msg_rcv(rc->rc_s, &reply, &eof) < 0){
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	if (eof){
+	    clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	rc->rc_pending--;
+	if (ntohl(reply->op_reqid) == reqid)
+	    break;
+	if (clicon_rpc_conn_save(rc, reply) < 0){
+	    reply = NULL;
+	    goto done;
+	}
+	reply = NULL;
+    }
+    /* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
+     * to reply.
+     */
+    if (ntohl(reply->op_flags) & CLICON_MSG_F_BIN){
+	len = ntohl(reply->op_len) - sizeof(*reply);
+	if (len && reply->op_body[len-1] == '\0') /* null-termination added by sender */
+	    len--;
+	clicon_debug(1, "%s retdata: binary %zu bytes", __FUNCTION__, len);
+	if (clixon_xml_parse_bin(reply->op_body, len, YB_NONE, NULL, &xret, NULL) < 0)
+	    goto done;
+    }
+    else {
+	clicon_debug(1, "%s retdata:%s", __FUNCTION__, reply->op_body);
+	if (clixon_xml_parse_string(reply->op_body, YB_NONE, NULL, &xret, NULL) < 0)
+	    goto done;
+    }
+    if (xret0){
+	*xret0 = xret;
+	xret = NULL;
+    }
+    retval = 0;
+ done:
+    if (reply)
+	free(reply);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
+/*! Send internal netconf rpc to backend and pass the reply to a callback as it arrives
+ *
+ * A large reply, eg of get, is sent by the backend in several messages. Each part
+ * of the reply body is passed to fn when it is received, instead of waiting for the
+ * whole reply and parsing it. The persistent connection of the handle is used.
+ * @param[in]  h      CLICON handle
+ * @param[in]  msg    Encoded message
+ * @param[in]  fn     Called with each part of the reply body, last set on final part
+ * @param[in]  arg    Argument to fn
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clicon_rpc_msg  which waits for the whole reply and parses it
+ */
+int
+clicon_rpc_msg_stream(clicon_handle         h, 
+		      struct clicon_msg    *msg, 
+		      clicon_rpc_stream_cb *fn,
+		      void                 *arg)
+{
+    int                     retval = -1;
+    struct clicon_rpc_conn *rc;
+    struct clicon_msg      *frame = NULL;
+    uint32_t                reqid;
+    int                     eof;
+    int                     more;
+    size_t                  len;
+
+    if (clicon_rpc_msg_send(h, msg, &reqid) < 0)
+	goto done;
+    if ((rc = clicon_rpc_conn_get(h)) == NULL)
+	goto done;
+    do {
+	if (clicon_msg_rcv_frame(rc->rc_s, &frame, &eof) < 0){
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	if (eof){
+	    clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	if (ntohl(frame->op_reqid) != reqid){ /* Reply of an earlier request */
+	    if (clicon_msg_rcv_rest(rc->rc_s, &frame, &eof) < 0 || eof){
+		clicon_rpc_conn_reset(rc);
+		goto done;
+	    }
+	    rc->rc_pending--;
+	    if (clicon_rpc_conn_save(rc, frame) < 0){
+		frame = NULL;
+		goto done;
+	    }
+	    frame = NULL;
+	    more = 1;
+	    continue;
+	}
+	more = ntohl(frame->op_flags) & CLICON_MSG_F_MORE;
+	len = ntohl(frame->op_len) - sizeof(*frame);
+	if (len && frame->op_body[len-1] == '\0')
+	    len--;
+	if (fn(frame->op_body, len, !more, arg) < 0){
+	    /* Rest of reply is not read */
+	    clicon_rpc_conn_reset(rc);
+	    goto done;
+	}
+	free(frame);
+	frame = NULL;
+    } while (more);
+    rc->rc_pending--;
+    retval = 0;
+ done:
+    if (frame)
+	free(frame);
+    return retval;
+}
+
 /*! Send internal netconf rpc from client to backend
  * @param[in]    h      CLICON handle
  * @param[in]    msg    Encoded message. Deallocate with free
@@ -90,6 +516,8 @@
  *                      and return it here. For keeping a notify socket open
  * @note sock0 is if connection should be persistent, like a notification/subscribe api
  * @note xret is populated with yangspec according to standard handle yangspec
+ * @note If sock0 is NULL, the persistent connection of the handle is used, 
+ *       see clicon_rpc_msg_send
  */
 int
 clicon_rpc_msg(clicon_handle      h, 
@@ -102,10 +530,20 @@ clicon_rpc_msg(clicon_handle      h,
     int                port;
     char              *retdata = NULL;
     cxobj             *xret = NULL;
+    uint32_t           reqid;
 
 #ifdef RPC_USERNAME_ASSERT
     assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
 #endif
+    if (sock0 == NULL){
+	if (clicon_proto_binary_get(h)) /* Negotiated in hello */
+	    msg->op_flags |= htonl(CLICON_MSG_F_BIN_REPLY);
+	if (clicon_rpc_msg_send(h, msg, &reqid) < 0)
+	    goto done;
+	if (clicon_rpc_msg_rcv(h, reqid, xret0) < 0)
+	    goto done;
+	goto ok;
+    }
     clicon_debug(1, "%s request:%s", __FUNCTION__, msg->op_body);
     if ((sock = clicon_sock(h)) == NULL){
 	clicon_err(OE_FATAL, 0, "CLICON_SOCK option not set");
@@ -150,6 +588,7 @@ clicon_rpc_msg(clicon_handle      h,
 	*xret0 = xret;
 	xret = NULL;
     }
+ ok:
     retval = 0;
  done:
     if (retdata)
@@ -160,7 +599,7 @@ clicon_rpc_msg(clicon_handle      h,
 }
 
 /*! Check if there is a valid (cached) session-id. If not, send a hello request to backend 
- * Session-ids survive TCP sessions that are created for each message sent to the backend.
+ * Session-ids survive TCP sessions, eg if the backend closes the persistent connection.
  * Clients use two approaches, either:
  * (1) Once at the beginning of the session. Netconf and restconf does this
  * (2) First usage, ie "lazy" evaluation when first needed
@@ -280,6 +719,48 @@ clicon_rpc_netconf_xml(clicon_handle  h,
     return retval;
 }
 
+/*! Generic xml netconf clicon rpc where the reply is passed to a callback as it arrives
+ * The reply is not parsed, eg a netconf client may write it directly to its peer.
+ * @param[in]  h       clicon handle
+ * @param[in]  xml     XML netconf tree 
+ * @param[in]  fn      Called with each part of the reply, see clicon_rpc_msg_stream
+ * @param[in]  arg     Argument to fn
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clicon_rpc_netconf_xml  which returns the reply as xml tree
+ */
+int
+clicon_rpc_netconf_xml_stream(clicon_handle         h, 
+			      cxobj                *xml,
+			      clicon_rpc_stream_cb *fn,
+			      void                 *arg)
+{
+    int                retval = -1;
+    uint32_t           session_id;
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cb, xml, 0, 0, -1) < 0)
+	goto done;
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+	goto done;
+    if (clicon_rpc_msg_stream(h, msg, fn, arg) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 
 /*! Get database configuration
  * Same as clicon_proto_change just with a cvec instead of lvec
@@ -772,6 +1253,7 @@ clicon_rpc_get(clicon_handle   h,
 }
 
 /*! Close a (user) session
+ * Also closes the persistent connection to the backend
  * @param[in] h        CLICON handle
  * @retval    0        OK
  * @retval   -1        Error and logged to syslog
@@ -801,6 +1283,8 @@ clicon_rpc_close_session(clicon_handle h)
     }
     retval = 0;
  done:
+    /* Session is closed: close persistent connection */
+    clicon_rpc_msg_close(h);
     if (xret)
 	xml_free(xret);
     if (msg)
@@ -1069,6 +1553,8 @@ clicon_rpc_debug(clicon_handle h,
  * @note this is internal netconf to backend, not northbound to user client
  * @note this deviates from RFC6241 slightly in that it waits for a reply, the RFC does not
  *       stipulate that.
+ * If CLICON_SOCK_BINARY is set, binary encoded replies are offered as a capability,
+ * and used if the backend echoes it, see clicon_proto_binary_get.
  */
 int
 clicon_hello_req(clicon_handle h,
@@ -1079,14 +1565,18 @@ clicon_hello_req(clicon_handle h,
     cxobj             *xret = NULL;
     cxobj             *xerr;
     cxobj             *x;
+    cxobj             *xc;
     char              *username;
     char              *b;
     int                ret;
+    int                binary;
 
     username = clicon_username_get(h);
-    if ((msg = clicon_msg_encode(0, "<hello username=\"%s\" xmlns=\"%s\"><capabilities><capability>urn:ietf:params:netconf:base:1.0</capability></capabilities></hello>",
+    binary = clicon_option_bool(h, "CLICON_SOCK_BINARY");
+    if ((msg = clicon_msg_encode(0, "<hello username=\"%s\" xmlns=\"%s\"><capabilities><capability>urn:ietf:params:netconf:base:1.0</capability>%s</capabilities></hello>",
 				 username?username:"",
-				 NETCONF_BASE_NAMESPACE)) == NULL)
+				 NETCONF_BASE_NAMESPACE,
+				 binary?"<capability>"CLIXON_PROTO_BINARY_CAPABILITY"</capability>":"")) == NULL)
 	goto done;
     if (clicon_rpc_msg(h, msg, &xret, NULL) < 0)
 	goto done;
@@ -1103,6 +1593,18 @@ clicon_hello_req(clicon_handle h,
 	clicon_err(OE_XML, errno, "parse_uint32"); 
 	goto done;
     }
+    /* Use binary replies only if backend echoes the capability */
+    if (binary && (x = xpath_first(xret, NULL, "hello/capabilities")) != NULL){
+	binary = 0;
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xc), "capability") == 0 &&
+		clicon_strcmp(xml_body(xc), CLIXON_PROTO_BINARY_CAPABILITY) == 0)
+		binary = 1;
+    }
+    else
+	binary = 0;
+    clicon_proto_binary_set(h, binary);
     retval = 0;
  done:
     if (msg)
@@ -0,0 +1,246 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Delimiter search for the hand-written XML and JSON scanners, see configure
+ * --enable-xml-scanner.
+ * Scanning text, attribute values and strings is mostly finding the next of a
+ * few delimiter characters, eg '<' or '&'. This is made 16 (SSE2) or 32 (AVX2) 
+ * bytes at a time on x86-64, selected at runtime from the cpu features, with a
+ * table-driven scalar loop for the rest and for other cpus.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CLIXON_SCAN_X86
+#include <immintrin.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_scan.h"
+
+/* Delimiter search function, selected by cpu features */
+typedef char *(scan_fn_t)(clixon_scan_set *ss, char *p, char *end);
+
+static scan_fn_t *_scan_fn = NULL;
+static const char *_scan_impl = NULL;
+
+/*! Scalar delimiter search using the table of the set
+ */
+static char *
+scan_delim_scalar(clixon_scan_set *ss,
+		  char            *p,
+		  char            *end)
+{
+    while (p < end && ss->ss_tab[(unsigned char)*p] == 0)
+	p++;
+    return p;
+}
+
+#ifdef CLIXON_SCAN_X86
+/*! SSE2 delimiter search, 16 bytes at a time
+ * SSE2 is part of x86-64, so always available
+ */
+static char *
+scan_delim_sse2(clixon_scan_set *ss,
+		char            *p,
+		char            *end)
+{
+    __m128i d[CLIXON_SCAN_MAXDELIM];
+    __m128i v;
+    __m128i m;
+    int     mask;
+    int     i;
+
+    for (i=0; i<ss->ss_n; i++)
+	d[i] = _mm_set1_epi8(ss->ss_c[i]);
+    while (end - p >= 16){
+	v = _mm_loadu_si128((const __m128i *)p);
+	m = _mm_cmpeq_epi8(v, d[0]);
+	for (i=1; i<ss->ss_n; i++)
+	    m = _mm_or_si128(m, _mm_cmpeq_epi8(v, d[i]));
+	if ((mask = _mm_movemask_epi8(m)) != 0)
+	    return p + __builtin_ctz(mask);
+	p += 16;
+    }
+    return scan_delim_scalar(ss, p, end);
+}
+
+/*! AVX2 delimiter search, 32 bytes at a time
+ */
+__attribute__((target("avx2")))
+static char *
+scan_delim_avx2(clixon_scan_set *ss,
+		char            *p,
+		char            *end)
+{
+    __m256i  d[CLIXON_SCAN_MAXDELIM];
+    __m256i  v;
+    __m256i  m;
+    uint32_t mask;
+    int      i;
+
+    for (i=0; i<ss->ss_n; i++)
+	d[i] = _mm256_set1_epi8(ss->ss_c[i]);
+    while (end - p >= 32){
+	v = _mm256_loadu_si256((const __m256i *)p);
+	m = _mm256_cmpeq_epi8(v, d[0]);
+	for (i=1; i<ss->ss_n; i++)
+	    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, d[i]));
+	if ((mask = (uint32_t)_mm256_movemask_epi8(m)) != 0)
+	    return p + __builtin_ctz(mask);
+	p += 32;
+    }
+    return scan_delim_sse2(ss, p, end);
+}
+#endif /* CLIXON_SCAN_X86 */
+
+/*! Select delimiter search function from cpu features
+ */
+static void
+scan_select(void)
+{
+#ifdef CLIXON_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")){
+	_scan_fn = scan_delim_avx2;
+	_scan_impl = "avx2";
+    }
+    else{
+	_scan_fn = scan_delim_sse2;
+	_scan_impl = "sse2";
+    }
+#else
+    _scan_fn = scan_delim_scalar;
+    _scan_impl = "scalar";
+#endif
+}
+
+/*! Prepare a set of delimiter characters
+ *
+ * @param[out] ss      Delimiter set
+ * @param[in]  delims  Delimiter characters, at most CLIXON_SCAN_MAXDELIM, not '\0'
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+clixon_scan_set_init(clixon_scan_set *ss,
+		     const char      *delims)
+{
+    int i;
+
+    if (_scan_fn == NULL)
+	scan_select();
+    memset(ss, 0, sizeof(*ss));
+    if ((ss->ss_n = strlen(delims)) == 0 || ss->ss_n > CLIXON_SCAN_MAXDELIM){
+	clicon_err(OE_XML, EINVAL, "Invalid number of delimiters: %d", ss->ss_n);
+	return -1;
+    }
+    for (i=0; i<ss->ss_n; i++){
+	ss->ss_c[i] = (unsigned char)delims[i];
+	ss->ss_tab[(unsigned char)delims[i]] = 1;
+    }
+    return 0;
+}
+
+/*! Find first delimiter of a set in a buffer
+ *
+ * @param[in]  ss   Delimiter set
+ * @param[in]  p    Start of buffer
+ * @param[in]  end  End of buffer, bytes at and after end are not read
+ * @retval     p    Pointer to first delimiter in [p, end), or end if none
+ */
+char *
+clixon_scan_delim(clixon_scan_set *ss,
+		  char            *p,
+		  char            *end)
+{
+    return _scan_fn(ss, p, end);
+}
+
+/*! Name of the delimiter search implementation, eg "avx2", for debugging
+ * @see clixon_scan_impl_set
+ */
+const char *
+clixon_scan_impl(void)
+{
+    if (_scan_fn == NULL)
+	scan_select();
+    return _scan_impl;
+}
+
+/*! Select delimiter search implementation, for testing
+ *
+ * @param[in]  impl  "scalar", "sse2", "avx2", or NULL for the best on the running cpu
+ * @retval     0     OK
+ * @retval    -1     Error: not supported on this cpu
+ * @see clixon_scan_impl
+ */
+int
+clixon_scan_impl_set(const char *impl)
+{
+    if (impl == NULL)
+	scan_select();
+    else if (strcmp(impl, "scalar") == 0){
+	_scan_fn = scan_delim_scalar;
+	_scan_impl = "scalar";
+    }
+#ifdef CLIXON_SCAN_X86
+    else if (strcmp(impl, "sse2") == 0){
+	_scan_fn = scan_delim_sse2;
+	_scan_impl = "sse2";
+    }
+    else if (strcmp(impl, "avx2") == 0 && __builtin_cpu_supports("avx2")){
+	_scan_fn = scan_delim_avx2;
+	_scan_impl = "avx2";
+    }
+#endif
+    else{
+	clicon_err(OE_UNIX, ENOTSUP, "Delimiter search %s not supported", impl);
+	return -1;
+    }
+    return 0;
+}
@@ -62,7 +62,11 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <syslog.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -87,6 +91,16 @@
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Initial length of replay buffer and number of replay index entries */
+#define STREAM_REPLAY_DATA_INIT 4096
+#define STREAM_REPLAY_ENT_INIT  64
+
+static struct stream_replay *stream_replay_new(clicon_handle h, const char *name);
+static int stream_replay_free(struct stream_replay *r);
+static int stream_replay_drop(struct stream_replay *r);
+static int stream_replay_add_buf(event_stream_t *es, struct timeval *tv, char *data, size_t len);
+static int stream_filter_free(struct stream_filter *sf);
+
 /*! Find an event notification stream given name
  * @param[in]  h    Clicon handle
  * @param[in]  name Name of stream
@@ -116,6 +130,8 @@ stream_find(clicon_handle h,
  * @param[in]  description    Description of stream
  * @param[in]  replay_enabled Set if replay possible in stream
  * @param[in]  retention      For replay buffer how much relative to save
+ * Size and count limits of the replay buffer are given by options
+ * CLICON_STREAM_RETENTION_SIZE and CLICON_STREAM_RETENTION_COUNT.
  */
 int
 stream_add(clicon_handle   h,
@@ -125,9 +141,9 @@ stream_add(clicon_handle   h,
 	   struct timeval *retention) 
 {
     int             retval = -1;
-    event_stream_t *es;
+    event_stream_t *es = NULL;
 
-    if ((es = stream_find(h, name)) != NULL)
+    if (stream_find(h, name) != NULL)
 	goto ok;
     if ((es = malloc(sizeof(event_stream_t))) == NULL){
 	clicon_err(OE_XML, errno, "malloc");
@@ -145,10 +161,21 @@ stream_add(clicon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
 	es->es_retention = *retention;
+    if (replay_enabled &&
+	(es->es_replay = stream_replay_new(h, name)) == NULL)
+	goto done;
     clicon_stream_append(h, es);
+    es = NULL;
  ok:
     retval = 0;
  done:
+    if (es){
+	if (es->es_name)
+	    free(es->es_name);
+	if (es->es_description)
+	    free(es->es_description);
+	free(es);
+    }
     return retval;
 }
 
@@ -160,8 +187,8 @@ int
 stream_delete_all(clicon_handle h,
 		  int           force)
 {
-    struct stream_replay *r;
     struct stream_subscription *ss;
+    struct stream_filter *sf;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
     
@@ -174,12 +201,12 @@ stream_delete_all(clicon_handle h,
 	    free(es->es_description);
 	while ((ss = es->es_subscription) != NULL)
 	    stream_ss_rm(h, es, ss, force); /* XXX in some cases leaks memory due to DONT clause in stream_ss_rm() */
-	while ((r = es->es_replay) != NULL){
-	    DELQ(r, es->es_replay, struct stream_replay *);
-	    if (r->r_xml)
-		xml_free(r->r_xml);
-	    free(r);
+	while ((sf = es->es_filters) != NULL){
+	    DELQ(sf, es->es_filters, struct stream_filter *);
+	    stream_filter_free(sf);
 	}
+	if (es->es_replay)
+	    stream_replay_free(es->es_replay);
 	free(es);
     }
     return 0;
@@ -246,7 +273,6 @@ stream_timer_setup(int   fd,
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
     struct stream_replay        *r;
-    struct stream_replay        *r1;
     
     clicon_debug(2, "%s", __FUNCTION__);
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -277,18 +303,10 @@ stream_timer_setup(int   fd,
 	    if (timerisset(&es->es_retention) &&
 		(r = es->es_replay) != NULL){
 		timersub(&now, &es->es_retention, &tret);
-		do {
-		    if (timercmp(&r->r_tv, &tret, <)){
-			r1 = NEXTQ(struct stream_replay *, r);
-			DELQ(r, es->es_replay, struct stream_replay *);
-			if (r->r_xml)
-			    xml_free(r->r_xml);
-			free(r);
-			r = r1;
-		    }
-		    else
-			r = NEXTQ(struct stream_replay *, r);
-		} while (r && r!=es->es_replay);
+		/* Entries are in time order, drop from oldest */
+		while (r->r_nr &&
+		       timercmp(&r->r_ent[r->r_first].re_tv, &tret, <))
+		    stream_replay_drop(r);
 	    }
 	    es = NEXTQ(struct event_stream *, es);
 	} while (es && es != clicon_stream(h));
@@ -316,6 +334,102 @@ stream_del()
 }
 #endif
 
+/*! Free subscription filter
+ * @param[in]  sf   Filter
+ */
+static int
+stream_filter_free(struct stream_filter *sf)
+{
+    if (sf->sf_xpath)
+	free(sf->sf_xpath);
+    if (sf->sf_xpt)
+	xpath_tree_free(sf->sf_xpt);
+    free(sf);
+    return 0;
+}
+
+/*! Get subscription filter of a stream given xpath, create it if not found
+ * Subscriptions with the same xpath share the filter, so it is parsed once and
+ * evaluated once per event.
+ * @param[in]  es    Event stream
+ * @param[in]  xpath Filter selector as xpath
+ * @retval     sf    Filter, release with stream_filter_release
+ * @retval     NULL  Error, eg xpath parse error
+ */
+static struct stream_filter *
+stream_filter_get(event_stream_t *es,
+		  char           *xpath)
+{
+    struct stream_filter *sf;
+
+    if ((sf = es->es_filters) != NULL)
+	do {
+	    if (strcmp(sf->sf_xpath, xpath) == 0){
+		sf->sf_refcnt++;
+		return sf;
+	    }
+	    sf = NEXTQ(struct stream_filter *, sf);
+	} while (sf && sf != es->es_filters);
+    if ((sf = malloc(sizeof(*sf))) == NULL){
+	clicon_err(OE_CFG, errno, "malloc");
+	goto fail;
+    }
+    memset(sf, 0, sizeof(*sf));
+    if ((sf->sf_xpath = strdup(xpath)) == NULL){
+	clicon_err(OE_CFG, errno, "strdup");
+	goto fail;
+    }
+    if (xpath_parse(xpath, &sf->sf_xpt) < 0)
+	goto fail;
+    sf->sf_refcnt = 1;
+    ADDQ(sf, es->es_filters);
+    return sf;
+ fail:
+    if (sf)
+	stream_filter_free(sf);
+    return NULL;
+}
+
+/*! Release subscription filter, free it if not used by any subscription
+ * @param[in]  es    Event stream
+ * @param[in]  sf    Filter
+ */
+static int
+stream_filter_release(event_stream_t       *es,
+		      struct stream_filter *sf)
+{
+    if (--sf->sf_refcnt > 0)
+	return 0;
+    DELQ(sf, es->es_filters, struct stream_filter *);
+    return stream_filter_free(sf);
+}
+
+/*! Check if subscription filter matches event, evaluate once per event
+ * @param[in]  es     Event stream
+ * @param[in]  sf     Filter
+ * @param[in]  xevent Event as XML
+ * @retval     1      Match, ie xpath selects nodes of event
+ * @retval     0      No match, or error evaluating xpath
+ */
+static int
+stream_filter_match(event_stream_t       *es,
+		    struct stream_filter *sf,
+		    cxobj                *xevent)
+{
+    xp_ctx *xr = NULL;
+
+    if (sf->sf_event != es->es_event){
+	sf->sf_event = es->es_event;
+	sf->sf_match = 0;
+	if (xpath_tree_ctx(xevent, NULL, sf->sf_xpt, 0, &xr) == 0 &&
+	    xr->xc_type == XT_NODESET && xr->xc_size > 0)
+	    sf->sf_match = 1;
+	if (xr)
+	    ctx_free(xr);
+    }
+    return sf->sf_match;
+}
+
 /*! Add an event notification callback to a stream given a callback function
  * @param[in]  h        Clicon handle
  * @param[in]  stream   Name of stream
@@ -361,13 +475,21 @@ stream_ss_add(clicon_handle     h,
 	clicon_err(OE_CFG, errno, "strdup");
 	goto done;
     }
+    if (xpath && strlen(xpath) &&
+	(ss->ss_filter = stream_filter_get(es, xpath)) == NULL)
+	goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
-    if (ss)
+    if (ss){
+	if (ss->ss_stream)
+	    free(ss->ss_stream);
+	if (ss->ss_xpath)
+	    free(ss->ss_xpath);
 	free(ss);
+    }
     return NULL;
 }
 
@@ -387,8 +509,12 @@ stream_ss_rm(clicon_handle                h,
 {
     clicon_debug(1, "%s", __FUNCTION__);
     DELQ(ss, es->es_subscription, struct stream_subscription *);
+    if (ss->ss_filter){
+	stream_filter_release(es, ss->ss_filter);
+	ss->ss_filter = NULL;
+    }
     /* Remove from upper layers - close socket etc. */
-    (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
+    (*ss->ss_fn)(h, 1, NULL, NULL, ss->ss_arg);
     if (force){
 	if (ss->ss_stream)
 	    free(ss->ss_stream);
@@ -481,6 +607,9 @@ stream_ss_delete(clicon_handle     h,
 }
 
 /*! Stream notify event and distribute to all registered callbacks
+ * The event is serialized once and shared by all subscriptions, and stored in
+ * the replay buffer if replay is enabled.
+ * Subscription filters are evaluated once per event, see stream_filter_match.
  * @param[in]  h       Clicon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
  * @param[in]  tv      Timestamp. Dont notify if subscription has stoptime<tv
@@ -498,8 +627,16 @@ stream_notify1(clicon_handle   h,
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    cbuf                       *cbev = NULL;
     
     clicon_debug(2, "%s", __FUNCTION__);
+    if ((cbev = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cbev, xevent, 0, 0, -1) < 0)
+	goto done;
+    es->es_event++;
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
 	do {
@@ -513,16 +650,20 @@ stream_notify1(clicon_handle   h,
 		ss = ss1;
 	    }
 	    else{  /* xpath match */
-		if (ss->ss_xpath == NULL ||
-		    strlen(ss->ss_xpath)==0 ||
-		    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
-		    if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
+		if (ss->ss_filter == NULL ||
+		    stream_filter_match(es, ss->ss_filter, xevent))
+		    if ((*ss->ss_fn)(h, 0, xevent, cbev, ss->ss_arg) < 0)
 			goto done;
 		ss = NEXTQ(struct stream_subscription *, ss);
 	    }
 	} while (es->es_subscription && ss != es->es_subscription);
+    if (es->es_replay_enabled &&
+	stream_replay_add_buf(es, tv, cbuf_get(cbev), cbuf_len(cbev)) < 0)
+	goto done;
     retval = 0;
   done:
+    if (cbev)
+	cbuf_free(cbev);
     return retval;
 }
 
@@ -590,11 +731,6 @@ stream_notify(clicon_handle h,
 	goto done;
     if (stream_notify1(h, es, &tv, xev) < 0)
 	goto done;
-    if (es->es_replay_enabled){
-	if (stream_replay_add(es, &tv, xev) < 0)
-	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
-    }
  ok:
     retval = 0;
   done:
@@ -659,11 +795,6 @@ stream_notify_xml(clicon_handle h,
 	goto done;
     if (stream_notify1(h, es, &tv, xev) < 0)
 	goto done;
-    if (es->es_replay_enabled){
-	if (stream_replay_add(es, &tv, xev) < 0)
-	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
-    }
  ok:
     retval = 0;
   done:
@@ -677,6 +808,247 @@ stream_notify_xml(clicon_handle h,
 }
 
 
+/*! Create replay store of a stream
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Name of stream, used for segment file
+ * @retval     r     Replay store, free with stream_replay_free
+ * @retval     NULL  Error
+ * If CLICON_STREAM_REPLAY_DIR is set, events are stored in a memory-mapped
+ * segment file <dir>/<stream>.replay instead of in memory.
+ */
+static struct stream_replay *
+stream_replay_new(clicon_handle h,
+		  const char   *name)
+{
+    struct stream_replay *r = NULL;
+    char                 *dir;
+    cbuf                 *cb = NULL;
+
+    if ((r = malloc(sizeof(*r))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto fail;
+    }
+    memset(r, 0, sizeof(*r));
+    r->r_fd = -1;
+    if (clicon_option_exists(h, "CLICON_STREAM_RETENTION_SIZE"))
+	r->r_maxsize = clicon_option_int(h, "CLICON_STREAM_RETENTION_SIZE");
+    if (clicon_option_exists(h, "CLICON_STREAM_RETENTION_COUNT"))
+	r->r_maxnr = clicon_option_int(h, "CLICON_STREAM_RETENTION_COUNT");
+    if ((dir = clicon_option_str(h, "CLICON_STREAM_REPLAY_DIR")) != NULL){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto fail;
+	}
+	cprintf(cb, "%s/%s.replay", dir, name);
+	if ((r->r_file = strdup(cbuf_get(cb))) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto fail;
+	}
+	if ((r->r_fd = open(r->r_file, O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR)) < 0){
+	    clicon_err(OE_UNIX, errno, "open(%s)", r->r_file);
+	    goto fail;
+	}
+    }
+    cbuf_free(cb);
+    return r;
+ fail:
+    if (cb)
+	cbuf_free(cb);
+    if (r)
+	stream_replay_free(r);
+    return NULL;
+}
+
+/*! Free replay store, and remove its segment file if any
+ * @param[in]  r     Replay store
+ */
+static int
+stream_replay_free(struct stream_replay *r)
+{
+    if (r->r_data){
+	if (r->r_fd != -1)
+	    munmap(r->r_data, r->r_datalen);
+	else
+	    free(r->r_data);
+    }
+    if (r->r_fd != -1)
+	close(r->r_fd);
+    if (r->r_file){
+	unlink(r->r_file);
+	free(r->r_file);
+    }
+    if (r->r_ent)
+	free(r->r_ent);
+    free(r);
+    return 0;
+}
+
+/*! Get replay index entry i, where 0 is the oldest
+ */
+static inline struct stream_replay_ent *
+stream_replay_ent(struct stream_replay *r,
+		  size_t                i)
+{
+    return &r->r_ent[(r->r_first + i) % r->r_entmax];
+}
+
+/*! Drop oldest event from replay store
+ * @param[in]  r     Replay store
+ */
+static int
+stream_replay_drop(struct stream_replay *r)
+{
+    if (r->r_nr == 0)
+	return 0;
+    r->r_first = (r->r_first + 1) % r->r_entmax;
+    if (--r->r_nr == 0)
+	r->r_head = 0;
+    return 0;
+}
+
+/*! Resize replay index, entries are moved to the start of the new index
+ * @param[in]  r     Replay store
+ * @param[in]  n     New number of entries, at least r_nr
+ */
+static int
+stream_replay_ent_resize(struct stream_replay *r,
+			 size_t                n)
+{
+    int                       retval = -1;
+    struct stream_replay_ent *ent;
+    size_t                    i;
+
+    if ((ent = calloc(n, sizeof(*ent))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<r->r_nr; i++)
+	ent[i] = *stream_replay_ent(r, i);
+    if (r->r_ent)
+	free(r->r_ent);
+    r->r_ent = ent;
+    r->r_entmax = n;
+    r->r_first = 0;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Resize replay buffer, events are moved in time order to the start of the new buffer
+ * @param[in]  r     Replay store
+ * @param[in]  len   New length, at least the sum of all event lengths
+ * If the store has a segment file, the file is truncated to len and remapped.
+ */
+static int
+stream_replay_data_resize(struct stream_replay *r,
+			  size_t                len)
+{
+    int                       retval = -1;
+    char                     *data = NULL;
+    size_t                    off = 0;
+    size_t                    nr;
+    size_t                    i;
+    struct stream_replay_ent *re;
+
+    if ((data = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    for (i=0; i<r->r_nr; i++){
+	re = stream_replay_ent(r, i);
+	memcpy(data + off, r->r_data + re->re_off, re->re_len);
+	re->re_off = off;
+	off += re->re_len;
+    }
+    if (r->r_fd != -1){
+	/* Store is empty until the segment is remapped */
+	nr = r->r_nr;
+	r->r_nr = 0;
+	if (r->r_data && munmap(r->r_data, r->r_datalen) < 0){
+	    clicon_err(OE_UNIX, errno, "munmap");
+	    goto done;
+	}
+	r->r_data = NULL;
+	r->r_datalen = 0;
+	if (ftruncate(r->r_fd, len) < 0){
+	    clicon_err(OE_UNIX, errno, "ftruncate(%s)", r->r_file);
+	    goto done;
+	}
+	if ((r->r_data = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_SHARED,
+			      r->r_fd, 0)) == MAP_FAILED){
+	    r->r_data = NULL;
+	    clicon_err(OE_UNIX, errno, "mmap(%s)", r->r_file);
+	    goto done;
+	}
+	memcpy(r->r_data, data, off);
+	r->r_nr = nr;
+    }
+    else{
+	if (r->r_data)
+	    free(r->r_data);
+	r->r_data = data;
+	data = NULL;
+    }
+    r->r_datalen = len;
+    r->r_head = off;
+    retval = 0;
+ done:
+    if (data)
+	free(data);
+    return retval;
+}
+
+/*! Find offset in replay buffer where an event can be written without dropping
+ * @param[in]  r     Replay store
+ * @param[in]  len   Length of event
+ * @retval     off   Offset in r_data
+ * @retval    -1     No free space of len
+ * Events are written after the newest, or at the start of the buffer if the
+ * end is reached.
+ */
+static ssize_t
+stream_replay_free_off(struct stream_replay *r,
+		       size_t                len)
+{
+    size_t oldest;
+
+    if (r->r_nr == 0)
+	return len <= r->r_datalen ? 0 : -1;
+    oldest = stream_replay_ent(r, 0)->re_off;
+    if (r->r_head > oldest){ /* Not wrapped */
+	if (r->r_head + len <= r->r_datalen)
+	    return r->r_head;
+	if (len <= oldest)
+	    return 0;
+    }
+    else if (r->r_head + len <= oldest)
+	return r->r_head;
+    return -1;
+}
+
+/*! Find first replay index entry with timestamp at or after a time
+ * @param[in]  r     Replay store
+ * @param[in]  tv    Time
+ * @retval     i     Index entry, or r_nr if none
+ */
+static size_t
+stream_replay_find(struct stream_replay *r,
+		   struct timeval       *tv)
+{
+    size_t lo = 0;
+    size_t hi = r->r_nr;
+    size_t mid;
+
+    while (lo < hi){
+	mid = (lo + hi) / 2;
+	if (timercmp(&stream_replay_ent(r, mid)->re_tv, tv, <))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
 /*! Replay a stream by sending notification messages
  * @see RFC5277 Sec 2.1.1:
  *  Start Time:
@@ -707,34 +1079,123 @@ stream_replay_notify(clicon_handle               h,
 		     event_stream_t             *es,
 		     struct stream_subscription *ss)
 {
-    int                   retval = -1;
-    struct stream_replay *r;
+    int                       retval = -1;
+    struct stream_replay     *r;
+    struct stream_replay_ent *re;
+    size_t                    i;
+    cbuf                     *cb = NULL;
+    cxobj                    *xev = NULL;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
 	goto ok;
     if (!es->es_replay_enabled)
 	goto ok;
-    /* Get replay linked list */
     if ((r = es->es_replay) == NULL)
 	goto ok;
-    /* First loop to skip until start */
-    do {
-	if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-	    break;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
-	goto ok; /* No samples to replay */
-    /* Then notify until stop */
-    do {
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Skip until start, then notify until stop */
+    for (i = stream_replay_find(r, &ss->ss_starttime); i < r->r_nr; i++){
+	re = stream_replay_ent(r, i);
 	if (timerisset(&ss->ss_stoptime) &&
-	    timercmp(&r->r_tv, &ss->ss_stoptime, >))
+	    timercmp(&re->re_tv, &ss->ss_stoptime, >))
 	    break;
-	if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+	cbuf_reset(cb);
+	cbuf_append_buf(cb, r->r_data + re->re_off, re->re_len);
+	if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xev, NULL) < 0)
+	    goto done;
+	if (xml_rootchild(xev, 0, &xev) < 0)
+	    goto done;
+	if ((*ss->ss_fn)(h, 0, xev, cb, ss->ss_arg) < 0)
+	    goto done;
+	xml_free(xev);
+	xev = NULL;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xev)
+	xml_free(xev);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Add serialized replay sample to stream with timestamp
+ * @param[in] es   Stream
+ * @param[in] tv   Timestamp
+ * @param[in] data Event serialized as XML, copied
+ * @param[in] len  Length of data
+ * If the size or count limit of the replay store is reached, oldest events are
+ * dropped. An event larger than the size limit is not stored.
+ */
+static int
+stream_replay_add_buf(event_stream_t *es,
+		      struct timeval *tv,
+		      char           *data,
+		      size_t          len)
+{
+    int                       retval = -1;
+    struct stream_replay     *r;
+    struct stream_replay_ent *re;
+    size_t                    sz;
+    ssize_t                   off;
+
+    if ((r = es->es_replay) == NULL)
+	goto ok;
+    if (r->r_maxsize && len > r->r_maxsize){
+	clicon_debug(1, "%s event of %zu bytes larger than replay buffer of %s",
+		     __FUNCTION__, len, es->es_name);
+	goto ok;
+    }
+    /* Index entry */
+    while (r->r_maxnr && r->r_nr >= r->r_maxnr)
+	stream_replay_drop(r);
+    if (r->r_nr == r->r_entmax){
+	sz = r->r_entmax ? 2*r->r_entmax : STREAM_REPLAY_ENT_INIT;
+	if (r->r_maxnr && sz > r->r_maxnr)
+	    sz = r->r_maxnr;
+	if (stream_replay_ent_resize(r, sz) < 0)
+	    goto done;
+    }
+    /* Data: grow buffer up to the size limit, then drop oldest events */
+    if ((off = stream_replay_free_off(r, len)) < 0 &&
+	(r->r_maxsize == 0 || r->r_datalen < r->r_maxsize)){
+	sz = r->r_datalen ? 2*r->r_datalen : STREAM_REPLAY_DATA_INIT;
+	while (sz < r->r_datalen + len)
+	    sz *= 2;
+	if (r->r_maxsize && sz > r->r_maxsize)
+	    sz = r->r_maxsize;
+	if (stream_replay_data_resize(r, sz) < 0)
 	    goto done;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+	off = stream_replay_free_off(r, len);
+    }
+    if (off < 0){
+	off = r->r_head;
+	if (off + len > r->r_datalen){
+	    /* Wrap: drop events between head and end */
+	    while (r->r_nr && stream_replay_ent(r, 0)->re_off >= off)
+		stream_replay_drop(r);
+	    off = 0;
+	}
+	while (r->r_nr &&
+	       (re = stream_replay_ent(r, 0))->re_off < off + len &&
+	       re->re_off + re->re_len > off)
+	    stream_replay_drop(r);
+    }
+    memcpy(r->r_data + off, data, len);
+    re = stream_replay_ent(r, r->r_nr);
+    re->re_tv = *tv;
+    /* Keep index sorted if clock goes backwards */
+    if (r->r_nr && timercmp(tv, &stream_replay_ent(r, r->r_nr-1)->re_tv, <))
+	re->re_tv = stream_replay_ent(r, r->r_nr-1)->re_tv;
+    re->re_off = off;
+    re->re_len = len;
+    r->r_nr++;
+    r->r_head = off + len;
  ok:
     retval = 0;
  done:
@@ -744,26 +1205,32 @@ stream_replay_notify(clicon_handle               h,
 /*! Add replay sample to stream with timestamp
  * @param[in] es   Stream
  * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] xv   XML, serialized and stored, not consumed
+ * @see stream_replay_add_buf
  */
 int
 stream_replay_add(event_stream_t *es,
 		  struct timeval *tv,
 		  cxobj          *xv)
 {
-    int                   retval = -1;
-    struct stream_replay *new;
+    int   retval = -1;
+    cbuf *cb = NULL;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if (es->es_replay == NULL)
+	goto ok;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
 	goto done;
     }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
+    if (clicon_xml2cbuf(cb, xv, 0, 0, -1) < 0)
+	goto done;
+    if (stream_replay_add_buf(es, tv, cbuf_get(cb), cbuf_len(cb)) < 0)
+	goto done;
+ ok:
     retval = 0;
  done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
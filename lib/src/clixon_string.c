@@ -488,6 +488,8 @@ xml_chardata_encode(char      **escp,
 }
 
 /*! Escape characters according to XML definition and append to cbuf
+ * Runs of characters that need no escaping are appended as they are, ie a string
+ * without "<>&" is copied once.
  * @param[in]   cb     CLIgen buf
  * @param[in]   str    Not-encoded input string
  * @see xml_chardata_encode for the generic function
@@ -496,46 +498,63 @@ int
 xml_chardata_cbuf_append(cbuf *cb,
 			 char *str)
 {
-    int  retval = -1;
-    int  i;
-    int  cdata; /* when set, skip encoding */
+    char  *p = str;
+    char  *q;
+    size_t n;
 
     /* The orignal of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		cdata = 0;
-		cbuf_append(cb, str[i++]);
-		cbuf_append(cb, str[i++]);
-	    }
-	    cbuf_append(cb, str[i]);
+    while (*p != '\0'){
+	if ((n = strcspn(p, "&<>")) > 0){
+	    cbuf_append_buf(cb, p, n);
+	    p += n;
 	}
-	else
-	switch (str[i]){
+	switch (*p){
 	case '&':
 	    cbuf_append_str(cb, "&amp;");
+	    p++;
 	    break;
 	case '<':
-	    if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		cbuf_append(cb, str[i]);
-		cdata++;
+	    if (strncmp(p, "<![CDATA[", strlen("<![CDATA[")) == 0){
+		/* Skip encoding until end of cdata */
+		if ((q = strstr(p + strlen("<![CDATA["), "]]>")) != NULL)
+		    q += strlen("]]>");
+		else
+		    q = p + strlen(p);
+		cbuf_append_buf(cb, p, q - p);
+		p = q;
 		break;
 	    }
 	    cbuf_append_str(cb, "&lt;");
+	    p++;
 	    break;
 	case '>':
 	    cbuf_append_str(cb, "&gt;");
+	    p++;
+	    break;
+	default: /* end of string */
 	    break;
-	default:
-	    cbuf_append(cb, str[i]);
 	}
     }
-    retval = 0;
-    // done:
-    return retval;
+    return 0;
+}
+
+/*! Append n spaces of indentation to cbuf, as cprintf(cb, "%*s", n, "") but without formatting
+ * @param[in]   cb     CLIgen buf
+ * @param[in]   n      Nr of spaces
+ */
+int
+clixon_cbuf_indent(cbuf *cb,
+		   int   n)
+{
+    static char spaces[] = "                                "; /* 32 */
+    int         len;
+
+    while (n > 0){
+	len = n < sizeof(spaces)-1 ? n : sizeof(spaces)-1;
+	cbuf_append_buf(cb, spaces, len);
+	n -= len;
+    }
+    return 0;
 }
 
 /*! Split a string into a cligen variable vector using 1st and 2nd delimiter 
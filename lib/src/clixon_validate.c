@@ -77,6 +77,9 @@
 #include "clixon_yang_module.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_map.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_vec.h"
+#include "clixon_data.h"
 #include "clixon_validate.h"
 
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
@@ -1027,6 +1030,184 @@ xml_yang_validate_list_key_only(clicon_handle h,
     goto done;
 }
 
+/*! Validate leafref, identityref, must and when constraints of a single XML node
+ * Not recursive. These constraints may refer to other parts of the XML tree.
+ * @param[in]  xt    XML node to be validated
+ * @param[in]  ys    Yang spec of xt
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see xml_yang_validate_all   which calls this function recursively
+ */
+static int
+xml_yang_validate_node(cxobj     *xt,
+		       yang_stmt *ys,
+		       cxobj    **xret)
+{
+    int        retval = -1;
+    yang_stmt *yc;  /* yang child */
+    yang_stmt *ye;  /* yang must error-message */
+    char      *xpath;
+    int        nr;
+    int        ret;
+    cbuf      *cb = NULL;
+    cvec      *nsc = NULL;
+
+    switch (yang_keyword_get(ys)){
+    case Y_LEAF:
+	/* fall thru */
+    case Y_LEAF_LIST:
+	/* Special case if leaf is leafref, then first check against
+	   current xml tree
+	*/
+	/* Get base type yc */
+	if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	if (strcmp(yang_argument_get(yc), "leafref") == 0){
+	    if ((ret = validate_leafref(xt, ys, yc, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	else if (strcmp(yang_argument_get(yc), "identityref") == 0){
+	    if ((ret = validate_identityref(xt, ys, yc, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	break;
+    default:
+	break;
+    }
+    /* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
+     * XXX. use yang path instead? */
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	if (yang_keyword_get(yc) != Y_MUST)
+	    continue;
+	xpath = yang_argument_get(yc); /* "must" has xpath argument */
+	if (xml_nsctx_yang(yc, &nsc) < 0)
+	    goto done;
+	if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
+	    goto done;
+	if (!nr){
+	    ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
+	    if (netconf_operation_failed_xml(xret, "application", 
+					     ye?yang_argument_get(ye):"must xpath validation failed") < 0)
+		goto done;
+	    goto fail;
+	}
+	if (nsc){
+	    xml_nsctx_free(nsc);
+	    nsc = NULL;
+	}
+    }
+    /* "when" sub-node RFC 7950 Sec 7.21.5. Can only be one. */
+    if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL){
+	xpath = yang_argument_get(yc); /* "when" has xpath argument */
+	/* WHEN xpath needs namespace context */
+	if (xml_nsctx_yang(ys, &nsc) < 0)
+	    goto done;
+	if ((nr = xpath_vec_bool(xt, nsc,
+				 "%s", xpath)) < 0)
+	    goto done;
+	if (nsc){
+	    xml_nsctx_free(nsc);
+	    nsc = NULL;
+	}
+	if (nr == 0){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed WHEN condition of %s in module %s",
+		    xml_name(xt),
+		    yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application", 
+					     cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    /* Augmented when using special struct. */
+    if ((xpath = yang_when_xpath_get(ys)) != NULL){
+	if ((nr = xpath_vec_bool(xml_parent(xt), yang_when_nsc_get(ys),
+				 "%s", xpath)) < 0)
+	    goto done;
+	if (nr == 0){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed augmented WHEN condition of %s in module %s",
+		    xml_name(xt),
+		    yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application", 
+					     cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Handle XML node without yang spec in validation
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML node without yang spec
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Skip node (CLICON_YANG_UNKNOWN_ANYDATA set)
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ */
+static int
+xml_yang_validate_nospec(clicon_handle h,
+			 cxobj        *xt,
+			 cxobj       **xret)
+{
+    int    retval = -1;
+    cxobj *xp;
+    char  *ns = NULL;
+    cbuf  *cb = NULL;
+
+    if (clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1) {
+	clicon_log(LOG_WARNING,
+		   "%s: %d: No YANG spec for %s, validation skipped",
+		   __FUNCTION__, __LINE__, xml_name(xt));
+	goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "Failed to find YANG spec of XML node: %s", xml_name(xt));
+    if ((xp = xml_parent(xt)) != NULL)
+	cprintf(cb, " with parent: %s", xml_name(xp));
+    if (xml2ns(xt, xml_prefix(xt), &ns) < 0)
+	goto done;
+    if (ns)
+	cprintf(cb, " in namespace: %s", ns);
+    if (netconf_unknown_element_xml(xret, "application", xml_name(xt), cbuf_get(cb)) < 0)
+	goto done;
+    retval = 0;
+    goto done;
+ ok:
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Validate a single XML node with yang specification for all (not only added) entries
  * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
  * @param[in]  xt  XML node to be validated
@@ -1054,143 +1235,27 @@ xml_yang_validate_all(clicon_handle h,
 {
     int        retval = -1;
     yang_stmt *ys;  /* yang node */
-    yang_stmt *yc;  /* yang child */
-    yang_stmt *ye;  /* yang must error-message */
-    char      *xpath;
-    int        nr;
     int        ret;
     cxobj     *x;
-    cxobj     *xp;
-    char      *ns = NULL;
-    cbuf      *cb = NULL;
-    cvec      *nsc = NULL;
 
     /* if not given by argument (overide) use default link 
        and !Node has a config sub-statement and it is false */
     ys=xml_spec(xt);
     if (ys==NULL){
-	if (clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1) {
-	    clicon_log(LOG_WARNING,
-		       "%s: %d: No YANG spec for %s, validation skipped",
-		       __FUNCTION__, __LINE__, xml_name(xt));
-	    goto ok;
-	}
-	if ((cb = cbuf_new()) == NULL){
-	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	if ((ret = xml_yang_validate_nospec(h, xt, xret)) < 0)
 	    goto done;
-	}
-	cprintf(cb, "Failed to find YANG spec of XML node: %s", xml_name(xt));
-	if ((xp = xml_parent(xt)) != NULL)
-	    cprintf(cb, " with parent: %s", xml_name(xp));
-	if (xml2ns(xt, xml_prefix(xt), &ns) < 0)
-	    goto done;
-	if (ns)
-	    cprintf(cb, " in namespace: %s", ns);
-	if (netconf_unknown_element_xml(xret, "application", xml_name(xt), cbuf_get(cb)) < 0)
-	    goto done;
-	goto fail;
+	if (ret == 0)
+	    goto fail;
+	goto ok;
     }
     if (yang_config(ys) != 0){
 	/* Node-specific validation */
-	switch (yang_keyword_get(ys)){
-	case Y_ANYXML:
-	case Y_ANYDATA:
+	if (yang_keyword_get(ys) == Y_ANYXML || yang_keyword_get(ys) == Y_ANYDATA)
 	    goto ok;
-	    break;
-	case Y_LEAF:
-	    /* fall thru */
-	case Y_LEAF_LIST:
-	    /* Special case if leaf is leafref, then first check against
-	       current xml tree
- 	    */
-	    /* Get base type yc */
-	    if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
-		goto done;
-	    if (strcmp(yang_argument_get(yc), "leafref") == 0){
-		if ((ret = validate_leafref(xt, ys, yc, xret)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-		}
-	    else if (strcmp(yang_argument_get(yc), "identityref") == 0){
-		if ((ret = validate_identityref(xt, ys, yc, xret)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-	    }
-	    break;
-	default:
-	    break;
-	}
-	/* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
-	 * XXX. use yang path instead? */
-	yc = NULL;
-	while ((yc = yn_each(ys, yc)) != NULL) {
-	    if (yang_keyword_get(yc) != Y_MUST)
-		continue;
-	    xpath = yang_argument_get(yc); /* "must" has xpath argument */
-	    if (xml_nsctx_yang(yc, &nsc) < 0)
-		goto done;
-	    if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
-		goto done;
-	    if (!nr){
-		ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
-		if (netconf_operation_failed_xml(xret, "application", 
-						 ye?yang_argument_get(ye):"must xpath validation failed") < 0)
-		    goto done;
-		goto fail;
-	    }
-	    if (nsc){
-		xml_nsctx_free(nsc);
-		nsc = NULL;
-	    }
-	}
-	/* "when" sub-node RFC 7950 Sec 7.21.5. Can only be one. */
-	if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL){
-	    xpath = yang_argument_get(yc); /* "when" has xpath argument */
-	    /* WHEN xpath needs namespace context */
-	    if (xml_nsctx_yang(ys, &nsc) < 0)
-		goto done;
-	    if ((nr = xpath_vec_bool(xt, nsc,
-				     "%s", xpath)) < 0)
-		goto done;
-	    if (nsc){
-		xml_nsctx_free(nsc);
-		nsc = NULL;
-	    }
-	    if (nr == 0){
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed WHEN condition of %s in module %s",
-			xml_name(xt),
-			yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	}
-	/* Augmented when using special struct. */
-	if ((xpath = yang_when_xpath_get(ys)) != NULL){
-	    if ((nr = xpath_vec_bool(xml_parent(xt), yang_when_nsc_get(ys),
-				     "%s", xpath)) < 0)
-		goto done;
-	    if (nr == 0){
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed augmented WHEN condition of %s in module %s",
-			xml_name(xt),
-			yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	}
+	if ((ret = xml_yang_validate_node(xt, ys, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
     }
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
@@ -1210,10 +1275,6 @@ xml_yang_validate_all(clicon_handle h,
  ok:
     retval = 1;
  done:
-    if (cb)
-	cbuf_free(cb);
-    if (nsc)
-	xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
@@ -1242,3 +1303,690 @@ xml_yang_validate_all_top(clicon_handle h,
 	return ret;
     return 1;
 }
+
+/*! Check that all nodes in an XML tree have yang specs, but no other validation
+ *
+ * This is the minimal check required by xml_diff, used instead of 
+ * xml_yang_validate_all_top when the tree is validated incrementally.
+ * Children of anyxml and anydata nodes are not checked.
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML tree (top-level)
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     All nodes have yang specs
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see xml_yang_validate_diff
+ */
+int
+xml_yang_validate_bind(clicon_handle h,
+		       cxobj        *xt,
+		       cxobj       **xret)
+{
+    int        retval = -1;
+    cxobj     *x;
+    yang_stmt *ys;
+    int        ret;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	if ((ys = xml_spec(x)) == NULL){
+	    if ((ret = xml_yang_validate_nospec(h, x, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	    continue;
+	}
+	if (yang_keyword_get(ys) == Y_ANYXML || yang_keyword_get(ys) == Y_ANYDATA)
+	    continue;
+	if ((ret = xml_yang_validate_bind(h, x, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*
+ * Incremental validation, see xml_yang_validate_diff
+ */
+
+/*! Yang constraint that may depend on other parts of the XML tree
+ * One entry per config yang node with a leafref, must or when constraint.
+ */
+struct validate_dep{
+    yang_stmt  *vd_ys;      /* Yang node with constraint */
+    yang_stmt **vd_path;    /* Data node ancestors of vd_ys, top-level first, incl vd_ys */
+    int         vd_len;     /* Length of vd_path */
+    int         vd_leafref; /* Only leafref: added nodes cannot invalidate it */
+    int         vd_any;     /* Any change may invalidate it, eg wildcards or deref() */
+    cvec       *vd_names;   /* Node names referenced by the constraint xpaths */
+};
+typedef struct validate_dep validate_dep;
+
+/*! Dependency index of a yang spec, cached in clicon handle
+ */
+struct validate_deps{
+    yang_stmt    *vi_yspec; /* Yang spec the index is built from */
+    int           vi_len;   /* Length of vi_vec */
+    validate_dep *vi_vec;   /* Vector of yang nodes with constraints */
+};
+typedef struct validate_deps validate_deps;
+
+/*! Add node names referenced by a parsed xpath to a dependency entry
+ * @param[in]  vd    Dependency entry
+ * @param[in]  xs    Parsed xpath tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_dep_names(validate_dep *vd,
+		   xpath_tree   *xs)
+{
+    int retval = -1;
+    
+    switch (xs->xs_type){
+    case XP_NODE:
+	if (xs->xs_s1 == NULL) /* wildcard */
+	    vd->vd_any = 1;
+	else if (cvec_find(vd->vd_names, xs->xs_s1) == NULL &&
+		 cvec_add_string(vd->vd_names, xs->xs_s1, NULL) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+	break;
+    case XP_NODE_FN: /* node(), text() */
+	vd->vd_any = 1;
+	break;
+    case XP_PRIME_FN:
+	if (xs->xs_s0 && strcmp(xs->xs_s0, "deref") == 0)
+	    vd->vd_any = 1;
+	break;
+    case XP_STEP:
+	/* The value of a non-leaf self node depends on its descendants */
+	if (xs->xs_int == A_SELF &&
+	    yang_keyword_get(vd->vd_ys) != Y_LEAF &&
+	    yang_keyword_get(vd->vd_ys) != Y_LEAF_LIST)
+	    vd->vd_any = 1;
+	break;
+    default:
+	break;
+    }
+    if (xs->xs_c0 && validate_dep_names(vd, xs->xs_c0) < 0)
+	goto done;
+    if (xs->xs_c1 && validate_dep_names(vd, xs->xs_c1) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Parse a constraint xpath and add its referenced node names to a dependency entry
+ * If the xpath cannot be parsed, any change may invalidate the constraint
+ * @param[in]  vd    Dependency entry
+ * @param[in]  xpath XPath of leafref path, must or when statement
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_dep_xpath(validate_dep *vd,
+		   char         *xpath)
+{
+    int         retval = -1;
+    xpath_tree *xpt = NULL;
+
+    if (xpath_parse(xpath, &xpt) < 0){
+	clicon_err_reset();
+	vd->vd_any = 1;
+	goto ok;
+    }
+    if (validate_dep_names(vd, xpt) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xpt)
+	xpath_tree_free(xpt);
+    return retval;
+}
+
+/*! Add a dependency entry for a yang node if it has leafref, must or when constraints
+ * @param[in]  vi    Dependency index
+ * @param[in]  ys    Yang data node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_dep_add(validate_deps *vi,
+		 yang_stmt     *ys)
+{
+    int           retval = -1;
+    validate_dep *vd = NULL;
+    yang_stmt    *yrestype = NULL;
+    yang_stmt    *yc;
+    yang_stmt    *yp;
+    char         *xpath;
+    int           leafref = 0;
+    int           other = 0;
+    int           i;
+    
+    if (yang_keyword_get(ys) == Y_LEAF || yang_keyword_get(ys) == Y_LEAF_LIST){
+	if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	if (yrestype && strcmp(yang_argument_get(yrestype), "leafref") == 0)
+	    leafref++;
+    }
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL)
+	if (yang_keyword_get(yc) == Y_MUST || yang_keyword_get(yc) == Y_WHEN)
+	    other++;
+    if (yang_when_xpath_get(ys) != NULL)
+	other++;
+    if (leafref == 0 && other == 0)
+	goto ok;
+    if ((vi->vi_vec = realloc(vi->vi_vec, (vi->vi_len+1)*sizeof(validate_dep))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	goto done;
+    }
+    vd = &vi->vi_vec[vi->vi_len++];
+    memset(vd, 0, sizeof(*vd));
+    vd->vd_ys = ys;
+    vd->vd_leafref = (other == 0);
+    if ((vd->vd_names = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    /* Data node path from top-level, skipping choice and case */
+    for (yp = ys; yp != NULL; yp = yang_parent_get(yp)){
+	if (yang_keyword_get(yp) == Y_MODULE || yang_keyword_get(yp) == Y_SUBMODULE)
+	    break;
+	if (yang_keyword_get(yp) != Y_CHOICE && yang_keyword_get(yp) != Y_CASE)
+	    vd->vd_len++;
+    }
+    if ((vd->vd_path = calloc(vd->vd_len, sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    i = vd->vd_len;
+    for (yp = ys; yp != NULL; yp = yang_parent_get(yp)){
+	if (yang_keyword_get(yp) == Y_MODULE || yang_keyword_get(yp) == Y_SUBMODULE)
+	    break;
+	if (yang_keyword_get(yp) != Y_CHOICE && yang_keyword_get(yp) != Y_CASE)
+	    vd->vd_path[--i] = yp;
+    }
+    if (leafref &&
+	(yc = yang_find(yrestype, Y_PATH, NULL)) != NULL &&
+	validate_dep_xpath(vd, yang_argument_get(yc)) < 0)
+	goto done;
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL)
+	if (yang_keyword_get(yc) == Y_MUST || yang_keyword_get(yc) == Y_WHEN)
+	    if (validate_dep_xpath(vd, yang_argument_get(yc)) < 0)
+		goto done;
+    if ((xpath = yang_when_xpath_get(ys)) != NULL &&
+	validate_dep_xpath(vd, xpath) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Recursively add config data nodes with constraints to dependency index
+ * @param[in]  vi    Dependency index
+ * @param[in]  yn    Yang node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_deps_build(validate_deps *vi,
+		    yang_stmt     *yn)
+{
+    int        retval = -1;
+    yang_stmt *yc;
+
+    yc = NULL;
+    while ((yc = yn_each(yn, yc)) != NULL) {
+	switch (yang_keyword_get(yc)){
+	case Y_CONTAINER:
+	case Y_LIST:
+	case Y_LEAF:
+	case Y_LEAF_LIST:
+	    if (yang_config(yc) == 0)
+		break;
+	    if (validate_dep_add(vi, yc) < 0)
+		goto done;
+	    /* fall thru */
+	case Y_MODULE:
+	case Y_SUBMODULE:
+	case Y_CHOICE:
+	case Y_CASE:
+	    if (validate_deps_build(vi, yc) < 0)
+		goto done;
+	    break;
+	default:
+	    break;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get dependency index of yang spec, build it if not cached in the handle
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Yang spec
+ * @retval     vi    Dependency index
+ * @retval     NULL  Error
+ */
+static validate_deps *
+validate_deps_get(clicon_handle h,
+		  yang_stmt    *yspec)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    validate_deps *vi = NULL;
+    size_t         len;
+    void          *p;
+
+    if ((p = clicon_hash_value(cdat, "validate_deps", &len)) != NULL){
+	vi = *(validate_deps **)p;
+	if (vi->vi_yspec == yspec)
+	    return vi;
+	xml_yang_validate_deps_free(h);
+    }
+    if ((vi = malloc(sizeof(*vi))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(vi, 0, sizeof(*vi));
+    vi->vi_yspec = yspec;
+    /* Store before build so that it is freed also on error */
+    if (clicon_hash_add(cdat, "validate_deps", &vi, sizeof(vi)) == NULL){
+	free(vi);
+	return NULL;
+    }
+    if (validate_deps_build(vi, yspec) < 0){
+	xml_yang_validate_deps_free(h);
+	return NULL;
+    }
+    return vi;
+}
+
+/*! Free the cached dependency index used by incremental validation
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @see xml_yang_validate_diff
+ */
+int
+xml_yang_validate_deps_free(clicon_handle h)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    validate_deps *vi;
+    validate_dep  *vd;
+    size_t         len;
+    void          *p;
+    int            i;
+
+    if ((p = clicon_hash_value(cdat, "validate_deps", &len)) == NULL)
+	return 0;
+    vi = *(validate_deps **)p;
+    for (i=0; i<vi->vi_len; i++){
+	vd = &vi->vi_vec[i];
+	if (vd->vd_path)
+	    free(vd->vd_path);
+	if (vd->vd_names)
+	    cvec_free(vd->vd_names);
+    }
+    if (vi->vi_vec)
+	free(vi->vi_vec);
+    free(vi);
+    clicon_hash_del(cdat, "validate_deps");
+    return 0;
+}
+
+/*! Add names of an XML subtree to hash sets of changed names
+ * @param[in]  x     XML node
+ * @param[in]  hall  All added, removed or changed names
+ * @param[in]  hdel  Removed or changed names, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_diff_names(cxobj         *x,
+		    clicon_hash_t *hall,
+		    clicon_hash_t *hdel)
+{
+    int    retval = -1;
+    cxobj *xc;
+
+    if (clicon_hash_add(hall, xml_name(x), NULL, 0) == NULL)
+	goto done;
+    if (hdel && clicon_hash_add(hdel, xml_name(x), NULL, 0) == NULL)
+	goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	if (validate_diff_names(xc, hall, hdel) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if any list or leaf-list child has min/max-elements or unique constraints
+ * @param[in]  yt    Yang node
+ * @retval     1     Yes, check_list_unique_minmax needs to be called for instances of yt
+ * @retval     0     No
+ */
+static int
+yang_minmax_children(yang_stmt *yt)
+{
+    yang_stmt *yc;
+
+    yc = NULL;
+    while ((yc = yn_each(yt, yc)) != NULL) {
+	switch (yang_keyword_get(yc)){
+	case Y_LIST:
+	case Y_LEAF_LIST:
+	    if (yang_find(yc, Y_MIN_ELEMENTS, NULL) != NULL ||
+		yang_find(yc, Y_MAX_ELEMENTS, NULL) != NULL ||
+		yang_find(yc, Y_UNIQUE, NULL) != NULL)
+		return 1;
+	    break;
+	case Y_CHOICE:
+	case Y_CASE:
+	    if (yang_minmax_children(yc))
+		return 1;
+	    break;
+	default:
+	    break;
+	}
+    }
+    return 0;
+}
+
+/*! Check list unique and min/max-element constraints of an XML node and its ancestors
+ * Nodes already checked are marked with XML_FLAG_MARK and skipped.
+ * @param[in]  x     XML node in target tree
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ */
+static int
+validate_diff_minmax(cxobj  *x,
+		     cxobj **xret)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    int        ret;
+
+    for (; x != NULL; x = xml_parent(x)){
+	if (xml_flag(x, XML_FLAG_MARK))
+	    break; /* Ancestors already checked */
+	xml_flag_set(x, XML_FLAG_MARK);
+	if ((y = xml_spec(x)) != NULL &&
+	    (yang_config(y) == 0 || !yang_minmax_children(y)))
+	    continue;
+	if ((ret = check_list_unique_minmax(x, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find the node in the target tree corresponding to a node in the source tree
+ * @param[in]  xt    Target tree top-level
+ * @param[in]  xs    Node in source tree
+ * @param[out] xtp   Corresponding node in target tree, or NULL if not found
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+validate_diff_target(cxobj  *xt,
+		     cxobj  *xs,
+		     cxobj **xtp)
+{
+    int    retval = -1;
+    cxobj *xp;
+
+    *xtp = NULL;
+    if (xml_parent(xs) == NULL){
+	*xtp = xt;
+	goto ok;
+    }
+    if (validate_diff_target(xt, xml_parent(xs), &xp) < 0)
+	goto done;
+    if (xp == NULL)
+	goto ok;
+    if (match_base_child(xp, xs, xml_spec(xs), xtp) < 0)
+	goto done;
+    /* Choice matching may return another case */
+    if (*xtp && xml_spec(*xtp) != xml_spec(xs))
+	*xtp = NULL;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Validate all XML instances of a yang data node path
+ * @param[in]  xt    XML node, instance of vd_path[i-1] or top-level
+ * @param[in]  vd    Dependency entry
+ * @param[in]  i     Index in vd_path of children of xt
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ */
+static int
+validate_dep_instances(cxobj        *xt,
+		       validate_dep *vd,
+		       int           i,
+		       cxobj       **xret)
+{
+    int    retval = -1;
+    cxobj *x;
+    int    ret;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	if (xml_spec(x) != vd->vd_path[i])
+	    continue;
+	if (i == vd->vd_len-1)
+	    ret = xml_yang_validate_node(x, vd->vd_ys, xret);
+	else
+	    ret = validate_dep_instances(x, vd, i+1, xret);
+	if (ret < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if any node name referenced by a constraint is in a set of changed names
+ * @param[in]  vd    Dependency entry
+ * @param[in]  hnames Hash set of changed names
+ * @retval     1     Yes, constraint may be invalidated
+ * @retval     0     No
+ */
+static int
+validate_dep_changed(validate_dep  *vd,
+		     clicon_hash_t *hnames)
+{
+    cg_var *cv = NULL;
+
+    while ((cv = cvec_each(vd->vd_names, cv)) != NULL)
+	if (clicon_hash_lookup(hnames, cv_name_get(cv)) != NULL)
+	    return 1;
+    return 0;
+}
+
+/*! Validate a target XML tree given its differences to a valid source tree
+ *
+ * Instead of validating the whole target tree as xml_yang_validate_all_top,
+ * only the following are validated:
+ * 1. Added and changed subtrees
+ * 2. List unique and min/max-elements constraints of the parents (and their 
+ *    ancestors) of added, changed and removed nodes
+ * 3. Leafref, must and when constraints elsewhere in the tree that refer to 
+ *    names of added, changed or removed nodes. A dependency index of such yang 
+ *    constraints is built on first call and cached in the handle.
+ *    A leafref is not re-validated when nodes are only added.
+ * The source tree is assumed to be valid. The time is proportional to the size
+ * of the change, not the size of the tree, unless the change affects constraints
+ * with many instances.
+ * @param[in]  h      Clicon handle
+ * @param[in]  xt     Target XML tree (top-level)
+ * @param[in]  dvec   Removed nodes (in source tree)
+ * @param[in]  dlen   Length of dvec
+ * @param[in]  avec   Added nodes (in target tree)
+ * @param[in]  alen   Length of avec
+ * @param[in]  scvec  Changed nodes, original values (in source tree)
+ * @param[in]  tcvec  Changed nodes, wanted values (in target tree)
+ * @param[in]  clen   Length of scvec and tcvec
+ * @param[out] xret   Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1      Validation OK
+ * @retval     0      Validation failed (xret set)
+ * @retval    -1      Error
+ * @see xml_yang_validate_all_top  for full validation
+ * @see xml_diff   which computes the differences
+ */
+int
+xml_yang_validate_diff(clicon_handle h,
+		       cxobj        *xt,
+		       cxobj       **dvec,
+		       int           dlen,
+		       cxobj       **avec,
+		       int           alen,
+		       cxobj       **scvec,
+		       cxobj       **tcvec,
+		       int           clen,
+		       cxobj       **xret)
+{
+    int            retval = -1;
+    yang_stmt     *yspec;
+    validate_deps *vi;
+    validate_dep  *vd;
+    clicon_hash_t *hall = NULL;
+    clicon_hash_t *hdel = NULL;
+    clixon_xvec   *xv = NULL;
+    cxobj         *x;
+    int            i;
+    int            ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if ((vi = validate_deps_get(h, yspec)) == NULL)
+	goto done;
+    clicon_debug(1, "%s: added:%d changed:%d removed:%d",
+		 __FUNCTION__, alen, clen, dlen);
+    /* 1. Added and changed subtrees */
+    for (i=0; i<alen; i++){
+	if ((ret = xml_yang_validate_all(h, avec[i], xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    for (i=0; i<clen; i++){
+	if ((ret = xml_yang_validate_all(h, tcvec[i], xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    /* 2. Parents whose children were added, changed or removed */
+    if ((xv = clixon_xvec_new()) == NULL)
+	goto done;
+    for (i=0; i<alen; i++)
+	if (clixon_xvec_append(xv, xml_parent(avec[i])) < 0)
+	    goto done;
+    for (i=0; i<clen; i++)
+	if (clixon_xvec_append(xv, xml_parent(tcvec[i])) < 0)
+	    goto done;
+    for (i=0; i<dlen; i++){
+	if (validate_diff_target(xt, xml_parent(dvec[i]), &x) < 0)
+	    goto done;
+	if (x == NULL){ /* Should not happen, revert to full validation */
+	    clicon_debug(1, "%s: %s not found in target, full validation",
+			 __FUNCTION__, xml_name(xml_parent(dvec[i])));
+	    if ((ret = xml_yang_validate_all_top(h, xt, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	    goto ok;
+	}
+	if (clixon_xvec_append(xv, x) < 0)
+	    goto done;
+    }
+    ret = 1;
+    for (i=0; i<clixon_xvec_len(xv); i++)
+	if ((ret = validate_diff_minmax(clixon_xvec_i(xv, i), xret)) < 1)
+	    break;
+    for (i=0; i<clixon_xvec_len(xv); i++)
+	for (x = clixon_xvec_i(xv, i); x && xml_flag(x, XML_FLAG_MARK); x = xml_parent(x))
+	    xml_flag_reset(x, XML_FLAG_MARK);
+    if (ret < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    /* 3. Constraints referring to added, changed or removed names */
+    if (alen + dlen + clen == 0)
+	goto ok;
+    if ((hall = clicon_hash_init()) == NULL)
+	goto done;
+    if ((hdel = clicon_hash_init()) == NULL)
+	goto done;
+    for (i=0; i<alen; i++)
+	if (validate_diff_names(avec[i], hall, NULL) < 0)
+	    goto done;
+    for (i=0; i<dlen; i++)
+	if (validate_diff_names(dvec[i], hall, hdel) < 0)
+	    goto done;
+    for (i=0; i<clen; i++){
+	if (validate_diff_names(scvec[i], hall, hdel) < 0)
+	    goto done;
+	if (validate_diff_names(tcvec[i], hall, hdel) < 0)
+	    goto done;
+    }
+    for (i=0; i<vi->vi_len; i++){
+	vd = &vi->vi_vec[i];
+	if (!vd->vd_any &&
+	    !validate_dep_changed(vd, vd->vd_leafref?hdel:hall))
+	    continue;
+	if ((ret = validate_dep_instances(xt, vd, 0, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (hall)
+	clicon_hash_free(hall);
+    if (hdel)
+	clicon_hash_free(hdel);
+    if (xv)
+	clixon_xvec_free(xv);
+    return retval;
+ fail:
+    clicon_debug(1, "%s: validation failed", __FUNCTION__);
+    retval = 0;
+    goto done;
+}
@@ -74,6 +74,7 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_atom.h"
 
 /*
  * Constants
@@ -87,6 +88,20 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16 
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Size of inline value buffer of body and attribute nodes. Longer values are malloced.
+ * Covers most integers, enumerations, short names and IPv4 addresses
+ */
+#define XML_VALUE_INLINE 16
+
+/* Size of an XML arena block. Blocks are aligned to their size so that the arena of a
+ * node can be found from the node address. Must be a power of two.
+ */
+#define XML_ARENA_BLOCK   (64*1024)
+
+/* Internal xml flags, not visible via xml_flag(). See XML_FLAG_* in clixon_xml.h
+ */
+#define XML_FLAG_ARENA   0x8000  /* Node is allocated in an arena */
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -123,6 +138,7 @@ struct search_index{
     qelem_t      si_q;    /* Queue header */
     char        *si_name; /* Name of index variable (must be (potential) child of xml node at hand */
     clixon_xvec *si_xvec; /* Sorted vector of xml object pointers (should be of YANG type LIST) */
+    int          si_sorted; /* Nr of sorted elements first in si_xvec, see xml_search_child_insert_vec */
 };
 #endif
 
@@ -162,16 +178,13 @@ struct search_index{
  */
 struct xml{
     enum cxobj_type   x_type;       /* type of node: element, attribute, body */
+    uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
-    uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
     struct xml       *x_up;         /* parent node in hierarchy if any */
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-				       memory) cv? */
     /*----- up to here is common to all next is element only */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
@@ -188,18 +201,72 @@ struct xml{
 };
 
 /* Variant of struct xml for use by non-elements to save space
+ * Values shorter than XML_VALUE_INLINE (including null) are stored in the node itself,
+ * longer values are malloced.
  * @see struct xml  For XML elements
  */
 struct xmlbody{
     enum cxobj_type   xb_type;       /* type of node: element, attribute, body */
+    uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
-    uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    /*----- up to here is common to all */
+    uint32_t          xb_value_len;  /* Length of value, excluding null */
+    uint32_t          xb_value_max;  /* Allocated size of value, 0 if not set,
+				        XML_VALUE_INLINE if inline */
+    union {
+	char          xv_inline[XML_VALUE_INLINE]; /* Inline value */
+	char         *xv_heap;                     /* Malloced value */
+    }                 xb_value;      /* attribute and body nodes have values */
+};
+
+/* Access body/attribute fields of a cxobj */
+#define xml_xb(x) ((struct xmlbody *)(x))
+/* Value string of a body/attribute with a value set */
+#define xml_xb_value(xb) ((xb)->xb_value_max > XML_VALUE_INLINE ? \
+			  (xb)->xb_value.xv_heap : (xb)->xb_value.xv_inline)
+
+/* XML arena
+ * An arena is used when parsing large XML/JSON files to avoid one malloc per node.
+ * Nodes are allocated consecutively from large aligned blocks, using separate slabs
+ * for elements and bodies/attributes.
+ * A freed node is put on a free list of its block, and the slot is reused by the next
+ * node of the same slab, also by nodes created after parsing. A block is released when
+ * its last node is freed, and the arena when its last block is released.
+ * Other node memory (child vectors, values, caches) is allocated on the heap as usual.
+ * @see xml_arena_begin
+ */
+enum xml_slab{
+    XA_ELMNT = 0, /* struct xml */
+    XA_BODY,      /* struct xmlbody */
+    XA_NR
+};
+
+/* Header of an arena block, followed by slab data */
+struct xml_arena_block{
+    struct xml_arena_block *ab_next;   /* List of all blocks of the arena */
+    struct xml_arena_block *ab_prev;
+    struct xml_arena_block *ab_fnext;  /* List of blocks with free slots, see _xml_arena_free */
+    struct xml_arena_block *ab_fprev;
+    struct xml_arena       *ab_arena;  /* Arena the block belongs to */
+    void                   *ab_free;   /* Free slots, linked through their first pointer */
+    uint32_t                ab_live;   /* Number of live nodes in block */
+    enum xml_slab           ab_slab;   /* Slab of all nodes in block */
+};
+
+/* Offset of first object in a block */
+#define XML_ARENA_HDR ((sizeof(struct xml_arena_block)+15) & ~(size_t)15)
+
+struct xml_arena{
+    struct xml_arena_block *xa_blocks;      /* All blocks of this arena */
+    struct xml_arena_block *xa_cur[XA_NR];  /* Current block of each slab */
+    size_t                  xa_used[XA_NR]; /* Bytes used of current block of each slab */
+    uint64_t                xa_nodes;       /* Number of live nodes in arena */
+    int                     xa_open;        /* Arena is used by an ongoing parse */
 };
 
 /*
@@ -227,6 +294,15 @@ xml_type2str(enum cxobj_type type)
 
 /* Stats */
 uint64_t _stats_nr = 0;
+static uint64_t _stats_arena_nr = 0;   /* Number of live arenas */
+static size_t   _stats_arena_size = 0; /* Allocated bytes in arena blocks */
+
+/* Arena used for new nodes while parsing, if any */
+static struct xml_arena *_xml_arena = NULL;
+static int               _xml_arena_enable = 0;
+
+/* Blocks of each slab with free slots, of all arenas */
+static struct xml_arena_block *_xml_arena_free[XA_NR] = {NULL, };
 
 /*! Get global statistics about XML objects
  */
@@ -238,12 +314,240 @@ xml_stats_global(uint64_t *nr)
     return 0;
 }
 
+/*! Get global statistics about XML arenas
+ * @param[out]  nrp  Number of live arenas
+ * @param[out]  szp  Bytes allocated in arena blocks
+ * @see xml_arena_begin
+ */
+int
+xml_stats_arena(uint64_t *nrp,
+		size_t   *szp)
+{
+    if (nrp)
+	*nrp = _stats_arena_nr;
+    if (szp)
+	*szp = _stats_arena_size;
+    return 0;
+}
+
+/*! Allocate memory from a slab of an arena
+ * @param[in]  xa    XML arena
+ * @param[in]  slab  Which slab to allocate from
+ * @param[in]  sz    Size of object, less than XML_ARENA_BLOCK - XML_ARENA_HDR
+ * @retval     ptr   Allocated memory, not initialized
+ * @retval     NULL  Error, errno set
+ */
+static void *
+xml_arena_alloc(struct xml_arena *xa,
+		enum xml_slab     slab,
+		size_t            sz)
+{
+    struct xml_arena_block *ab;
+    size_t                  used;
+    int                     ret;
+
+    /* Align to pointer size */
+    used = (xa->xa_used[slab] + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    if ((ab = xa->xa_cur[slab]) == NULL || used + sz > XML_ARENA_BLOCK){
+	if ((ret = posix_memalign((void**)&ab, XML_ARENA_BLOCK, XML_ARENA_BLOCK)) != 0){
+	    errno = ret;
+	    return NULL;
+	}
+	memset(ab, 0, sizeof(*ab));
+	ab->ab_arena = xa;
+	ab->ab_slab = slab;
+	if ((ab->ab_next = xa->xa_blocks) != NULL)
+	    ab->ab_next->ab_prev = ab;
+	xa->xa_blocks = ab;
+	xa->xa_cur[slab] = ab;
+	used = XML_ARENA_HDR;
+	_stats_arena_size += XML_ARENA_BLOCK;
+    }
+    xa->xa_used[slab] = used + sz;
+    ab->ab_live++;
+    xa->xa_nodes++;
+    return (char*)ab + used;
+}
+
+/*! Allocate memory from a free slot of an arena block, if any
+ * @param[in]  slab  Which slab to allocate from
+ * @retval     ptr   Allocated memory, not initialized
+ * @retval     NULL  No free slot
+ */
+static void *
+xml_arena_reuse(enum xml_slab slab)
+{
+    struct xml_arena_block *ab;
+    void                   *p;
+
+    if ((ab = _xml_arena_free[slab]) == NULL)
+	return NULL;
+    p = ab->ab_free;
+    if ((ab->ab_free = *(void**)p) == NULL){ /* Last free slot */
+	if ((_xml_arena_free[slab] = ab->ab_fnext) != NULL)
+	    ab->ab_fnext->ab_fprev = NULL;
+	ab->ab_fnext = NULL;
+    }
+    ab->ab_live++;
+    ab->ab_arena->xa_nodes++;
+    return p;
+}
+
+/*! Get arena block of an XML node allocated in an arena
+ * @param[in]  x   XML node with XML_FLAG_ARENA set
+ * @retval     ab  XML arena block
+ */
+static struct xml_arena_block *
+xml_arena_block_get(cxobj *x)
+{
+    return (struct xml_arena_block *)((uintptr_t)x & ~((uintptr_t)XML_ARENA_BLOCK - 1));
+}
+
+/*! Release an arena block
+ * @param[in]  ab  XML arena block, no live nodes
+ */
+static void
+xml_arena_block_free(struct xml_arena_block *ab)
+{
+    struct xml_arena *xa = ab->ab_arena;
+
+    if (ab->ab_free){ /* Remove from list of blocks with free slots */
+	if (ab->ab_fnext)
+	    ab->ab_fnext->ab_fprev = ab->ab_fprev;
+	if (ab->ab_fprev)
+	    ab->ab_fprev->ab_fnext = ab->ab_fnext;
+	else
+	    _xml_arena_free[ab->ab_slab] = ab->ab_fnext;
+    }
+    if (ab->ab_next)
+	ab->ab_next->ab_prev = ab->ab_prev;
+    if (ab->ab_prev)
+	ab->ab_prev->ab_next = ab->ab_next;
+    else
+	xa->xa_blocks = ab->ab_next;
+    if (xa->xa_cur[ab->ab_slab] == ab)
+	xa->xa_cur[ab->ab_slab] = NULL;
+    free(ab);
+    _stats_arena_size -= XML_ARENA_BLOCK;
+}
+
+/*! Release all blocks of an arena and the arena itself
+ * @param[in]  xa  XML arena
+ */
+static int
+xml_arena_free(struct xml_arena *xa)
+{
+    while (xa->xa_blocks != NULL)
+	xml_arena_block_free(xa->xa_blocks);
+    free(xa);
+    _stats_arena_nr--;
+    return 0;
+}
+
+/*! Put a freed XML node back on the free list of its arena block
+ * Release the block if it has no more live nodes, except the block an ongoing parse
+ * allocates from, and the arena if it has no more blocks.
+ * @param[in]  x   XML node with XML_FLAG_ARENA set, all its memory except x is freed
+ */
+static void
+xml_arena_put(cxobj *x)
+{
+    struct xml_arena_block *ab = xml_arena_block_get(x);
+    struct xml_arena       *xa = ab->ab_arena;
+    enum xml_slab           slab = ab->ab_slab;
+
+    xa->xa_nodes--;
+    if (--ab->ab_live == 0 && !(xa->xa_open && xa->xa_cur[slab] == ab)){
+	xml_arena_block_free(ab);
+	if (xa->xa_blocks == NULL && !xa->xa_open)
+	    xml_arena_free(xa);
+	return;
+    }
+    if (ab->ab_free == NULL){ /* First free slot: add to list of blocks with free slots */
+	ab->ab_fprev = NULL;
+	if ((ab->ab_fnext = _xml_arena_free[slab]) != NULL)
+	    ab->ab_fnext->ab_fprev = ab;
+	_xml_arena_free[slab] = ab;
+    }
+    *(void**)x = ab->ab_free;
+    ab->ab_free = x;
+}
+
+/*! Enable or disable use of arenas when parsing XML and JSON from file
+ * @param[in]  enable  Set to 1 to enable, 0 to disable
+ * @see CLICON_XML_ARENA
+ */
+int
+xml_arena_enable(int enable)
+{
+    _xml_arena_enable = enable;
+    return 0;
+}
+
+/*! Start allocating new XML nodes in a new arena
+ *
+ * Used by parsers of large input, all nodes created until xml_arena_end are allocated
+ * in the same arena. The arena is released when all its nodes are freed.
+ * @retval  1   Arena started, call xml_arena_end when done
+ * @retval  0   Arenas not enabled, or an arena already started
+ * @retval -1   Error
+ * @code
+ *   if ((arena = xml_arena_begin()) < 0)
+ *      err;
+ *   ... parse ...
+ *   if (arena)
+ *      xml_arena_end();
+ * @endcode
+ * @see xml_arena_enable
+ */
+int
+xml_arena_begin(void)
+{
+    struct xml_arena *xa;
+
+    if (!_xml_arena_enable || _xml_arena != NULL)
+	return 0;
+    if ((xa = malloc(sizeof(*xa))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return -1;
+    }
+    memset(xa, 0, sizeof(*xa));
+    xa->xa_open = 1;
+    _xml_arena = xa;
+    _stats_arena_nr++;
+    return 1;
+}
+
+/*! Stop allocating new XML nodes in the arena started by xml_arena_begin
+ * @see xml_arena_begin
+ */
+int
+xml_arena_end(void)
+{
+    struct xml_arena *xa;
+
+    enum xml_slab     slab;
+
+    if ((xa = _xml_arena) == NULL)
+	return 0;
+    _xml_arena = NULL;
+    xa->xa_open = 0;
+    /* Release blocks parsing allocated from that have no live nodes */
+    for (slab=0; slab<XA_NR; slab++)
+	if (xa->xa_cur[slab] && xa->xa_cur[slab]->ab_live == 0)
+	    xml_arena_block_free(xa->xa_cur[slab]);
+    if (xa->xa_blocks == NULL)
+	xml_arena_free(xa);
+    return 0;
+}
 
 /*! Return the alloced memory of a single XML obj 
  * @param[in]   x    XML object
  * @param[out]  szp  Size of this XML obj
  * @retval      0    OK
  * (baseline: 96 bytes per object on x86-64)
+ * @note Name and prefix are interned and shared by all nodes, and not included,
+ *       see xml_stats_atom
  */
 static int
 xml_stats_one(cxobj    *x,
@@ -251,10 +555,6 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
-	sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-	sz += strlen(x->x_prefix) + 1;
     switch (xml_type(x)){
     case CX_ELMNT:
 	sz += sizeof(struct xml);
@@ -277,8 +577,8 @@ xml_stats_one(cxobj    *x,
     case CX_BODY:
     case CX_ATTR:
 	sz += sizeof(struct xmlbody);
-	if (x->x_value_cb)
-	    sz += cbuf_buflen(x->x_value_cb);
+	if (xml_xb(x)->xb_value_max > XML_VALUE_INLINE)
+	    sz += xml_xb(x)->xb_value_max;
 	break;
     default:
 	break;
@@ -321,8 +621,8 @@ xml_print_stats_one(FILE   *f,
 		    (unsigned int)(strlen(x->x_search_index->si_name) + 1 + clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*)));
     }
     else{
-	if (x->x_value_cb)
-	    fprintf(f, "  value-cb: \t%u\n", cbuf_buflen(x->x_value_cb));
+	if (xml_xb(x)->xb_value_max > XML_VALUE_INLINE)
+	    fprintf(f, "  value: \t%u\n", xml_xb(x)->xb_value_max);
     }
     return 0;
 }
@@ -383,21 +683,21 @@ xml_name(cxobj *xn)
  * @param[in]  name  new name, null-terminated string, copied by function
  * @retval     -1    on error with clicon-err set
  * @retval     0     OK
+ * @note The name is interned: all nodes with the same name share the same string
+ * @see xml_atom_get
  */
 int
 xml_name_set(cxobj *xn, 
 	     char  *name)
 {
-    if (xn->x_name){
-	free(xn->x_name);
-	xn->x_name = NULL;
-    }
-    if (name){
-	if ((xn->x_name = strdup(name)) == NULL){
-	    clicon_err(OE_XML, errno, "strdup");
-	    return -1;
-	}
-    }
+    char *atom = NULL;
+
+    /* Get new before releasing old, name may be the old name */
+    if (name && (atom = xml_atom_get(name)) == NULL)
+	return -1;
+    if (xn->x_name)
+	xml_atom_put(xn->x_name);
+    xn->x_name = atom;
     return 0;
 }
 
@@ -416,21 +716,19 @@ xml_prefix(cxobj *xn)
  * @param[in]  prefix  New prefix, null-terminated string, copied by function
  * @retval     -1      Error with clicon-err set
  * @retval     0       OK
+ * @note The prefix is interned, see xml_name_set
  */
 int
 xml_prefix_set(cxobj *xn, 
 	       char  *prefix)
 {
-    if (xn->x_prefix){
-	free(xn->x_prefix);
-	xn->x_prefix = NULL;
-    }
-    if (prefix){
-	if ((xn->x_prefix = strdup(prefix)) == NULL){
-	    clicon_err(OE_XML, errno, "strdup");
-	    return -1;
-	}
-    }
+    char *atom = NULL;
+
+    if (prefix && (atom = xml_atom_get(prefix)) == NULL)
+	return -1;
+    if (xn->x_prefix)
+	xml_atom_put(xn->x_prefix);
+    xn->x_prefix = atom;
     return 0;
 }
 
@@ -623,9 +921,60 @@ xml_flag_reset(cxobj   *xn,
 char*
 xml_value(cxobj *xn)
 {
-    if (!is_bodyattr(xn))
+    struct xmlbody *xb = xml_xb(xn);
+
+    if (!is_bodyattr(xn) || xb->xb_value_max == 0)
 	return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    return xml_xb_value(xb);
+}
+
+/*! Ensure value buffer of a body or attribute node has room for a value
+ * Existing value is kept. Values that fit are stored inline in the node.
+ * @param[in]  xb    Body or attribute node
+ * @param[in]  sz    Required size, including null
+ * @param[in]  grow  If set, at least double the buffer (for appending)
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_value_alloc(struct xmlbody *xb,
+		size_t          sz,
+		int             grow)
+{
+    size_t max;
+    char  *v;
+
+    if (xb->xb_value_max == 0){ /* Not set */
+	xb->xb_value.xv_inline[0] = '\0';
+	xb->xb_value_max = XML_VALUE_INLINE;
+    }
+    if (sz <= xb->xb_value_max)
+	return 0;
+    if (sz > UINT32_MAX){
+	clicon_err(OE_XML, EFBIG, "value too large");
+	return -1;
+    }
+    max = sz;
+    if (grow && max < 2*(size_t)xb->xb_value_max)
+	max = 2*(size_t)xb->xb_value_max;
+    if (max > UINT32_MAX)
+	max = UINT32_MAX;
+    if (xb->xb_value_max > XML_VALUE_INLINE){
+	if ((v = realloc(xb->xb_value.xv_heap, max)) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return -1;
+	}
+    }
+    else {
+	if ((v = malloc(max)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return -1;
+	}
+	memcpy(v, xb->xb_value.xv_inline, xb->xb_value_len+1);
+    }
+    xb->xb_value.xv_heap = v;
+    xb->xb_value_max = max;
+    return 0;
 }
 
 /*! Set value of xml node, value is copied
@@ -638,8 +987,9 @@ int
 xml_value_set(cxobj *xn, 
 	      char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb = xml_xb(xn);
+    size_t          len;
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -647,16 +997,11 @@ xml_value_set(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
-	    goto done;
-	}
-    }
-    else
-	cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+    len = strlen(val);
+    if (xml_value_alloc(xb, len+1, 0) < 0)
+	goto done;
+    memmove(xml_xb_value(xb), val, len+1); /* val may be a part of the old value */
+    xb->xb_value_len = len;
     retval = 0;
  done:
     return retval;
@@ -672,8 +1017,9 @@ int
 xml_value_append(cxobj *xn, 
 		 char  *val)
 {
-    int    retval = -1;
-    size_t sz;
+    int             retval = -1;
+    struct xmlbody *xb = xml_xb(xn);
+    size_t          len;
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -681,17 +1027,11 @@ xml_value_append(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
-	    goto done;
-	}
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-	clicon_err(OE_XML, errno, "cprintf");
+    len = strlen(val);
+    if (xml_value_alloc(xb, xb->xb_value_len+len+1, 1) < 0)
 	goto done;
-    }
+    memcpy(xml_xb_value(xb)+xb->xb_value_len, val, len+1);
+    xb->xb_value_len += len;
     retval = 0;
  done:
     return retval;
@@ -1049,8 +1389,9 @@ xml_new(char           *name,
 	cxobj          *xp,
 	enum cxobj_type type)
 {
-    struct xml *x = NULL;
-    size_t      sz;
+    struct xml   *x = NULL;
+    size_t        sz;
+    enum xml_slab slab;
     
     switch (type){
     case CX_ELMNT:
@@ -1065,11 +1406,26 @@ xml_new(char           *name,
 	return NULL;
 	break;
     }
-    if ((x = malloc(sz)) == NULL){
-	clicon_err(OE_XML, errno, "malloc");
-	return NULL;
+    slab = (type==CX_ELMNT)?XA_ELMNT:XA_BODY;
+    if ((x = xml_arena_reuse(slab)) != NULL){
+	memset(x, 0, sz);
+	x->x_flags = XML_FLAG_ARENA;
+    }
+    else if (_xml_arena != NULL){
+	if ((x = xml_arena_alloc(_xml_arena, slab, sz)) == NULL){
+	    clicon_err(OE_XML, errno, "xml_arena_alloc");
+	    return NULL;
+	}
+	memset(x, 0, sz);
+	x->x_flags = XML_FLAG_ARENA;
+    }
+    else {
+	if ((x = malloc(sz)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	memset(x, 0, sz);
     }
-    memset(x, 0, sz);
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
 	return NULL;
@@ -1192,6 +1548,7 @@ xml_cv_set(cxobj  *x,
  * @note (2) Does not differentiate between element,attributes and body. You usually want elements.
  * @note (3) Linear scalability and relies on strcmp, does not use search/key indexes
  * @note (4) Only returns first match, eg a list/leaf-list may have several children with same name
+ * @note If name is the (interned) name of another node, a match is a pointer comparison
  * @see xml_find_type  A more generic function fixes (1) and (2) above
  */
 cxobj *
@@ -1199,12 +1556,15 @@ xml_find(cxobj *xp,
 	 char  *name)
 {
     cxobj *x = NULL;
+    char  *xname;
 
     if (!is_element(xp))
 	return NULL;
-    while ((x = xml_child_each(xp, x, -1)) != NULL) 
-	if (strcmp(name, xml_name(x)) == 0)
+    while ((x = xml_child_each(xp, x, -1)) != NULL){
+	xname = xml_name(x);
+	if (xname == name || strcmp(name, xname) == 0)
 	    break; /* x is set */
+    }
     return x;
 }
 
@@ -1617,12 +1977,17 @@ xml_enumerate_get(cxobj *x)
 char *
 xml_body(cxobj *xn)
 {
-    cxobj *xb = NULL;
+    cxobj *xb;
+    int    i;
 
     if (!is_element(xn))
 	return NULL;
-    while ((xb = xml_child_each(xn, xb, CX_BODY)) != NULL) 
-	return xml_value(xb);
+    /* A leaf has a single body child, avoid xml_child_each */
+    for (i = 0; i < xn->x_childvec_len; i++){
+	xb = xn->x_childvec[i];
+	if (xb != NULL && xml_type(xb) == CX_BODY)
+	    return xml_value(xb);
+    }
     return NULL;
 }
 
@@ -1696,19 +2061,19 @@ xml_find_type(cxobj           *xt,
 	      enum cxobj_type  type)
 {
     cxobj *x = NULL;
-    int    pmatch; /* prefix match */
-    char  *xprefix;     /* xprefix */
+    char  *aname;
+    char  *aprefix = NULL;
     
-    if (!is_element(xt))
+    if (!is_element(xt) || xml_child_nr(xt) == 0)
+	return NULL;
+    /* Names and prefixes are interned, if not found no node can match */
+    if ((aname = xml_atom_find(name)) == NULL)
+	return NULL;
+    if (prefix && (aprefix = xml_atom_find(prefix)) == NULL)
 	return NULL;
     while ((x = xml_child_each(xt, x, type)) != NULL) {
-	if (prefix){
-	    xprefix = xml_prefix(x);
-	    pmatch = xprefix ? strcmp(prefix,xprefix)==0 : 0;
-	}
-	else
-	    pmatch = 1;
-	if (pmatch && strcmp(name, xml_name(x)) == 0)
+	if (xml_name(x) == aname &&
+	    (prefix == NULL || xml_prefix(x) == aprefix))
 	    return x;
     }
     return NULL;
@@ -1814,9 +2179,9 @@ xml_free(cxobj *x)
     cxobj *xc;
 
     if (x->x_name)
-	free(x->x_name);
+	xml_atom_put(x->x_name);
     if (x->x_prefix)
-	free(x->x_prefix);
+	xml_atom_put(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
 	for (i=0; i<x->x_childvec_len; i++){
@@ -1837,13 +2202,16 @@ xml_free(cxobj *x)
 	break;
     case CX_BODY:
     case CX_ATTR:
-	if (x->x_value_cb)
-	    cbuf_free(x->x_value_cb);  
+	if (xml_xb(x)->xb_value_max > XML_VALUE_INLINE)
+	    free(xml_xb(x)->xb_value.xv_heap);
 	break;
     default:
 	break;
     }
-    free(x);
+    if (x->x_flags & XML_FLAG_ARENA)
+	xml_arena_put(x);
+    else
+	free(x);
     _stats_nr--;
     return 0;
 }
@@ -2551,6 +2919,61 @@ xml_search_child_insert(cxobj *xp,
     return retval;
 }
 
+/*! Insert several list elements into the search index vectors of their parent
+ *
+ * The elements are appended to the vectors, which are then sorted once, instead
+ * of inserting them one by one with xml_search_child_insert.
+ * @param[in] xpp   XML parent of list elements
+ * @param[in] xvec  List elements, children of xpp
+ * @param[in] xlen  Length of xvec
+ * @retval    0     OK
+ * @retval   -1     Error
+ * @see xml_insert_vec
+ */
+int
+xml_search_child_insert_vec(cxobj  *xpp,
+			    cxobj **xvec,
+			    int     xlen)
+{
+    int                  retval = -1;
+    struct search_index *si;
+    cxobj               *xi;
+    int                  i;
+    int                  len;
+
+    if ((si = xpp->x_search_index) != NULL) {
+	do {
+	    si->si_sorted = clixon_xvec_len(si->si_xvec);
+	    si = NEXTQ(struct search_index *, si);
+	} while (si && si != xpp->x_search_index);
+    }
+    for (i=0; i<xlen; i++){
+	xi = NULL;
+	while ((xi = xml_child_each(xvec[i], xi, CX_ELMNT)) != NULL){
+	    if (!xml_search_index_p(xi))
+		continue;
+	    if ((si = xml_search_index_get(xpp, xml_name(xi))) == NULL &&
+		(si = xml_search_index_add(xpp, xml_name(xi))) == NULL)
+		goto done;
+	    if (clixon_xvec_append(si->si_xvec, xvec[i]) < 0)
+		goto done;
+	}
+    }
+    /* Sort appended elements and merge them with the sorted elements */
+    if ((si = xpp->x_search_index) != NULL) {
+	do {
+	    len = clixon_xvec_len(si->si_xvec);
+	    if (xml_vec_merge(clixon_xvec_vec(si->si_xvec), si->si_sorted,
+			      len - si->si_sorted, 0, si->si_name) < 0)
+		goto done;
+	    si = NEXTQ(struct search_index *, si);
+	} while (si && si != xpp->x_search_index);
+    }
+    retval = 0;
+ done:    
+    return retval;
+}
+
 /*! Remove a single cxobj from search vector 
  * @param[in] xp  XML parent object (the list element)
  * @param[in] xi  XML index object (that should be added)
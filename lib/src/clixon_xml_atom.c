@@ -0,0 +1,245 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Interned XML name and prefix strings
+  * All XML nodes with the same name share one copy of the name string, an "atom".
+  * Equal names therefore have equal pointers, and a name can be compared with an atom
+  * by pointer comparison.
+  * An atom is reference counted by the nodes using it, and removed from the table
+  * when the last reference is released.
+  * The table is global and not protected by locks.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_err.h"
+#include "clixon_hash.h"
+#include "clixon_xml_atom.h"
+
+#define ATOM_SIZE_START 256 /* Initial number of slots. Must be a power of 2 */
+
+/* Table is grown when number of atoms exceeds 3/4 of the slots */
+#define atom_full(n, size) ((n)+1 > ((size)/4)*3)
+
+/*
+ * Types
+ */
+struct xml_atom{
+    uint64_t at_hash;  /* Hash of string */
+    uint32_t at_refs;  /* Number of references, removed when zero */
+    char     at_str[]; /* Interned string */
+};
+
+/* Get atom struct from interned string */
+#define atom_of(s) ((struct xml_atom *)((s) - offsetof(struct xml_atom, at_str)))
+
+/*
+ * Variables
+ */
+static struct xml_atom **_atoms = NULL;  /* Open addressing table of _atoms_size slots */
+static size_t            _atoms_size = 0;
+static size_t            _atoms_nr = 0;
+static size_t            _atoms_bytes = 0; /* Sum of allocated atom sizes */
+
+/*! Find slot of string, or empty slot where string should be inserted
+ * @param[in]  str   String
+ * @param[in]  hv    Hash value of string
+ * @retval     i     Slot index, slot is NULL if not found
+ */
+static size_t
+atom_slot_find(const char *str,
+	       uint64_t    hv)
+{
+    size_t           mask = _atoms_size - 1;
+    size_t           i;
+    struct xml_atom *at;
+
+    for (i = hv & mask; ; i = (i+1) & mask){
+	if ((at = _atoms[i]) == NULL)
+	    break;
+	if (at->at_hash == hv && strcmp(at->at_str, str) == 0)
+	    break;
+    }
+    return i;
+}
+
+/*! Double the number of slots (or create initial table) and re-insert all atoms
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+atom_grow(void)
+{
+    struct xml_atom **atoms;
+    size_t            size;
+    size_t            i;
+    size_t            j;
+
+    size = _atoms_size ? 2*_atoms_size : ATOM_SIZE_START;
+    if ((atoms = calloc(size, sizeof(struct xml_atom *))) == NULL){
+	clicon_err(OE_XML, errno, "calloc");
+	return -1;
+    }
+    for (i = 0; i < _atoms_size; i++){
+	if (_atoms[i] == NULL)
+	    continue;
+	for (j = _atoms[i]->at_hash & (size-1);
+	     atoms[j] != NULL;
+	     j = (j+1) & (size-1))
+	    ;
+	atoms[j] = _atoms[i];
+    }
+    if (_atoms)
+	free(_atoms);
+    _atoms = atoms;
+    _atoms_size = size;
+    return 0;
+}
+
+/*! Get interned copy of a string and increment its reference count
+ * @param[in]  str   String
+ * @retval     atom  Interned string, release with xml_atom_put
+ * @retval     NULL  Error
+ * @note The interned string must not be modified
+ */
+char *
+xml_atom_get(const char *str)
+{
+    uint64_t         hv;
+    size_t           i;
+    size_t           len;
+    struct xml_atom *at;
+
+    if (_atoms == NULL || atom_full(_atoms_nr, _atoms_size))
+	if (atom_grow() < 0)
+	    return NULL;
+    hv = clicon_hash_string(str);
+    i = atom_slot_find(str, hv);
+    if ((at = _atoms[i]) == NULL){
+	len = strlen(str) + 1;
+	if ((at = malloc(sizeof(*at) + len)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	at->at_hash = hv;
+	at->at_refs = 0;
+	memcpy(at->at_str, str, len);
+	_atoms[i] = at;
+	_atoms_nr++;
+	_atoms_bytes += sizeof(*at) + len;
+    }
+    at->at_refs++;
+    return at->at_str;
+}
+
+/*! Release a reference to an interned string, remove it if no references remain
+ * @param[in]  atom  Interned string returned by xml_atom_get
+ * @retval     0     OK
+ */
+int
+xml_atom_put(char *atom)
+{
+    struct xml_atom *at = atom_of(atom);
+    size_t           mask;
+    size_t           i;
+    size_t           j;
+    size_t           k;
+
+    if (--at->at_refs > 0)
+	return 0;
+    /* Find slot by pointer and remove with backward shift, see clicon_hash_del */
+    mask = _atoms_size - 1;
+    for (i = at->at_hash & mask; _atoms[i] != at; i = (i+1) & mask)
+	;
+    j = i;
+    for (;;){
+	j = (j+1) & mask;
+	if (_atoms[j] == NULL)
+	    break;
+	k = _atoms[j]->at_hash & mask; /* Home slot of atom in j */
+	/* Atom stays if its home slot is cyclically in (i, j] */
+	if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+	    continue;
+	_atoms[i] = _atoms[j];
+	i = j;
+    }
+    _atoms[i] = NULL;
+    _atoms_nr--;
+    _atoms_bytes -= sizeof(*at) + strlen(at->at_str) + 1;
+    free(at);
+    return 0;
+}
+
+/*! Find interned string without incrementing its reference count
+ * @param[in]  str   String
+ * @retval     atom  Interned string, valid as long as an XML node uses it
+ * @retval     NULL  Not found, ie no XML node has this name or prefix
+ * Use to compare a string with many XML names by pointer comparison
+ */
+char *
+xml_atom_find(const char *str)
+{
+    size_t i;
+
+    if (_atoms == NULL)
+	return NULL;
+    i = atom_slot_find(str, clicon_hash_string(str));
+    return _atoms[i] ? _atoms[i]->at_str : NULL;
+}
+
+/*! Get statistics about interned strings
+ * @param[out]  nrp  Number of interned strings
+ * @param[out]  szp  Allocated bytes, including the table
+ */
+int
+xml_stats_atom(uint64_t *nrp,
+	       size_t   *szp)
+{
+    if (nrp)
+	*nrp = _atoms_nr;
+    if (szp)
+	*szp = _atoms_bytes + _atoms_size*sizeof(struct xml_atom *);
+    return 0;
+}
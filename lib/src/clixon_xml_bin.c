@@ -0,0 +1,790 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Compact binary encoding of XML trees
+ * Used as an alternative to XML text on the backend socket, see CLICON_SOCK_BINARY.
+ * A tree is written as a header followed by a pre-order sequence of records:
+ *   header:        magic "CXB" and version byte
+ *   element start: XB_START, name, prefix
+ *   attribute:     XB_ATTR, name, prefix, value string
+ *   body:          XB_BODY, value string
+ *   integer body:  XB_INT, zig-zag varint. Only for bodies in canonical decimal 
+ *                  form, so that the text is restored exactly
+ *   element end:   XB_END
+ * Integers and lengths are unsigned LEB128 varints, strings are a length followed 
+ * by the bytes, without null-termination.
+ * Names and prefixes are interned per tree: a name is a varint reference where 0 is
+ * NULL, 1..n is a name already seen and n+1 is a new name followed by the string.
+ * Element and attribute names are therefore sent once, and values need no escaping.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_io.h"
+#include "clixon_xml_bin.h"
+
+#define XB_MAGIC   "CXB"
+#define XB_VERSION 1
+#define XB_HDRLEN  4
+
+/* Record types */
+#define XB_START 0x01
+#define XB_ATTR  0x02
+#define XB_BODY  0x03
+#define XB_INT   0x04
+#define XB_END   0x05
+
+/* Initial size of name intern table, power of 2 */
+#define XB_NAMES_INIT 64
+
+/* Name of xml top object created by parse functions */
+#define XML_TOP_SYMBOL "top" 
+
+/* Encoder */
+struct xml_bin_enc{
+    cbuf               *be_cb;    /* Output buffer */
+    size_t              be_chunk; /* Call be_fn when buffer is larger than this */
+    clicon_xml2cbuf_fn *be_fn;    /* Consumes buffer, or NULL */
+    void               *be_arg;   /* Argument to be_fn */
+    char              **be_names; /* Interned names, reference is index+1 */
+    uint32_t            be_nr;    /* Number of interned names */
+    uint32_t           *be_slots; /* Open addressing hash of be_names, index+1 or 0 */
+    uint32_t            be_size;  /* Number of slots, power of 2 */
+    int                 be_depth; /* Open elements */
+};
+
+/* Decoder, bounds checked on each read */
+struct xml_bin_rd{
+    const uint8_t *br_p;
+    const uint8_t *br_end;
+    int            br_err;    /* Set on malformed input */
+    char         **br_names;  /* Names read, reference is index+1 */
+    uint32_t       br_nr;
+    uint32_t       br_len;    /* Allocated length of br_names */
+    char          *br_str;    /* Null-terminated copy of last string read */
+    size_t         br_strlen; /* Allocated length of br_str */
+};
+
+/*
+ * Encode
+ */
+static int
+xb_uint(cbuf    *cb,
+	uint64_t u)
+{
+    uint8_t buf[10];
+    int     i = 0;
+
+    while (u >= 0x80){
+	buf[i++] = (u & 0x7f) | 0x80;
+	u >>= 7;
+    }
+    buf[i++] = u;
+    return cbuf_append_buf(cb, buf, i);
+}
+
+static int
+xb_str(cbuf   *cb,
+       char   *str,
+       size_t  len)
+{
+    if (xb_uint(cb, len) < 0)
+	return -1;
+    return cbuf_append_buf(cb, str, len);
+}
+
+/*! Check if string is an integer in canonical decimal form, ie it is restored by printing it
+ * @param[in]  str  String
+ * @param[out] val  Integer value
+ * @retval     1    Canonical integer
+ * @retval     0    Not canonical integer
+ */
+static int
+xb_canonical_int(const char *str,
+		 int64_t    *val)
+{
+    const char *s = str;
+    uint64_t    u = 0;
+    int         neg = 0;
+    int         n;
+
+    if (*s == '-'){
+	neg = 1;
+	s++;
+    }
+    if (*s == '0' && s[1] == '\0' && !neg){
+	*val = 0;
+	return 1;
+    }
+    if (*s < '1' || *s > '9')
+	return 0;
+    for (n=0; *s; s++, n++){ /* At most 18 digits, no overflow */
+	if (*s < '0' || *s > '9' || n == 18)
+	    return 0;
+	u = u*10 + (*s - '0');
+    }
+    *val = neg ? -(int64_t)u : (int64_t)u;
+    return 1;
+}
+
+/*! Grow name intern table of encoder and rehash
+ */
+static int
+xb_names_grow(xml_bin_enc *be)
+{
+    uint32_t *slots;
+    char    **names;
+    uint32_t  size = be->be_size ? be->be_size*2 : XB_NAMES_INIT;
+    uint32_t  i;
+    uint32_t  j;
+
+    if ((names = realloc(be->be_names, (size/2)*sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	return -1;
+    }
+    be->be_names = names;
+    if ((slots = calloc(size, sizeof(uint32_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    for (i=0; i<be->be_nr; i++){
+	j = clicon_hash_string(be->be_names[i]) & (size-1);
+	while (slots[j])
+	    j = (j+1) & (size-1);
+	slots[j] = i+1;
+    }
+    if (be->be_slots)
+	free(be->be_slots);
+    be->be_slots = slots;
+    be->be_size = size;
+    return 0;
+}
+
+/*! Write a name reference, and the name itself if it is new
+ * @param[in]  be    Encoder
+ * @param[in]  name  Name or prefix, or NULL
+ */
+static int
+xb_name(xml_bin_enc *be,
+	char        *name)
+{
+    uint32_t j;
+    uint32_t r;
+    
+    if (name == NULL)
+	return xb_uint(be->be_cb, 0);
+    if (be->be_size) {
+	j = clicon_hash_string(name) & (be->be_size-1);
+	while ((r = be->be_slots[j]) != 0){
+	    if (strcmp(be->be_names[r-1], name) == 0)
+		return xb_uint(be->be_cb, r);
+	    j = (j+1) & (be->be_size-1);
+	}
+    }
+    /* New name, at most half of the slots are used */
+    if (2*(be->be_nr+1) > be->be_size){
+	if (xb_names_grow(be) < 0)
+	    return -1;
+	j = clicon_hash_string(name) & (be->be_size-1);
+	while (be->be_slots[j])
+	    j = (j+1) & (be->be_size-1);
+    }
+    if ((be->be_names[be->be_nr] = strdup(name)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    be->be_slots[j] = ++be->be_nr;
+    if (xb_uint(be->be_cb, be->be_nr) < 0)
+	return -1;
+    return xb_str(be->be_cb, name, strlen(name));
+}
+
+/*! Create binary XML encoder and write header
+ *
+ * Records are written to cb. If fn is given, it is called when the buffer has grown
+ * to chunk bytes after an element. fn should consume the buffer, eg send it, and 
+ * reset it, as in clicon_xml2cbuf_stream.
+ * @param[in]  cb     Buffer to write to
+ * @param[in]  chunk  Call fn when buffer is larger than this
+ * @param[in]  fn     Function consuming buffer, or NULL
+ * @param[in]  arg    Argument to fn
+ * @retval     be     Encoder, free with clixon_xml_bin_free
+ * @retval     NULL   Error
+ * @code
+ *   xml_bin_enc *be;
+ *   if ((be = clixon_xml_bin_new(cb, 0, NULL, NULL)) == NULL)
+ *      err;
+ *   if (clixon_xml_bin_start(be, NULL, "rpc-reply") < 0 ||
+ *       clixon_xml_bin_tree(be, x, -1) < 0 ||
+ *       clixon_xml_bin_end(be) < 0)
+ *      err;
+ *   clixon_xml_bin_free(be);
+ * @endcode
+ */
+xml_bin_enc *
+clixon_xml_bin_new(cbuf               *cb,
+		   size_t              chunk,
+		   clicon_xml2cbuf_fn *fn,
+		   void               *arg)
+{
+    xml_bin_enc *be;
+    char         hdr[XB_HDRLEN] = XB_MAGIC;
+
+    if ((be = malloc(sizeof(*be))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(be, 0, sizeof(*be));
+    be->be_cb = cb;
+    be->be_chunk = chunk;
+    be->be_fn = fn;
+    be->be_arg = arg;
+    hdr[XB_HDRLEN-1] = XB_VERSION;
+    if (cbuf_append_buf(cb, hdr, XB_HDRLEN) < 0){
+	clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	free(be);
+	return NULL;
+    }
+    return be;
+}
+
+/*! Free binary XML encoder
+ * @param[in]  be   Encoder
+ */
+int
+clixon_xml_bin_free(xml_bin_enc *be)
+{
+    uint32_t i;
+
+    for (i=0; i<be->be_nr; i++)
+	free(be->be_names[i]);
+    if (be->be_names)
+	free(be->be_names);
+    if (be->be_slots)
+	free(be->be_slots);
+    free(be);
+    return 0;
+}
+
+/*! Write start of element
+ * @param[in]  be      Encoder
+ * @param[in]  prefix  Namespace prefix, or NULL
+ * @param[in]  name    Element name
+ */
+int
+clixon_xml_bin_start(xml_bin_enc *be,
+		     char        *prefix,
+		     char        *name)
+{
+    uint8_t t = XB_START;
+
+    if (cbuf_append_buf(be->be_cb, &t, 1) < 0 ||
+	xb_name(be, name) < 0 ||
+	xb_name(be, prefix) < 0)
+	return -1;
+    be->be_depth++;
+    return 0;
+}
+
+/*! Write attribute of current element, must precede bodies and sub-elements
+ * @param[in]  be      Encoder
+ * @param[in]  prefix  Namespace prefix, or NULL
+ * @param[in]  name    Attribute name
+ * @param[in]  value   Attribute value
+ */
+int
+clixon_xml_bin_attr(xml_bin_enc *be,
+		    char        *prefix,
+		    char        *name,
+		    char        *value)
+{
+    uint8_t t = XB_ATTR;
+
+    if (cbuf_append_buf(be->be_cb, &t, 1) < 0 ||
+	xb_name(be, name) < 0 ||
+	xb_name(be, prefix) < 0 ||
+	xb_str(be->be_cb, value, strlen(value)) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Write body of current element
+ * @param[in]  be      Encoder
+ * @param[in]  value   Body value (not escaped)
+ */
+int
+clixon_xml_bin_body(xml_bin_enc *be,
+		    char        *value)
+{
+    uint8_t t;
+    int64_t i;
+
+    if (xb_canonical_int(value, &i)){
+	t = XB_INT;
+	if (cbuf_append_buf(be->be_cb, &t, 1) < 0 ||
+	    xb_uint(be->be_cb, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63)) < 0)
+	    return -1;
+    }
+    else{
+	t = XB_BODY;
+	if (cbuf_append_buf(be->be_cb, &t, 1) < 0 ||
+	    xb_str(be->be_cb, value, strlen(value)) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Write end of current element
+ * If the buffer has grown to the chunk size, it is passed to the consuming function.
+ * @param[in]  be      Encoder
+ */
+int
+clixon_xml_bin_end(xml_bin_enc *be)
+{
+    uint8_t t = XB_END;
+
+    if (be->be_depth == 0){
+	clicon_err(OE_XML, EINVAL, "No element to end");
+	return -1;
+    }
+    be->be_depth--;
+    if (cbuf_append_buf(be->be_cb, &t, 1) < 0)
+	return -1;
+    if (be->be_fn && cbuf_len(be->be_cb) >= be->be_chunk &&
+	be->be_fn(be->be_cb, be->be_arg) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Write an XML tree
+ * @param[in]  be     Encoder
+ * @param[in]  x      XML tree
+ * @param[in]  depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @see clicon_xml2cbuf
+ */
+int
+clixon_xml_bin_tree(xml_bin_enc *be,
+		    cxobj       *x,
+		    int32_t      depth)
+{
+    cxobj *xc;
+    char  *val;
+
+    if (depth == 0)
+	return 0;
+    switch (xml_type(x)){
+    case CX_BODY:
+	if ((val = xml_value(x)) != NULL) /* incomplete tree */
+	    return clixon_xml_bin_body(be, val);
+	break;
+    case CX_ATTR:
+	return clixon_xml_bin_attr(be, xml_prefix(x), xml_name(x), xml_value(x));
+    case CX_ELMNT:
+	if (clixon_xml_bin_start(be, xml_prefix(x), xml_name(x)) < 0)
+	    return -1;
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ATTR)) != NULL)
+	    if (clixon_xml_bin_tree(be, xc, -1) < 0)
+		return -1;
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, -1)) != NULL)
+	    if (xml_type(xc) != CX_ATTR &&
+		clixon_xml_bin_tree(be, xc, depth-1) < 0)
+		return -1;
+	return clixon_xml_bin_end(be);
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Encode an XML tree to a buffer, with header
+ * @param[in,out] cb     Buffer to write to
+ * @param[in]     x      XML tree
+ * @param[in]     depth  Limit levels of child resources: -1 is all
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see clixon_xml_parse_bin
+ */
+int
+clixon_xml2bin(cbuf   *cb,
+	       cxobj  *x,
+	       int32_t depth)
+{
+    int          retval = -1;
+    xml_bin_enc *be;
+
+    if ((be = clixon_xml_bin_new(cb, 0, NULL, NULL)) == NULL)
+	goto done;
+    if (clixon_xml_bin_tree(be, x, depth) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (be)
+	clixon_xml_bin_free(be);
+    return retval;
+}
+
+/*
+ * Decode
+ */
+static uint64_t
+xbr_uint(struct xml_bin_rd *br)
+{
+    uint64_t u = 0;
+    int      shift;
+    uint8_t  b;
+
+    for (shift=0; shift<64; shift+=7){
+	if (br->br_p >= br->br_end)
+	    break;
+	b = *br->br_p++;
+	u |= (uint64_t)(b & 0x7f) << shift;
+	if ((b & 0x80) == 0)
+	    return u;
+    }
+    br->br_err++;
+    return 0;
+}
+
+/*! Ensure the string buffer of the decoder holds len bytes and a null
+ */
+static int
+xbr_strbuf(struct xml_bin_rd *br,
+	   size_t             len)
+{
+    char  *str;
+    size_t sz;
+
+    if (len < br->br_strlen)
+	return 0;
+    sz = br->br_strlen ? br->br_strlen : 64;
+    while (sz <= len)
+	sz *= 2;
+    if ((str = realloc(br->br_str, sz)) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	return -1;
+    }
+    br->br_str = str;
+    br->br_strlen = sz;
+    return 0;
+}
+
+/*! Read a string to the string buffer of the decoder
+ * @retval  0  OK, string in br_str (or malformed, br_err set)
+ * @retval -1  Error
+ */
+static int
+xbr_str(struct xml_bin_rd *br)
+{
+    uint64_t len;
+
+    len = xbr_uint(br);
+    if (br->br_err || (uint64_t)(br->br_end - br->br_p) < len){
+	br->br_err++;
+	return 0;
+    }
+    if (xbr_strbuf(br, len) < 0)
+	return -1;
+    memcpy(br->br_str, br->br_p, len);
+    br->br_str[len] = '\0';
+    br->br_p += len;
+    return 0;
+}
+
+/*! Read a name reference, and add the name if it is new
+ * @param[out] name  Name (owned by decoder), or NULL
+ * @retval     0     OK (or malformed, br_err set)
+ * @retval    -1     Error
+ */
+static int
+xbr_name(struct xml_bin_rd *br,
+	 char             **name)
+{
+    uint64_t r;
+    char   **names;
+
+    *name = NULL;
+    r = xbr_uint(br);
+    if (br->br_err || r == 0)
+	return 0;
+    if (r <= br->br_nr){
+	*name = br->br_names[r-1];
+	return 0;
+    }
+    if (r != br->br_nr+1){
+	br->br_err++;
+	return 0;
+    }
+    if (xbr_str(br) < 0)
+	return -1;
+    if (br->br_err)
+	return 0;
+    if (br->br_nr == br->br_len){
+	br->br_len = br->br_len ? br->br_len*2 : XB_NAMES_INIT;
+	if ((names = realloc(br->br_names, br->br_len*sizeof(char*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	br->br_names = names;
+    }
+    if ((*name = strdup(br->br_str)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    br->br_names[br->br_nr++] = *name;
+    return 0;
+}
+
+/*! Print integer body in decimal to the string buffer of the decoder
+ */
+static int
+xbr_int(struct xml_bin_rd *br)
+{
+    uint64_t u;
+    int64_t  i;
+    char     buf[24];
+    char    *s = &buf[sizeof(buf)];
+    
+    u = xbr_uint(br);
+    i = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    u = i < 0 ? -(uint64_t)i : (uint64_t)i;
+    do {
+	*--s = '0' + u%10;
+	u /= 10;
+    } while (u);
+    if (i < 0)
+	*--s = '-';
+    if (xbr_strbuf(br, &buf[sizeof(buf)] - s) < 0)
+	return -1;
+    memcpy(br->br_str, s, &buf[sizeof(buf)] - s);
+    br->br_str[&buf[sizeof(buf)] - s] = '\0';
+    return 0;
+}
+
+/*! Decode records into XML tree
+ * @param[in]  br    Decoder
+ * @param[in]  xt    Top of tree
+ * @retval     1     OK
+ * @retval     0     Malformed input
+ * @retval    -1     Error
+ */
+static int
+xbr_tree(struct xml_bin_rd *br,
+	 cxobj             *xt)
+{
+    cxobj *xp = xt;
+    cxobj *x;
+    char  *name;
+    char  *prefix;
+    int    depth = 0;
+    uint8_t t;
+
+    while (br->br_p < br->br_end && !br->br_err){
+	t = *br->br_p++;
+	switch (t){
+	case XB_START:
+	case XB_ATTR:
+	    if (xbr_name(br, &name) < 0 ||
+		xbr_name(br, &prefix) < 0)
+		return -1;
+	    if (br->br_err || name == NULL)
+		return 0;
+	    if (t == XB_ATTR){
+		if (xbr_str(br) < 0)
+		    return -1;
+		if (br->br_err || xp == xt)
+		    return 0;
+	    }
+	    if ((x = xml_new(name, xp, t==XB_START?CX_ELMNT:CX_ATTR)) == NULL)
+		return -1;
+	    if (prefix && xml_prefix_set(x, prefix) < 0)
+		return -1;
+	    if (t == XB_START){
+		xp = x;
+		depth++;
+	    }
+	    else if (xml_value_set(x, br->br_str) < 0)
+		return -1;
+	    break;
+	case XB_BODY:
+	case XB_INT:
+	    if ((t == XB_BODY ? xbr_str(br) : xbr_int(br)) < 0)
+		return -1;
+	    if (br->br_err || xp == xt)
+		return 0;
+	    if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+		return -1;
+	    if (xml_value_set(x, br->br_str) < 0)
+		return -1;
+	    break;
+	case XB_END:
+	    if (depth-- == 0)
+		return 0;
+	    xp = xml_parent(xp);
+	    break;
+	default:
+	    return 0;
+	}
+    }
+    if (br->br_err || depth != 0)
+	return 0;
+    return 1;
+}
+
+/*! Parse binary encoded XML into an XML tree
+ *
+ * As clixon_xml_parse_string but for a tree encoded by clixon_xml2bin or 
+ * clixon_xml_bin_tree.
+ * @param[in]     buf    Encoded tree, including header
+ * @param[in]     len    Length of buf
+ * @param[in]     yb     How to bind yang to XML top-level when parsing
+ * @param[in]     yspec  Yang specification, or NULL
+ * @param[in,out] xt     Pointer to XML parse tree. If empty, create.
+ * @param[out]    xerr   Reason for failure (yang assignment not made)
+ * @retval        1      Parse OK and all yang assignment made
+ * @retval        0      Parse OK but yang assigment not made (or only partial)
+ * @retval       -1      Error with clicon_err called. Includes malformed input
+ * @see clixon_xml_parse_string
+ */
+int
+clixon_xml_parse_bin(const char *buf,
+		     size_t      len,
+		     yang_bind   yb,
+		     yang_stmt  *yspec,
+		     cxobj     **xt,
+		     cxobj     **xerr)
+{
+    int               retval = -1;
+    struct xml_bin_rd br = {0,};
+    char              hdr[XB_HDRLEN] = XB_MAGIC;
+    cxobj            *x;
+    int               i0;
+    int               i;
+    int               ret;
+    int               failed = 0;
+
+    if (xt == NULL){
+	clicon_err(OE_XML, EINVAL, "xt is NULL");
+	return -1;
+    }
+    if (yb == YB_MODULE && yspec == NULL){
+	clicon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
+	return -1;
+    }
+    hdr[XB_HDRLEN-1] = XB_VERSION;
+    if (len < XB_HDRLEN || memcmp(buf, hdr, XB_HDRLEN) != 0){
+	clicon_err(OE_XML, XMLPARSE_ERRNO, "Binary XML: bad header");
+	return -1;
+    }
+    if (*xt == NULL){
+	if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	    return -1;
+    }
+    i0 = xml_child_nr(*xt);
+    br.br_p = (const uint8_t *)buf + XB_HDRLEN;
+    br.br_end = (const uint8_t *)buf + len;
+    if ((ret = xbr_tree(&br, *xt)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_XML, XMLPARSE_ERRNO, "Binary XML: malformed at offset %ld",
+		   (long)((const char*)br.br_p - buf));
+	goto done;
+    }
+    /* Traverse new objects, see _xml_parse */
+    for (i = i0; i < xml_child_nr(*xt); i++) {
+	x = xml_child_i(*xt, i);
+	if (xml_type(x) != CX_ELMNT)
+	    continue;
+	if (xml2ns_recurse(x) < 0)
+	    goto done;
+	switch (yb){
+	case YB_NONE:
+	    ret = 1;
+	    break;
+	case YB_PARENT:
+	case YB_MODULE:
+	    if ((ret = xml_bind_yang0(x, yb, yspec, xerr)) < 0)
+		goto done;
+	    break;
+	case YB_RPC:
+	    if ((ret = xml_bind_yang_rpc(x, yspec, xerr)) < 0)
+		goto done;
+	    break;
+	}
+	if (ret == 0)
+	    failed++;
+    }
+    if (failed)
+	goto fail;
+    if (yb != YB_NONE)
+	if (xml_sort_recurse(*xt) < 0)
+	    goto done;
+    retval = 1;
+ done:
+    if (br.br_names){
+	for (i=0; i<(int)br.br_nr; i++)
+	    free(br.br_names[i]);
+	free(br.br_names);
+    }
+    if (br.br_str)
+	free(br.br_str);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
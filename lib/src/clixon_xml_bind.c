@@ -117,13 +117,15 @@ strip_whitespace(cxobj *xt)
 
 /*! Associate XML node x with x:s parents yang:s matching child
  *
- * @param[in]   xt     XML tree node
- * @param[out]  xerr   Reason for failure, or NULL
+ * @param[in]   xt       XML tree node
+ * @param[in]   xsibling If set, previous XML node with same name, use its yang spec
+ * @param[out]  xerr     Reason for failure, or NULL
  * @retval      1      OK Yang assignment made
  * @retval      2      OK Yang assignment not made because yang parent is anyxml or anydata
  * @retval      0      Yang assigment not made and xerr set
  * @retval     -1      Error
  * @note retval = 2 is special
+ * @note Search index is not updated since xt body may not be known, see xml_bind_yang_end
  * @see populate_self_top
  */
 static int
@@ -207,10 +209,6 @@ populate_self_parent(cxobj  *xt,
     }
  set:
     xml_spec_set(xt, y);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xt))
-	xml_search_child_insert(xp, xt);
-#endif
     retval = 1;
  done:
     if (cb)
@@ -407,6 +405,10 @@ xml_bind_yang0_opt(cxobj     *xt,
 	goto fail;
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
     	goto ok;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_p(xt))
+	xml_search_child_insert(xml_parent(xt), xt);
+#endif
     strip_whitespace(xt);
     xc = NULL;     /* Apply on children */
     while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
@@ -489,6 +491,10 @@ xml_bind_yang0(cxobj     *xt,
 	goto fail;
     else if (ret == 2)     /* ret=2 for anyxml from parent^ */
     	goto ok;
+#ifdef XML_EXPLICIT_INDEX
+    if (yb == YB_PARENT && xml_search_index_p(xt))
+	xml_search_child_insert(xml_parent(xt), xt);
+#endif
     strip_whitespace(xt);
     xc = NULL;     /* Apply on children */
     while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
@@ -508,6 +514,72 @@ xml_bind_yang0(cxobj     *xt,
     goto done;
 }
 
+/*! Find yang spec association of a single XML node, not its children, while parsing
+ *
+ * Called by the XML parser when the start-tag of xt is complete, ie its attributes
+ * (and namespaces) are known but not its children. The parent of xt is already bound.
+ * @param[in]   xt       XML tree node
+ * @param[in]   yb       How to bind yang to xt: YB_MODULE or YB_PARENT
+ * @param[in]   yspec    Yang spec (if YB_MODULE)
+ * @param[in]   xsibling If set, XML node with same name as xt, eg previous sibling: use its spec
+ * @param[out]  xerr     Reason for failure, or NULL
+ * @retval      1        OK yang assignment made, or made not since parent is anyxml or anydata
+ * @retval      0        Yang assigment not made and xerr set
+ * @retval     -1        Error
+ * @see xml_bind_yang_end  Called when the end-tag of xt is parsed
+ * @see xml_bind_yang0     For binding a complete tree
+ */
+int
+xml_bind_yang_node(cxobj     *xt, 
+		   yang_bind  yb,
+		   yang_stmt *yspec,
+		   cxobj     *xsibling,
+		   cxobj    **xerr)
+{
+    int retval = -1;
+    int ret;
+
+    switch (yb){
+    case YB_MODULE:
+	if ((ret = populate_self_top(xt, yspec, xerr)) < 0) 
+	    goto done;
+	break;
+    case YB_PARENT:
+	if ((ret = populate_self_parent(xt, xsibling, xerr)) < 0)
+	    goto done;
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
+	goto done;
+	break;
+    }
+    retval = ret?1:0;
+ done:
+    return retval;
+}
+
+/*! Complete yang binding of a single XML node when its children are parsed
+ *
+ * Strip whitespace of non-leafs and update search index of the grand-parent
+ * @param[in]   xt       XML tree node
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see xml_bind_yang_node Called when the start-tag of xt is parsed
+ */
+int
+xml_bind_yang_end(cxobj *xt)
+{
+    if (xml_spec(xt) == NULL)
+	return 0;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_p(xt) &&
+	xml_search_child_insert(xml_parent(xt), xt) < 0)
+	return -1;
+#endif
+    strip_whitespace(xt);
+    return 0;
+}
+
 /*! Find yang spec association of XML node for incoming RPC starting with <rpc>
  * 
  * Incoming RPC has an "input" structure that is not taken care of by xml_bind_yang
@@ -52,6 +52,7 @@
 #include <errno.h>
 #include <string.h>
 #include <limits.h>
+#include <dirent.h>
 #include <assert.h>
 
 /* cligen */
@@ -73,6 +74,7 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_parse.h"
+#include "clixon_file.h"
 #include "clixon_xml_io.h"
 
 /*
@@ -82,6 +84,8 @@
 #define BUFLEN 1024  
 /* Indentation for xml pretty-print. Consider option? */
 #define XML_INDENT 3
+/* Serialized XML is written to file when output buffer is larger than this */
+#define XML_OUT_CHUNK 65536
 /* Name of xml top object created by xml parse functions */
 #define XML_TOP_SYMBOL "top" 
 
@@ -97,9 +101,7 @@
  * @param[in]   level       how many spaces to insert before each line
  * @param[in]   prettyprint insert \n and spaces tomake the xml more readable.
  * @param[in]   fn          Callback to make print function
- * @see clicon_xml2cbuf
- * One can use clicon_xml2cbuf to get common code, but using fprintf is
- * much faster than using cbuf and then printing that,...
+ * @see clicon_xml2file which serializes into a buffer and writes it in large blocks
  */
 int
 xml2file_recurse(FILE             *f, 
@@ -125,6 +127,10 @@ xml2file_recurse(FILE             *f,
     case CX_BODY:
 	if ((val = xml_value(x)) == NULL) /* incomplete tree */
 	    break;
+	if (strpbrk(val, "&<>") == NULL){ /* Nothing to encode, no copy */
+	    (*fn)(f, "%s", val);
+	    break;
+	}
 	if (xml_chardata_encode(&encstr, "%s", val) < 0)
 	    goto done;
 	(*fn)(f, "%s", encstr);
@@ -196,6 +202,152 @@ xml2file_recurse(FILE             *f,
     return retval;
 }
 
+/*! Append a qualified name, ie prefix:name or name, to a cligen buffer
+ */
+static inline void
+xml2cbuf_name(cbuf *cb,
+	      char *prefix,
+	      char *name)
+{
+    if (prefix){
+	cbuf_append_str(cb, prefix);
+	cbuf_append(cb, ':');
+    }
+    cbuf_append_str(cb, name);
+}
+
+/*! Print an XML tree structure to a cligen buffer, pass it on when it grows large
+ * @see clicon_xml2cbuf
+ * @see clicon_xml2cbuf_stream
+ */
+static int
+xml2cbuf_recurse(cbuf               *cb, 
+		 cxobj              *x, 
+		 int                 level,
+		 int                 prettyprint,
+		 int32_t             depth,
+		 size_t              chunk,
+		 clicon_xml2cbuf_fn *fn,
+		 void               *arg)
+{
+    int    retval = -1;
+    cxobj *xc;
+    char  *name;
+    int    hasbody;
+    int    haselement;
+    char  *namespace;
+    char  *val;
+    
+    if (depth == 0 || x == NULL)
+	goto ok;
+    name = xml_name(x);
+    namespace = xml_prefix(x);
+    switch(xml_type(x)){
+    case CX_BODY:
+	if ((val = xml_value(x)) == NULL) /* incomplete tree */
+	    break;
+	if (xml_chardata_cbuf_append(cb, val) < 0)
+	    goto done;
+	break;
+    case CX_ATTR:
+	cbuf_append(cb, ' ');
+	xml2cbuf_name(cb, namespace, name);
+	cbuf_append_str(cb, "=\"");
+	if ((val = xml_value(x)) != NULL)
+	    cbuf_append_str(cb, val);
+	cbuf_append(cb, '"');
+	break;
+    case CX_ELMNT:
+	if (prettyprint)
+	    clixon_cbuf_indent(cb, level*XML_INDENT);
+	cbuf_append(cb, '<');
+	xml2cbuf_name(cb, namespace, name);
+	hasbody = 0;
+	haselement = 0;
+	xc = NULL;
+	/* print attributes only */
+	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
+	    switch (xml_type(xc)){
+	    case CX_ATTR:
+		if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, -1, 0, NULL, NULL) < 0)
+		    goto done;
+		break;
+	    case CX_BODY:
+		hasbody=1;
+		break;
+	    case CX_ELMNT:
+		haselement=1;
+		break;
+	    default:
+		break;
+	    }
+	/* Check for special case <a/> instead of <a></a> */
+	if (hasbody==0 && haselement==0) 
+	    cbuf_append_str(cb, "/>");
+	else{
+	    cbuf_append(cb, '>');
+	    if (prettyprint && hasbody == 0)
+		cbuf_append(cb, '\n');
+	    xc = NULL;
+	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
+		if (xml_type(xc) != CX_ATTR){
+		    if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, depth-1, chunk, fn, arg) < 0)
+			goto done;
+		    if (fn && cbuf_len(cb) >= chunk && fn(cb, arg) < 0)
+			goto done;
+		}
+	    if (prettyprint && hasbody == 0)
+		clixon_cbuf_indent(cb, level*XML_INDENT);
+	    cbuf_append_str(cb, "</");
+	    xml2cbuf_name(cb, namespace, name);
+	    cbuf_append(cb, '>');
+	}
+	if (prettyprint)
+	    cbuf_append(cb, '\n');
+	break;
+    default:
+	break;
+    }/* switch */
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write a part of a serialized XML tree to an output stream, see clicon_xml2cbuf_stream
+ * @param[in]  cb   Buffer with serialized XML, reset when written
+ * @param[in]  arg  Output stream (FILE*)
+ */
+static int
+xml2file_part(cbuf *cb,
+	      void *arg)
+{
+    FILE *f = (FILE *)arg;
+
+    if (cbuf_len(cb) && fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb)){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	return -1;
+    }
+    cbuf_reset(cb);
+    return 0;
+}
+
+/*! Write a part of a serialized XML tree to a file descriptor, see clicon_xml2cbuf_stream
+ * @param[in]  cb   Buffer with serialized XML, reset when written
+ * @param[in]  arg  Pointer to file descriptor (int*)
+ */
+static int
+xml2fd_part(cbuf *cb,
+	    void *arg)
+{
+    int fd = *(int *)arg;
+
+    if (clicon_file_write(fd, cbuf_get(cb), cbuf_len(cb)) < 0)
+	return -1;
+    cbuf_reset(cb);
+    return 0;
+}
+
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
  *
  * @param[in]   f           UNIX output stream
@@ -211,7 +363,57 @@ clicon_xml2file(FILE  *f,
 		int    level, 
 		int    prettyprint)
 {
-    return xml2file_recurse(f, x, level, prettyprint, fprintf);
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (xml2cbuf_recurse(cb, x, level, prettyprint, -1, XML_OUT_CHUNK, xml2file_part, f) < 0)
+	goto done;
+    if (xml2file_part(cb, f) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Print an XML tree structure to a file descriptor and encode chars "<>&"
+ *
+ * The tree is serialized into a buffer which is written in large blocks
+ * @param[in]   fd          File descriptor
+ * @param[in]   xn          clicon xml tree
+ * @param[in]   level       how many spaces to insert before each line
+ * @param[in]   prettyprint insert \n and spaces tomake the xml more readable.
+ * @retval      0           OK
+ * @retval     -1           Error
+ * @see clicon_xml2file print to an output stream
+ */
+int
+clicon_xml2fd(int    fd, 
+	      cxobj *x, 
+	      int    level, 
+	      int    prettyprint)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (xml2cbuf_recurse(cb, x, level, prettyprint, -1, XML_OUT_CHUNK, xml2fd_part, &fd) < 0)
+	goto done;
+    if (xml2fd_part(cb, &fd) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
 }
 
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
@@ -245,7 +447,7 @@ int
 xml_print(FILE  *f, 
 	  cxobj *x)
 {
-    return xml2file_recurse(f, x, 0, 1, fprintf);
+    return clicon_xml2file(f, x, 0, 1);
 }
 
 /*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
@@ -273,94 +475,36 @@ clicon_xml2cbuf(cbuf   *cb,
 		int     prettyprint,
 		int32_t depth)
 {
-    int    retval = -1;
-    cxobj *xc;
-    char  *name;
-    int    hasbody;
-    int    haselement;
-    char  *namespace;
-    char  *val;
-    
-    if (depth == 0)
-	goto ok;
-    name = xml_name(x);
-    namespace = xml_prefix(x);
-    switch(xml_type(x)){
-    case CX_BODY:
-	if ((val = xml_value(x)) == NULL) /* incomplete tree */
-	    break;
-	if (xml_chardata_cbuf_append(cb, val) < 0)
-	    goto done;
-	break;
-    case CX_ATTR:
-	cbuf_append_str(cb, " ");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cprintf(cb, "%s=\"%s\"", name, xml_value(x));
-	break;
-    case CX_ELMNT:
-	if (prettyprint)
-	    cprintf(cb, "%*s<", level*XML_INDENT, "");
-	else
-	    cbuf_append_str(cb, "<");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cbuf_append_str(cb, name);
-	hasbody = 0;
-	haselement = 0;
-	xc = NULL;
-	/* print attributes only */
-	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-	    switch (xml_type(xc)){
-	    case CX_ATTR:
-		if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, -1) < 0)
-		    goto done;
-		break;
-	    case CX_BODY:
-		hasbody=1;
-		break;
-	    case CX_ELMNT:
-		haselement=1;
-		break;
-	    default:
-		break;
-	    }
-	/* Check for special case <a/> instead of <a></a> */
-	if (hasbody==0 && haselement==0) 
-	    cbuf_append_str(cb, "/>");
-	else{
-	    cbuf_append_str(cb, ">");
-	    if (prettyprint && hasbody == 0)
-		cbuf_append_str(cb, "\n");
-	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-		if (xml_type(xc) != CX_ATTR)
-		    if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, depth-1) < 0)
-			goto done;
-	    if (prettyprint && hasbody == 0)
-		cprintf(cb, "%*s", level*XML_INDENT, "");
-	    cbuf_append_str(cb, "</");
-	    if (namespace){
-		cbuf_append_str(cb, namespace);
-		cbuf_append_str(cb, ":");
-	    }
-	    cbuf_append_str(cb, name);
-	    cbuf_append_str(cb, ">");
-	}
-	if (prettyprint)
-	    cbuf_append_str(cb, "\n");
-	break;
-    default:
-	break;
-    }/* switch */
- ok:
-    retval = 0;
- done:
-    return retval;
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, 0, NULL, NULL);
+}
+
+/*! Print an XML tree structure to a cligen buffer in parts
+ *
+ * As clicon_xml2cbuf, but when the buffer has grown to chunk bytes after an 
+ * element, fn is called. fn should consume the buffer, eg send it, and reset it.
+ * This bounds the memory used when serializing a large tree.
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     chunk       Call fn when buffer is larger than this
+ * @param[in]     fn          Function consuming buffer
+ * @param[in]     arg         Argument to fn
+ * @note The last part of the tree remains in cb when returning
+ * @see  clicon_xml2cbuf
+ */
+int
+clicon_xml2cbuf_stream(cbuf               *cb, 
+		       cxobj              *x, 
+		       int                 level,
+		       int                 prettyprint,
+		       int32_t             depth,
+		       size_t              chunk,
+		       clicon_xml2cbuf_fn *fn,
+		       void               *arg)
+{
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, chunk, fn, arg);
 }
 
 /*! Return an xml tree as a pretty-printed malloced string.
@@ -433,6 +577,8 @@ xmltree2cbuf(cbuf  *cb,
  *
  * Given a string containing XML, parse into existing XML tree and return
  * @param[in]     str   Pointer to string containing XML definition. 
+ * @param[in]     len   If > 0, parse str in place: length of str including two 
+ *                      terminating null bytes. If 0, str is copied by the scanner.
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
  * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
@@ -447,6 +593,7 @@ xmltree2cbuf(cbuf  *cb,
  */
 static int 
 _xml_parse(const char *str, 
+	   size_t      len,
 	   yang_bind   yb,
 	   yang_stmt  *yspec,
 	   cxobj      *xt,
@@ -460,19 +607,26 @@ _xml_parse(const char *str,
     int             i;
 
     clicon_debug(2, "%s", __FUNCTION__);
-    if (strlen(str) == 0)
+    if (*str == '\0')
 	return 0; /* OK */
     if (xt == NULL){
 	clicon_err(OE_XML, errno, "Unexpected NULL XML");
 	return -1;	
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-	clicon_err(OE_XML, errno, "strdup");
-	return -1;
-    }
+    xy.xy_parse_string = (char*)str;
+    xy.xy_parse_len = len;
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
+    /* Bind yang and sort in the parser as elements are parsed, instead of traversing
+     * the tree afterwards. Not for rpc:s or if there are existing (maybe unsorted) 
+     * elements. */
+    if ((yb == YB_MODULE || yb == YB_PARENT) &&
+	xml_child_nr_type(xt, CX_ELMNT) == 0){
+	xy.xy_bind = 1;
+	xy.xy_yb = yb;
+	xy.xy_xerr = xerr;
+    }
     if (clixon_xml_parsel_init(&xy) < 0)
 	goto done;    
     if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
@@ -481,12 +635,17 @@ _xml_parse(const char *str,
     x = NULL;
     while ((x = xml_find_type(xt, NULL, "body", CX_BODY)) != NULL)
 	xml_purge(x);
-    /* Traverse new objects */
+    if (xy.xy_bind){
+	if (xy.xy_failed)
+	    goto fail;
+	/* Children of new objects are sorted already */
+	if (xml_sort_children(xt) < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Traverse new objects (namespaces are verified by the parser) */
     for (i = 0; i < xy.xy_xlen; i++) {
 	x = xy.xy_xvec[i];
-	/* Verify namespaces after parsing */
-	if (xml2ns_recurse(x) < 0)
-	    goto done;
 	/* Populate, ie associate xml nodes with yang specs 
 	 */
 	switch (yb){
@@ -538,11 +697,10 @@ _xml_parse(const char *str,
     if (yb != YB_NONE)
 	if (xml_sort_recurse(xt) < 0)
 	    goto done;
+ ok:
     retval = 1;
   done:
     clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
-	free(xy.xy_parse_string);
     if (xy.xy_xvec)
 	free(xy.xy_xvec);
     return retval; 
@@ -588,6 +746,7 @@ FSM(char *tag,
  * @see clixon_json_parse_file
  * @note, If xt empty, a top-level symbol will be added so that <tree../> will be:  <top><tree.../></tree></top>
  * @note May block on file I/O
+ * @note If enabled, nodes are allocated in an arena, see xml_arena_begin
  */
 int 
 clixon_xml_parse_file(int        fd, 
@@ -597,17 +756,17 @@ clixon_xml_parse_file(int        fd,
 		      cxobj    **xt,
 		      cxobj    **xerr)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   endtaglen = 0;
-    int   state = 0;
-    int   oldxmlbuflen;
-    int   failed = 0;
+    int    retval = -1;
+    int    ret;
+    size_t len = 0;
+    char   ch;
+    char  *xmlbuf = NULL;
+    char  *b;
+    size_t xmlbuflen = BUFLEN; /* start size */
+    int    endtaglen = 0;
+    int    state = 0;
+    int    failed = 0;
+    int    arena = 0;
 
     if (xt==NULL){
 	clicon_err(OE_XML, EINVAL, "xt is NULL");
@@ -617,52 +776,58 @@ clixon_xml_parse_file(int        fd,
 	clicon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
 	return -1;
     }
-    if (endtag != NULL)
-	endtaglen = strlen(endtag);
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-	clicon_err(OE_XML, errno, "malloc");
-	goto done;
+    if (endtag == NULL){
+	/* Read whole file in large blocks */
+	if (clicon_file_read(fd, &xmlbuf, &len) < 0)
+	    goto done;
     }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-	if ((ret = read(fd, &ch, 1)) < 0){
-	    clicon_err(OE_XML, errno, "read: [pid:%d]", 
-		    (int)getpid());
-	    break;
-	}
-	if (ret != 0){
-	    if (endtag)
-		state = FSM(endtag, ch, state);
-	    xmlbuf[len++] = ch;
+    else {
+	/* Read byte by byte so as not to read beyond endtag in the stream */
+	endtaglen = strlen(endtag);
+	if ((xmlbuf = malloc(xmlbuflen)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
 	}
-	if (ret == 0 ||
-	    (endtag && (state == endtaglen))){
-	    state = 0;
-	    if (*xt == NULL)
-		if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-		    goto done;
-	    if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
+	while (1){
+	    if ((ret = read(fd, &ch, 1)) < 0){
+		clicon_err(OE_XML, errno, "read: [pid:%d]", 
+			   (int)getpid());
 		goto done;
+	    }
 	    if (ret == 0)
-		failed++;
-	    break;
-	}
-	if (len >= xmlbuflen-1){ /* Space: one for the null character */
-	    oldxmlbuflen = xmlbuflen;
-	    xmlbuflen *= 2;
-	    if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-		clicon_err(OE_XML, errno, "realloc");
-		goto done;
+		break;
+	    state = FSM(endtag, ch, state);
+	    xmlbuf[len++] = ch;
+	    if (state == endtaglen)
+		break;
+	    if (len >= xmlbuflen-2){ /* Space: two for the null characters */
+		xmlbuflen *= 2;
+		if ((b = realloc(xmlbuf, xmlbuflen)) == NULL){
+		    clicon_err(OE_XML, errno, "realloc");
+		    goto done;
+		}
+		xmlbuf = b;
 	    }
-	    memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-	    ptr = xmlbuf;
-	}
-    } /* while */
+	} /* while */
+	xmlbuf[len] = '\0';
+	xmlbuf[len+1] = '\0';
+    }
+    if ((arena = xml_arena_begin()) < 0)
+	goto done;
+    if (*xt == NULL)
+	if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	    goto done;
+    /* Parse buffer in place, it is terminated by two null bytes */
+    if ((ret = _xml_parse(xmlbuf, len+2, yb, yspec, *xt, xerr)) < 0)
+	goto done;
+    if (ret == 0)
+	failed++;
     retval = (failed==0) ? 1 : 0;
  done:
+    if (arena)
+	xml_arena_end();
     if (retval < 0 && *xt){
-	free(*xt);
+	xml_free(*xt);
 	*xt = NULL;
     }
     if (xmlbuf)
@@ -713,7 +878,7 @@ clixon_xml_parse_string(const char *str,
 	if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
 	    return -1;
     }
-    return _xml_parse(str, yb, yspec, *xt, xerr);
+    return _xml_parse(str, 0, yb, yspec, *xt, xerr);
 }
 
 /*! Read XML from var-arg list and parse it into xml tree
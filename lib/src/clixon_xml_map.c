@@ -674,6 +674,232 @@ xml_diff(yang_stmt *yspec,
     return retval;
 }
 
+/*! Check if two XML nodes may be synced in place, ie they are the "same" node
+ * @param[in]  x0   Source XML node
+ * @param[in]  x1   Destination XML node
+ * @retval     1    Same type, name, prefix and yang spec. Lists and leaf-lists also same keys
+ * @retval     0    Not same
+ * @see xml_cmp  which is used for lists and leaf-lists
+ */
+static int
+xml_sync_same(cxobj *x0,
+	      cxobj *x1)
+{
+    yang_stmt *y;
+    char      *p0;
+    char      *p1;
+
+    if (xml_type(x0) != xml_type(x1))
+	return 0;
+    if (strcmp(xml_name(x0), xml_name(x1)) != 0)
+	return 0;
+    p0 = xml_prefix(x0);
+    p1 = xml_prefix(x1);
+    if ((p0 == NULL) != (p1 == NULL))
+	return 0;
+    if (p0 && strcmp(p0, p1) != 0)
+	return 0;
+    if (xml_type(x0) != CX_ELMNT)
+	return 1;
+    if ((y = xml_spec(x0)) != xml_spec(x1))
+	return 0;
+    if (y && (yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_LEAF_LIST))
+	return xml_cmp(x0, x1, 0, 0, NULL) == 0;
+    return 1;
+}
+
+/*! Remove and free child i of x1 as part of xml_tree_sync
+ * @param[in]  x1   Destination XML node
+ * @param[in]  i    Child number
+ */
+static int
+xml_sync_rm(cxobj *x1,
+	    int    i)
+{
+    int    retval = -1;
+    cxobj *xc;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xi;
+#endif
+
+    xc = xml_child_i(x1, i);
+#ifdef XML_EXPLICIT_INDEX
+    /* List entries are registered in the search vectors of x1 */
+    xi = NULL;
+    while ((xi = xml_child_each(xc, xi, CX_ELMNT)) != NULL)
+	if (xml_search_index_p(xi))
+	    if (xml_search_child_rm(xc, xi) < 0)
+		goto done;
+#endif
+    if (xml_child_rm(x1, i) < 0)
+	goto done;
+    xml_free(xc);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Insert a copy of x0c as child i of x1 as part of xml_tree_sync
+ * @param[in]  x0c  Source XML node
+ * @param[in]  x1   Destination XML node
+ * @param[in]  i    Child number
+ */
+static int
+xml_sync_add(cxobj *x0c,
+	     cxobj *x1,
+	     int    i)
+{
+    int    retval = -1;
+    cxobj *xc;
+
+    if ((xc = xml_new(xml_name(x0c), NULL, xml_type(x0c))) == NULL)
+	goto done;
+    if (xml_copy(x0c, xc) < 0){
+	xml_free(xc);
+	goto done;
+    }
+    if (xml_child_insert_pos(x1, xc, i) < 0){
+	xml_free(xc);
+	goto done;
+    }
+    xml_parent_set(xc, x1);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Set value of body or attribute child i of x1 to the value of x0c
+ * A value cannot be unset, if x0c has no value the child is replaced by a copy
+ * of x0c instead.
+ * @param[in]  x0c  Source XML node
+ * @param[in]  x1   Destination XML node
+ * @param[in]  i    Child number
+ */
+static int
+xml_sync_value(cxobj *x0c,
+	       cxobj *x1,
+	       int    i)
+{
+    char *v0;
+
+    if ((v0 = xml_value(x0c)) != NULL)
+	return xml_value_set(xml_child_i(x1, i), v0);
+    if (xml_sync_rm(x1, i) < 0)
+	return -1;
+    return xml_sync_add(x0c, x1, i);
+}
+
+/*! Make XML tree x1 equal to x0 by only changing the nodes that differ
+ *
+ * The children of x0 and x1 are traversed in lock-step. Nodes that are the 
+ * "same" (see xml_sync_same) are kept in x1 and synced recursively, other
+ * nodes in x1 are removed and missing nodes are copied from x0.
+ * In contrast to xml_free+xml_copy, unchanged nodes are neither freed nor 
+ * allocated, and cached information such as search indexes are kept.
+ * The result is equal to xml_copy(x0, x1) of an empty x1 except that only the
+ * XML_FLAG_DEFAULT flag is synced, other flags of unchanged nodes are kept.
+ * @note Both trees are traversed in full, since edits of x0 are not recorded,
+ *       only nodes that differ are allocated or freed.
+ * @param[in]     x0   Source XML tree
+ * @param[in,out] x1   Destination XML tree, modified to be equal to x0
+ * @retval        0    OK
+ * @retval       -1    Error
+ * @see xml_diff   Computes the differences between two trees, same traversal
+ * @see xml_copy   Copy a whole tree
+ */
+int
+xml_tree_sync(cxobj *x0,
+	      cxobj *x1)
+{
+    int    retval = -1;
+    int    i0;
+    int    i1;
+    cxobj *x0c;
+    cxobj *x1c;
+    int    nschange = 0;
+
+    if (strcmp(xml_name(x0), xml_name(x1)) != 0)
+	if (xml_name_set(x1, xml_name(x0)) < 0)
+	    goto done;
+    if (xml_flag(x0, XML_FLAG_DEFAULT) != xml_flag(x1, XML_FLAG_DEFAULT)){
+	if (xml_flag(x0, XML_FLAG_DEFAULT))
+	    xml_flag_set(x1, XML_FLAG_DEFAULT);
+	else
+	    xml_flag_reset(x1, XML_FLAG_DEFAULT);
+    }
+    i0 = i1 = 0;
+    while (i0 < xml_child_nr(x0)){
+	x0c = xml_child_i(x0, i0);
+	if (i1 < xml_child_nr(x1)){
+	    x1c = xml_child_i(x1, i1);
+	    if (xml_sync_same(x0c, x1c)){
+		switch (xml_type(x0c)){
+		case CX_ELMNT:
+		    if (xml_tree_sync(x0c, x1c) < 0) /* recursion */
+			goto done;
+		    break;
+		case CX_ATTR:
+		case CX_BODY:
+		    if (clicon_strcmp(xml_value(x0c), xml_value(x1c)) != 0){
+			if (xml_type(x0c) == CX_ATTR)
+			    nschange++;
+			else /* Cached value of the leaf is obsolete */
+			    xml_cv_set(x1, NULL);
+#ifdef XML_EXPLICIT_INDEX
+			if (xml_type(x0c) == CX_BODY && xml_search_index_p(x1)){
+			    if (xml_search_child_rm(xml_parent(x1), x1) < 0)
+				goto done;
+			    if (xml_sync_value(x0c, x1, i1) < 0)
+				goto done;
+			    if (xml_search_child_insert(xml_parent(x1), x1) < 0)
+				goto done;
+			    break;
+			}
+#endif
+			if (xml_sync_value(x0c, x1, i1) < 0)
+			    goto done;
+		    }
+		    break;
+		default:
+		    break;
+		}
+		i0++;
+		i1++;
+		continue;
+	    }
+	    /* x1c sorts before x0c: it does not exist in x0 */
+	    if (xml_cmp(x0c, x1c, 0, 0, NULL) > 0){
+		if (xml_type(x1c) == CX_ATTR)
+		    nschange++;
+		if (xml_sync_rm(x1, i1) < 0)
+		    goto done;
+		continue;
+	    }
+	}
+	/* x0c does not exist in x1: copy it */
+	if (xml_sync_add(x0c, x1, i1) < 0)
+	    goto done;
+	if (xml_type(x0c) == CX_ATTR)
+	    nschange++;
+	i0++;
+	i1++;
+    }
+    /* Remaining children of x1 do not exist in x0 */
+    while (i1 < xml_child_nr(x1)){
+	if (xml_type(xml_child_i(x1, i1)) == CX_ATTR)
+	    nschange++;
+	if (xml_sync_rm(x1, i1) < 0)
+	    goto done;
+    }
+    /* Namespace declarations changed: cached namespace contexts are obsolete */
+    if (nschange)
+	if (xml_apply0(x1, CX_ELMNT, (xml_applyfn_t*)nscache_clear, NULL) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Prune everything that does not pass test or have at least a child* does not
  * @param[in]   xt      XML tree with some node marked
  * @param[in]   flag    Which flag to test for
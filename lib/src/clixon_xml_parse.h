@@ -45,7 +45,8 @@
  */
 /*! XML parser yacc handler struct */
 struct clixon_xml_parse_yacc {
-    char       *xy_parse_string; /* original (copy of) parse string */
+    char       *xy_parse_string; /* original parse string */
+    size_t      xy_parse_len;    /* If set, parse string in place: length incl two null bytes */
     int         xy_linenum;      /* Number of \n in parsed buffer */
     void       *xy_lexbuf;       /* internal parse buffer from lex */
     cxobj      *xy_xtop;         /* cxobj top element (fixed) */
@@ -55,6 +56,10 @@ struct clixon_xml_parse_yacc {
     int         xy_lex_state;    /* lex return state */
     cxobj     **xy_xvec;         /* Vector of created top-level nodes (to know which are created) */
     int         xy_xlen;         /* Length of xy_xvec */
+    int         xy_bind;         /* Bind yang and sort as elements are parsed */
+    yang_bind   xy_yb;           /* How to bind yang to top-level elements, if xy_bind */
+    cxobj     **xy_xerr;         /* Reason for yang bind failure, if xy_bind */
+    int         xy_failed;       /* Nr of yang bind failures, if xy_bind */
 };
 typedef struct clixon_xml_parse_yacc clixon_xml_yacc;
 
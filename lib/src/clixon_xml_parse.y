@@ -62,6 +62,8 @@
 /* typecast macro */
 #define _XY ((clixon_xml_yacc *)_xy)
 
+#include "clixon_config.h"
+
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -81,6 +83,8 @@
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_bind.h"
 #include "clixon_xml_parse.h"
 
 /* Enable for debugging, steals some cycles otherwise */
@@ -217,9 +221,154 @@ xml_parse_prefixed_name(clixon_xml_yacc *xy,
     return retval;
 }
 
+/*! Find previous element with same name as x to use as yang binding role model
+ *
+ * Either the previous sibling of x, or the same child of the previous sibling of 
+ * the parent of x, eg in the previous list entry.
+ * @param[in] x   XML element whose start-tag is parsed (last child of its parent)
+ * @retval    xs  XML element with same name, prefix and bound to yang
+ * @retval    NULL Not found
+ */
+static cxobj *
+xml_parse_sibling(cxobj *x)
+{
+    cxobj *xp;
+    cxobj *xpp;
+    cxobj *xs = NULL;
+    int    i;
+
+    xp = xml_parent(x);
+    for (i = xml_child_nr(xp)-2; i >= 0; i--)
+	if (xml_type(xs = xml_child_i(xp, i)) == CX_ELMNT)
+	    break;
+    if (i >= 0){ /* Previous sibling */
+	if (clicon_strcmp(xml_name(xs), xml_name(x)) == 0 &&
+	    clicon_strcmp(xml_prefix(xs), xml_prefix(x)) == 0 &&
+	    xml_spec(xs) != NULL)
+	    return xs;
+    }
+    if ((xpp = xml_parent(xp)) == NULL)
+	return NULL;
+    for (i = xml_child_nr(xpp)-2; i >= 0; i--)
+	if (xml_type(xs = xml_child_i(xpp, i)) == CX_ELMNT)
+	    break;
+    if (i >= 0 && /* Previous sibling of parent */
+	xml_spec(xs) == xml_spec(xp) &&
+	clicon_strcmp(xml_name(xs), xml_name(xp)) == 0 &&
+	clicon_strcmp(xml_prefix(xs), xml_prefix(xp)) == 0 &&
+	(xs = xml_find_type(xs, xml_prefix(x), xml_name(x), CX_ELMNT)) != NULL &&
+	xml_spec(xs) != NULL)
+	return xs;
+    return NULL;
+}
+
+/*! Start-tag of element is parsed: check namespace and bind yang
+ *
+ * Attributes, and thereby namespace declarations, of x and its ancestors are
+ * known, but not its children.
+ * @param[in] xy  XML parser yacc handler struct 
+ * @param[in] x   XML element
+ * @see xml2ns_recurse
+ */
+static int
+xml_parse_bind(clixon_xml_yacc *xy,
+	       cxobj           *x)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    char      *prefix;
+    char      *ns;
+    yang_bind  yb;
+    cxobj     *xs = NULL;
+    int        ret;
+
+    xp = xml_parent(x);
+    if (xp != xy->xy_xtop && (prefix = xml_prefix(x)) != NULL){
+	ns = NULL;
+	if (xml2ns(x, prefix, &ns) < 0)
+	    goto done;
+	if (ns == NULL){
+	    clicon_err(OE_XML, ENOENT, "No namespace associated with %s:%s", prefix, xml_name(x));
+	    goto done;
+	}	    
+    }
+    if (!xy->xy_bind)
+	goto ok;
+    if (xp == xy->xy_xtop){
+	yb = xy->xy_yb;
+#ifdef XMLDB_CONFIG_HACK
+	if (yb == YB_MODULE &&
+	    (strcmp(xml_name(x), "config") == 0 || strcmp(xml_name(x), "data") == 0))
+	    goto ok; /* Its children are bound from modules */
+#endif
+    }
+#ifdef XMLDB_CONFIG_HACK
+    else if (xy->xy_yb == YB_MODULE &&
+	     xml_parent(xp) == xy->xy_xtop && xml_spec(xp) == NULL &&
+	     (strcmp(xml_name(xp), "config") == 0 || strcmp(xml_name(xp), "data") == 0))
+	yb = YB_MODULE;
+#endif
+    else if (xml_spec(xp) == NULL)
+	goto ok; /* Parent not bound: failed, or child of anyxml */
+    else{
+	yb = YB_PARENT;
+	xs = xml_parse_sibling(x);
+    }
+    if ((ret = xml_bind_yang_node(x, yb, xy->xy_yspec, xs, xy->xy_xerr)) < 0)
+	goto done;
+    if (ret == 0)
+	xy->xy_failed++;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! End-tag of element is parsed: finish yang binding and sort its children
+ *
+ * @param[in] xy  XML parser yacc handler struct 
+ * @param[in] x   XML element
+ */
+static int
+xml_parse_bind_end(clixon_xml_yacc *xy,
+		   cxobj           *x)
+{
+    int retval = -1;
+
+    if (xy->xy_bind){
+	if (xml_bind_yang_end(x) < 0)
+	    goto done;
+	if (xml_sort_children(x) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Empty element tag <name/> is parsed
+ */
+static int
+xml_parse_empty(clixon_xml_yacc *xy)
+{
+    int    retval = -1;
+    cxobj *x = xy->xy_xelement;
+
+    if (xml_parse_bind(xy, x) < 0)
+	goto done;
+    if (xml_parse_bind_end(xy, x) < 0)
+	goto done;
+    xy->xy_xelement = NULL;
+    retval = 0;
+ done:
+    return retval;
+}
+
 static int
 xml_parse_endslash_pre(clixon_xml_yacc *xy)
 {
+    if (xml_parse_bind(xy, xy->xy_xelement) < 0)
+	return -1;
     xy->xy_xparent = xy->xy_xelement;
     xy->xy_xelement = NULL;
     return 0;
@@ -289,6 +438,8 @@ xml_parse_bslash(clixon_xml_yacc *xy,
 	if (xml_rm_children(x, CX_BODY) < 0) /* remove all bodies */
 	    goto done;
     }
+    if (xml_parse_bind_end(xy, x) < 0)
+	goto done;
     retval = 0;
   done:
     if (prefix)
@@ -390,9 +541,9 @@ qname       : NAME           { if (xml_parse_prefixed_name(_XY, NULL, $1) < 0) Y
                                 _PARSE_DEBUG("qname -> NAME : NAME");}
             ;
 
-element1    :  ESLASH         {_XY->xy_xelement = NULL; 
+element1    :  ESLASH         { if (xml_parse_empty(_XY) < 0) YYABORT; 
                                _PARSE_DEBUG("element1 -> />");} 
-            | '>'             { xml_parse_endslash_pre(_XY); }
+            | '>'             { if (xml_parse_endslash_pre(_XY) < 0) YYABORT; }
               elist           { xml_parse_endslash_mid(_XY); }
               endtag          { xml_parse_endslash_post(_XY); 
                                _PARSE_DEBUG("element1 -> > elist endtag");} 
@@ -0,0 +1,484 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written XML scanner, alternative to the flex scanner in clixon_xml_parse.l
+ * Enabled with configure --enable-xml-scanner.
+ * Returns the same tokens as the flex scanner to the yacc parser in 
+ * clixon_xml_parse.y, but scans text and attribute values in bulk using
+ * clixon_scan_delim(), and scans the buffer in place.
+ * As in flex, the text of the last token (clixon_xml_parsetext) is null-terminated
+ * in the buffer, and the overwritten character is restored when the next token
+ * is scanned.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#ifdef CLIXON_XML_SCANNER
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "clixon_xml_parse.tab.h"   /* generated file */
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_err.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_parse.h"
+#include "clixon_scan.h"
+
+/* Scanner states, same as start conditions in clixon_xml_parse.l */
+enum xml_scan_state{
+    XS_START,
+    XS_STATEA,     /* Element content */
+    XS_AMPERSAND,  /* Entity reference */
+    XS_CDATA,
+    XS_CMNT,
+    XS_TEXTDECL,
+    XS_PIDECL,
+    XS_PIDECL2,
+    XS_STRDQ,      /* Double-quoted string */
+    XS_STRSQ       /* Single-quoted string */
+};
+
+/*! XML scanner state, kept in xy_lexbuf */
+struct xml_scan{
+    char  *xs_buf;    /* Scanned buffer, terminated by two null bytes */
+    int    xs_copy;   /* xs_buf is a copy of the parse string, free it */
+    char  *xs_p;      /* Current position in xs_buf */
+    char  *xs_end;    /* End of xs_buf (first null byte) */
+    char  *xs_holdp;  /* Null byte terminating last token, or NULL */
+    char   xs_hold;   /* Character overwritten by that null byte */
+    enum xml_scan_state xs_state;
+};
+
+/* From https://www.w3.org/TR/2009/REC-xml-names-20091208: NCName, see clixon_xml_parse.l */
+#define NAMESTART(c) (((c)>='A'&&(c)<='Z') || ((c)>='a'&&(c)<='z') || (c)=='_')
+#define NAMECHAR(c)  (NAMESTART(c) || ((c)>='0'&&(c)<='9') || (c)=='-' || (c)=='.')
+
+/* Delimiter sets, initialized once */
+static int             _xs_init = 0;
+static clixon_scan_set _xs_text;  /* Element content */
+static clixon_scan_set _xs_cdata;
+static clixon_scan_set _xs_cmnt;
+static clixon_scan_set _xs_pi;
+static clixon_scan_set _xs_dq;
+static clixon_scan_set _xs_sq;
+
+/*! Return token: null-terminate its text in the buffer and advance
+ */
+static int
+xs_token(struct xml_scan *xs,
+	 char            *start,
+	 char            *end,
+	 int              token)
+{
+    clixon_xml_parsetext = start;
+    xs->xs_holdp = end;
+    xs->xs_hold = *end;
+    *end = '\0';
+    xs->xs_p = end;
+    return token;
+}
+
+/*! Return token with a copy of its text as value
+ */
+static int
+xs_token_dup(struct xml_scan *xs,
+	     char            *start,
+	     char            *end,
+	     int              token)
+{
+    if ((clixon_xml_parselval.string = strndup(start, end-start)) == NULL){
+	clicon_err(OE_XML, errno, "strndup");
+	return -1;
+    }
+    return xs_token(xs, start, end, token);
+}
+
+/*! Return token with its text in the buffer as value
+ */
+static int
+xs_token_text(struct xml_scan *xs,
+	      char            *start,
+	      char            *end,
+	      int              token)
+{
+    xs_token(xs, start, end, token);
+    clixon_xml_parselval.string = clixon_xml_parsetext;
+    return token;
+}
+
+/*! Return 1 if the string s is at p (and before end)
+ */
+static inline int
+xs_match(char       *p,
+	 char       *end,
+	 const char *s,
+	 size_t      len)
+{
+    return (size_t)(end - p) >= len && memcmp(p, s, len) == 0;
+}
+
+/*! Scan next token, called by the yacc parser
+ * @param[in]  _xy  XML parser yacc handler struct
+ * @retval     token
+ * @retval     0     End of input in the middle of a construct
+ * @retval    -1     Error
+ */
+int
+clixon_xml_parselex(void *_xy)
+{
+    clixon_xml_yacc *xy = (clixon_xml_yacc *)_xy;
+    struct xml_scan *xs = (struct xml_scan *)xy->xy_lexbuf;
+    char            *p;
+    char            *q;
+    char            *end;
+    char             c;
+
+    if (xs->xs_holdp){
+	*xs->xs_holdp = xs->xs_hold;
+	xs->xs_holdp = NULL;
+    }
+    p = xs->xs_p;
+    end = xs->xs_end;
+    while (1){
+	if (p >= end){
+	    if (xs->xs_state == XS_START || xs->xs_state == XS_STATEA)
+		return xs_token(xs, end, end, MY_EOF);
+	    xs_token(xs, end, end, 0);
+	    return 0;
+	}
+	c = *p;
+	switch (xs->xs_state){
+	case XS_START:
+	    if (NAMESTART(c)){
+		for (q = p+1; q < end && NAMECHAR(*q); q++);
+		return xs_token_dup(xs, p, q, NAME);
+	    }
+	    switch (c){
+	    case ' ': case '\t': case '\r':
+		p++;
+		continue;
+	    case '\n':
+		xy->xy_linenum++;
+		p++;
+		continue;
+	    case '<':
+		if (xs_match(p, end, "<?xml", 5)){
+		    xs->xs_state = XS_TEXTDECL;
+		    return xs_token(xs, p, p+5, BXMLDCL);
+		}
+		if (xs_match(p, end, "<?", 2)){
+		    xs->xs_state = XS_PIDECL;
+		    return xs_token(xs, p, p+2, BQMARK);
+		}
+		if (xs_match(p, end, "<!--", 4)){
+		    xs->xs_state = XS_CMNT;
+		    return xs_token(xs, p, p+4, BCOMMENT);
+		}
+		if (xs_match(p, end, "</", 2))
+		    return xs_token(xs, p, p+2, BSLASH);
+		return xs_token(xs, p, p+1, c);
+	    case '/':
+		if (xs_match(p, end, "/>", 2)){
+		    xs->xs_state = XS_STATEA;
+		    return xs_token(xs, p, p+2, ESLASH);
+		}
+		return xs_token(xs, p, p+1, c);
+	    case ':': case '=':
+		return xs_token(xs, p, p+1, c);
+	    case '>':
+		xs->xs_state = XS_STATEA;
+		return xs_token(xs, p, p+1, c);
+	    case '"':
+		xy->xy_lex_state = XS_START;
+		xs->xs_state = XS_STRDQ;
+		return xs_token(xs, p, p+1, c);
+	    case '\'':
+		xy->xy_lex_state = XS_START;
+		xs->xs_state = XS_STRSQ;
+		return xs_token(xs, p, p+1, c);
+	    default:
+		return xs_token_text(xs, p, p+1, CHARDATA);
+	    }
+	    break;
+	case XS_STATEA:
+	    switch (c){
+	    case '<':
+		if (xs_match(p, end, "</", 2)){
+		    xs->xs_state = XS_START;
+		    return xs_token(xs, p, p+2, BSLASH);
+		}
+		if (xs_match(p, end, "<!--", 4)){
+		    xs->xs_state = XS_CMNT;
+		    return xs_token(xs, p, p+4, BCOMMENT);
+		}
+		if (xs_match(p, end, "<![CDATA[", 9)){
+		    xy->xy_lex_state = XS_STATEA;
+		    xs->xs_state = XS_CDATA;
+		    return xs_token_text(xs, p, p+9, CHARDATA);
+		}
+		if (xs_match(p, end, "<?", 2)){
+		    xs->xs_state = XS_PIDECL;
+		    return xs_token(xs, p, p+2, BQMARK);
+		}
+		xs->xs_state = XS_START;
+		return xs_token(xs, p, p+1, c);
+	    case '&':
+		xy->xy_lex_state = XS_STATEA;
+		xs->xs_state = XS_AMPERSAND;
+		p++;
+		continue;
+	    case ' ': case '\t':
+		for (q = p+1; q < end && (*q == ' ' || *q == '\t'); q++);
+		return xs_token_text(xs, p, q, WHITESPACE);
+	    case '\r':
+		q = p+1;
+		if (q < end && *q == '\n'){
+		    xy->xy_linenum++;
+		    q++;
+		}
+		xs_token(xs, p, q, WHITESPACE);
+		clixon_xml_parselval.string = "\n";
+		return WHITESPACE;
+	    case '\n':
+		xy->xy_linenum++;
+		xs_token(xs, p, p+1, WHITESPACE);
+		clixon_xml_parselval.string = "\n";
+		return WHITESPACE;
+	    default:
+		q = clixon_scan_delim(&_xs_text, p+1, end);
+		return xs_token_text(xs, p, q, CHARDATA);
+	    }
+	    break;
+	case XS_AMPERSAND: /* @see xml_chardata_encode */
+	    if (xs_match(p, end, "amp;", 4))
+		q = "&";
+	    else if (xs_match(p, end, "lt;", 3))
+		q = "<";
+	    else if (xs_match(p, end, "gt;", 3))
+		q = ">";
+	    else if (xs_match(p, end, "apos;", 5))
+		q = "'";
+	    else if (xs_match(p, end, "quot;", 5))
+		q = "\"";
+	    else { /* Not an entity, skip character */
+		p++;
+		continue;
+	    }
+	    xs->xs_state = xy->xy_lex_state;
+	    xs_token(xs, p, (char*)memchr(p, ';', end-p)+1, CHARDATA);
+	    clixon_xml_parselval.string = q;
+	    return CHARDATA;
+	case XS_CDATA:
+	    if (c == '\n'){
+		xy->xy_linenum++;
+		return xs_token_text(xs, p, p+1, CHARDATA);
+	    }
+	    if (c == ']'){
+		if (xs_match(p, end, "]]>", 3)){
+		    xs->xs_state = xy->xy_lex_state;
+		    return xs_token_text(xs, p, p+3, CHARDATA);
+		}
+		return xs_token_text(xs, p, p+1, CHARDATA);
+	    }
+	    q = clixon_scan_delim(&_xs_cdata, p+1, end);
+	    return xs_token_text(xs, p, q, CHARDATA);
+	case XS_CMNT:
+	    if (c == '-' && xs_match(p, end, "-->", 3)){
+		xs->xs_state = XS_START;
+		return xs_token(xs, p, p+3, ECOMMENT);
+	    }
+	    if (c == '\n')
+		xy->xy_linenum++;
+	    p = clixon_scan_delim(&_xs_cmnt, p+1, end);
+	    continue;
+	case XS_TEXTDECL:
+	    switch (c){
+	    case ' ': case '\t': case '\r':
+		p++;
+		continue;
+	    case '\n':
+		xy->xy_linenum++;
+		p++;
+		continue;
+	    case '=':
+		return xs_token(xs, p, p+1, c);
+	    case '"':
+		xy->xy_lex_state = XS_TEXTDECL;
+		xs->xs_state = XS_STRDQ;
+		return xs_token(xs, p, p+1, c);
+	    case '\'':
+		xy->xy_lex_state = XS_TEXTDECL;
+		xs->xs_state = XS_STRSQ;
+		return xs_token(xs, p, p+1, c);
+	    default:
+		break;
+	    }
+	    if (xs_match(p, end, "encoding", 8))
+		return xs_token(xs, p, p+8, ENC);
+	    if (xs_match(p, end, "version", 7))
+		return xs_token(xs, p, p+7, VER);
+	    if (xs_match(p, end, "standalone", 10))
+		return xs_token(xs, p, p+10, SD);
+	    if (xs_match(p, end, "?>", 2)){
+		xs->xs_state = XS_START;
+		return xs_token(xs, p, p+2, EQMARK);
+	    }
+	    return xs_token_text(xs, p, p+1, CHARDATA);
+	case XS_PIDECL:
+	    if (NAMESTART(c)){
+		for (q = p+1; q < end && NAMECHAR(*q); q++);
+		return xs_token_dup(xs, p, q, NAME);
+	    }
+	    if (c == ' ' || c == '\t'){
+		xs->xs_state = XS_PIDECL2;
+		p++;
+		continue;
+	    }
+	    if (c == '\n'){ /* Not matched by flex scanner either */
+		p++;
+		continue;
+	    }
+	    return xs_token_text(xs, p, p+1, CHARDATA);
+	case XS_PIDECL2:
+	    if (xs_match(p, end, "?>", 2)){
+		xs->xs_state = XS_START;
+		return xs_token(xs, p, p+2, EQMARK);
+	    }
+	    if (_xs_pi.ss_tab[(unsigned char)c]){ /* Not matched by flex scanner either */
+		p++;
+		continue;
+	    }
+	    q = clixon_scan_delim(&_xs_pi, p+1, end);
+	    return xs_token_dup(xs, p, q, STRING);
+	case XS_STRDQ:
+	case XS_STRSQ:
+	    if (c == (xs->xs_state == XS_STRDQ ? '"' : '\'')){
+		xs->xs_state = xy->xy_lex_state;
+		return xs_token(xs, p, p+1, c);
+	    }
+	    q = clixon_scan_delim(xs->xs_state == XS_STRDQ ? &_xs_dq : &_xs_sq, p+1, end);
+	    return xs_token_dup(xs, p, q, STRING);
+	}
+    }
+    return 0; /* not reached */
+}
+
+/*! Initialize XML scanner.
+ */
+int
+clixon_xml_parsel_init(clixon_xml_yacc *xy)
+{
+    int              retval = -1;
+    struct xml_scan *xs = NULL;
+    size_t           len;
+
+    if (_xs_init == 0){
+	if (clixon_scan_set_init(&_xs_text, "&\r\n \t<") < 0 ||
+	    clixon_scan_set_init(&_xs_cdata, "]\n") < 0 ||
+	    clixon_scan_set_init(&_xs_cmnt, "-\n") < 0 ||
+	    clixon_scan_set_init(&_xs_pi, "{?>}") < 0 ||
+	    clixon_scan_set_init(&_xs_dq, "\"") < 0 ||
+	    clixon_scan_set_init(&_xs_sq, "'") < 0)
+	    goto done;
+	_xs_init++;
+    }
+    if ((xs = malloc(sizeof(*xs))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memset(xs, 0, sizeof(*xs));
+    if (xy->xy_parse_len){ /* Scan in place, no copy */
+	len = xy->xy_parse_len;
+	if (len < 2 || xy->xy_parse_string[len-2] != '\0' || xy->xy_parse_string[len-1] != '\0'){
+	    clicon_err(OE_XML, 0, "Parse buffer not terminated by two null bytes");
+	    goto done;
+	}
+	xs->xs_buf = xy->xy_parse_string;
+	len -= 2;
+    }
+    else{
+	len = strlen(xy->xy_parse_string);
+	if ((xs->xs_buf = malloc(len+2)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	memcpy(xs->xs_buf, xy->xy_parse_string, len);
+	xs->xs_buf[len] = '\0';
+	xs->xs_buf[len+1] = '\0';
+	xs->xs_copy = 1;
+    }
+    xs->xs_p = xs->xs_buf;
+    xs->xs_end = xs->xs_buf + len;
+    xs->xs_state = XS_START;
+    xy->xy_lexbuf = xs;
+    xs = NULL;
+    retval = 0;
+ done:
+    if (xs)
+	free(xs);
+    return retval;
+}
+
+/*! Exit xml scanner */
+int
+clixon_xml_parsel_exit(clixon_xml_yacc *xy)
+{
+    struct xml_scan *xs = (struct xml_scan *)xy->xy_lexbuf;
+
+    if (xs == NULL)
+	return 0;
+    if (xs->xs_holdp)
+	*xs->xs_holdp = xs->xs_hold;
+    if (xs->xs_copy)
+	free(xs->xs_buf);
+    free(xs);
+    xy->xy_lexbuf = NULL;
+    return 0;
+}
+
+#endif /* CLIXON_XML_SCANNER */
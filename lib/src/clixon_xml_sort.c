@@ -345,7 +345,8 @@ xml_cmp(cxobj  *x1,
 	    /* match1: key matching skipped for keys not in x1 (see explanation) */
 	    if (skip1 && x1b == NULL)
 		continue;
-	    x2b = xml_find(x2, keyname);
+	    /* Use interned name of x1b if found, compared by pointer */
+	    x2b = xml_find(x2, x1b?xml_name(x1b):keyname);
 	    if (x1b == NULL && x2b == NULL)
 		;
 	    else if (x1b == NULL)
@@ -421,27 +422,53 @@ xml_sort(cxobj *x)
     return 0;
 }
 
-/*! Recursively sort a tree 
- * Alt to use xml_apply
+/*! Sort children of an XML node if not already sorted, not recursively
+ *
+ * @param[in] xn   XML node
+ * @retval    -1   Error
+ * @retval     0   OK, children of xn are sorted
+ * @retval     1   OK, xn is not sortable (state data)
+ * @see xml_sort_recurse  Recursive variant
  */
 int
-xml_sort_recurse(cxobj *xn)
+xml_sort_children(cxobj *xn)
 {
-    int    retval = -1;
-    cxobj *x;
-    int    ret;
+    int retval = -1;
+    int ret;
     
     ret = xml_sort_verify(xn, NULL);
     if (ret == 1) /* This node is not sortable */
-	goto ok;
+	goto skip;
     if (ret == -1){ /* not sorted */
 	if ((ret = xml_sort(xn)) < 0)
 	    goto done;
 	if (ret == 1) /* This node is not sortable */
-	    goto ok;
+	    goto skip;
     }
     if (xml_cv_cache_clear(xn) < 0)
 	goto done;
+    retval = 0;
+ done:
+    return retval;
+ skip:
+    retval = 1;
+    goto done;
+}
+
+/*! Recursively sort a tree 
+ * Alt to use xml_apply
+ */
+int
+xml_sort_recurse(cxobj *xn)
+{
+    int    retval = -1;
+    cxobj *x;
+    int    ret;
+    
+    if ((ret = xml_sort_children(xn)) < 0)
+	goto done;
+    if (ret == 1) /* This node is not sortable */
+	goto ok;
     x = NULL;
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
 	if (xml_sort_recurse(x) < 0)
@@ -1088,6 +1115,171 @@ xml_insert(cxobj           *xp,
     return retval;
 }
 
+/*! Merge two sorted XML vectors into out, elements of v1 first if equal
+ */
+static void
+xml_vec_merge2(cxobj **v1,
+	       int     n1,
+	       cxobj **v2,
+	       int     n2,
+	       cxobj **out,
+	       int     same,
+	       char   *indexvar)
+{
+    int i = 0;
+    int j = 0;
+    int k = 0;
+
+    while (i < n1 && j < n2){
+	if (xml_cmp(v2[j], v1[i], same, 0, indexvar) < 0)
+	    out[k++] = v2[j++];
+	else
+	    out[k++] = v1[i++];
+    }
+    while (i < n1)
+	out[k++] = v1[i++];
+    while (j < n2)
+	out[k++] = v2[j++];
+}
+
+/*! Stable merge sort of XML vector, tmp is work space of same length
+ */
+static void
+xml_vec_msort(cxobj **vec,
+	      int     n,
+	      cxobj **tmp,
+	      int     same,
+	      char   *indexvar)
+{
+    int m;
+
+    if (n < 2)
+	return;
+    m = n/2;
+    xml_vec_msort(vec, m, tmp, same, indexvar);
+    xml_vec_msort(vec+m, n-m, tmp, same, indexvar);
+    xml_vec_merge2(vec, m, vec+m, n-m, tmp, same, indexvar);
+    memcpy(vec, tmp, n*sizeof(cxobj *));
+}
+
+/*! Sort the last elements of an XML vector and merge them with the first, sorted, elements
+ *
+ * This is O(n + m log m) instead of O((n+m) log (n+m)) for sorting all.
+ * The sort is stable: elements that are equal keep their order, and are placed 
+ * after equal elements of the sorted part.
+ * @param[in,out] vec      XML vector, the first n elements are sorted
+ * @param[in]     n        Nr of sorted elements
+ * @param[in]     m        Nr of elements after them to sort and merge
+ * @param[in]     same     See xml_cmp, if set enumeration of children should be reset
+ * @param[in]     indexvar Explicit index variable to compare list elements on, or NULL
+ * @retval        0        OK
+ * @retval       -1        Error
+ */
+int
+xml_vec_merge(cxobj **vec,
+	      int     n,
+	      int     m,
+	      int     same,
+	      char   *indexvar)
+{
+    cxobj **tmp;
+
+    if (m == 0)
+	return 0;
+    if ((tmp = malloc((n+m)*sizeof(cxobj *))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return -1;
+    }
+    xml_vec_msort(vec+n, m, tmp, same, indexvar);
+    xml_vec_merge2(vec, n, vec+n, m, tmp, same, indexvar);
+    memcpy(vec, tmp, (n+m)*sizeof(cxobj *));
+    free(tmp);
+    return 0;
+}
+
+/*! Insert several children in xp:s sorted child list. Remove them from previous parent.
+ *
+ * The children are sorted and merged with the existing children in one pass, which is
+ * O(n + m log m) for m children inserted among n, instead of O(n*m) when inserted 
+ * one by one with xml_insert. The same is done for search index vectors of xp.
+ * @param[in] xp    Parent xml node with sorted children
+ * @param[in] xvec  Child xml nodes, YANG bound and without parent
+ * @param[in] xlen  Length of xvec
+ * @retval    0     OK
+ * @retval   -1     Error, nodes of xvec that are not inserted are freed
+ * @note Ordered-by user children are inserted last, in the order of xvec
+ * @see xml_insert  for inserting a single child, also before or after another
+ */
+int
+xml_insert_vec(cxobj  *xp,
+	       cxobj **xvec,
+	       int     xlen)
+{
+    int        retval = -1;
+    cxobj    **vec = NULL;
+    cxobj     *xi;
+    yang_stmt *y;
+    int        n;
+    int        i;
+
+    for (i=0; i<xlen; i++){
+	xi = xvec[i];
+	if (xml_parent(xi) != NULL){
+	    clicon_err(OE_XML, 0, "XML node %s should not have parent", xml_name(xi));
+	    goto done;
+	}
+	if ((y = xml_spec(xi)) == NULL){
+	    clicon_err(OE_XML, 0, "No spec found %s", xml_name(xi));
+	    goto done;
+	}
+#ifndef STATE_ORDERED_BY_SYSTEM
+	/* State data is not sorted, see xml_sort */
+	if (yang_config_ancestor(y) == 0)
+	    break;
+#endif
+    }
+    if (i < xlen){
+	for (i=0; i<xlen; i++)
+	    if (xml_insert(xp, xvec[i], INS_LAST, NULL, NULL) < 0)
+		goto done;
+	goto ok;
+    }
+    n = xml_child_nr(xp);
+    if ((vec = malloc((n+xlen)*sizeof(cxobj *))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    if (n)
+	memcpy(vec, xml_childvec_get(xp), n*sizeof(cxobj *));
+    memcpy(vec+n, xvec, xlen*sizeof(cxobj *));
+    if (xml_childvec_set(xp, n+xlen) < 0)
+	goto done;
+    memcpy(xml_childvec_get(xp), vec, (n+xlen)*sizeof(cxobj *));
+    for (i=0; i<xlen; i++){
+	xml_parent_set(xvec[i], xp);
+	/* clear namespace context cache of child */
+	nscache_clear(xvec[i]);
+    }
+    /* Equal children, eg ordered-by user, keep their order */
+    xml_enumerate_reset(xp);
+    if (xml_vec_merge(xml_childvec_get(xp), n, xlen, 1, NULL) < 0)
+	goto done;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_child_insert_vec(xp, xvec, xlen) < 0)
+	goto done;
+#endif
+ ok:
+    retval = 0;
+ done:
+    if (retval < 0) /* Nodes not linked into xp are not freed with it */
+	for (i=0; i<xlen; i++)
+	    if (xml_parent(xvec[i]) == NULL)
+		xml_free(xvec[i]);
+    if (vec)
+	free(vec);
+    return retval;
+}
+
 /*! Verify all children of XML node are sorted according to xml_sort()
  * @param[in]   x    XML node. Check its children
  * @param[in]   arg  Dummy. Ensures xml_apply can be used with this fn
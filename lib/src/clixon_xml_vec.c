@@ -198,6 +198,19 @@ clixon_xvec_i(clixon_xvec *xv,
 	return NULL;
 }
 
+/*! Return the XML object vector of an xvec, not a copy
+ *
+ * Elements may be reordered, but not added or removed
+ * @param[in]  xv    XML tree vector
+ * @retval     xvec  XML object vector, NULL if empty
+ * @see clixon_xvec_extract which moves the vector out of xv
+ */
+cxobj **
+clixon_xvec_vec(clixon_xvec *xv)
+{
+    return xv->xv_vec;
+}
+
 /*! Return whole XML object vector and null it in original xvec, essentially moving it
  *
  * Used in glue code between clixon_xvec code and cxobj **, size_t code, may go AWAY?
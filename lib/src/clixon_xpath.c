@@ -67,6 +67,8 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <stdarg.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <assert.h>
@@ -84,16 +86,51 @@
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_atom.h"
 #include "clixon_yang_module.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
 
+/*
+ * Constants
+ */
+/* Formatted xpaths shorter than this are not allocated */
+#define XPATH_FORMAT_BUFLEN 256
+
 /*
  * Variables
  */
 
+/*! Prepared xpath: an entry in the xpath cache
+ * Entries are reference counted: one reference is held by each user and they are
+ * removed from the cache (but kept until released) when least recently used.
+ * @see xpath_prepare
+ */
+struct xpath_prepared{
+    qelem_t     xp_qelem;   /* LRU list, most recently used first */
+    char       *xp_xpath;   /* xpath string, key of cache */
+    xpath_tree *xp_tree;    /* Parsed xpath */
+    int         xp_refcnt;  /* Nr of users of this entry */
+    int         xp_cached;  /* Entry is in cache */
+    uint64_t    xp_hits;    /* Nr of cache hits of this entry */
+};
+
+/* Parsed xpaths indexed by xpath string */
+static clicon_hash_t  *_xpath_cache = NULL;
+
+/* Cache entries, most recently used first */
+static xpath_prepared *_xpath_lru = NULL;
+
+/* Nr of entries in cache, and max nr of entries */
+static int             _xpath_cache_nr = 0;
+static int             _xpath_cache_size = XPATH_CACHE_SIZE;
+
+/* Cache statistics */
+static uint64_t        _xpath_cache_hits = 0;
+static uint64_t        _xpath_cache_misses = 0;
+
 /* Mapping between xpath_tree node name string <--> int  
  * @see xpath_tree_int2str
  */
@@ -116,6 +153,7 @@ static const map_str2int xpath_tree_map[] = {
     {"primaryexpr nr",   XP_PRIME_NR},
     {"primaryexpr str",  XP_PRIME_STR},
     {"primaryexpr fn",   XP_PRIME_FN}, 
+    {"primaryexpr var",  XP_PRIME_VAR},
     {NULL,               -1}
 };
 
@@ -258,6 +296,9 @@ xpath_tree2cbuf(xpath_tree *xs,
     case XP_PRIME_NR:
 	cprintf(xcb, "%s", xs->xs_strnr?xs->xs_strnr:"0"); 
 	break;
+    case XP_PRIME_VAR:
+	cprintf(xcb, "$%s", xs->xs_s0);
+	break;
     case XP_STEP:
 	switch (xs->xs_int){
 	case A_SELF:
@@ -352,6 +393,10 @@ xpath_tree_eq(xpath_tree   *xt1, /* pattern */
 #if 1 /* special case that they are expressions but of different types */
 	&& !((xt1->xs_type == XP_PRIME_NR || xt1->xs_type == XP_PRIME_STR) &&
 	     (xt2->xs_type == XP_PRIME_NR || xt2->xs_type == XP_PRIME_STR))
+	/* and a variable matching a literal, its value is bound when evaluated */
+	&& !(xt1->xs_match &&
+	     (xt1->xs_type == XP_PRIME_NR || xt1->xs_type == XP_PRIME_STR) &&
+	     xt2->xs_type == XP_PRIME_VAR)
 #endif
 	){
 	clicon_debug(2, "%s type %s vs %s\n", __FUNCTION__,
@@ -460,7 +505,7 @@ xpath_tree_free(xpath_tree *xs)
     if (xs->xs_s0)
 	free(xs->xs_s0);
     if (xs->xs_s1)
-	free(xs->xs_s1);
+	xml_atom_put(xs->xs_s1);
     if (xs->xs_c0)
 	xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
@@ -528,9 +573,387 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+/*! Free a prepared xpath not in cache
+ */
+static int
+xpath_prepared_free1(xpath_prepared *xp)
+{
+    if (xp->xp_xpath)
+	free(xp->xp_xpath);
+    if (xp->xp_tree)
+	xpath_tree_free(xp->xp_tree);
+    free(xp);
+    return 0;
+}
+
+/*! Remove a prepared xpath from the cache, free it if it is not used
+ */
+static int
+xpath_cache_remove(xpath_prepared *xp)
+{
+    DELQ(xp, _xpath_lru, xpath_prepared *);
+    if (_xpath_cache)
+	clicon_hash_del(_xpath_cache, xp->xp_xpath);
+    xp->xp_cached = 0;
+    _xpath_cache_nr--;
+    if (xp->xp_refcnt == 0)
+	xpath_prepared_free1(xp);
+    return 0;
+}
+
+/*! Parse an xpath once and return a prepared xpath for evaluating it many times
+ *
+ * The parsed xpath is taken from the xpath cache if the same xpath string has been
+ * parsed before, otherwise it is parsed and added to the cache.
+ * Instead of formatting values into the xpath string, use variable references, eg 
+ * "a[k=$key]" and bind values when evaluating, which makes the xpath string, and
+ * thereby the cache entry, the same for all values.
+ * @param[in]  xpath  String with XPATH 1.0 syntax
+ * @param[out] xpp    Prepared xpath, free with xpath_prepared_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   xpath_prepared *xp = NULL;
+ *   cvec           *vars;  // eg key:"foo"
+ *   cxobj          *x;
+ *   if (xpath_prepare("a[k=$key]", &xp) < 0)
+ *     err;
+ *   x = xpath_prepared_first(xtop, nsc, xp, vars);
+ *   xpath_prepared_free(xp);
+ * @endcode
+ * @note The xpath tree is independent of namespace context, which is applied at
+ *       evaluation, so the xpath string is the cache key.
+ * @see xpath_cache_size_set
+ */
+int
+xpath_prepare(const char      *xpath,
+	      xpath_prepared **xpp)
+{
+    int             retval = -1;
+    xpath_prepared *xp = NULL;
+    xpath_prepared **xpv;
+    
+    if (xpath == NULL || xpp == NULL){
+	clicon_err(OE_XML, EINVAL, "xpath or xpp is NULL");
+	goto done;
+    }
+    if (_xpath_cache &&
+	(xpv = clicon_hash_value(_xpath_cache, xpath, NULL)) != NULL){
+	xp = *xpv;
+	_xpath_cache_hits++;
+	xp->xp_hits++;
+	if (xp != _xpath_lru){ /* Move first in LRU list */
+	    DELQ(xp, _xpath_lru, xpath_prepared *);
+	    INSQ(xp, _xpath_lru);
+	}
+	xp->xp_refcnt++;
+	*xpp = xp;
+	xp = NULL;
+	goto ok;
+    }
+    _xpath_cache_misses++;
+    if ((xp = malloc(sizeof(*xp))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xp, 0, sizeof(*xp));
+    if ((xp->xp_xpath = strdup(xpath)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (xpath_parse(xpath, &xp->xp_tree) < 0)
+	goto done;
+    if (_xpath_cache_size > 0){
+	if (_xpath_cache == NULL &&
+	    (_xpath_cache = clicon_hash_init()) == NULL)
+	    goto done;
+	if (clicon_hash_add(_xpath_cache, xpath, &xp, sizeof(xp)) == NULL)
+	    goto done;
+	INSQ(xp, _xpath_lru);
+	xp->xp_cached = 1;
+	/* Remove least recently used */
+	if (++_xpath_cache_nr > _xpath_cache_size)
+	    xpath_cache_remove(PREVQ(xpath_prepared *, _xpath_lru));
+    }
+    xp->xp_refcnt++;
+    *xpp = xp;
+    xp = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xp)
+	xpath_prepared_free1(xp);
+    return retval;
+}
+
+/*! Release a prepared xpath
+ * The parsed xpath remains in the cache until it is least recently used
+ * @param[in]  xp    Prepared xpath
+ * @see xpath_prepare
+ */
+int
+xpath_prepared_free(xpath_prepared *xp)
+{
+    if (xp == NULL)
+	return 0;
+    if (--xp->xp_refcnt == 0 && !xp->xp_cached)
+	xpath_prepared_free1(xp);
+    return 0;
+}
+
+/*! Get parsed xpath tree of a prepared xpath
+ * @param[in]  xp    Prepared xpath
+ * @retval     xpt   XPath tree, owned by xp, do not modify
+ */
+xpath_tree *
+xpath_prepared_tree(xpath_prepared *xp)
+{
+    return xp->xp_tree;
+}
+
+/*! Set max number of entries in the xpath cache
+ * @param[in]  size  Max nr of parsed xpaths, 0 disables the cache
+ * @retval     0     OK
+ * @see XPATH_CACHE_SIZE
+ */
+int
+xpath_cache_size_set(int size)
+{
+    _xpath_cache_size = size<0?0:size;
+    while (_xpath_cache_nr > _xpath_cache_size)
+	xpath_cache_remove(PREVQ(xpath_prepared *, _xpath_lru));
+    return 0;
+}
+
+/*! Get xpath cache statistics
+ * @param[out] hits    Nr of xpaths found in cache (or NULL)
+ * @param[out] misses  Nr of xpaths parsed (or NULL)
+ * @param[out] nr      Nr of entries in cache (or NULL)
+ * @retval     0       OK
+ */
+int
+xpath_cache_stats(uint64_t *hits,
+		  uint64_t *misses,
+		  int      *nr)
+{
+    if (hits)
+	*hits = _xpath_cache_hits;
+    if (misses)
+	*misses = _xpath_cache_misses;
+    if (nr)
+	*nr = _xpath_cache_nr;
+    return 0;
+}
+
+/*! Print xpath cache entries with hits, most recently used first
+ * @param[in]  f   UNIX output stream
+ */
+int
+xpath_cache_print(FILE *f)
+{
+    xpath_prepared *xp;
+    
+    fprintf(f, "xpath cache: %d entries, %" PRIu64 " hits, %" PRIu64 " misses\n",
+	    _xpath_cache_nr, _xpath_cache_hits, _xpath_cache_misses);
+    if ((xp = _xpath_lru) != NULL){
+	do {
+	    fprintf(f, "%8" PRIu64 " %s\n", xp->xp_hits, xp->xp_xpath);
+	    xp = NEXTQ(xpath_prepared *, xp);
+	} while (xp && xp != _xpath_lru);
+    }
+    return 0;
+}
+
+/*! Empty the xpath cache and free it
+ * Prepared xpaths in use are freed when released
+ */
+void
+xpath_cache_exit(void)
+{
+    if (clicon_debug_get() && _xpath_cache_hits + _xpath_cache_misses)
+	clicon_debug(1, "%s hits:%" PRIu64 " misses:%" PRIu64, __FUNCTION__,
+		     _xpath_cache_hits, _xpath_cache_misses);
+    while (_xpath_lru)
+	xpath_cache_remove(_xpath_lru);
+    if (_xpath_cache){
+	clicon_hash_free(_xpath_cache);
+	_xpath_cache = NULL;
+    }
+}
+
+/*! Given XML tree and prepared xpath, eval it with variable bindings
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xp     Prepared xpath
+ * @param[in]  vars   Variable bindings as name:value pairs, or NULL
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp    Return XPATH context
+ * @retval     0      OK
+ * @retval    -1      Error, eg unbound variable
+ * Boolean and numeric values of vars are used as xpath booleans and numbers,
+ * other types as strings.
+ * @see xpath_prepare
+ */
+int
+xpath_prepared_ctx(cxobj          *xcur,
+		   cvec           *nsc,
+		   xpath_prepared *xp,
+		   cvec           *vars,
+		   int             localonly,
+		   xp_ctx        **xrp)
+{
+    int   retval;
+    cvec *vars0;
+
+    vars0 = xp_eval_vars_set(vars);
+    retval = xpath_tree_ctx(xcur, nsc, xp->xp_tree, localonly, xrp);
+    xp_eval_vars_set(vars0);
+    return retval;
+}
+
+/*! Given XML tree and prepared xpath, returns nodeset as xml node vector
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xp     Prepared xpath
+ * @param[in]  vars   Variable bindings as name:value pairs, or NULL
+ * @param[out] vec    vector of xml-trees. Vector must be free():d after use
+ * @param[out] veclen returns length of vector in return value
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_vec
+ */
+int
+xpath_prepared_vec(cxobj          *xcur,
+		   cvec           *nsc,
+		   xpath_prepared *xp,
+		   cvec           *vars,
+		   cxobj        ***vec,
+		   size_t         *veclen)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+
+    *vec = NULL;
+    *veclen = 0;
+    if (xpath_prepared_ctx(xcur, nsc, xp, vars, 0, &xr) < 0)
+	goto done;
+    if (xr && xr->xc_type == XT_NODESET){
+	*vec    = xr->xc_nodeset;
+	xr->xc_nodeset = NULL;
+	*veclen = xr->xc_size;
+    }
+    retval = 0;
+ done:
+    if (xr)
+	ctx_free(xr);
+    return retval;
+}
+
+/*! Given XML tree and prepared xpath, return first matching node
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xp     Prepared xpath
+ * @param[in]  vars   Variable bindings as name:value pairs, or NULL
+ * @retval     xml-tree  XML tree of first match
+ * @retval     NULL      Error or not found
+ * @see xpath_first
+ */
+cxobj *
+xpath_prepared_first(cxobj          *xcur,
+		     cvec           *nsc,
+		     xpath_prepared *xp,
+		     cvec           *vars)
+{
+    cxobj  *cx = NULL;
+    xp_ctx *xr = NULL;
+
+    if (xpath_prepared_ctx(xcur, nsc, xp, vars, 0, &xr) < 0)
+	goto done;
+    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
+	cx = xr->xc_nodeset[0];
+ done:
+    if (xr)
+	ctx_free(xr);
+    return cx;
+}
+
+/*! Given XML tree and prepared xpath, returns boolean
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xp     Prepared xpath
+ * @param[in]  vars   Variable bindings as name:value pairs, or NULL
+ * @retval     1      True
+ * @retval     0      False
+ * @retval    -1      Error
+ * @see xpath_vec_bool
+ */
+int
+xpath_prepared_bool(cxobj          *xcur,
+		    cvec           *nsc,
+		    xpath_prepared *xp,
+		    cvec           *vars)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL;
+
+    if (xpath_prepared_ctx(xcur, nsc, xp, vars, 0, &xr) < 0)
+	goto done;
+    if (xr)
+	retval = ctx2boolean(xr);
+ done:
+    if (xr)
+	ctx_free(xr);
+    return retval;
+}
+
+/*! Format an xpath string from a format string and arguments
+ * Formats into buf if it fits, otherwise allocates the string. A format string
+ * without conversions is used as is.
+ * @param[in]  buf     Buffer
+ * @param[in]  buflen  Length of buffer
+ * @param[in]  xpformat Format string for XPATH syntax
+ * @param[in]  ap      Arguments
+ * @retval     xpath   Formatted xpath, free if not buf or xpformat
+ * @retval     NULL    Error
+ */
+static const char *
+xpath_format(char       *buf,
+	     size_t      buflen,
+	     const char *xpformat,
+	     va_list     ap)
+{
+    va_list ap1;
+    int     len;
+    char   *xpath;
+
+    if (strchr(xpformat, '%') == NULL)
+	return xpformat;
+    va_copy(ap1, ap);
+    len = vsnprintf(buf, buflen, xpformat, ap1);
+    va_end(ap1);
+    if (len < 0){
+	clicon_err(OE_UNIX, errno, "vsnprintf");
+	return NULL;
+    }
+    if (len < buflen)
+	return buf;
+    /* allocate an xpath string exactly fitting the length */
+    if ((xpath = malloc(len+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
+	clicon_err(OE_UNIX, errno, "vsnprintf");
+	free(xpath);
+	return NULL;
+    }
+    return xpath;
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  * This is a raw form of xpath where you can do type conversion of the return
  * value, etc, not just a nodeset.
+ * The parsed xpath is taken from, or added to, the xpath cache.
  * @param[in]  xcur   XML-tree where to search
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH 1.0 syntax
@@ -552,13 +975,43 @@ xpath_vec_ctx(cxobj      *xcur,
 	      const char *xpath,
 	      int         localonly,
 	      xp_ctx    **xrp)
+{
+    int             retval = -1;
+    xpath_prepared *xp = NULL;
+    
+    if (xpath_prepare(xpath, &xp) < 0)
+	goto done;
+    if (xpath_prepared_ctx(xcur, nsc, xp, NULL, localonly, xrp) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (xp)
+	xpath_prepared_free(xp);
+    return retval;
+}
+
+/*! Given XML tree and parsed xpath, eval it and return xpath context
+ * Same as xpath_vec_ctx but with an xpath parsed with xpath_parse, for
+ * evaluating the same xpath many times.
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xptree Parsed xpath
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp    Return XPATH context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_vec_ctx
+ */
+int
+xpath_tree_ctx(cxobj      *xcur, 
+	       cvec       *nsc,
+	       xpath_tree *xptree,
+	       int         localonly,
+	       xp_ctx    **xrp)
 {
     int         retval = -1;
-    xpath_tree *xptree = NULL;
     xp_ctx      xc = {0,};
     
-    if (xpath_parse(xpath, &xptree) < 0)
-	goto done;
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
@@ -566,14 +1019,10 @@ xpath_vec_ctx(cxobj      *xcur,
 	goto done;
     if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
 	goto done;
-    if (xc.xc_nodeset){
-	free(xc.xc_nodeset);
-	xc.xc_nodeset = NULL;
-    }
     retval = 0;
  done:
-    if (xptree)
-	xpath_tree_free(xptree);
+    if (xc.xc_nodeset)
+	free(xc.xc_nodeset);
     return retval;
 }
 
@@ -604,26 +1053,15 @@ xpath_first(cxobj      *xcur,
 {
     cxobj     *cx = NULL;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    char       buf[XPATH_FORMAT_BUFLEN];
+    const char *xpath = NULL;
     xp_ctx    *xr = NULL;
     
-    va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, xpformat);
+    xpath = xpath_format(buf, sizeof(buf), xpformat, ap);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
-	goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-	clicon_err(OE_UNIX, errno, "vsnprintf");
-	va_end(ap);
+    if (xpath == NULL)
 	goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
 	goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
@@ -631,8 +1069,8 @@ xpath_first(cxobj      *xcur,
  done:
     if (xr)
 	ctx_free(xr);
-    if (xpath)
-	free(xpath);
+    if (xpath && xpath != buf && xpath != xpformat)
+	free((char*)xpath);
     return cx;
 }
 
@@ -663,26 +1101,15 @@ xpath_first_localonly(cxobj      *xcur,
 {
     cxobj     *cx = NULL;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    char       buf[XPATH_FORMAT_BUFLEN];
+    const char *xpath = NULL;
     xp_ctx    *xr = NULL;
     
-    va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, xpformat);
+    xpath = xpath_format(buf, sizeof(buf), xpformat, ap);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if (xpath == NULL)
 	goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-	clicon_err(OE_UNIX, errno, "vsnprintf");
-	va_end(ap);
-	goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
 	goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
@@ -690,8 +1117,8 @@ xpath_first_localonly(cxobj      *xcur,
  done:
     if (xr)
 	ctx_free(xr);
-    if (xpath)
-	free(xpath);
+    if (xpath && xpath != buf && xpath != xpformat)
+	free((char*)xpath);
     return cx;
 }
 
@@ -727,26 +1154,15 @@ xpath_vec(cxobj      *xcur,
 {
     int        retval = -1;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    char       buf[XPATH_FORMAT_BUFLEN];
+    const char *xpath = NULL;
     xp_ctx    *xr = NULL; 
 	
-    va_start(ap, veclen);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, veclen);
+    xpath = xpath_format(buf, sizeof(buf), xpformat, ap);
     va_end(ap);
-    /* allocate an xpath string exactly fitting the length */
-    if ((xpath = malloc(len+1)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if (xpath == NULL)
 	goto done;
-    }
-    /* second round: actually compute xpath string content */
-    va_start(ap, veclen);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-	clicon_err(OE_UNIX, errno, "vsnprintf");
-	va_end(ap);
-	goto done;
-    }
-    va_end(ap);
     *vec=NULL;
     *veclen = 0;
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
@@ -760,8 +1176,8 @@ xpath_vec(cxobj      *xcur,
  done:
     if (xr)
 	ctx_free(xr);
-    if (xpath)
-	free(xpath);
+    if (xpath && xpath != buf && xpath != xpformat)
+	free((char*)xpath);
     return retval;
 }
 
@@ -800,28 +1216,17 @@ xpath_vec_flag(cxobj      *xcur,
 {
     int        retval = -1;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    char       buf[XPATH_FORMAT_BUFLEN];
+    const char *xpath = NULL;
     xp_ctx    *xr = NULL;
     int        i;
     cxobj     *x;
     
-    va_start(ap, veclen);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, veclen);
+    xpath = xpath_format(buf, sizeof(buf), xpformat, ap);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
-	goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, veclen);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-	clicon_err(OE_UNIX, errno, "vsnprintf");
-	va_end(ap);
+    if (xpath == NULL)
 	goto done;
-    }
-    va_end(ap);
     *vec=NULL;
     *veclen = 0;
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
@@ -838,8 +1243,8 @@ xpath_vec_flag(cxobj      *xcur,
  done:
     if (xr)
 	ctx_free(xr);
-    if (xpath)
-	free(xpath);
+    if (xpath && xpath != buf && xpath != xpformat)
+	free((char*)xpath);
     return retval;
 }
 
@@ -860,26 +1265,15 @@ xpath_vec_bool(cxobj      *xcur,
 {
     int        retval = -1;
     va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
+    char       buf[XPATH_FORMAT_BUFLEN];
+    const char *xpath = NULL;
     xp_ctx    *xr = NULL;
     
-    va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    va_start(ap, xpformat);
+    xpath = xpath_format(buf, sizeof(buf), xpformat, ap);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if (xpath == NULL)
 	goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-	clicon_err(OE_UNIX, errno, "vsnprintf");
-	va_end(ap);
-	goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
 	goto done;
     if (xr)
@@ -887,8 +1281,8 @@ xpath_vec_bool(cxobj      *xcur,
  done:
     if (xr)
 	ctx_free(xr);
-    if (xpath)
-	free(xpath);
+    if (xpath && xpath != buf && xpath != xpformat)
+	free((char*)xpath);
     return retval;
 }
 
@@ -109,6 +109,12 @@ const map_str2int xpopmap[] = {
     {NULL,               -1}
 };
 
+/* Variable bindings of the xpath being evaluated, as name:value pairs.
+ * Set by prepared xpath evaluation, referenced in xpaths as $name.
+ * @see xp_eval_vars_set
+ */
+static cvec *_xp_vars = NULL;
+
 /*! Eval an XPATH nodetest
  * @retval   -1     Error  XXX: retval -1 not properly handled 
  * @retval    0     No match  
@@ -130,16 +136,17 @@ nodetest_eval_node(cxobj      *x,
     /* Namespaces is s0, name is s1 */
     if (strcmp(xs->xs_s1, "*")==0)
 	return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-	goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+    /* Before going into namespaces, check name equality and filter out noteq
+     * Both names are interned, see xml_atom_get */
+    if (name1 != name2){
 	retval = 0; /* no match */
 	goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+	goto done;
     /* here names are equal 
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -190,8 +197,9 @@ nodetest_eval_node_localonly(cxobj      *x,
     if (strcmp(xs->xs_s1, "*")==0)
 	return 1;
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+    /* Before going into namespaces, check name equality and filter out noteq
+     * Both names are interned, see xml_atom_get */
+    if (name1 != name2){
 	retval = 0; /* no match */
 	goto done;
     }
@@ -910,6 +918,90 @@ xp_union(xp_ctx    *xc1,
     return retval;
 }
 
+/*! Set variable bindings for subsequent xpath evaluations
+ * @param[in]  vars  Vector of name:value pairs, or NULL for no bindings
+ * @retval     vars  Previous bindings, to be restored by the caller
+ * @note Not reentrant between threads, same as xpath optimize
+ */
+cvec *
+xp_eval_vars_set(cvec *vars)
+{
+    cvec *old = _xp_vars;
+
+    _xp_vars = vars;
+    return old;
+}
+
+/*! Get variable bindings of the xpath being evaluated
+ * @retval  vars  Vector of name:value pairs, or NULL if no bindings
+ * @see xp_eval_vars_set
+ */
+cvec *
+xp_eval_vars_get(void)
+{
+    return _xp_vars;
+}
+
+/*! Evaluate a variable reference using the current bindings
+ * Booleans and numeric values keep their types, all others are strings
+ * @param[in]  xc   Incoming context
+ * @param[in]  name Variable name (without $)
+ * @param[out] xrp  Resulting context
+ * @retval     0    OK
+ * @retval    -1    Error, including unbound variable
+ */
+static int
+xp_eval_var(xp_ctx  *xc,
+	    char    *name,
+	    xp_ctx **xrp)
+{
+    int          retval = -1;
+    xp_ctx      *xr = NULL;
+    cg_var      *cv;
+    enum cv_type type;
+    char        *str = NULL;
+
+    if (_xp_vars == NULL || (cv = cvec_find(_xp_vars, name)) == NULL){
+	clicon_err(OE_XML, ENOENT, "XPath variable $%s is not bound", name);
+	goto done;
+    }
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xc->xc_initial;
+    type = cv_type_get(cv);
+    if (type == CGV_BOOL){
+	xr->xc_type = XT_BOOL;
+	xr->xc_bool = cv_bool_get(cv);
+    }
+    else {
+	if ((str = cv2str_dup(cv)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	if (cv_isint(type) || type == CGV_DEC64){
+	    xr->xc_type = XT_NUMBER;
+	    xr->xc_number = strtod(str, NULL);
+	}
+	else{
+	    xr->xc_type = XT_STRING;
+	    xr->xc_string = str;
+	    str = NULL;
+	}
+    }
+    *xrp = xr;
+    xr = NULL;
+    retval = 0;
+ done:
+    if (str)
+	free(str);
+    if (xr)
+	ctx_free(xr);
+    return retval;
+}
+
 /*! Evaluate an XPATH on an XML tree
 
  * The initial sequence of steps selects a set of nodes relative to a context node. 
@@ -1097,6 +1189,10 @@ xp_eval(xp_ctx     *xc,
 	xr0->xc_type = XT_STRING;
 	xr0->xc_string = xs->xs_s0?strdup(xs->xs_s0):NULL;
 	break;
+    case XP_PRIME_VAR:
+	if (xp_eval_var(xc, xs->xs_s0, &xr0) < 0)
+	    goto done;
+	break;
     default:
 	break;
     }
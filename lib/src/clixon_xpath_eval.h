@@ -45,6 +45,8 @@ extern const map_str2int xpopmap[];
 /*
  * Prototypes
  */
+cvec *xp_eval_vars_set(cvec *vars);
+cvec *xp_eval_vars_get(void);
 int xp_eval(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 
 #endif /* _CLIXON_XPATH_EVAL_H */
@@ -68,6 +68,7 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_eval.h"
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
@@ -178,6 +179,9 @@ loop_preds(xpath_tree *xt,
     xpath_tree **vec = NULL;
     size_t       veclen = 0;
     cg_var      *cvi;
+    cvec        *vars;
+    cg_var      *cv;
+    char        *str;
 	
     if (xt->xs_type == XP_PRED && xt->xs_c0){
 	if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
@@ -197,7 +201,19 @@ loop_preds(xpath_tree *xt,
 	    goto done;
 	}
 	cv_name_set(cvi, vec[0]->xs_s1);
-	if (vec[1]->xs_type == XP_PRIME_NR)
+	if (vec[1]->xs_type == XP_PRIME_VAR){
+	    /* Value bound to variable, if unbound evaluation reports it */
+	    if ((vars = xp_eval_vars_get()) == NULL ||
+		(cv = cvec_find(vars, vec[1]->xs_s0)) == NULL)
+		goto ok;
+	    if ((str = cv2str_dup(cv)) == NULL){
+		clicon_err(OE_UNIX, errno, "cv2str_dup");
+		goto done;
+	    }
+	    cv_string_set(cvi, str);
+	    free(str);
+	}
+	else if (vec[1]->xs_type == XP_PRIME_NR)
 	    cv_string_set(cvi, vec[1]->xs_strnr);
 	else
 	    cv_string_set(cvi, vec[1]->xs_s0);
@@ -63,6 +63,7 @@
 %token <string> DOUBLEDOT
 %token <string> DOUBLESLASH
 %token <string> FUNCTIONNAME
+%token <string> VARREF
 
 %type <intval>    axisspec
 
@@ -120,6 +121,7 @@
 #include "clixon_handle.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_atom.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_function.h"
@@ -196,7 +198,11 @@ xp_new(enum xp_type  type,
     else
 	xs->xs_double = 0.0;
     xs->xs_s0  = s0;
-    xs->xs_s1  = s1;
+    if (s1){ /* Node names are interned to be compared with XML names by pointer */
+	if ((xs->xs_s1 = xml_atom_get(s1)) == NULL)
+	    goto done;
+	free(s1);
+    }
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
  done:
@@ -440,6 +446,7 @@ primaryexpr : '(' expr ')'         { $$=xp_new(XP_PRI0,A_NAN,NULL, NULL, NULL, $
             | QUOTE QUOTE          { $$=xp_new(XP_PRIME_STR,A_NAN,NULL, NULL, NULL, NULL, NULL);clicon_debug(3,"primaryexpr-> \" \""); } 
             | APOST string APOST   { $$=xp_new(XP_PRIME_STR,A_NAN,NULL, $2, NULL, NULL, NULL);clicon_debug(3,"primaryexpr-> ' string '"); }
             | APOST APOST          { $$=xp_new(XP_PRIME_STR,A_NAN,NULL, NULL, NULL, NULL, NULL);clicon_debug(3,"primaryexpr-> ' '"); } 
+            | VARREF               { $$=xp_new(XP_PRIME_VAR,A_NAN,NULL, $1, NULL, NULL, NULL);clicon_debug(3,"primaryexpr-> $%s", $1); }
             | FUNCTIONNAME ')'      { if (($$ = xp_primary_function(_XPY, $1, NULL)) == NULL) YYERROR; clicon_debug(3,"primaryexpr-> functionname ()"); }
             | FUNCTIONNAME args ')' { if (($$ = xp_primary_function(_XPY, $1, $2)) == NULL) YYERROR;  clicon_debug(3,"primaryexpr-> functionname (arguments)"); } 
             ;
@@ -243,6 +243,7 @@ yang_argument_set(yang_stmt *ys,
 		  char      *arg)
 {
     ys->ys_argument = arg; /* not strdup/copied */
+    yang_index_invalidate(ys->ys_parent);
     return 0;
 }
 
@@ -443,6 +444,262 @@ ys_new(enum rfc_6020 keyw)
     return ys;
 }
 
+/*
+ * Child lookup index
+ * A yang node with many children gets a lazily built open-addressing hash
+ * table mapping (keyword, argument) to the first matching child. Two pseudo 
+ * keywords index the data and schema nodes reachable through choice/case as
+ * used by yang_find_datanode and yang_find_schemanode.
+ * The index is dropped when the children of a node change, and since choice
+ * and case nodes are part of the index of their parent, so is the index of 
+ * the closest ancestor that is not a choice or case.
+ */
+#define YANG_INDEX_MIN        8   /* Only index nodes with at least this many children */
+#define YANG_INDEX_DATANODE  -1   /* Pseudo keyword: yang_find_datanode */
+#define YANG_INDEX_SCHEMANODE -2  /* Pseudo keyword: yang_find_schemanode */
+
+struct yang_index_entry{
+    uint64_t   ye_hash;     /* Hash of keyword and argument */
+    int        ye_keyword;  /* Keyword or pseudo keyword */
+    yang_stmt *ye_ys;       /* Child (or choice/case descendant), NULL if empty */
+};
+
+struct yang_index{
+    size_t                   yi_size; /* Table size, power of two */
+    size_t                   yi_nr;   /* Number of entries */
+    struct yang_index_entry *yi_vec;  /* Table */
+};
+
+static int _yang_index_enable = 1;
+
+/*! Enable or disable yang child lookup index
+ * @param[in] enable  0: Linear search of children, 1: use index on large nodes
+ * Mainly for benchmarking, see clixon_util_yang
+ */
+int
+yang_index_enable(int enable)
+{
+    _yang_index_enable = enable;
+    return 0;
+}
+
+/*! Hash of keyword and argument
+ */
+static uint64_t
+yang_index_hash(int         keyword,
+		const char *argument)
+{
+    return clicon_hash_string(argument) ^ ((uint64_t)(keyword + 3) * 0x9E3779B97F4A7C15ULL);
+}
+
+/*! Find index slot of keyword and argument, or the empty slot where it should be
+ */
+static struct yang_index_entry *
+yang_index_slot(struct yang_index *yi,
+		uint64_t           hash,
+		int                keyword,
+		const char        *argument)
+{
+    size_t                   mask = yi->yi_size - 1;
+    size_t                   i;
+    struct yang_index_entry *ye;
+
+    for (i = hash & mask; ; i = (i+1) & mask){
+	ye = &yi->yi_vec[i];
+	if (ye->ye_ys == NULL)
+	    break;
+	if (ye->ye_hash == hash &&
+	    ye->ye_keyword == keyword &&
+	    strcmp(ye->ye_ys->ys_argument, argument) == 0)
+	    break;
+    }
+    return ye;
+}
+
+/*! Add an entry to index unless there already is one: the first match wins
+ * @param[in] yi       Index
+ * @param[in] keyword  Keyword or pseudo keyword
+ * @param[in] ys       Yang statement with non-NULL argument
+ * @retval    0        OK
+ * @retval   -1        Error
+ */
+static int
+yang_index_add(struct yang_index *yi,
+	       int                keyword,
+	       yang_stmt         *ys)
+{
+    uint64_t                 hash;
+    struct yang_index_entry *ye;
+    struct yang_index_entry *vec0;
+    size_t                   size0;
+    size_t                   i;
+
+    if (ys->ys_argument == NULL)
+	return 0;
+    if ((yi->yi_nr+1)*4 > yi->yi_size*3){ /* Grow at 3/4 */
+	vec0 = yi->yi_vec;
+	size0 = yi->yi_size;
+	yi->yi_size = size0?size0*2:16;
+	if ((yi->yi_vec = calloc(yi->yi_size, sizeof(*ye))) == NULL){
+	    clicon_err(OE_YANG, errno, "calloc");
+	    yi->yi_vec = vec0;
+	    yi->yi_size = size0;
+	    return -1;
+	}
+	for (i=0; i<size0; i++){
+	    if (vec0[i].ye_ys == NULL)
+		continue;
+	    ye = yang_index_slot(yi, vec0[i].ye_hash, vec0[i].ye_keyword,
+				 vec0[i].ye_ys->ys_argument);
+	    *ye = vec0[i];
+	}
+	if (vec0)
+	    free(vec0);
+    }
+    hash = yang_index_hash(keyword, ys->ys_argument);
+    ye = yang_index_slot(yi, hash, keyword, ys->ys_argument);
+    if (ye->ye_ys == NULL){
+	ye->ye_hash = hash;
+	ye->ye_keyword = keyword;
+	ye->ye_ys = ys;
+	yi->yi_nr++;
+    }
+    return 0;
+}
+
+/*! Add data or schema nodes of yn to index in the same order as yang_find_datanode
+ * @param[in] yi      Index
+ * @param[in] yn      Yang node, or choice/case below the indexed node
+ * @param[in] schema  0: data nodes (YANG_INDEX_DATANODE), 1: schema nodes
+ */
+static int
+yang_index_add_nodes(struct yang_index *yi,
+		     yang_stmt         *yn,
+		     int                schema)
+{
+    int        i;
+    int        j;
+    yang_stmt *ys;
+    yang_stmt *yc;
+    int        keyword = schema?YANG_INDEX_SCHEMANODE:YANG_INDEX_DATANODE;
+
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE){
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yc->ys_keyword == Y_CASE){
+		    if (yang_index_add_nodes(yi, yc, schema) < 0)
+			return -1;
+		}
+		else if (schema?yang_schemanode(yc):yang_datanode(yc)){
+		    if (yang_index_add(yi, keyword, yc) < 0)
+			return -1;
+		}
+	    }
+	}
+	else if (schema?yang_schemanode(ys):yang_datanode(ys)){
+	    if (yang_index_add(yi, keyword, ys) < 0)
+		return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Add a new last child to an existing index
+ */
+static int
+yang_index_add_child(struct yang_index *yi,
+		     yang_stmt         *yc)
+{
+    if (yang_index_add(yi, yc->ys_keyword, yc) < 0)
+	return -1;
+    if (yang_datanode(yc) && yang_index_add(yi, YANG_INDEX_DATANODE, yc) < 0)
+	return -1;
+    if (yang_schemanode(yc) && yang_index_add(yi, YANG_INDEX_SCHEMANODE, yc) < 0)
+	return -1;
+    return 0;
+}
+
+static void
+yang_index_free(struct yang_index *yi)
+{
+    if (yi->yi_vec)
+	free(yi->yi_vec);
+    free(yi);
+}
+
+/*! Get child index of yang node, build it if it does not exist
+ * @param[in]  yn  Yang node
+ * @retval     yi  Index
+ * @retval     NULL Node too small to be indexed, index disabled, or error
+ * On error, callers fall back to linear search
+ */
+static struct yang_index *
+yang_index_get(yang_stmt *yn)
+{
+    struct yang_index *yi;
+    int                i;
+
+    if (yn->ys_index != NULL)
+	return yn->ys_index;
+    if (!_yang_index_enable || yn->ys_len < YANG_INDEX_MIN)
+	return NULL;
+    if ((yi = malloc(sizeof(*yi))) == NULL){
+	clicon_err(OE_YANG, errno, "malloc");
+	return NULL;
+    }
+    memset(yi, 0, sizeof(*yi));
+    for (i=0; i<yn->ys_len; i++)
+	if (yang_index_add(yi, yn->ys_stmt[i]->ys_keyword, yn->ys_stmt[i]) < 0)
+	    goto err;
+    if (yang_index_add_nodes(yi, yn, 0) < 0 ||
+	yang_index_add_nodes(yi, yn, 1) < 0)
+	goto err;
+    yn->ys_index = yi;
+    return yi;
+ err:
+    yang_index_free(yi);
+    return NULL;
+}
+
+/*! Look up keyword (or pseudo keyword) and argument in index
+ * @param[in]  yi       Index
+ * @param[in]  keyword  Keyword or pseudo keyword
+ * @param[in]  argument Argument
+ * @retval     ys       First matching yang statement
+ * @retval     NULL     Not found
+ */
+static yang_stmt *
+yang_index_find(struct yang_index *yi,
+		int                keyword,
+		const char        *argument)
+{
+    return yang_index_slot(yi, yang_index_hash(keyword, argument),
+			   keyword, argument)->ye_ys;
+}
+
+/*! Drop child index of yang node since its children have changed
+ * Also drop the index of choice/case ancestors up to and including the first 
+ * node which is not a choice or case, since they index through choice/case.
+ * @param[in]  ys   Yang node whose children (or their arguments) changed
+ * @retval     0    OK
+ */
+int
+yang_index_invalidate(yang_stmt *ys)
+{
+    while (ys != NULL){
+	if (ys->ys_index){
+	    yang_index_free(ys->ys_index);
+	    ys->ys_index = NULL;
+	}
+	if (ys->ys_keyword != Y_CHOICE && ys->ys_keyword != Y_CASE)
+	    break;
+	ys = ys->ys_parent;
+    }
+    return 0;
+}
+
 /*! Free a single yang statement, dont remove children
  * 
  * @param[in]  ys   Yang node to remove 
@@ -475,6 +732,10 @@ ys_free1(yang_stmt *ys,
 	free(ys->ys_when_xpath);
     if (ys->ys_when_nsc)
 	cvec_free(ys->ys_when_nsc);
+    if (ys->ys_index){
+	yang_index_free(ys->ys_index);
+	ys->ys_index = NULL;
+    }
     if (self)
 	free(ys);
     return 0;
@@ -503,6 +764,7 @@ ys_prune(yang_stmt *yp,
 	    &yp->ys_stmt[i+1],
 	    size);
     yp->ys_stmt[yp->ys_len--] = NULL;
+    yang_index_invalidate(yp);
  done:
     return yc;
 }
@@ -542,6 +804,8 @@ yspec_free(yang_stmt *yspec)
     }
     if (yspec->ys_stmt)
 	free(yspec->ys_stmt);
+    if (yspec->ys_index)
+	yang_index_free(yspec->ys_index);
     free(yspec);
     return 0;
 }
@@ -583,6 +847,7 @@ ys_cp(yang_stmt *ynew,
 
     memcpy(ynew, yold, sizeof(*yold)); 
     ynew->ys_parent = NULL;
+    ynew->ys_index = NULL;
     if (yold->ys_stmt)
 	if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
 	    clicon_err(OE_YANG, errno, "calloc");
@@ -695,6 +960,7 @@ ys_replace(yang_stmt *yorig,
     if (ys_cp(yorig, yfrom) < 0)
 	goto done;
     yorig->ys_parent = yp;
+    yang_index_invalidate(yp);
     retval = 0;
  done:
     return retval;
@@ -718,6 +984,15 @@ yn_insert(yang_stmt *ys_parent,
 	return -1;
     ys_parent->ys_stmt[pos] = ys_child;
     ys_child->ys_parent = ys_parent;
+    if (ys_parent->ys_index){
+	/* A choice child adds its descendants: rebuild, otherwise append */
+	if (ys_parent->ys_keyword == Y_CHOICE || ys_parent->ys_keyword == Y_CASE ||
+	    ys_child->ys_keyword == Y_CHOICE ||
+	    yang_index_add_child(ys_parent->ys_index, ys_child) < 0)
+	    yang_index_invalidate(ys_parent);
+    }
+    else if (ys_parent->ys_keyword == Y_CHOICE || ys_parent->ys_keyword == Y_CASE)
+	yang_index_invalidate(ys_parent);
     return 0;
 }
 
@@ -779,8 +1054,11 @@ yang_find(yang_stmt  *yn,
     char      *name;
     yang_stmt *yspec;
     yang_stmt *ym;
+    struct yang_index *yi;
 
-    for (i=0; i<yn->ys_len; i++){
+    if (keyword != 0 && argument != NULL && (yi = yang_index_get(yn)) != NULL)
+	yret = yang_index_find(yi, keyword, argument);
+    else for (i=0; i<yn->ys_len; i++){
 	ys = yn->ys_stmt[i];
 	if (keyword == 0 || ys->ys_keyword == keyword){
 	    if (argument == NULL ||
@@ -858,7 +1136,12 @@ yang_find_datanode(yang_stmt *yn,
     yang_stmt *yspec;
     yang_stmt *ysmatch = NULL;
     char      *name;
+    struct yang_index *yi;
 
+    if (argument != NULL && (yi = yang_index_get(yn)) != NULL){
+	ysmatch = yang_index_find(yi, YANG_INDEX_DATANODE, argument);
+	goto include;
+    }
     ys = NULL;
     while ((ys = yn_each(yn, ys)) != NULL){
 	if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -890,6 +1173,7 @@ yang_find_datanode(yang_stmt *yn,
 	    }
 	}
     }
+ include:
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
     if (ysmatch == NULL &&
@@ -926,7 +1210,12 @@ yang_find_schemanode(yang_stmt *yn,
     yang_stmt *ysmatch = NULL;
     char      *name;
     int        i, j;
+    struct yang_index *yi;
 
+    if (argument != NULL && (yi = yang_index_get(yn)) != NULL){
+	ysmatch = yang_index_find(yi, YANG_INDEX_SCHEMANODE, argument);
+	goto include;
+    }
     for (i=0; i<yn->ys_len; i++){
 	ys = yn->ys_stmt[i];
 	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
@@ -957,6 +1246,7 @@ yang_find_schemanode(yang_stmt *yn,
 		    goto match;
 	    }
     }
+ include:
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
     if (ysmatch == NULL &&
@@ -2427,6 +2717,7 @@ yang_features(clicon_handle h,
 		    yt->ys_stmt[j-1] = yt->ys_stmt[j];
 		yt->ys_len--;
 		yt->ys_stmt[yt->ys_len] = NULL;
+		yang_index_invalidate(yt);
 		ys_free(ys);
 		continue; /* Don't increment i */
 		break;
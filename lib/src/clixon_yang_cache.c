@@ -0,0 +1,990 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+ * Binary yang cache, see CLICON_YANG_CACHE_DIR
+ * Parsing, resolving and expanding all yang modules of an application is 
+ * done on every start, which with large module sets takes seconds, and is
+ * paid by each short-lived clixon_netconf session.
+ * Instead, the resulting yang tree (after grouping expansion, augments, type
+ * resolution and populate) is written to <dir>/<name>.ycache, and read back 
+ * by the next start as long as its fingerprint matches. The fingerprint is a
+ * hash of the clixon version, all options, and the inode/mtime/size of the main
+ * yang file and of all .yang files in the yang directories. Any change in
+ * those and the cache is silently rebuilt.
+ * File format (native byte order, the cache is local to a host):
+ *   header: magic, version, number of nodes, fingerprint, payload length
+ *   nodes in pre-order: keyword, flags, children, argument, module reference,
+ *                       when-xpath/nsc, cv, cvec, type cache
+ * References to other nodes (ys_mymodule, resolved type) are stored as pre-order
+ * node numbers. Compiled regexps are not stored; they are compiled on first use
+ * as after a regular parse.
+ * The cache is not used if a plugin has a yang extension callback, since such
+ * a callback may need to be invoked or may alter the tree.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+#include <dirent.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_log.h"
+#include "clixon_err.h"
+#include "clixon_file.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_io.h"
+#include "clixon_yang_module.h"
+#include "clixon_yang_parse_lib.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_plugin.h"
+#include "clixon_yang_cache.h"
+#include "clixon_yang_internal.h" /* cache reads and writes yang internals */
+
+#define YANG_CACHE_MAGIC   "CLIXONYC"
+#define YANG_CACHE_VERSION 1
+#define YANG_CACHE_NULL    0xffffffff /* NULL string or cvec, no node reference */
+
+/* Cache file header */
+struct ycache_hdr{
+    char     yh_magic[8];
+    uint32_t yh_version;
+    uint32_t yh_nodes;       /* Number of yang nodes (yspec not included) */
+    uint64_t yh_fingerprint; /* See yang_cache_fingerprint */
+    uint64_t yh_len;         /* Length of node data following the header */
+};
+
+/* Cache reader, bounds checked on each read */
+struct ycache_rd{
+    const uint8_t *yr_p;
+    const uint8_t *yr_end;
+    int            yr_err;   /* Set on read beyond end */
+};
+
+/* Node pointer to pre-order number, sorted on pointer for bsearch */
+struct ycache_ref{
+    yang_stmt *yf_ys;
+    uint32_t   yf_nr;
+};
+
+/*! Add identity of a file to fingerprint buffer
+ */
+static void
+yang_cache_stat(cbuf       *cb,
+		const char *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) < 0)
+	cprintf(cb, "%s -\n", path);
+    else
+	cprintf(cb, "%s %lu %ld.%09ld %lld\n", path,
+		(unsigned long)st.st_ino,
+		(long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec,
+		(long long)st.st_size);
+}
+
+/*! Add identity of a directory and all yang files in it to fingerprint buffer
+ */
+static int
+yang_cache_stat_dir(cbuf       *cb,
+		    const char *dir)
+{
+    int            retval = -1;
+    struct dirent *dp = NULL;
+    int            ndp;
+    int            i;
+    struct stat    st;
+    char           filename[MAXPATHLEN];
+
+    yang_cache_stat(cb, dir);
+    if (stat(dir, &st) < 0 || !S_ISDIR(st.st_mode))
+	goto ok;
+    if ((ndp = clicon_file_dirent(dir, &dp, "(.yang)$", S_IFREG)) < 0)
+	goto done;
+    for (i=0; i<ndp; i++){
+	snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+	yang_cache_stat(cb, filename);
+    }
+ ok:
+    retval = 0;
+ done:
+    if (dp)
+	free(dp);
+    return retval;
+}
+
+static int
+yang_cache_strcmp(const void *a,
+		  const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/*! Compute fingerprint of everything the yang tree of an application depends on
+ * @param[in]  h    Clicon handle
+ * @param[out] fp   Fingerprint
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+yang_cache_fingerprint(clicon_handle h,
+		       uint64_t     *fp)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    char  **keys = NULL;
+    size_t  nkeys = 0;
+    size_t  i;
+    cxobj  *x;
+    cxobj  *xc;
+    char   *str;
+    clixon_plugin *cp = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s %d %zu\n", CLIXON_VERSION_STRING, YANG_CACHE_VERSION, sizeof(yang_stmt));
+    /* All options, sorted since hash order is not part of the key */
+    if (clicon_hash_keys(clicon_options(h), &keys, &nkeys) < 0)
+	goto done;
+    if (nkeys)
+	qsort(keys, nkeys, sizeof(*keys), yang_cache_strcmp);
+    for (i=0; i<nkeys; i++)
+	cprintf(cb, "%s=%s\n", keys[i], (str = clicon_option_str(h, keys[i]))?str:"");
+    /* Config file, leaf-lists such as CLICON_YANG_DIR and CLICON_FEATURE */
+    if ((x = clicon_conf_xml(h)) != NULL){
+	if (clicon_xml2cbuf(cb, x, 0, 0, -1) < 0)
+	    goto done;
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	    if (strcmp(xml_name(xc), "CLICON_YANG_DIR") == 0 &&
+		(str = xml_body(xc)) != NULL &&
+		yang_cache_stat_dir(cb, str) < 0)
+		goto done;
+	}
+    }
+    if ((str = clicon_yang_main_dir(h)) != NULL &&
+	yang_cache_stat_dir(cb, str) < 0)
+	goto done;
+    if ((str = clicon_yang_main_file(h)) != NULL)
+	yang_cache_stat(cb, str);
+    /* Pseudo plugins with extension callbacks, see yang_cache_file */
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_extension != NULL && cp->cp_handle == NULL)
+	    cprintf(cb, "plugin %s\n", cp->cp_name);
+    *fp = clicon_hash_string(cbuf_get(cb));
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if the cache is used: option set and no plugin with extension callback
+ * Pseudo plugins, ie built into the application and not loaded with dlopen, are
+ * exempt: their extension callbacks only modify the yang tree, which is what the
+ * cache stores. They are part of the fingerprint instead.
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Application name
+ * @retval     path  Malloced cache filename
+ * @retval     NULL  Cache not used (or error)
+ */
+static char *
+yang_cache_file(clicon_handle h,
+		const char   *name)
+{
+    char          *dir;
+    char          *path;
+    clixon_plugin *cp = NULL;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+	return NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_extension != NULL && cp->cp_handle != NULL){
+	    clicon_debug(1, "%s: plugin %s has extension callback, no yang cache",
+			 __FUNCTION__, cp->cp_name);
+	    return NULL;
+	}
+    if ((path = malloc(strlen(dir) + strlen(name) + 9)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    sprintf(path, "%s/%s.ycache", dir, name);
+    return path;
+}
+
+/*
+ * Write
+ */
+static void
+ycw_u32(FILE    *f,
+	uint32_t u)
+{
+    fwrite(&u, sizeof(u), 1, f);
+}
+
+static void
+ycw_str(FILE       *f,
+	const char *str)
+{
+    uint32_t len;
+
+    if (str == NULL)
+	ycw_u32(f, YANG_CACHE_NULL);
+    else{
+	len = strlen(str);
+	ycw_u32(f, len);
+	fwrite(str, 1, len, f);
+    }
+}
+
+static int
+ycw_cv(FILE   *f,
+       cg_var *cv)
+{
+    int          retval = -1;
+    enum cv_type type;
+    char        *val = NULL;
+    uint8_t      n = 0;
+
+    if (cv == NULL){
+	ycw_u32(f, YANG_CACHE_NULL);
+	goto ok;
+    }
+    type = cv_type_get(cv);
+    ycw_u32(f, type);
+    ycw_u32(f, (uint8_t)cv_flag(cv, (char)0xff));
+    ycw_str(f, cv_name_get(cv));
+    if (type == CGV_DEC64)
+	n = cv_dec64_n_get(cv);
+    fwrite(&n, 1, 1, f);
+    /* Value as string, not for unset, void, empty or NULL strings */
+    if (cv_flag(cv, V_UNSET) || type == CGV_VOID || type == CGV_EMPTY ||
+	(cv_isstring(type) && cv_string_get(cv) == NULL))
+	ycw_str(f, NULL);
+    else {
+	if ((val = cv2str_dup(cv)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	ycw_str(f, val);
+    }
+ ok:
+    retval = 0;
+ done:
+    if (val)
+	free(val);
+    return retval;
+}
+
+static int
+ycw_cvec(FILE *f,
+	 cvec *cvv)
+{
+    cg_var *cv = NULL;
+
+    if (cvv == NULL){
+	ycw_u32(f, YANG_CACHE_NULL);
+	return 0;
+    }
+    ycw_u32(f, cvec_len(cvv));
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+	if (ycw_cv(f, cv) < 0)
+	    return -1;
+    return 0;
+}
+
+static int
+ycache_ref_cmp(const void *a,
+	       const void *b)
+{
+    const struct ycache_ref *ra = a;
+    const struct ycache_ref *rb = b;
+
+    if (ra->yf_ys < rb->yf_ys)
+	return -1;
+    return ra->yf_ys > rb->yf_ys;
+}
+
+/*! Write reference to another node as its pre-order number
+ */
+static void
+ycw_ref(FILE              *f,
+	struct ycache_ref *refs,
+	uint32_t           nr,
+	yang_stmt         *ys)
+{
+    struct ycache_ref  key = {ys, 0};
+    struct ycache_ref *ref = NULL;
+
+    if (ys != NULL)
+	ref = bsearch(&key, refs, nr, sizeof(*refs), ycache_ref_cmp);
+    ycw_u32(f, ref?ref->yf_nr:YANG_CACHE_NULL);
+}
+
+/*! Number yang nodes in pre-order
+ */
+static void
+ycache_number(yang_stmt         *yn,
+	      struct ycache_ref *refs,
+	      uint32_t          *nr)
+{
+    int i;
+
+    for (i=0; i<yn->ys_len; i++){
+	if (refs){
+	    refs[*nr].yf_ys = yn->ys_stmt[i];
+	    refs[*nr].yf_nr = *nr;
+	}
+	(*nr)++;
+	ycache_number(yn->ys_stmt[i], refs, nr);
+    }
+}
+
+/*! Write children of yn recursively in pre-order
+ */
+static int
+ycw_children(FILE              *f,
+	     yang_stmt         *yn,
+	     struct ycache_ref *refs,
+	     uint32_t           nr)
+{
+    int        retval = -1;
+    int        i;
+    yang_stmt *ys;
+    yang_stmt *resolved = NULL;
+    int        options = 0;
+    cvec      *cvv = NULL;
+    cvec      *patterns = NULL;
+    uint8_t    fraction = 0;
+    int        ret;
+
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	ycw_u32(f, ys->ys_keyword);
+	ycw_u32(f, ys->ys_flags);
+	ycw_u32(f, ys->ys_len);
+	ycw_str(f, ys->ys_argument);
+	ycw_ref(f, refs, nr, ys->ys_mymodule);
+	ycw_str(f, ys->ys_when_xpath);
+	if (ycw_cvec(f, ys->ys_when_nsc) < 0 ||
+	    ycw_cv(f, ys->ys_cv) < 0 ||
+	    ycw_cvec(f, ys->ys_cvec) < 0)
+	    goto done;
+	if ((patterns = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	if ((ret = yang_type_cache_get(ys, &resolved, &options, &cvv, patterns,
+				       NULL, NULL, &fraction)) < 0)
+	    goto done;
+	if (ret == 0)
+	    ycw_u32(f, 0);
+	else {
+	    ycw_u32(f, 1);
+	    ycw_u32(f, options);
+	    ycw_u32(f, fraction);
+	    ycw_ref(f, refs, nr, resolved);
+	    if (ycw_cvec(f, cvv) < 0 ||
+		ycw_cvec(f, patterns) < 0)
+		goto done;
+	}
+	cvec_free(patterns);
+	patterns = NULL;
+	if (ycw_children(f, ys, refs, nr) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (patterns)
+	cvec_free(patterns);
+    return retval;
+}
+
+/*! Write yang spec to cache file
+ *
+ * Written to a temporary file which is renamed, so that concurrently starting
+ * processes never see a partially written cache.
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Application name, eg "backend", "netconf"
+ * @param[in]  yspec Yang spec, all modules loaded
+ * @retval     0     OK, also if the cache is not used or cannot be written
+ * @retval    -1    Error
+ * @see yang_cache_load
+ */
+int
+yang_cache_save(clicon_handle h,
+		const char   *name,
+		yang_stmt    *yspec)
+{
+    int                retval = -1;
+    char              *path = NULL;
+    char              *tmpfile = NULL;
+    FILE              *f = NULL;
+    struct ycache_hdr  hdr = {{0,}, };
+    struct ycache_ref *refs = NULL;
+    uint32_t           nr = 0;
+    long               len;
+    int                ok = 0;
+
+    if (yspec->ys_len == 0 ||
+	(path = yang_cache_file(h, name)) == NULL)
+	goto ok;
+    memcpy(hdr.yh_magic, YANG_CACHE_MAGIC, sizeof(hdr.yh_magic));
+    hdr.yh_version = YANG_CACHE_VERSION;
+    if (yang_cache_fingerprint(h, &hdr.yh_fingerprint) < 0)
+	goto done;
+    ycache_number(yspec, NULL, &nr);
+    if ((refs = calloc(nr?nr:1, sizeof(*refs))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    hdr.yh_nodes = nr;
+    nr = 0;
+    ycache_number(yspec, refs, &nr);
+    qsort(refs, nr, sizeof(*refs), ycache_ref_cmp);
+    if ((tmpfile = malloc(strlen(path) + 32)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    sprintf(tmpfile, "%s.%d.tmp", path, (int)getpid());
+    if ((f = fopen(tmpfile, "w")) == NULL){
+	clicon_log(LOG_WARNING, "%s: %s: %s, yang cache not written",
+		   __FUNCTION__, tmpfile, strerror(errno));
+	goto ok;
+    }
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    ycw_u32(f, yspec->ys_len);
+    if (ycw_children(f, yspec, refs, nr) < 0)
+	goto done;
+    if ((len = ftell(f)) < 0)
+	goto werr;
+    hdr.yh_len = len - sizeof(hdr);
+    if (fseek(f, 0, SEEK_SET) < 0 ||
+	fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+	fflush(f) != 0 || ferror(f))
+	goto werr;
+    if (fclose(f) != 0){
+	f = NULL;
+	goto werr;
+    }
+    f = NULL;
+    if (rename(tmpfile, path) < 0)
+	goto werr;
+    ok = 1;
+    clicon_debug(1, "%s: %s: %u nodes", __FUNCTION__, path, hdr.yh_nodes);
+ ok:
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (tmpfile){
+	if (!ok)
+	    unlink(tmpfile);
+	free(tmpfile);
+    }
+    if (refs)
+	free(refs);
+    if (path)
+	free(path);
+    return retval;
+ werr:
+    clicon_log(LOG_WARNING, "%s: %s: %s, yang cache not written",
+	       __FUNCTION__, tmpfile, strerror(errno));
+    goto ok;
+}
+
+/*
+ * Read
+ */
+static uint32_t
+ycr_u32(struct ycache_rd *yr)
+{
+    uint32_t u = 0;
+
+    if (yr->yr_end - yr->yr_p < (long)sizeof(u))
+	yr->yr_err++;
+    else{
+	memcpy(&u, yr->yr_p, sizeof(u));
+	yr->yr_p += sizeof(u);
+    }
+    return u;
+}
+
+/*! Read string
+ * @param[out] strp  Malloced string, or NULL
+ * @retval     0     OK (or read beyond end, yr_err set)
+ * @retval    -1     Error
+ */
+static int
+ycr_str(struct ycache_rd *yr,
+	char            **strp)
+{
+    uint32_t len;
+
+    *strp = NULL;
+    if ((len = ycr_u32(yr)) == YANG_CACHE_NULL || yr->yr_err)
+	return 0;
+    if (yr->yr_end - yr->yr_p < (long)len){
+	yr->yr_err++;
+	return 0;
+    }
+    if ((*strp = malloc(len+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    memcpy(*strp, yr->yr_p, len);
+    (*strp)[len] = '\0';
+    yr->yr_p += len;
+    return 0;
+}
+
+/*! Read cv into cv, which is created by caller with the type read by ycr_cv_type
+ */
+static int
+ycr_cv_value(struct ycache_rd *yr,
+	     cg_var           *cv)
+{
+    int      retval = -1;
+    uint32_t flags;
+    char    *name = NULL;
+    char    *val = NULL;
+    char    *reason = NULL;
+    uint8_t  n = 0;
+
+    flags = ycr_u32(yr);
+    if (ycr_str(yr, &name) < 0)
+	goto done;
+    if (yr->yr_p < yr->yr_end)
+	n = *yr->yr_p++;
+    else
+	yr->yr_err++;
+    if (ycr_str(yr, &val) < 0)
+	goto done;
+    if (yr->yr_err)
+	goto ok;
+    if (name && cv_name_set(cv, name) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_name_set");
+	goto done;
+    }
+    if (cv_type_get(cv) == CGV_DEC64)
+	cv_dec64_n_set(cv, n);
+    if (val && cv_parse1(val, cv, &reason) != 1){
+	yr->yr_err++; /* Should not happen: written with cv2str */
+	goto ok;
+    }
+    cv_flag_set(cv, (char)flags);
+ ok:
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    if (val)
+	free(val);
+    if (reason)
+	free(reason);
+    return retval;
+}
+
+/*! Read cv
+ * @param[out] cvp   Created cv, or NULL
+ */
+static int
+ycr_cv(struct ycache_rd *yr,
+       cg_var          **cvp)
+{
+    uint32_t type;
+    cg_var  *cv;
+
+    *cvp = NULL;
+    if ((type = ycr_u32(yr)) == YANG_CACHE_NULL || yr->yr_err)
+	return 0;
+    if ((cv = cv_new(type)) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_new");
+	return -1;
+    }
+    if (ycr_cv_value(yr, cv) < 0){
+	cv_free(cv);
+	return -1;
+    }
+    *cvp = cv;
+    return 0;
+}
+
+/*! Read cvec
+ * @param[out] cvvp   Created cvec, or NULL
+ */
+static int
+ycr_cvec(struct ycache_rd *yr,
+	 cvec            **cvvp)
+{
+    uint32_t len;
+    uint32_t i;
+    uint32_t type;
+    cvec    *cvv;
+    cg_var  *cv;
+
+    *cvvp = NULL;
+    if ((len = ycr_u32(yr)) == YANG_CACHE_NULL || yr->yr_err)
+	return 0;
+    if ((cvv = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	return -1;
+    }
+    *cvvp = cvv;
+    for (i=0; i<len && !yr->yr_err; i++){
+	if ((type = ycr_u32(yr)) == YANG_CACHE_NULL || yr->yr_err){
+	    yr->yr_err++;
+	    break;
+	}
+	if ((cv = cvec_add(cvv, type)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add");
+	    return -1;
+	}
+	if (ycr_cv_value(yr, cv) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Read children of yn recursively in pre-order
+ * @param[in]  yr    Reader
+ * @param[in]  yn    Parent, its number of children is already read
+ * @param[in]  len   Number of children
+ * @param[in]  vec   Nodes in pre-order
+ * @param[in]  refs  Node references to fix up, two per node (module, resolved type)
+ * @param[in]  nodes Number of nodes in vec
+ * @param[in,out] nr Next pre-order number
+ */
+static int
+ycr_children(struct ycache_rd *yr,
+	     yang_stmt        *yn,
+	     uint32_t          len,
+	     yang_stmt       **vec,
+	     uint32_t         *refs,
+	     uint32_t          nodes,
+	     uint32_t         *nr)
+{
+    int        retval = -1;
+    uint32_t   i;
+    uint32_t   keyword;
+    uint32_t   clen;
+    yang_stmt *ys;
+    cvec      *cvv = NULL;
+    cvec      *patterns = NULL;
+    uint32_t   options;
+    uint32_t   fraction;
+
+    if (len > nodes - *nr){
+	yr->yr_err++;
+	goto ok;
+    }
+    if (len && (yn->ys_stmt = calloc(len, sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_YANG, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<len && !yr->yr_err; i++){
+	keyword = ycr_u32(yr);
+	if ((ys = ys_new(keyword)) == NULL)
+	    goto done;
+	yn->ys_stmt[yn->ys_len++] = ys;
+	ys->ys_parent = yn;
+	vec[*nr] = ys;
+	ys->ys_flags = ycr_u32(yr);
+	clen = ycr_u32(yr);
+	if (ycr_str(yr, &ys->ys_argument) < 0)
+	    goto done;
+	refs[2*(*nr)] = ycr_u32(yr);
+	if (ycr_str(yr, &ys->ys_when_xpath) < 0 ||
+	    ycr_cvec(yr, &ys->ys_when_nsc) < 0 ||
+	    ycr_cv(yr, &ys->ys_cv) < 0)
+	    goto done;
+	if (ys->ys_cvec){ /* Created by ys_new */
+	    cvec_free(ys->ys_cvec);
+	    ys->ys_cvec = NULL;
+	}
+	if (ycr_cvec(yr, &ys->ys_cvec) < 0)
+	    goto done;
+	refs[2*(*nr)+1] = YANG_CACHE_NULL;
+	if (ycr_u32(yr) == 1){ /* type cache */
+	    options = ycr_u32(yr);
+	    fraction = ycr_u32(yr);
+	    refs[2*(*nr)+1] = ycr_u32(yr);
+	    if (ycr_cvec(yr, &cvv) < 0 ||
+		ycr_cvec(yr, &patterns) < 0)
+		goto done;
+	    /* Resolved type is set in fixup */
+	    if (!yr->yr_err &&
+		yang_type_cache_set(ys, NULL, options, cvv, patterns, fraction) < 0)
+		goto done;
+	    if (cvv){
+		cvec_free(cvv);
+		cvv = NULL;
+	    }
+	    if (patterns){
+		cvec_free(patterns);
+		patterns = NULL;
+	    }
+	}
+	(*nr)++;
+	if (yr->yr_err)
+	    break;
+	if (ycr_children(yr, ys, clen, vec, refs, nodes, nr) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cvv)
+	cvec_free(cvv);
+    if (patterns)
+	cvec_free(patterns);
+    return retval;
+}
+
+/*! Remove all modules from yang spec after a failed load
+ */
+static void
+yang_cache_reset(yang_stmt *yspec)
+{
+    int i;
+
+    for (i=0; i<yspec->ys_len; i++)
+	ys_free(yspec->ys_stmt[i]);
+    if (yspec->ys_stmt)
+	free(yspec->ys_stmt);
+    yspec->ys_stmt = NULL;
+    yspec->ys_len = 0;
+    yang_index_invalidate(yspec);
+}
+
+/*! Load yang spec from cache file if it is valid
+ *
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Application name, eg "backend", "netconf"
+ * @param[in]  yspec Empty yang spec
+ * @retval     1     Loaded from cache: do not parse yang modules
+ * @retval     0     No valid cache: parse yang and call yang_cache_save()
+ * @retval    -1     Error
+ * @code
+ *   if ((ret = yang_cache_load(h, "netconf", yspec)) < 0)
+ *      goto err;
+ *   if (ret == 0){
+ *      yang_spec_parse_module(h, ...);
+ *      ...
+ *      if (yang_cache_save(h, "netconf", yspec) < 0)
+ *         goto err;
+ *   }
+ * @endcode
+ * @see yang_cache_spec_load  Load all yang modules of an application
+ */
+int
+yang_cache_load(clicon_handle h,
+		const char   *name,
+		yang_stmt    *yspec)
+{
+    int                retval = -1;
+    char              *path = NULL;
+    int                fd = -1;
+    struct stat        st;
+    void              *map = MAP_FAILED;
+    struct ycache_hdr  hdr;
+    struct ycache_rd   yr = {NULL, NULL, 0};
+    uint64_t           fp;
+    yang_stmt        **vec = NULL;
+    uint32_t          *refs = NULL;
+    uint32_t           nr = 0;
+    uint32_t           i;
+    uint32_t           ref;
+    yang_stmt         *ys;
+    yang_type_cache   *ycache;
+
+    if (yang_len_get(yspec) != 0 ||
+	(path = yang_cache_file(h, name)) == NULL)
+	goto fail;
+    if ((fd = open(path, O_RDONLY)) < 0)
+	goto fail; /* No cache */
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(hdr))
+	goto fail;
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	goto fail;
+    memcpy(&hdr, map, sizeof(hdr));
+    if (memcmp(hdr.yh_magic, YANG_CACHE_MAGIC, sizeof(hdr.yh_magic)) != 0 ||
+	hdr.yh_version != YANG_CACHE_VERSION ||
+	hdr.yh_len != (uint64_t)st.st_size - sizeof(hdr) ||
+	hdr.yh_nodes == 0)
+	goto fail;
+    if (yang_cache_fingerprint(h, &fp) < 0)
+	goto done;
+    if (fp != hdr.yh_fingerprint){
+	clicon_debug(1, "%s: %s is stale", __FUNCTION__, path);
+	goto fail;
+    }
+    yr.yr_p = (const uint8_t *)map + sizeof(hdr);
+    yr.yr_end = (const uint8_t *)map + st.st_size;
+    if ((vec = calloc(hdr.yh_nodes, sizeof(*vec))) == NULL ||
+	(refs = calloc(2*(size_t)hdr.yh_nodes, sizeof(*refs))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    /* The modules, ie children of yspec, and recursively all nodes */
+    if (ycr_children(&yr, yspec, ycr_u32(&yr), vec, refs, hdr.yh_nodes, &nr) < 0)
+	goto err;
+    if (yr.yr_err || nr != hdr.yh_nodes || yr.yr_p != yr.yr_end){
+	clicon_log(LOG_WARNING, "%s: %s: corrupt yang cache, ignored", __FUNCTION__, path);
+	goto reset;
+    }
+    /* Fix up references to other nodes */
+    for (i=0; i<nr; i++){
+	ys = vec[i];
+	if ((ref = refs[2*i]) != YANG_CACHE_NULL){
+	    if (ref >= nr)
+		goto reset;
+	    ys->ys_mymodule = vec[ref];
+	}
+	if ((ref = refs[2*i+1]) != YANG_CACHE_NULL){
+	    if (ref >= nr || (ycache = ys->ys_typecache) == NULL)
+		goto reset;
+	    ycache->yc_resolved = vec[ref];
+	}
+    }
+    clicon_debug(1, "%s: %s: %u nodes", __FUNCTION__, path, nr);
+    retval = 1;
+ done:
+    if (map != MAP_FAILED)
+	munmap(map, st.st_size);
+    if (fd != -1)
+	close(fd);
+    if (vec)
+	free(vec);
+    if (refs)
+	free(refs);
+    if (path)
+	free(path);
+    return retval;
+ reset: /* Remove what was read, caller parses yang instead */
+    yang_cache_reset(yspec);
+ fail:
+    retval = 0;
+    goto done;
+ err:
+    yang_cache_reset(yspec);
+    goto done;
+}
+
+/*! Load all yang modules of an application, from cache if valid
+ *
+ * If there is no valid cache, parse the main yang file, module and directory,
+ * the clixon-lib, module library and netconf modules, and the application
+ * modules loaded by fn. Then save the result in the cache for next start.
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Application name, eg "backend", "netconf"
+ * @param[in]  yspec Empty yang spec
+ * @param[in]  fn    Load application-specific modules, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see yang_cache_load
+ */
+int
+yang_cache_spec_load(clicon_handle h,
+		     const char   *name,
+		     yang_stmt    *yspec,
+		     int         (*fn)(clicon_handle h, yang_stmt *yspec))
+{
+    int   retval = -1;
+    char *str;
+    int   ret;
+
+    if ((ret = yang_cache_load(h, name, yspec)) < 0)
+	goto done;
+    if (ret == 1)
+	goto ok;
+    /* 1. Load a yang module as a specific absolute filename */
+    if ((str = clicon_yang_main_file(h)) != NULL)
+	if (yang_spec_parse_file(h, str, yspec) < 0)
+	    goto done;
+    /* 2. Load a (single) main module */
+    if ((str = clicon_yang_module_main(h)) != NULL)
+	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				   yspec) < 0)
+	    goto done;
+    /* 3. Load all modules in a directory (will not overwrite file loaded ^) */
+    if ((str = clicon_yang_main_dir(h)) != NULL)
+	if (yang_spec_load_dir(h, str, yspec) < 0)
+	    goto done;
+    /* Load clixon lib yang module */
+    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
+	goto done;
+    /* Load yang module library, RFC7895 */
+    if (yang_modules_init(h) < 0)
+	goto done;
+    /* Add netconf yang spec, used by netconf client and as internal protocol */
+    if (netconf_module_load(h) < 0)
+	goto done;
+    if (fn && fn(h, yspec) < 0)
+	goto done;
+    /* Save loaded Yang modules in cache for next start */
+    if (yang_cache_save(h, name, yspec) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
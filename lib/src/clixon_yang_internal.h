@@ -58,6 +58,8 @@ struct yang_type_cache{
 };
 typedef struct yang_type_cache yang_type_cache;
 
+struct yang_index; /* Child lookup index, see clixon_yang.c */
+
 /*! yang statement 
  */
 struct yang_stmt{
@@ -90,9 +92,14 @@ struct yang_stmt{
     char              *ys_when_xpath; /* Special conditional for a "when"-associated augment xpath */
     cvec              *ys_when_nsc;   /* Special conditional for a "when"-associated augment namespace ctx */
     int               _ys_vector_i;   /* internal use: yn_each */
-
+    struct yang_index *ys_index;      /* Lazily built child lookup index, see yang_find */
 };
 
+/*
+ * Prototypes
+ */
+int yang_index_invalidate(yang_stmt *ys);
+
 
 #endif  /* _CLIXON_YANG_INTERNAL_H_ */
 
@@ -510,6 +510,7 @@ yang_expand_grouping(yang_stmt *yn)
 		yg->ys_parent = yn;
 		k++;
 	    }
+	    yang_index_invalidate(yn);
 	    /* Remove 'uses' node */
 	    ys_free(ys); 
 	    /* Remove the grouping copy */
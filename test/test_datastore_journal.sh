@@ -0,0 +1,151 @@
+#!/usr/bin/env bash
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Datastore journal tests, see CLICON_XMLDB_JOURNAL
+# Edits are appended to <db>_db.journal, replayed on read, and compacted into
+# <db>_db when the journal grows larger than the datastore file.
+# Just run a binary direct to datastore. No clixon.
+
+fyang=$dir/journal.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF > $fyang
+module journal{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf c {
+        type string;
+      }
+    }
+    leaf g {
+      type string;
+    }
+  }
+}
+EOF
+
+xml='<config><x xmlns="urn:example:clixon"><y><a>1</a><c>first-entry</c></y><y><a>2</a><c>second-entry</c></y><y><a>3</a><c>third-entry</c></y><g>astring</g></x></config>'
+
+mydir=$dir/journal
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+conf="-d candidate -b $mydir -y $fyang -j"
+
+new "datastore init"
+expectfn "$clixon_util_datastore $conf init" 0 ""
+
+new "datastore put all replace"
+ret=$($clixon_util_datastore $conf put replace "$xml")
+expectmatch "$ret" $? "0" ""
+
+new "datastore get"
+expectfn "$clixon_util_datastore $conf get /" 0 "^$xml$"
+
+new "datastore merge leaf is journaled"
+expectfn "$clixon_util_datastore $conf put merge <config><x><g>bstring</g></x></config>" 0 ""
+
+new "check journal exists"
+if [ ! -s $mydir/candidate_db.journal ]; then
+    err "$mydir/candidate_db.journal" "no journal"
+fi
+
+new "check datastore file not rewritten"
+expectfn "cat $mydir/candidate_db" 0 "astring"
+
+new "datastore get replays journal"
+expectfn "$clixon_util_datastore $conf get /" 0 '^<config><x xmlns="urn:example:clixon"><y><a>1</a><c>first-entry</c></y><y><a>2</a><c>second-entry</c></y><y><a>3</a><c>third-entry</c></y><g>bstring</g></x></config>$'
+
+new "datastore remove list entry is journaled"
+expectfn "$clixon_util_datastore $conf put remove <config><x><y><a>2</a></y></x></config>" 0 ""
+
+new "datastore get replays journal"
+expectfn "$clixon_util_datastore $conf get /" 0 '^<config><x xmlns="urn:example:clixon"><y><a>1</a><c>first-entry</c></y><y><a>3</a><c>third-entry</c></y><g>bstring</g></x></config>$'
+
+new "datastore other db init"
+expectfn "$clixon_util_datastore -d kalle -b $mydir -y $fyang -j init" 0 ""
+
+new "datastore copy with journal"
+expectfn "$clixon_util_datastore $conf copy kalle" 0 ""
+
+new "datastore get copy"
+expectfn "$clixon_util_datastore -d kalle -b $mydir -y $fyang -j get /" 0 '^<config><x xmlns="urn:example:clixon"><y><a>1</a><c>first-entry</c></y><y><a>3</a><c>third-entry</c></y><g>bstring</g></x></config>$'
+
+# Simulate a crash while appending: a partial record at end of journal
+echo -n "merge 200
+<config><x xmlns=\"urn:example:clixon\"><g>" >> $mydir/candidate_db.journal
+
+jsize=$(stat -c %s $mydir/candidate_db.journal)
+
+new "datastore get ignores truncated record"
+expectfn "$clixon_util_datastore $conf get /" 0 '^<config><x xmlns="urn:example:clixon"><y><a>1</a><c>first-entry</c></y><y><a>3</a><c>third-entry</c></y><g>bstring</g></x></config>$'
+
+# A reader may see a record being appended: only the writer truncates the journal
+new "check get does not truncate journal"
+if [ $(stat -c %s $mydir/candidate_db.journal) != $jsize ]; then
+    err "$jsize" "$(stat -c %s $mydir/candidate_db.journal)"
+fi
+
+new "datastore merge after truncated record"
+expectfn "$clixon_util_datastore $conf put merge <config><x><g>cstring</g></x></config>" 0 ""
+
+new "datastore get"
+expectfn "$clixon_util_datastore $conf get /" 0 '^<config><x xmlns="urn:example:clixon"><y><a>1</a><c>first-entry</c></y><y><a>3</a><c>third-entry</c></y><g>cstring</g></x></config>$'
+
+new "datastore merges until journal is compacted"
+for i in $(seq 1 10); do
+    expectfn "$clixon_util_datastore $conf put merge <config><x><y><a>$i</a><c>entry-$i</c></y></x></config>" 0 ""
+done
+
+new "check datastore file rewritten"
+expectfn "cat $mydir/candidate_db" 0 "entry-"
+
+new "check journal smaller than datastore file"
+if [ -f $mydir/candidate_db.journal ]; then
+    if [ $(stat -c %s $mydir/candidate_db.journal) -gt $(stat -c %s $mydir/candidate_db) ]; then
+	err "journal smaller than datastore file" "$(stat -c %s $mydir/candidate_db.journal)"
+    fi
+fi
+
+new "datastore get after compaction"
+expectfn "$clixon_util_datastore $conf get /" 0 '^<config><x xmlns="urn:example:clixon"><y><a>1</a><c>entry-1</c></y><y><a>10</a><c>entry-10</c></y><y><a>2</a><c>entry-2</c></y><y><a>3</a><c>entry-3</c></y><y><a>4</a><c>entry-4</c></y><y><a>5</a><c>entry-5</c></y><y><a>6</a><c>entry-6</c></y><y><a>7</a><c>entry-7</c></y><y><a>8</a><c>entry-8</c></y><y><a>9</a><c>entry-9</c></y><g>cstring</g></x></config>$'
+
+new "datastore put all replace without journal"
+ret=$($clixon_util_datastore -d candidate -b $mydir -y $fyang put replace "$xml")
+expectmatch "$ret" $? "0" ""
+
+# Simulate a crash after a new datastore file is written but before the journal
+# is removed: the journal header refers to another datastore file
+cat <<EOF > $mydir/candidate_db.journal
+clixon-journal 1 0 0
+merge 38
+<config><x><g>dstring</g></x></config>
+EOF
+
+new "datastore get ignores stale journal"
+expectfn "$clixon_util_datastore $conf get /" 0 "^$xml$"
+
+new "datastore delete removes journal"
+expectfn "$clixon_util_datastore $conf delete" 0 ""
+if [ -f $mydir/candidate_db.journal ]; then
+    err "no journal" "$mydir/candidate_db.journal"
+fi
+
+# unset conditional parameters
+unset clixon_util_datastore
+
+rm -rf $mydir
+
+rm -rf $dir
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# Bulk list loads in edit-config: many new list entries in one edit are inserted
+# at once in the datastore instead of one by one.
+# Add entries in reverse order, among existing entries, and check they are sorted.
+# Ordered-by user entries keep the order they are entered, also when
+# mixed with new ordered-by system entries.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=10000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/bulk.yang
+fconfig=$dir/config.xml
+
+cat <<EOF > $fyang
+module bulk{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+    leaf-list z {
+      type int32;
+    }
+    list u {
+      key "a";
+      ordered-by user;
+      leaf a {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "netconf add some entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>old</b></y><y><a>3</a><b>old</b></y><z>3</z><u><a>5</a></u></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "generate config with $perfnr list entries in reverse order"
+data=""
+for (( i=$perfnr; i>0; i-- )); do
+    if [ $i -ne 3 ]; then
+	data="$data<y><a>$i</a><b>new</b></y>"
+    fi
+done
+echo "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">$data<z>4</z><z>1</z><u><a>9</a></u><z>2</z><u><a>1</a></u></x></config></edit-config></rpc>]]>]]>" > $fconfig
+
+new "netconf write $perfnr entries"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "generate expected sorted config"
+data="<y><a>0</a><b>old</b></y>"
+for (( i=1; i<=$perfnr; i++ )); do
+    if [ $i -eq 3 ]; then
+	data="$data<y><a>$i</a><b>old</b></y>"
+    else
+	data="$data<y><a>$i</a><b>new</b></y>"
+    fi
+done
+
+new "netconf get-config sorted entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data<z>1</z><z>2</z><z>3</z><z>4</z><u><a>5</a></u><u><a>9</a></u><u><a>1</a></u></x></data></rpc-reply>]]>]]>$"
+
+new "netconf get-config entry with xpath"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=7]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>7</a><b>new</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "netconf validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf create existing entry fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>100000000</a></y><y xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"create\"><a>1</a></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>data-exists</error-tag>"
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+# unset conditional parameters
+unset perfnr
+
+rm -rf $dir
@@ -2,6 +2,8 @@
 # Startup performance tests for different formats and startup modes.
 # Generate file in different formats:
 # xml, xml pretty-printed, xml with prefixes, json
+# Also time parsing of the files from file and from a pipe, a file is read in
+# one block and parsed in place, a pipe is read in growing blocks.
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -9,6 +11,9 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 # Number of list/leaf-list entries in file
 : ${perfnr:=10000}
 
+# Parse files
+: ${clixon_util_xml:=clixon_util_xml}
+
 APPNAME=example
 
 cfg=$dir/scaling-conf.xml
@@ -133,6 +138,25 @@ done
 echo "]}}}" >> $sj
 fi
 
+# Parse each variant from file and from pipe
+for variant in prefix plain pretty; do
+    case $variant in
+        plain)
+	    f=$sx
+            ;;
+	pretty)
+	    f=$sxpp
+            ;;
+	prefix)
+	    f=$sxpre
+            ;;
+       esac
+    new "Parse $variant from file"
+    { time -p $clixon_util_xml -f $f > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+    new "Parse $variant from pipe"
+    { time -p cat $f | $clixon_util_xml > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+done
+
 # Loop over mode and format
 mode=startup # running
 format=xml
@@ -164,3 +188,4 @@ rm -rf $dir
 
 # unset conditional parameters 
 unset perfnr
+unset clixon_util_xml
@@ -1,5 +1,5 @@
 #!/usr/bin/env bash
-# Test: XML performance test (CDATA test only)
+# Test: XML performance test: parse long CDATA, and serialize a large tree to XML and JSON
 # See https://github.com/clicon/clixon/issues/96
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -24,6 +24,29 @@ echo "]]></stdout></rpc-reply>" >> $fxml
 new "xml parse long CDATA"
 expecteof_file "time -p $clixon_util_xml" 0 "$fxml" 2>&1 | awk '/real/ {print $2}'
 
+# Serialize a multi-MB tree: bodies without and with chars to encode
+fxml=$dir/large.xml
+new "generate large tree $fxml"
+echo -n "<x>" > $fxml
+for (( i=0; i<$perfnr; i++ )); do  
+    echo -n "<y><a>$i</a><b>entry-$i</b><c>a&lt;b&amp;c&gt;$i</c></y>" >> $fxml
+done
+echo -n "</x>" >> $fxml
+
+new "xml output large tree"
+{ time -p $clixon_util_xml -of $fxml > $dir/large.out ; } 2>&1 | awk '/real/ {print $2}'
+
+new "xml output large tree same as input"
+if ! cmp -s $fxml $dir/large.out; then
+    err "$(cat $fxml | head -c 200)" "$(cat $dir/large.out | head -c 200)"
+fi
+
+new "json output large tree"
+{ time -p $clixon_util_xml -ojf $fxml > $dir/large.json ; } 2>&1 | awk '/real/ {print $2}'
+
+new "json output large tree entry"
+expectpart "$(head -c 200 $dir/large.json)" 0 '^{"x":{"y":\[{"a":"0","b":"entry-0","c":"a<b&c>0"},{"a":"1"'
+
 rm -rf $dir
 
 # unset conditional parameters 
@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Binary encoded replies on the backend socket, see CLICON_SOCK_BINARY
+# First check that the binary encoding of an XML file is decoded to the same tree,
+# and compare serialize and parse times with XML text.
+# Then let the cli get config from the backend with binary encoded replies,
+# and check it is the same as with XML text replies. Netconf is not affected.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Binary encoding benchmark
+: ${clixon_util_xml_bin:=clixon_util_xml_bin}
+
+# Number of list entries in benchmark
+: ${perfnr:=10000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/binary.yang
+fxml=$dir/large.xml
+dclispec=$dir/clispec
+
+cat <<EOF > $fyang
+module binary{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+      leaf c {
+        type int64;
+      }
+    }
+  }
+}
+EOF
+
+mkdir $dclispec
+cat <<EOF > $dclispec/clispec.cli
+   CLICON_MODE="example";
+   CLICON_PROMPT="%U@%H> ";
+   CLICON_PLUGIN="example_cli";
+
+   show, cli_show_config("running", "xml", "/");
+EOF
+
+# Arg 1: CLICON_SOCK_BINARY
+writeconf(){
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>$dclispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_SOCK_BINARY>$1</CLICON_SOCK_BINARY>
+</clixon-config>
+EOF
+}
+
+new "generate xml with $perfnr list entries"
+data=""
+for (( i=0; i<$perfnr; i++ )); do
+    data="$data<y><a>$i</a><b>entry-$i</b><c>-$i</c></y>"
+done
+echo "<x xmlns=\"urn:example:clixon\">$data</x>" > $fxml
+
+new "binary encoding benchmark"
+expectpart "$($clixon_util_xml_bin -f $fxml -n 10)" 0 "xml serialize:" "binary serialize:" "xml parse:" "binary parse:"
+
+# Non-canonical integers are sent as strings
+XML='<ex:x xmlns:ex="urn:example:clixon" ex:t="1"><ex:y><ex:a>0</ex:a><ex:b>007</ex:b><ex:c>-0</ex:c></ex:y><ex:y><ex:a>-123456789012345678</ex:a><ex:b>a&lt;&amp;b</ex:b><ex:c>9223372036854775808</ex:c></ex:y><ex:y><ex:a>1.5</ex:a><ex:b/><ex:c>1e3</ex:c></ex:y></ex:x>'
+
+new "binary encoding of special values"
+expecteof "$clixon_util_xml_bin -o" 0 "$XML" "$XML$"
+
+writeconf true
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+DATA="<x xmlns=\"urn:example:clixon\"><y><a>1</a><b>foo&lt;&amp;bar</b><c>-42</c></y><y><a>2</a><b>0042</b><c>9223372036854775807</c></y></x>"
+
+new "netconf write config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$DATA</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "cli show config with binary replies"
+expectpart "$($clixon_cli -1 -f $cfg show)" 0 "<a>1</a>" "<b>foo&lt;&amp;bar</b>" "<c>-42</c>" "<b>0042</b>" "<c>9223372036854775807</c>"
+
+new "netconf get-config with binary replies configured"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$DATA</data></rpc-reply>]]>]]>$"
+
+# Client without binary replies to same backend
+writeconf false
+
+new "cli show config with xml replies"
+expectpart "$($clixon_cli -1 -f $cfg show)" 0 "<a>1</a>" "<b>foo&lt;&amp;bar</b>" "<c>-42</c>" "<b>0042</b>" "<c>9223372036854775807</c>"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+# unset conditional parameters
+unset clixon_util_xml_bin
+unset perfnr
+
+rm -rf $dir
@@ -0,0 +1,142 @@
+#!/usr/bin/env bash
+# Get and get-config served by read workers, see CLICON_BACKEND_READ_WORKERS
+# Start several large get-config requests in parallel and make a commit
+# while they are served. Check that all replies are complete, and that
+# a get after the commit sees the change.
+# Then check that clients that do not read large replies, served by the workers
+# and by the backend itself, do not stall other clients.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries, each about 30 bytes
+: ${perfnr:=10000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/workers.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module workers{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_READ_WORKERS>2</CLICON_BACKEND_READ_WORKERS>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "generate config with $perfnr list entries"
+data=""
+for (( i=0; i<$perfnr; i++ )); do
+    data="$data<y><a>$i</a><b>entry-$i</b></y>"
+done
+echo "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">$data</x></config></edit-config></rpc>]]>]]>" > $fconfig
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit large config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config in worker"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS message-id=\"42\"><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS message-id=\"42\"><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>]]>]]>$"
+
+new "netconf get and get-config in one session"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=7]\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]><rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]><rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=8]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>7</a><b>entry-7</b></y></x></data></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>8</a><b>entry-8</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "start parallel get-config"
+pids=""
+for i in 1 2 3 4; do
+    echo "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg > $dir/get$i &
+    pids="$pids $!"
+done
+
+new "netconf commit while get-config is served"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$perfnr</a><b>new</b></y></x></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+wait $pids
+
+for i in 1 2 3 4; do
+    new "check parallel get-config $i"
+    ret=$(cat $dir/get$i)
+    match=$(echo "$ret" | grep -Eo "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data(<y><a>$perfnr</a><b>new</b></y>)?</x></data></rpc-reply>]]>]]>$")
+    if [ -z "$match" ]; then
+	err "complete reply" "$ret"
+    fi
+done
+
+new "netconf get-config after commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=$perfnr]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$perfnr</a><b>new</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "netconf write and commit 50000 more list entries"
+seq 100000 149999 | awk -v ns="$DEFAULTNS" 'BEGIN{printf "<rpc %s><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">", ns} {printf "<y><a>%d</a><b>entry-%d</b></y>", $1, $1} END{printf "</x></config></edit-config></rpc>]]>]]><rpc %s><commit/></rpc>]]>]]>", ns}' > $fconfig
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "start slow readers of large get-config"
+# More slow readers than workers: at least one is served by the backend
+pids=""
+for i in 1 2 3; do
+    echo "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg | (sleep 12; cat > /dev/null) &
+    pids="$pids $!"
+done
+sleep 2
+
+new "netconf get-config while slow readers are served"
+expecteof "timeout 5 $clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=7]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>7</a><b>entry-7</b></y></x></data></rpc-reply>]]>]]>$"
+
+wait $pids
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+# unset conditional parameters
+unset perfnr
+
+rm -rf $dir
@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Delimiter search of the hand-written XML and JSON scanners, see configure --enable-xml-scanner
+# Scalar, SSE2 and AVX2 searches are compared with a plain loop on all buffer lengths,
+# alignments and tails, the vector searches only if supported by the cpu.
+# The scanners themselves are tested by test_xml.sh and test_json.sh in a build
+# configured with --enable-xml-scanner, this checks which scanner is built.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_scan:=clixon_util_scan}
+: ${clixon_util_xml:="clixon_util_xml"}
+
+for impl in scalar sse2 avx2; do
+    if ! $clixon_util_scan -i $impl -n 0 > /dev/null 2>&1; then
+	echo "...skipped: $impl not supported"
+	continue
+    fi
+    new "delimiter search $impl"
+    expectpart "$($clixon_util_scan -i $impl -n 100)" 0 "^$impl: OK$"
+done
+
+new "delimiter search default"
+expectpart "$($clixon_util_scan -n 40)" 0 "OK$"
+
+if [ "$XML_SCANNER" = yes ]; then
+    new "xml scanner is hand-written"
+    expectpart "$(echo '<x>a</x>' | $clixon_util_xml -D 1 -o 2>&1)" 0 "xml scanner: hand-written, delimiter search" "<x>a</x>"
+else
+    new "xml scanner is flex"
+    expectpart "$(echo '<x>a</x>' | $clixon_util_xml -D 1 -o 2>&1)" 0 "xml scanner: flex" "<x>a</x>"
+fi
+
+rm -rf $dir
+
+# unset conditional parameters 
+unset clixon_util_scan
+unset clixon_util_xml
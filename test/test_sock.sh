@@ -69,6 +69,15 @@ EOF
     new "hello session-id 2"
     expecteof "$clixon_util_socket -a $family -s $sock -D $DBG" 0 "<hello $DEFAULTNS/>" "<hello $DEFAULTNS><session-id>4</session-id></hello>"
 
+    new "pipelined hello on persistent connection, replies in order"
+    expecteof "$clixon_util_socket -a $family -s $sock -D $DBG -n 3" 0 "<hello $DEFAULTNS/>" "<hello $DEFAULTNS><session-id>7</session-id></hello>"
+
+    new "pipelined rpc beyond max outstanding requests"
+    expecteof "$clixon_util_socket -a $family -s $sock -D $DBG -n 100" 0 "<rpc $DEFAULTNS username=\"$USER\"><get-config><source><candidate/></source></get-config></rpc>" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+    new "client statistics"
+    expecteof "$clixon_util_socket -a $family -s $sock -D $DBG" 0 "<rpc $DEFAULTNS username=\"$USER\"><stats xmlns=\"http://clicon.org/lib\"/></rpc>" "<client><nr>[0-9]*</nr><session-id>[0-9]*</session-id><in>1</in><out>0</out><queued>0</queued><queued-max>0</queued-max><stalls>0</stalls><drops>0</drops></client>"
+
     if [ $BE -ne 0 ]; then
 	new "Kill backend"
 	# Check if premature kill
@@ -0,0 +1,120 @@
+#!/usr/bin/env bash
+# State data callbacks called in parallel, and state data cache
+# See CLICON_STATEDATA_PARALLEL and ca_statedata_ttl (example backend -c <ms>)
+# The example backend reads state from a file on every request. Change the file
+# and check that state is read again, or served from the cache.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+fstate=$dir/state.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STATEDATA_PARALLEL>true</CLICON_STATEDATA_PARALLEL>
+  <CLICON_STATEDATA_TIMEOUT>10000</CLICON_STATEDATA_TIMEOUT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container counters {
+    config false;
+    list counter {
+      key name;
+      leaf name {
+        type string;
+      }
+      leaf value {
+        type uint32;
+      }
+    }
+  }
+}
+EOF
+
+# Arg 1: value of counters
+writestate(){
+    echo "<counters xmlns=\"urn:example:clixon\"><counter><name>a</name><value>$1</value></counter><counter><name>b</name><value>$1</value></counter></counters>" > $fstate
+}
+
+# Arg 1: xpath
+# Arg 2: expected data
+getstate(){
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"$1\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$2</data></rpc-reply>]]>]]>$"
+}
+
+# Arg 1: extra plugin arguments
+startbe(){
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg -- -sS $fstate $1"
+	start_backend -s init -f $cfg -- -sS $fstate $1
+
+	new "waiting"
+	wait_backend
+    fi
+}
+
+stopbe(){
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	stop_backend -f $cfg
+    fi
+}
+
+new "test params: -f $cfg"
+
+writestate 1
+startbe ""
+
+new "get state in parallel"
+getstate "/ex:counters" '<counters xmlns="urn:example:clixon"><counter><name>a</name><value>1</value></counter><counter><name>b</name><value>1</value></counter></counters>'
+
+writestate 2
+
+new "get changed state, no cache"
+getstate "/ex:counters" '<counters xmlns="urn:example:clixon"><counter><name>a</name><value>2</value></counter><counter><name>b</name><value>2</value></counter></counters>'
+
+stopbe
+
+startbe "-c 60000"
+
+new "get state with cache"
+getstate "/ex:counters" '<counters xmlns="urn:example:clixon"><counter><name>a</name><value>2</value></counter><counter><name>b</name><value>2</value></counter></counters>'
+
+writestate 3
+
+new "get changed state, cached"
+getstate "/ex:counters" '<counters xmlns="urn:example:clixon"><counter><name>a</name><value>2</value></counter><counter><name>b</name><value>2</value></counter></counters>'
+
+new "get changed state with other xpath, not cached"
+getstate "/ex:counters/ex:counter[ex:name='a']" '<counters xmlns="urn:example:clixon"><counter><name>a</name><value>3</value></counter></counters>'
+
+stopbe
+
+rm -rf $dir
@@ -0,0 +1,137 @@
+#!/usr/bin/env bash
+# State data callbacks only called for xpaths that may select their declared paths
+# See ca_statedata_paths (example backend -p <path>)
+# The example backend reads counters state from a file. If the declared path does
+# not intersect the requested xpath, the callback is skipped and no state is returned.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+fstate=$dir/state.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container counters {
+    config false;
+    list counter {
+      key name;
+      leaf name {
+        type string;
+      }
+      leaf value {
+        type uint32;
+      }
+    }
+  }
+  container other {
+    config false;
+    leaf value {
+      type uint32;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $fstate
+<counters xmlns="urn:example:clixon"><counter><name>a</name><value>1</value></counter><counter><name>b</name><value>2</value></counter></counters>
+EOF
+
+COUNTERS='<counters xmlns="urn:example:clixon"><counter><name>a</name><value>1</value></counter><counter><name>b</name><value>2</value></counter></counters>'
+
+# Arg 1: xpath
+# Arg 2: expected data
+getstate(){
+    if [ -z "$2" ]; then
+	expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"$1\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+    else
+	expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"$1\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$2</data></rpc-reply>]]>]]>$"
+    fi
+}
+
+# Arg 1: declared state path
+startbe(){
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg -- -sS $fstate -p $1"
+	start_backend -s init -f $cfg -- -sS $fstate -p $1
+
+	new "waiting"
+	wait_backend
+    fi
+}
+
+stopbe(){
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	stop_backend -f $cfg
+    fi
+}
+
+new "test params: -f $cfg"
+
+startbe "/$APPNAME:counters"
+
+new "get declared path"
+getstate "/ex:counters" "$COUNTERS"
+
+new "get below declared path"
+getstate "/ex:counters/ex:counter[ex:name='a']" '<counters xmlns="urn:example:clixon"><counter><name>a</name><value>1</value></counter></counters>'
+
+new "get all"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$COUNTERS</data></rpc-reply>]]>]]>$"
+
+new "get other path, callback skipped"
+getstate "/ex:other" ""
+
+stopbe
+
+startbe "/$APPNAME:counters/counter"
+
+new "get above declared path"
+getstate "/ex:counters" "$COUNTERS"
+
+stopbe
+
+startbe "/$APPNAME:other"
+
+new "get path not declared, callback skipped"
+getstate "/ex:counters" ""
+
+new "get descendant path, callback called"
+getstate "//ex:counter[ex:name='b']" '<counters xmlns="urn:example:clixon"><counter><name>b</name><value>2</value></counter></counters>'
+
+new "get union, callback called"
+getstate "/ex:other | /ex:counters" "$COUNTERS"
+
+stopbe
+
+rm -rf $dir
@@ -0,0 +1,120 @@
+#!/usr/bin/env bash
+# Stream subscription filters shared by subscriptions with the same xpath
+# The example backend sends an EXAMPLE notification every 5s. Start several
+# netconf subscriptions in parallel, some with the same filter, and check which
+# get the notification. A filter that is not a valid xpath is rejected.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container event {
+    config false;
+    leaf event-class {
+      type string;
+    }
+    container reportingEntity {
+      leaf card {
+        type string;
+      }
+    }
+    leaf severity {
+      type string;
+    }
+  }
+}
+EOF
+
+NOTIFY="<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20[0-9:.TZ-]*</eventTime><event xmlns=\"urn:example:clixon\"><event-class>fault</event-class><reportingEntity><card>Ethernet0</card></reportingEntity><severity>major</severity></event></notification>"
+
+# Start a netconf subscription in background, output in file
+# Arg 1: output file
+# Arg 2: filter xpath
+subscribe(){
+    sleep 7 | cat <(echo "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"$2\"/></create-subscription></rpc>]]>]]>") - | $clixon_netconf -qf $cfg > $1 &
+    pids="$pids $!"
+}
+
+# Arg 1: output file
+# Arg 2: expected pattern
+checksub(){
+    ret=$(cat $1)
+    match=$(echo "$ret" | grep -Eo "$2")
+    if [ -z "$match" ]; then
+	err "$2" "$ret"
+    fi
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "start subscriptions with same and different filters"
+pids=""
+subscribe $dir/sub1 "event[event-class='fault']"
+subscribe $dir/sub2 "event[event-class='fault']"
+subscribe $dir/sub3 "event[event-class='other']"
+subscribe $dir/sub4 "event"
+wait $pids
+
+new "check first subscription with shared filter"
+checksub $dir/sub1 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$NOTIFY"
+
+new "check second subscription with shared filter"
+checksub $dir/sub2 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$NOTIFY"
+
+new "check subscription with non-matching filter"
+checksub $dir/sub3 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "check subscription with other filter"
+checksub $dir/sub4 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$NOTIFY"
+
+new "subscription with invalid xpath filter"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><filter type=\"xpath\" select=\"event[\"/></create-subscription></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag>"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+rm -rf $dir
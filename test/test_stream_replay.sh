@@ -0,0 +1,137 @@
+#!/usr/bin/env bash
+# Stream replay buffer limits, see CLICON_STREAM_RETENTION_COUNT,
+# CLICON_STREAM_RETENTION_SIZE and CLICON_STREAM_REPLAY_DIR
+# The example backend sends an EXAMPLE notification every 5s. Wait for some
+# notifications and then replay from a time long ago, and count the replayed
+# notifications.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+
+# Arg 1: extra config options
+writeconf(){
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_STREAM_RETENTION>60</CLICON_STREAM_RETENTION>
+  $1
+</clixon-config>
+EOF
+}
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container event {
+    config false;
+    leaf event-class {
+      type string;
+    }
+    container reportingEntity {
+      leaf card {
+        type string;
+      }
+    }
+    leaf severity {
+      type string;
+    }
+  }
+}
+EOF
+
+startbe(){
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+
+	new "waiting"
+	wait_backend
+    fi
+}
+
+stopbe(){
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	stop_backend -f $cfg
+    fi
+}
+
+# Replay all stored notifications and check their number
+# Arg 1: expected number of notifications
+replay(){
+    ret=$(sleep 2 | cat <(echo "<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>2000-01-01T00:00:00Z</startTime></create-subscription></rpc>]]>]]>") - | $clixon_netconf -qf $cfg)
+    match=$(echo "$ret" | grep -Eo "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20[0-9:.TZ-]*</eventTime><event xmlns=\"urn:example:clixon\"><event-class>fault</event-class>")
+    if [ -z "$match" ]; then
+	err "notification" "$ret"
+    fi
+    nr=$(echo "$ret" | grep -o "<notification " | wc -l)
+    if [ $nr -ne $1 ]; then
+	err "$1 notifications" "$nr"
+    fi
+}
+
+new "test params: -f $cfg"
+
+writeconf "<CLICON_STREAM_RETENTION_COUNT>2</CLICON_STREAM_RETENTION_COUNT><CLICON_STREAM_REPLAY_DIR>$dir</CLICON_STREAM_REPLAY_DIR>"
+startbe
+
+new "wait for 3 notifications"
+sleep 16
+
+if [ $BE -ne 0 ]; then
+    new "check replay segment file"
+    if [ ! -s $dir/EXAMPLE.replay ]; then
+	err "$dir/EXAMPLE.replay" "no file"
+    fi
+fi
+
+new "replay with count limit 2"
+replay 2
+
+stopbe
+
+if [ $BE -ne 0 ]; then
+    new "check replay segment file removed"
+    if [ -f $dir/EXAMPLE.replay ]; then
+	err "no file" "$dir/EXAMPLE.replay"
+    fi
+fi
+
+# A notification is about 300 bytes
+writeconf "<CLICON_STREAM_RETENTION_SIZE>500</CLICON_STREAM_RETENTION_SIZE>"
+startbe
+
+new "wait for 3 notifications"
+sleep 16
+
+new "replay with size limit of one notification"
+replay 1
+
+stopbe
+
+rm -rf $dir
@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+# Large get and get-config replies sent from backend in several messages
+# The backend sends reply data in parts of 64K while serializing, netconf writes
+# the parts as they arrive, other clients receive the whole reply.
+# Check that large replies are complete and that rpc attributes are copied.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Raw unit tester of backend unix socket
+: ${clixon_util_socket:=clixon_util_socket}
+
+# Number of list entries, each about 30 bytes
+: ${perfnr:=10000}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/stream.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module stream{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "generate config with $perfnr list entries"
+data=""
+for (( i=0; i<$perfnr; i++ )); do
+    data="$data<y><a>$i</a><b>entry-$i</b></y>"
+done
+echo "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">$data</x></config></edit-config></rpc>]]>]]>" > $fconfig
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit large config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config large config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>]]>]]>$"
+
+new "netconf get large config with message-id"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS message-id=\"42\"><get><filter type=\"xpath\" select=\"/ex:x\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS message-id=\"42\"><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>]]>]]>$"
+
+new "netconf get-config small config with message-id"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS message-id=\"43\"><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=7]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS message-id=\"43\"><data><x xmlns=\"urn:example:clixon\"><y><a>7</a><b>entry-7</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "netconf two large gets in one session"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]><rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>]]>]]>$"
+
+new "socket get-config large config in one reply"
+expecteof "$clixon_util_socket -s /usr/local/var/$APPNAME/$APPNAME.sock -D $DBG" 0 "<rpc $DEFAULTNS username=\"$USER\"><get-config><source><running/></source></get-config></rpc>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>$"
+
+new "socket pipelined get-config large config"
+expecteof "$clixon_util_socket -s /usr/local/var/$APPNAME/$APPNAME.sock -D $DBG -n 5" 0 "<rpc $DEFAULTNS username=\"$USER\"><get-config><source><running/></source></get-config></rpc>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\">$data</x></data></rpc-reply>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+# unset conditional parameters
+unset clixon_util_socket
+unset perfnr
+
+rm -rf $dir
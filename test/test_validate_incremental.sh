@@ -0,0 +1,228 @@
+#!/usr/bin/env bash
+# Incremental validation, see CLICON_VALIDATE_INCREMENTAL
+# Commit a valid config, then make small changes that break leafref, must,
+# when, unique and max-elements constraints elsewhere in the tree, and check
+# that validate fails although only the changed part is validated.
+# The backend debug log is checked to ensure the errors are detected by the
+# incremental validation, not by a full validation of the candidate.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/incremental.yang
+flog=$dir/backend.log
+touch $flog
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_VALIDATE_INCREMENTAL>true</CLICON_VALIDATE_INCREMENTAL>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module incremental{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container interfaces{
+    list interface{
+      key name;
+      max-elements 3;
+      unique "ip";
+      leaf name{
+        type string;
+      }
+      leaf ip{
+        type string;
+      }
+      leaf mtu{
+        type uint32;
+      }
+    }
+  }
+  container routing{
+    leaf ifref{
+      type leafref{
+        path "/ex:interfaces/ex:interface/ex:name";
+      }
+    }
+    leaf minmtu{
+      type uint32;
+      must "count(/ex:interfaces/ex:interface[ex:mtu < 1000]) = 0" {
+        error-message "minmtu larger than an interface mtu";
+      }
+    }
+  }
+  container debug{
+    leaf enable{
+      type boolean;
+    }
+    leaf level{
+      when "../enable = 'true'";
+      type uint32;
+    }
+  }
+}
+EOF
+
+# Check that the validate or commit since log line $l0 was made incrementally
+# and, if $1 is false, that the incremental validation failed
+# Set l0 before the validate or commit
+checkincremental(){
+    ok=$1
+    if [ $BE -eq 0 ]; then
+	return # backend log not available
+    fi
+    new "check incremental validation"
+    t=$(tail -n +$((l0+1)) $flog)
+    match=$(echo "$t" | grep "xml_yang_validate_diff: added:")
+    if [ -z "$match" ]; then
+	err "xml_yang_validate_diff: added:" "$t"
+    fi
+    match=$(echo "$t" | grep "full validation")
+    if [ -n "$match" ]; then
+	err "no full validation" "$match"
+    fi
+    match=$(echo "$t" | grep "xml_yang_validate_diff: validation failed")
+    if $ok; then
+	if [ -n "$match" ]; then
+	    err "incremental validation ok" "$match"
+	fi
+    elif [ -z "$match" ]; then
+	err "xml_yang_validate_diff: validation failed" "$t"
+    fi
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -D 1 -l f$flog"
+    start_backend -s init -f $cfg -D 1 -l f$flog
+
+    new "waiting"
+    wait_backend
+fi
+
+new "add valid config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><ip>10.0.0.1</ip><mtu>1500</mtu></interface><interface><name>eth1</name><ip>10.0.0.2</ip><mtu>9000</mtu></interface></interfaces><routing xmlns=\"urn:example:clixon\"><ifref>eth0</ifref><minmtu>1000</minmtu></routing><debug xmlns=\"urn:example:clixon\"><enable>true</enable><level>3</level></debug></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit valid config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "change unrelated leaf"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth1</name><mtu>8000</mtu></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "commit unrelated change"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+checkincremental true
+
+# leafref
+new "delete interface referenced by leafref"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><interface nc:operation=\"delete\"><name>eth0</name></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "validate leafref fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-tag>bad-element</error-tag><error-info><bad-element>eth0</bad-element></error-info>"
+checkincremental false
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# must
+new "lower interface mtu below minmtu"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><mtu>500</mtu></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "validate must fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-message>minmtu larger than an interface mtu</error-message>"
+checkincremental false
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "add interface with mtu below minmtu"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth2</name><ip>10.0.0.3</ip><mtu>500</mtu></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "validate must fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-message>minmtu larger than an interface mtu</error-message>"
+checkincremental false
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# when
+new "disable debug"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><debug xmlns=\"urn:example:clixon\"><enable>false</enable></debug></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "validate when fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-message>Failed WHEN condition of level in module incremental</error-message>"
+checkincremental false
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# unique
+new "change ip to duplicate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth1</name><ip>10.0.0.1</ip></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "validate unique fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-app-tag>data-not-unique</error-app-tag>"
+checkincremental false
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# max-elements
+new "add two interfaces"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth2</name><ip>10.0.0.3</ip></interface><interface><name>eth3</name><ip>10.0.0.4</ip></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "commit max-elements fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "<error-app-tag>too-many-elements</error-app-tag>"
+checkincremental false
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "delete debug level and referenced interface eth1"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><interface nc:operation=\"delete\"><name>eth1</name></interface></interfaces><debug xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><level nc:operation=\"delete\"/></debug></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "commit ok"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+checkincremental true
+
+new "get-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><interfaces xmlns=\"urn:example:clixon\"><interface><name>eth0</name><ip>10.0.0.1</ip><mtu>1500</mtu></interface></interfaces><routing xmlns=\"urn:example:clixon\"><ifref>eth0</ifref><minmtu>1000</minmtu></routing><debug xmlns=\"urn:example:clixon\"><enable>true</enable></debug></data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+rm -rf $dir
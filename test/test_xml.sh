@@ -179,6 +179,19 @@ EOF
 )
 expecteof "$clixon_util_xml -o" 0 "$XML" '^<bk:book xmlns:bk="urn:loc.gov:books" xmlns:isbn="urn:ISBN:0-395-36341-6"><bk:title>Cheaper by the Dozen</bk:title><isbn:number>1568491379</isbn:number></bk:book>$'
 
+new "xml parse with arena"
+expecteof "$clixon_util_xml -ao" 0 "$XML" '^<bk:book xmlns:bk="urn:loc.gov:books" xmlns:isbn="urn:ISBN:0-395-36341-6"><bk:title>Cheaper by the Dozen</bk:title><isbn:number>1568491379</isbn:number></bk:book>$'
+
+new "xml parse with arena to json"
+expecteof "$clixon_util_xml -aoj" 0 "<a><b>x</b><c/></a>" '{"a":{"b":"x","c":{}}}'
+
+name=$(printf 'n%.0s' $(seq 1 1100))
+new "xml parse with arena long name"
+expecteof "$clixon_util_xml -ao" 0 "<a><$name>x</$name></a>" "^<a><$name>x</$name></a>$"
+
+new "xml parse with arena error"
+expecteof "$clixon_util_xml -ao" 255 "<a><b></a>" ""
+
 rm -rf $dir
 
 # unset conditional parameters 
@@ -10,6 +10,8 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 xml=$dir/xml.xml
 xml2=$dir/xml2.xml
 xml3=$dir/xml3.xml
+xml4=$dir/xml4.xml
+fyang=$dir/example.yang
 
 cat <<EOF > $xml
 <aaa>
@@ -210,6 +212,59 @@ expectpart "$($clixon_util_xpath -f $xml3 -p 'derived-from-or-self(../../change-
 new "xpath contains"
 expectpart "$($clixon_util_xpath -f $xml3 -p "contains(../../objectClass,'BTSFunction') or contains(../../objectClass,'RNCFunction')")" 0 "bool:false"
 
+# Variable references bound at evaluation
+new "xpath bbb[ccc=\$v] with v=bar"
+expecteof "$clixon_util_xpath -f $xml3 -v v=bar -p bbb[ccc=\$v]" 0 "" "^nodeset:0:<bbb x=\"hello\"><ccc>foo</ccc><ccc>42</ccc><ccc>bar</ccc></bbb>$"
+
+new "xpath bbb[ccc=\$v] with v=fie"
+expecteof "$clixon_util_xpath -f $xml3 -v v=fie -p bbb[ccc=\$v]" 0 "" "^nodeset:$"
+
+new "xpath contains(\$a,\$b)"
+expectpart "$($clixon_util_xpath -f $xml3 -v a=foobar -v b=oba -p 'contains($a,$b)')" 0 "bool:true"
+
+new "xpath unbound variable"
+expectpart "$($clixon_util_xpath -f $xml3 -l o -p 'bbb[ccc=$v]')" 255 "XPath variable \$v is not bound"
+
+# Variable as list key: same result as literal key, using binary search
+cat <<EOF > $fyang
+module example{
+  yang-version 1.1;
+  namespace "urn:example:x";
+  prefix ex;
+  container c{
+    list a{
+      key k;
+      leaf k{
+        type string;
+      }
+      leaf v{
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $xml4
+<c xmlns="urn:example:x"><a><k>a</k><v>1</v></a><a><k>b</k><v>2</v></a><a><k>c</k><v>3</v></a></c>
+EOF
+
+new "xpath list key c/a[k='b']"
+ret1=$($clixon_util_xpath -f $xml4 -y $fyang -n null:urn:example:x -p "c/a[k='b']")
+expectpart "$ret1" 0 "^nodeset:0:<a><k>b</k><v>2</v></a>$"
+
+new "xpath list key c/a[k=\$key] with key=b"
+ret2=$($clixon_util_xpath -f $xml4 -y $fyang -n null:urn:example:x -v key=b -p 'c/a[k=$key]')
+if [ "$ret1" != "$ret2" ]; then
+    err "$ret1" "$ret2"
+fi
+
+new "xpath list key c/a[k=\$key] uses binary search"
+expectpart "$($clixon_util_xpath -D 1 -f $xml4 -y $fyang -n null:urn:example:x -v key=b -p 'c/a[k=$key]' 2>&1)" 0 "xpath list optimize hits: 1"
+
+new "xpath list key c/a[k=\$key] with key=d"
+expecteof "$clixon_util_xpath -f $xml4 -y $fyang -n null:urn:example:x -v key=d -p c/a[k=\$key]" 0 "" "^nodeset:$"
+
 # Nodetests
 
 new "xpath nodetest: node"
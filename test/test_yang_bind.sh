@@ -114,6 +114,26 @@ EOF
 new "XML Add any on top"
 expectpart "$($clixon_util_xml -vy $fyang -f $fxml)" 0 '^$'
 
+# Yang is bound and children sorted as XML elements are parsed
+cat <<EOF > $fxml
+   <a xmlns="urn:example:match"><a><k>3</k></a><a><k>1</k></a><any><c/><b/></any><a><k>2</k></a></a>
+EOF
+
+new "XML list entries sorted while parsed"
+expectpart "$($clixon_util_xml -ovy $fyang -f $fxml)" 0 '^<a xmlns="urn:example:match"><a><k>1</k></a><a><k>2</k></a><a><k>3</k></a><any><c/><b/></any></a>$'
+
+cat <<EOF > $fxml
+   <a xmlns="urn:example:match"><a><k>3</k></a><a><k>1</k><x>1</x></a></a>
+EOF
+new "XML unknown element in second list entry, should fail"
+expectpart "$($clixon_util_xml -vy $fyang -f $fxml 2>&1)" 255 "Failed to find YANG spec of XML node: x with parent: a"
+
+cat <<EOF > $fxml
+   <a xmlns="urn:example:match"><m:a><k>3</k></m:a></a>
+EOF
+new "XML element prefix without namespace, should fail"
+expectpart "$($clixon_util_xml -vy $fyang -f $fxml 2>&1)" 255 "No namespace associated with m:a"
+
 # OK, same thing with JSON!
 
 cat <<EOF > $fjson
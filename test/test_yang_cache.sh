@@ -0,0 +1,317 @@
+#!/usr/bin/env bash
+# Binary yang cache, see CLICON_YANG_CACHE_DIR
+# Start backend and netconf twice: first parses yang and writes the cache,
+# second reads the cache. Check that types, defaults, groupings and choices
+# behave the same. Then change the yang file and check the cache is rebuilt.
+# Also change a module in a yang directory in place and check the cache is rebuilt.
+# Also check restconf, which has a built-in yang extension callback.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+cachedir=$dir/ycache
+ydir=$dir/yang
+ftypes=$ydir/example-types.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$ydir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_CACHE_DIR>$cachedir</CLICON_YANG_CACHE_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+# Yang with constructs that are resolved when loading: typedefs with range and
+# pattern, grouping/uses, choice, default and identities
+# Arg 1: Extra leaf
+writeyang(){
+    cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   import example-types {
+      prefix et;
+   }
+   identity base;
+   identity derived {
+      base base;
+   }
+   typedef percent {
+      type uint8 {
+         range "0..100";
+      }
+   }
+   typedef word {
+      type string {
+         pattern '[a-z]+';
+      }
+   }
+   grouping g {
+      leaf w {
+         type word;
+      }
+   }
+   container c {
+      leaf p {
+         type percent;
+      }
+      leaf d {
+         type int32;
+         default 42;
+      }
+      leaf i {
+         type identityref {
+            base base;
+         }
+      }
+      uses g;
+      choice ch {
+         leaf a {
+            type string;
+         }
+         leaf b {
+            type string;
+         }
+      }
+      leaf t {
+         type et:small;
+      }
+      $1
+   }
+}
+EOF
+}
+
+# Module in yang directory, imported by main module
+# Arg 1: Range of typedef small
+writetypes(){
+    cat <<EOF > $ftypes
+module example-types{
+   yang-version 1.1;
+   namespace "urn:example:types";
+   prefix et;
+   typedef small {
+      type uint8 {
+         range "$1";
+      }
+   }
+}
+EOF
+}
+
+# Run the same netconf tests with and without cache
+testrun(){
+    new "netconf edit range ok"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><p>50</p><w>abc</w><i xmlns:ex=\"urn:example:clixon\">ex:derived</i><a>x</a></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate ok"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get default and choice"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><p>50</p><d>42</d><i xmlns:ex=\"urn:example:clixon\">ex:derived</i><w>abc</w><a>x</a></c></data></rpc-reply>]]>]]>$"
+
+    new "netconf edit out of range"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><p>101</p></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate range error"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>p</bad-element></error-info><error-severity>error</error-severity><error-message>Number 101 out of range: 0 - 100</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+    new "netconf edit pattern mismatch"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><p>50</p><w>ABC</w></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate pattern error"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-tag>bad-element</error-tag><error-info><bad-element>w</bad-element></error-info>"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+}
+
+rm -rf $cachedir $ydir
+mkdir $cachedir $ydir
+writeyang ""
+writetypes "0..10"
+
+# Start backend, write cache (1st) or read it (2nd)
+startbe(){
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+
+	new "waiting"
+	wait_backend
+    fi
+}
+
+stopbe(){
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	stop_backend -f $cfg
+    fi
+}
+
+new "test params: -f $cfg"
+startbe
+
+new "netconf hello writes cache"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "check netconf cache exists"
+if [ ! -s $cachedir/netconf.ycache ]; then
+    err "$cachedir/netconf.ycache" "no cache"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "check backend cache exists"
+    if [ ! -s $cachedir/backend.ycache ]; then
+	err "$cachedir/backend.ycache" "no cache"
+    fi
+fi
+
+inode=$(stat -c %i $cachedir/netconf.ycache)
+
+new "test with cache"
+testrun
+
+# Restconf has a built-in yang-data extension callback which is part of its cache
+startrc(){
+    if [ $RC -ne 0 ]; then
+	new "kill old restconf daemon"
+	stop_restconf_pre
+
+	new "start restconf daemon"
+	start_restconf -f $cfg
+
+	new "waiting"
+	wait_restconf
+    fi
+}
+
+stoprc(){
+    if [ $RC -ne 0 ]; then
+	new "Kill restconf daemon"
+	stop_restconf
+    fi
+}
+
+if [ $BE -ne 0 ]; then
+    startrc
+    if [ $RC -ne 0 ]; then
+	new "check restconf cache exists"
+	if [ ! -s $cachedir/restconf.ycache ]; then
+	    err "$cachedir/restconf.ycache" "no cache"
+	fi
+	rcinode=$(stat -c %i $cachedir/restconf.ycache)
+    fi
+    stoprc
+
+    new "restart restconf with cache"
+    startrc
+
+    new "restconf get restconf root (yang-data extension) with cache"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf)" 0 'HTTP/1.1 200 OK' '{"ietf-restconf:restconf":{"data":{},"operations":{}'
+
+    if [ $RC -ne 0 ]; then
+	new "check restconf cache not rewritten"
+	if [ $(stat -c %i $cachedir/restconf.ycache) != $rcinode ]; then
+	    err "$rcinode" "$(stat -c %i $cachedir/restconf.ycache)"
+	fi
+    fi
+    stoprc
+fi
+
+stopbe
+
+new "restart backend with cache"
+startbe
+
+new "test with cache in both netconf and backend"
+testrun
+
+new "check netconf cache not rewritten"
+if [ $(stat -c %i $cachedir/netconf.ycache) != $inode ]; then
+    err "$inode" "$(stat -c %i $cachedir/netconf.ycache)"
+fi
+
+new "corrupt netconf cache"
+truncate -s 100 $cachedir/netconf.ycache
+
+new "test with corrupt cache"
+testrun
+
+inode=$(stat -c %i $cachedir/netconf.ycache)
+
+new "change yang file"
+writeyang "leaf e { type string; }"
+
+new "netconf with changed yang rebuilds cache"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "check netconf cache rewritten"
+if [ $(stat -c %i $cachedir/netconf.ycache) = $inode ]; then
+    err "new cache" "$inode"
+fi
+
+inode=$(stat -c %i $cachedir/netconf.ycache)
+if [ $BE -ne 0 ]; then
+    beinode=$(stat -c %i $cachedir/backend.ycache)
+fi
+
+new "change module in yang dir in place"
+writetypes "0..5"
+
+new "netconf with changed yang dir module rebuilds cache"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "check netconf cache rewritten after yang dir change"
+if [ $(stat -c %i $cachedir/netconf.ycache) = $inode ]; then
+    err "new cache" "$inode"
+fi
+
+if [ $BE -ne 0 ]; then
+    stopbe
+
+    new "restart backend with changed yang dir module"
+    startbe
+
+    new "check backend cache rewritten after yang dir change"
+    if [ $(stat -c %i $cachedir/backend.ycache) = $beinode ]; then
+	err "new cache" "$beinode"
+    fi
+
+    new "netconf edit small"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><t>7</t></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate small with changed range"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "<error-tag>bad-element</error-tag><error-info><bad-element>t</bad-element></error-info><error-severity>error</error-severity><error-message>Number 7 out of range: 0 - 5</error-message>"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+fi
+
+stopbe
+
+rm -rf $cachedir $ydir
+
+endtest
@@ -65,7 +65,7 @@
 #include <clixon/clixon.h>
 
 /* Command line options to be passed to getopt(3) */
-#define DATASTORE_OPTS "hDd:b:f:x:y:"
+#define DATASTORE_OPTS "hDd:b:f:jx:y:"
 
 /*! usage
  */
@@ -79,6 +79,7 @@ usage(char *argv0)
 		"\t-d <db>\t\tDatabase name. Default: running. Alt: candidate,startup\n"
 		"\t-b <dir>\tDatabase directory. Mandatory\n"
 	        "\t-f <fmt>\tDatabase format: xml or json\n"
+		"\t-j\t\tJournal datastore writes (CLICON_XMLDB_JOURNAL)\n"
 		"\t-x <xml>\tXML file. Alternative to put <xml> argument\n"
 		"\t-y <file>\tYang file. Mandatory\n"
 		"and command is either:\n"
@@ -153,6 +154,9 @@ main(int argc, char **argv)
 	        usage(argv0);
 	    clicon_option_str_set(h, "CLICON_XMLDB_FORMAT", optarg);
 	    break;
+	case 'j': /* journal */
+	    clicon_option_bool_set(h, "CLICON_XMLDB_JOURNAL", 1);
+	    break;
 	case 'x': /* XML file */
 	    if (!optarg)
 	        usage(argv0);
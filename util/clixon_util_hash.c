@@ -0,0 +1,292 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Benchmark of clicon_hash lookups. 
+  * Compares the clicon_hash table with the previous implementation (sum of 
+  * characters modulo 1031 buckets with chained lists), which is included here
+  * for reference.
+  * Example: clixon_util_hash -n 1000 -l 1000000
+  */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/*
+ * Previous hash implementation, for comparison
+ */
+#define LEGACY_HASH_SIZE 1031
+
+struct legacy_hash {
+    qelem_t	h_qelem;
+    char       *h_key;
+    void       *h_val;
+};
+typedef struct legacy_hash *legacy_hash_t;
+
+static uint32_t
+legacy_bucket(const char *str)
+{
+    uint32_t n = 0;
+
+    while(*str)
+	n += (uint32_t)*str++;
+    return n % LEGACY_HASH_SIZE;
+}
+
+static legacy_hash_t
+legacy_lookup(legacy_hash_t *hash, 
+	      const char    *key)
+{
+    uint32_t      bkt;
+    legacy_hash_t h;
+
+    bkt = legacy_bucket(key);
+    h = hash[bkt];
+    if (h) {
+	do {
+	    if (!strcmp(h->h_key, key))
+		return h;
+	    h = NEXTQ(legacy_hash_t, h);
+	} while (h != hash[bkt]);
+    }
+    return NULL;
+}
+
+static int
+legacy_add(legacy_hash_t *hash, 
+	   const char    *key, 
+	   void          *val)
+{
+    legacy_hash_t h;
+
+    if (legacy_lookup(hash, key) != NULL)
+	return 0;
+    if ((h = malloc(sizeof(*h))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    memset(h, 0, sizeof(*h));
+    if ((h->h_key = strdup(key)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	free(h);
+	return -1;
+    }
+    h->h_val = val;
+    INSQ(h, hash[legacy_bucket(key)]);
+    return 0;
+}
+
+static void
+legacy_free(legacy_hash_t *hash)
+{
+    int           i;
+    legacy_hash_t h;
+
+    for (i = 0; i < LEGACY_HASH_SIZE; i++) {
+	while ((h = hash[i]) != NULL) {
+	    DELQ(h, hash[i], legacy_hash_t);
+	    free(h->h_key);
+	    free(h);
+	}
+    }
+    free(hash);
+}
+
+/*! Return time in seconds since t0
+ */
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t1;
+    struct timeval td;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &td);
+    return td.tv_sec + td.tv_usec/1000000.0;
+}
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level>\tDebug\n"
+	    "\t-n <nr>     \tNumber of keys (default: 100)\n"
+	    "\t-l <nr>     \tNumber of lookups (default: 1000000)\n"
+	    "\t-p <prefix> \tKey prefix (default: CLICON_KEY_)\n",
+	    argv0
+	    );
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int            retval = -1;
+    char          *argv0 = argv[0];
+    int            c;
+    int            dbg = 0;
+    int            nr = 100;
+    int            lookups = 1000000;
+    char          *prefix = "CLICON_KEY_";
+    char         **keys = NULL;
+    clicon_hash_t *hash = NULL;
+    legacy_hash_t *legacy = NULL;
+    struct timeval t0;
+    double         t;
+    int            i;
+    int            found;
+    size_t         len;
+
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, "hD:n:l:p:")) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv0);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv0);
+	    break;
+	case 'n': /* Number of keys */
+	    if ((nr = atoi(optarg)) <= 0)
+		usage(argv0);
+	    break;
+	case 'l': /* Number of lookups */
+	    if ((lookups = atoi(optarg)) < 0)
+		usage(argv0);
+	    break;
+	case 'p': /* Key prefix */
+	    prefix = optarg;
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR); 
+    clicon_debug_init(dbg, NULL);
+
+    /* Similar keys, such as option names, is the worst case of the legacy hash */
+    if ((keys = calloc(nr, sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    len = strlen(prefix) + 16;
+    for (i=0; i<nr; i++){
+	if ((keys[i] = malloc(len)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	snprintf(keys[i], len, "%s%d", prefix, i);
+    }
+    if ((hash = clicon_hash_init()) == NULL)
+	goto done;
+    if ((legacy = calloc(LEGACY_HASH_SIZE, sizeof(legacy_hash_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    /* Insert */
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++)
+	if (clicon_hash_add(hash, keys[i], &i, sizeof(i)) == NULL)
+	    goto done;
+    t = elapsed(&t0);
+    fprintf(stdout, "clicon_hash insert: %d keys in %.6f s\n", nr, t);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++)
+	if (legacy_add(legacy, keys[i], keys[i]) < 0)
+	    goto done;
+    t = elapsed(&t0);
+    fprintf(stdout, "legacy insert:      %d keys in %.6f s\n", nr, t);
+    /* Lookup */
+    found = 0;
+    gettimeofday(&t0, NULL);
+    for (i=0; i<lookups; i++)
+	if (clicon_hash_lookup(hash, keys[i%nr]) != NULL)
+	    found++;
+    t = elapsed(&t0);
+    fprintf(stdout, "clicon_hash lookup: %d in %.6f s (%.0f lookups/s)\n",
+	    lookups, t, t>0?lookups/t:0);
+    if (found != lookups){
+	fprintf(stderr, "clicon_hash: %d keys not found\n", lookups-found);
+	goto done;
+    }
+    found = 0;
+    gettimeofday(&t0, NULL);
+    for (i=0; i<lookups; i++)
+	if (legacy_lookup(legacy, keys[i%nr]) != NULL)
+	    found++;
+    t = elapsed(&t0);
+    fprintf(stdout, "legacy lookup:      %d in %.6f s (%.0f lookups/s)\n",
+	    lookups, t, t>0?lookups/t:0);
+    /* Delete */
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++)
+	if (clicon_hash_del(hash, keys[i]) < 0){
+	    fprintf(stderr, "clicon_hash: %s not deleted\n", keys[i]);
+	    goto done;
+	}
+    t = elapsed(&t0);
+    fprintf(stdout, "clicon_hash delete: %d keys in %.6f s\n", nr, t);
+    retval = 0;
+ done:
+    if (hash)
+	clicon_hash_free(hash);
+    if (legacy)
+	legacy_free(legacy);
+    if (keys){
+	for (i=0; i<nr; i++)
+	    if (keys[i])
+		free(keys[i]);
+	free(keys);
+    }
+    return retval;
+}
@@ -87,7 +87,6 @@ main(int    argc,
     int        retval = -1;
     cxobj     *xt = NULL;
     cxobj     *xc;
-    cbuf      *cb = cbuf_new();
     int        c;
     int        logdst = CLICON_LOG_STDERR;
     int        json = 0;
@@ -145,11 +144,12 @@ main(int    argc,
     }
     xc = NULL;
     while ((xc = xml_child_each(xt, xc, -1)) != NULL) 
-	if (json)
-	    xml2json_cbuf(cb, xc, pretty); /* print xml */
-	else
-	    clicon_xml2cbuf(cb, xc, 0, pretty, -1); /* print xml */
-    fprintf(stdout, "%s", cbuf_get(cb));
+	if (json){
+	    if (xml2json(stdout, xc, pretty) < 0) /* print xml */
+		goto done;
+	}
+	else if (clicon_xml2file(stdout, xc, 0, pretty) < 0) /* print xml */
+	    goto done;
     fflush(stdout);
     retval = 0;
  done:
@@ -157,7 +157,5 @@ main(int    argc,
 	yspec_free(yspec);
     if (xt)
 	xml_free(xt);
-    if (cb)
-	cbuf_free(cb);
     return retval;
 }
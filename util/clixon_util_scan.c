@@ -0,0 +1,196 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Test of the delimiter search of the hand-written XML and JSON scanners.
+  * For all buffer lengths up to a max, all start alignments and all delimiter 
+  * positions, compares the result of clixon_scan_delim() with a plain loop.
+  * Bytes after the end of the buffer are delimiters, which must not be found.
+  * Alternately the first byte after the end is not, so that a search reading too far
+  * returns a position after the end.
+  * Example: clixon_util_scan -i avx2 -n 100
+  */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/* Max start offset of buffer, larger than the widest vector (32 bytes) */
+#define SCAN_ALIGN 32
+
+/* Delimiter sets used by the scanners, and the max set */
+static const char *scan_sets[] = {"<", "<&", "<&]", "\"\\", "<&\r\n]'\"-", NULL};
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level>\tDebug\n"
+	    "\t-i <impl>  \tDelimiter search: scalar, sse2 or avx2 (default: best on cpu)\n"
+	    "\t-n <nr>    \tMax buffer length (default: 100)\n",
+	    argv0
+	    );
+    exit(0);
+}
+
+/*! Test delimiter search of one set in buffers of one length
+ * @param[in]  ss    Delimiter set
+ * @param[in]  delims Delimiter characters of the set
+ * @param[in]  buf   Buffer of at least SCAN_ALIGN+len+SCAN_ALIGN bytes
+ * @param[in]  len   Buffer length
+ * @retval     n     Nr of searches, all OK
+ * @retval    -1     Search returned wrong position
+ */
+static int
+scan_test(clixon_scan_set *ss,
+	  const char      *delims,
+	  char            *buf,
+	  int              len)
+{
+    int   n = 0;
+    int   off;
+    int   pos;
+    int   i;
+    char *p;
+    char *end;
+    char *r;
+    char  d;
+
+    for (off=0; off<SCAN_ALIGN; off++){
+	p = buf + off;
+	end = p + len;
+	/* pos == len: no delimiter in buffer */
+	for (pos=0; pos<=len; pos++){
+	    /* Non-delimiters, including bytes with high bit set, then delimiters */
+	    for (i=0; i<len; i++){
+		d = (char)(((pos+i)*37 + 'a') & 0xff);
+		while (d == '\0' || strchr(delims, d) != NULL)
+		    d++;
+		p[i] = d;
+	    }
+	    memset(end, delims[0], SCAN_ALIGN);
+	    if (pos%2) /* Then a search reading one byte too far also ends after end */
+		end[0] = 'x';
+	    if (pos < len)
+		p[pos] = delims[pos%strlen(delims)];
+	    r = clixon_scan_delim(ss, p, end);
+	    if (r != p + pos){
+		fprintf(stderr, "%s: set \"%s\" len %d offset %d: expected %d, got %d\n",
+			clixon_scan_impl(), delims, len, off, pos, (int)(r - p));
+		return -1;
+	    }
+	    n++;
+	}
+    }
+    return n;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int             retval = -1;
+    char           *argv0 = argv[0];
+    int             c;
+    int             dbg = 0;
+    char           *impl = NULL;
+    int             nr = 100;
+    char           *buf = NULL;
+    clixon_scan_set ss;
+    int             i;
+    int             len;
+    int             n;
+    int             tot = 0;
+
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, "hD:i:n:")) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv0);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv0);
+	    break;
+	case 'i': /* Delimiter search implementation */
+	    impl = optarg;
+	    break;
+	case 'n': /* Max buffer length */
+	    if ((nr = atoi(optarg)) < 0)
+		usage(argv0);
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR); 
+    clicon_debug_init(dbg, NULL);
+
+    if (clixon_scan_impl_set(impl) < 0)
+	goto done;
+    if ((buf = malloc(SCAN_ALIGN + nr + SCAN_ALIGN)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    for (i=0; scan_sets[i]; i++){
+	if (clixon_scan_set_init(&ss, scan_sets[i]) < 0)
+	    goto done;
+	for (len=0; len<=nr; len++){
+	    if ((n = scan_test(&ss, scan_sets[i], buf, len)) < 0)
+		goto done;
+	    tot += n;
+	}
+    }
+    clicon_debug(1, "%s: %d searches", clixon_scan_impl(), tot);
+    fprintf(stdout, "%s: OK\n", clixon_scan_impl());
+    retval = 0;
+ done:
+    if (buf)
+	free(buf);
+    return retval;
+}
@@ -70,6 +70,8 @@ usage(char *argv0)
 	    "\t-s <sockpath> \tPath to unix domain socket (or IP addr)\n"
 	    "\t-f <file>\tXML input file (overrides stdin)\n"
 	    "\t-J \t\tInput as JSON (instead of XML)\n"
+	    "\t-n <nr>\tSend message nr times pipelined on one connection, print last reply\n"
+	    "\t-t \t\tPrint time of sending and receiving all messages on stderr\n"
 	    ,
 	    argv0);
     exit(0);
@@ -96,6 +98,13 @@ main(int    argc,
     cbuf              *cb = cbuf_new();
     clicon_handle      h;
     int                dbg = 0;
+    int                nr = 0;
+    int                timeit = 0;
+    int                i;
+    uint32_t          *reqids = NULL;
+    cxobj             *xret = NULL;
+    struct timeval     t0;
+    struct timeval     t1;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
@@ -105,7 +114,7 @@ main(int    argc,
 
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:s:f:Ja:")) != -1)
+    while ((c = getopt(argc, argv, "hD:s:f:Ja:n:t")) != -1)
 	switch (c) {
 	case 'h':
 	    usage(argv[0]);
@@ -126,6 +135,12 @@ main(int    argc,
 	case 'a':
 	    family = optarg;
 	    break;
+	case 'n':
+	    nr = atoi(optarg);
+	    break;
+	case 't':
+	    timeit++;
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -166,16 +181,53 @@ main(int    argc,
 	goto done;
     if ((msg = clicon_msg_encode(getpid(), "%s", cbuf_get(cb))) < 0)
 	goto done;
-    if (strcmp(family, "UNIX")==0){
-	if (clicon_rpc_connect_unix(h, msg, sockpath, &retdata, NULL) < 0)
+    gettimeofday(&t0, NULL);
+    if (nr > 0){
+	/* Persistent connection: send all requests, then read all replies */
+	clicon_option_str_set(h, "CLICON_SOCK", sockpath);
+	clicon_option_str_set(h, "CLICON_SOCK_FAMILY", strcmp(family, "UNIX")==0?"UNIX":"IPv4");
+	clicon_option_str_set(h, "CLICON_SOCK_PORT", "4535");
+	if ((reqids = calloc(nr, sizeof(uint32_t))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
 	    goto done;
-    }
-    else
-	if (clicon_rpc_connect_inet(h, msg, sockpath, 4535, &retdata, NULL) < 0)
+	}
+	for (i=0; i<nr; i++)
+	    if (clicon_rpc_msg_send(h, msg, &reqids[i]) < 0)
+		goto done;
+	for (i=0; i<nr; i++){
+	    if (xret){
+		xml_free(xret);
+		xret = NULL;
+	    }
+	    if (clicon_rpc_msg_rcv(h, reqids[i], &xret) < 0)
+		goto done;
+	}
+	clicon_rpc_msg_close(h);
+	if (clicon_xml2file(stdout, xml_child_i(xret, 0), 0, 0) < 0)
 	    goto done;
-    fprintf(stdout, "%s\n", retdata);
+	fprintf(stdout, "\n");
+    }
+    else {
+	if (strcmp(family, "UNIX")==0){
+	    if (clicon_rpc_connect_unix(h, msg, sockpath, &retdata, NULL) < 0)
+		goto done;
+	}
+	else
+	    if (clicon_rpc_connect_inet(h, msg, sockpath, 4535, &retdata, NULL) < 0)
+		goto done;
+	fprintf(stdout, "%s\n", retdata);
+    }
+    gettimeofday(&t1, NULL);
+    if (timeit){
+	timersub(&t1, &t0, &t1);
+	fprintf(stderr, "%ld.%06ld\n", t1.tv_sec, t1.tv_usec);
+    }
     retval = 0;
  done:
+    if (reqids)
+	free(reqids);
+    if (xret)
+	xml_free(xret);
     if (xerr)
 	xml_free(xerr);
     if (xt)
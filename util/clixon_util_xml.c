@@ -66,7 +66,7 @@
 #include "clixon/clixon.h"
 
 /* Command line options passed to getopt(3) */
-#define UTIL_XML_OPTS "hD:f:Jjl:pvoy:Y:t:T:u"
+#define UTIL_XML_OPTS "hD:f:Jjl:pvoy:Y:t:T:ua"
 
 static int
 validate_tree(clicon_handle h,
@@ -126,6 +126,7 @@ usage(char *argv0)
    	    "\t-t <file>\tXML top input file (where base tree is pasted to)\n"
 	    "\t-T <path>\tXPath to where in top input file base should be pasted\n"
 	    "\t-u \t\tTreat unknown XML as anydata\n"
+	    "\t-a \t\tAllocate parsed XML in an arena\n"
 	    ,
 	    argv0);
     exit(0);
@@ -226,6 +227,9 @@ main(int    argc,
 		goto done;
 	    xml_bind_yang_unknown_anydata(1);
 	    break;
+	case 'a':
+	    xml_arena_enable(1);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -240,6 +244,11 @@ main(int    argc,
     }
     clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, logdst);
     clicon_debug_init(dbg, NULL);
+#ifdef CLIXON_XML_SCANNER
+    clicon_debug(1, "xml scanner: hand-written, delimiter search %s", clixon_scan_impl());
+#else
+    clicon_debug(1, "xml scanner: flex");
+#endif
     
     /* 1. Parse yang */
     if (yang_file_dir){
@@ -336,11 +345,12 @@ main(int    argc,
     if (output){
 	xc = NULL;
 	while ((xc = xml_child_each(xt, xc, -1)) != NULL) 
-	    if (jsonout)
-		xml2json_cbuf(cb, xc, pretty); /* print xml */
-	    else
-		clicon_xml2cbuf(cb, xc, 0, pretty, -1); /* print xml */
-	fprintf(stdout, "%s", cbuf_get(cb));
+	    if (jsonout){
+		if (xml2json(stdout, xc, pretty) < 0) /* print xml */
+		    goto done;
+	    }
+	    else if (clicon_xml2file(stdout, xc, 0, pretty) < 0) /* print xml */
+		goto done;
 	fflush(stdout);
     }
     retval = 0;
@@ -0,0 +1,215 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Benchmark of binary encoded XML trees against XML text, as used on the
+  * backend socket, see CLICON_SOCK_BINARY.
+  * Reads an XML file, and times serializing and parsing it as XML text and as
+  * binary encoding. The tree decoded from the binary encoding is checked to be 
+  * equal to the original, and may be printed with -o.
+  * Example: clixon_util_xml_bin -f large.xml -n 100
+  */
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/*! Return time in seconds since t0
+ */
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t1;
+    struct timeval td;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &td);
+    return td.tv_sec + td.tv_usec/1000000.0;
+}
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options] with xml on stdin (unless -f)\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level>\tDebug\n"
+	    "\t-f <file>\tXML input file (overrides stdin)\n"
+	    "\t-n <nr>     \tNumber of iterations (default: 10)\n"
+	    "\t-o \t\tOutput tree decoded from binary encoding as XML\n",
+	    argv0
+	    );
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int    retval = -1;
+    char  *argv0 = argv[0];
+    int    c;
+    int    dbg = 0;
+    int    fd = 0; /* stdin */
+    int    nr = 10;
+    int    output = 0;
+    cxobj *xt = NULL;
+    cxobj *x;
+    cxobj *x1 = NULL;
+    cbuf  *cbx = NULL;
+    cbuf  *cbb = NULL;
+    cbuf  *cb1 = NULL;
+    struct timeval t0;
+    double tx;
+    double tb;
+    int    i;
+
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, "hD:f:n:o")) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv0);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv0);
+	    break;
+	case 'f':
+	    if ((fd = open(optarg, O_RDONLY)) < 0){
+		clicon_err(OE_UNIX, errno, "open(%s)", optarg);
+		goto done;
+	    }
+	    break;
+	case 'n': /* Number of iterations */
+	    if ((nr = atoi(optarg)) <= 0)
+		usage(argv0);
+	    break;
+	case 'o':
+	    output++;
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR); 
+    clicon_debug_init(dbg, NULL);
+
+    if (clixon_xml_parse_file(fd, YB_NONE, NULL, NULL, &xt, NULL) < 0)
+	goto done;
+    if ((x = xml_child_i_type(xt, 0, CX_ELMNT)) == NULL){
+	clicon_err(OE_XML, ENOENT, "No XML element in input");
+	goto done;
+    }
+    if ((cbx = cbuf_new()) == NULL ||
+	(cbb = cbuf_new()) == NULL ||
+	(cb1 = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Serialize */
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	cbuf_reset(cbx);
+	if (clicon_xml2cbuf(cbx, x, 0, 0, -1) < 0)
+	    goto done;
+    }
+    tx = elapsed(&t0);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	cbuf_reset(cbb);
+	if (clixon_xml2bin(cbb, x, -1) < 0)
+	    goto done;
+    }
+    tb = elapsed(&t0);
+    fprintf(stdout, "xml serialize:    %d bytes %d times in %.6f s\n", cbuf_len(cbx), nr, tx);
+    fprintf(stdout, "binary serialize: %d bytes %d times in %.6f s\n", cbuf_len(cbb), nr, tb);
+    /* Parse */
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	if (clixon_xml_parse_string(cbuf_get(cbx), YB_NONE, NULL, &x1, NULL) < 0)
+	    goto done;
+	xml_free(x1);
+	x1 = NULL;
+    }
+    tx = elapsed(&t0);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	if (clixon_xml_parse_bin(cbuf_get(cbb), cbuf_len(cbb), YB_NONE, NULL, &x1, NULL) < 0)
+	    goto done;
+	xml_free(x1);
+	x1 = NULL;
+    }
+    tb = elapsed(&t0);
+    fprintf(stdout, "xml parse:        %d times in %.6f s\n", nr, tx);
+    fprintf(stdout, "binary parse:     %d times in %.6f s\n", nr, tb);
+    /* Check that decoded tree is equal to original */
+    if (clixon_xml_parse_bin(cbuf_get(cbb), cbuf_len(cbb), YB_NONE, NULL, &x1, NULL) < 0)
+	goto done;
+    if ((x = xml_child_i_type(x1, 0, CX_ELMNT)) == NULL ||
+	clicon_xml2cbuf(cb1, x, 0, 0, -1) < 0)
+	goto done;
+    if (strcmp(cbuf_get(cbx), cbuf_get(cb1)) != 0){
+	fprintf(stderr, "binary decoded tree differs from original\n");
+	goto done;
+    }
+    if (output)
+	fprintf(stdout, "%s\n", cbuf_get(cb1));
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    if (x1)
+	xml_free(x1);
+    if (cbx)
+	cbuf_free(cbx);
+    if (cbb)
+	cbuf_free(cbb);
+    if (cb1)
+	cbuf_free(cb1);
+    return retval;
+}
@@ -59,7 +59,7 @@ See https://www.w3.org/TR/xpath/
 #include "clixon/clixon.h"
 
 /* Command line options to be passed to getopt(3) */
-#define XPATH_OPTS "hD:f:p:i:n:cl:y:Y:"
+#define XPATH_OPTS "hD:f:p:i:n:v:cl:y:Y:"
 
 static int
 usage(char *argv0)
@@ -72,6 +72,7 @@ usage(char *argv0)
 	    "\t-p <xpath> \tPrimary XPATH string\n"
 	    "\t-i <xpath0>\t(optional) Initial XPATH string\n"
 	    "\t-n <pfx:id>\tNamespace binding (pfx=NULL for default)\n"
+	    "\t-v <name=value>\tBind string value to xpath variable $name\n"
 	    "\t-c \t\tMap xpath to canonical form\n"
 	    "\t-l <s|e|o|f<file>> \tLog on (s)yslog, std(e)rr, std(o)ut or (f)ile (stderr is default)\n"
 	    "\t-y <filename> \tYang filename or dir (load all files)\n"
@@ -143,6 +144,11 @@ main(int    argc,
     cxobj      *xerr = NULL; /* malloced must be freed */
     int         logdst = CLICON_LOG_STDERR;
     int         dbg = 0;
+    cvec       *vars = NULL;
+    cg_var     *cv;
+    char       *val;
+    xpath_prepared *xp = NULL;
+    int         hits = 0;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init("xpath", LOG_DEBUG, logdst); 
@@ -199,6 +205,22 @@ main(int    argc,
 		free(id);
 	    break;
 	}
+	case 'v': /* Variable binding */
+	    if ((val = strchr(optarg, '=')) == NULL)
+		usage(argv[0]);
+	    *val++ = '\0';
+	    if (vars == NULL &&
+		(vars = cvec_new(0)) == NULL){
+		clicon_err(OE_UNIX, errno, "cvec_new");
+		goto done;
+	    }
+	    if ((cv = cvec_add(vars, CGV_STRING)) == NULL){
+		clicon_err(OE_UNIX, errno, "cvec_add");
+		goto done;
+	    }
+	    cv_name_set(cv, optarg);
+	    cv_string_set(cv, val);
+	    break;
 	case 'c': /* Map namespace to canonical form */
 	    canonical = 1;
 	    break;
@@ -352,8 +374,17 @@ main(int    argc,
     }
     else
 	x = x0;
-    if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
+    if (vars){ /* Evaluate as prepared xpath with bound variables */
+	if (xpath_prepare(xpath, &xp) < 0)
+	    goto done;
+	if (xpath_prepared_ctx(x, nsc, xp, vars, 0, &xc) < 0)
+	    goto done;
+    }
+    else if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
 	return -1;
+    /* Nr of list lookups made with binary search */
+    xpath_list_optimize_stats(&hits);
+    clicon_debug(1, "xpath list optimize hits: %d", hits);
     /* Print results */
     cb = cbuf_new();
     ctx_print2(cb, xc);
@@ -365,6 +396,10 @@ main(int    argc,
 	cbuf_free(cb);
     if (nsc)
 	xml_nsctx_free(nsc);
+    if (xp)
+	xpath_prepared_free(xp);
+    if (vars)
+	cvec_free(vars);
     if (xc)
 	ctx_free(xc);
     if (xcfg)
@@ -53,6 +53,7 @@
 #include <sys/stat.h>
 #include <libgen.h>
 #include <netinet/in.h>
+#include <sys/time.h>
 
 
 /* cligen */
@@ -61,6 +62,31 @@
 /* clixon */
 #include "clixon/clixon.h"
 
+/*! Look up all children of yn and its descendants by keyword and argument
+ * @param[in]  yn   Yang node
+ * @param[out] sum  Checksum of results, same regardless of lookup method
+ * @retval     n    Number of lookups
+ */
+static int
+yang_bench(yang_stmt *yn,
+	   uintptr_t *sum)
+{
+    yang_stmt *yc = NULL;
+    char      *arg;
+    int        n = 0;
+
+    while ((yc = yn_each(yn, yc)) != NULL) {
+	if ((arg = yang_argument_get(yc)) != NULL){
+	    *sum += (uintptr_t)yang_find(yn, yang_keyword_get(yc), arg);
+	    *sum += (uintptr_t)yang_find_datanode(yn, arg);
+	    *sum += (uintptr_t)yang_find_schemanode(yn, arg);
+	    n += 3;
+	}
+	n += yang_bench(yc, sum);
+    }
+    return n;
+}
+
 /*
 */
 static int
@@ -70,7 +96,8 @@ usage(char *argv0)
 	    "where options are\n"
             "\t-h \t\tHelp\n"
     	    "\t-D <level> \tDebug\n"
-	    "\t-l <s|e|o> \tLog on (s)yslog, std(e)rr, std(o)ut (stderr is default)\n",
+	    "\t-l <s|e|o> \tLog on (s)yslog, std(e)rr, std(o)ut (stderr is default)\n"
+	    "\t-n <nr> \tBenchmark: repeat yang_find lookups of all nodes nr times, with and without index\n",
 	    argv0);
     exit(0);
 }
@@ -82,10 +109,17 @@ main(int argc, char **argv)
     int        c;
     int        logdst = CLICON_LOG_STDERR;
     int        dbg = 0;
+    int        nr = 0;
+    int        i;
+    int        j;
+    int        n = 0;
+    uintptr_t  sum[2] = {0, 0};
+    struct timeval t0;
+    struct timeval t1;
     
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:l:")) != -1)
+    while ((c = getopt(argc, argv, "hD:l:n:")) != -1)
 	switch (c) {
 	case 'h':
 	    usage(argv[0]);
@@ -98,6 +132,10 @@ main(int argc, char **argv)
 	    if ((logdst = clicon_log_opt(optarg[0])) < 0)
 		usage(argv[0]);
 	    break;
+	case 'n':
+	    if (sscanf(optarg, "%d", &nr) != 1)
+		usage(argv[0]);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -110,7 +148,22 @@ main(int argc, char **argv)
 	fprintf(stderr, "yang parse error %s\n", clicon_err_reason);
 	return -1;
     }
-    yang_print(stdout, yspec);
+    if (nr == 0)
+	yang_print(stdout, yspec);
+    for (j=0; nr && j<2; j++){ /* First linear, then indexed */
+	yang_index_enable(j);
+	gettimeofday(&t0, NULL);
+	for (i=0; i<nr; i++)
+	    n = yang_bench(yspec, &sum[j]);
+	gettimeofday(&t1, NULL);
+	timersub(&t1, &t0, &t1);
+	fprintf(stdout, "%s: %d lookups: %ld.%06ld s\n",
+		j?"indexed":"linear", n*nr, (long)t1.tv_sec, (long)t1.tv_usec);
+    }
+    if (sum[0] != sum[1]){
+	fprintf(stderr, "yang lookup mismatch between linear and indexed\n");
+	return -1;
+    }
  done:
     if (yspec)
 	yspec_free(yspec);